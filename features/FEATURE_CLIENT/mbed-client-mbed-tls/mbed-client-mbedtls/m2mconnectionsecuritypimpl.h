@@ -31,6 +31,20 @@
 #include "mbedtls/error.h"
 #include "mbedtls/certs.h"
 #include "mbedtls/entropy_poll.h"
+#include "mbedtls/memory_buffer_alloc.h"
+
+// Size of the heap each secure connection gets for mbedtls, allocated when
+// the connection is first initialised. It is a hard limit, so size it from
+// the peaks heap_usage() reports for the server and certificates in use.
+// 0, the default, shares the system heap instead. Only used with
+// MBEDTLS_MEMORY_BUFFER_ALLOC_C.
+#ifdef YOTTA_CFG_TLS_HEAP_SIZE
+#define MBED_CLIENT_TLS_HEAP_SIZE YOTTA_CFG_TLS_HEAP_SIZE
+#elif defined MBED_CONF_MBED_CLIENT_TLS_HEAP_SIZE
+#define MBED_CLIENT_TLS_HEAP_SIZE MBED_CONF_MBED_CLIENT_TLS_HEAP_SIZE
+#else
+#define MBED_CLIENT_TLS_HEAP_SIZE 0
+#endif
 
 class M2MTimer;
 
@@ -133,6 +147,17 @@ public:
      */
     void set_entropy_callback(entropy_cb callback);
 
+    /**
+     * \brief Returns the peak heap usage of the connection, overall or
+     * during one phase of it.
+     * \param phase The phase to report, HeapTotal for the whole connection.
+     * \param peak_bytes Set to the peak number of bytes in use.
+     * \param peak_blocks Set to the peak number of blocks in use.
+     * \return True if the connection has a heap of its own, else false.
+     */
+    bool heap_usage(M2MConnectionSecurity::HeapPhase phase,
+                    size_t &peak_bytes, size_t &peak_blocks) const;
+
 protected: //From M2MTimerObserver
 
     virtual void timer_expired(M2MTimerObserver::Type type);
@@ -141,6 +166,13 @@ private:
 
     int start_handshake();
 
+    // Sets up the heap of a secure connection the first time it is needed
+    void init_heap();
+
+    // Routes mbedtls allocations to the heap of the connection while in scope
+    class HeapScope;
+    friend class HeapScope;
+
 private:
 
     bool                        _init_done;
@@ -154,6 +186,10 @@ private:
     uint32_t                    _flags;
     M2MTimer                    *_timer;
     M2MConnectionSecurity::SecurityMode _sec_mode;
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+    unsigned char               *_heap_buf;
+    mbedtls_memory_buffer_arena _heap;
+#endif
 
     friend class Test_M2MConnectionSecurityPimpl;
 };
@@ -69,3 +69,9 @@ void M2MConnectionSecurity::set_entropy_callback(entropy_cb callback)
 {
     _private_impl->set_entropy_callback(callback);
 }
+
+bool M2MConnectionSecurity::heap_usage(HeapPhase phase, size_t &peak_bytes,
+                                       size_t &peak_blocks) const
+{
+    return _private_impl->heap_usage(phase, peak_bytes, peak_blocks);
+}
@@ -67,6 +67,53 @@ static int verify_cert_chains(void *data, mbedtls_x509_crt *crt, int depth, uint
 }
 #endif
 
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+static int heap_phase(M2MConnectionSecurity::HeapPhase phase)
+{
+    switch (phase) {
+        case M2MConnectionSecurity::HeapCertificateParse:
+            return MBEDTLS_MEMORY_PHASE_CERT_PARSE;
+        case M2MConnectionSecurity::HeapKeyExchange:
+            return MBEDTLS_MEMORY_PHASE_KEY_EXCHANGE;
+        case M2MConnectionSecurity::HeapRecordIO:
+            return MBEDTLS_MEMORY_PHASE_RECORD_IO;
+        default:
+            return MBEDTLS_MEMORY_PHASE_NONE;
+    }
+}
+#endif
+
+// Memory is always freed to the heap it came from, so only the calls that
+// allocate need a scope
+class M2MConnectionSecurityPimpl::HeapScope {
+public:
+    HeapScope(M2MConnectionSecurityPimpl &impl, M2MConnectionSecurity::HeapPhase phase)
+    {
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+        mbedtls_memory_buffer_arena *heap = impl._heap_buf ? &impl._heap : NULL;
+        _prev = mbedtls_memory_buffer_arena_select(heap);
+        if (heap) {
+            mbedtls_memory_buffer_arena_set_phase(heap, heap_phase(phase));
+        }
+#else
+        (void) impl;
+        (void) phase;
+#endif
+    }
+
+    ~HeapScope()
+    {
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+        mbedtls_memory_buffer_arena_select(_prev);
+#endif
+    }
+
+private:
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+    mbedtls_memory_buffer_arena *_prev;
+#endif
+};
+
 M2MConnectionSecurityPimpl::M2MConnectionSecurityPimpl(M2MConnectionSecurity::SecurityMode mode)
   : _flags(0),
     _sec_mode(mode)
@@ -74,6 +121,9 @@ M2MConnectionSecurityPimpl::M2MConnectionSecurityPimpl(M2MConnectionSecurity::Se
     _init_done = false;
     cancelled = true;
     _timer = new M2MTimer(*this);
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+    _heap_buf = NULL;
+#endif
     mbedtls_ssl_init( &_ssl );
     mbedtls_ssl_config_init( &_conf );
     mbedtls_x509_crt_init( &_cacert );
@@ -91,9 +141,33 @@ M2MConnectionSecurityPimpl::~M2MConnectionSecurityPimpl(){
     mbedtls_pk_free(&_pkey);
     mbedtls_ctr_drbg_free( &_ctr_drbg );
     mbedtls_entropy_free( &_entropy );
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+    if (_heap_buf) {
+        mbedtls_memory_buffer_arena_free(&_heap);
+        free(_heap_buf);
+    }
+#endif
     delete _timer;
 }
 
+void M2MConnectionSecurityPimpl::init_heap()
+{
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+    // Kept until the object goes, reset() hands everything back to it
+    if (_heap_buf || MBED_CLIENT_TLS_HEAP_SIZE == 0 ||
+        _sec_mode == M2MConnectionSecurity::NO_SECURITY) {
+        return;
+    }
+
+    _heap_buf = (unsigned char*)malloc(MBED_CLIENT_TLS_HEAP_SIZE);
+    if (_heap_buf) {
+        mbedtls_memory_buffer_arena_init(&_heap, _heap_buf, MBED_CLIENT_TLS_HEAP_SIZE);
+    } else {
+        tr_warn("M2MConnectionSecurityPimpl::init_heap - no heap of its own, using the system heap");
+    }
+#endif
+}
+
 void M2MConnectionSecurityPimpl::timer_expired(M2MTimerObserver::Type type){
     tr_debug("M2MConnectionSecurityPimpl::timer_expired");
     if(type == M2MTimerObserver::Dtls && !cancelled){
@@ -125,6 +199,10 @@ void M2MConnectionSecurityPimpl::reset(){
 int M2MConnectionSecurityPimpl::init(const M2MSecurity *security)
 {
     tr_debug("M2MConnectionSecurityPimpl::init");
+    if (security != NULL) {
+        init_heap();
+    }
+    HeapScope heap(*this, M2MConnectionSecurity::HeapCertificateParse);
     int ret = -1;
     if (security != NULL) {
         const char *pers = "dtls_client";
@@ -247,6 +325,7 @@ int M2MConnectionSecurityPimpl::start_handshake(){
 int M2MConnectionSecurityPimpl::connect(M2MConnectionHandler* connHandler){
 
     tr_debug("M2MConnectionSecurityPimpl::connect");
+    HeapScope heap(*this, M2MConnectionSecurity::HeapKeyExchange);
     int ret=-1;
     if(!_init_done){
         return ret;
@@ -273,6 +352,7 @@ int M2MConnectionSecurityPimpl::connect(M2MConnectionHandler* connHandler){
 int M2MConnectionSecurityPimpl::start_connecting_non_blocking(M2MConnectionHandler* connHandler)
 {
     tr_debug("M2MConnectionSecurityPimpl::start_connecting_non_blocking");
+    HeapScope heap(*this, M2MConnectionSecurity::HeapKeyExchange);
     int ret=-1;
     if(!_init_done){
         return ret;
@@ -322,6 +402,7 @@ int M2MConnectionSecurityPimpl::start_connecting_non_blocking(M2MConnectionHandl
 int M2MConnectionSecurityPimpl::continue_connecting()
 {
     tr_debug("M2MConnectionSecurityPimpl::continue_connecting");
+    HeapScope heap(*this, M2MConnectionSecurity::HeapKeyExchange);
     int ret=-1;
     while( ret != M2MConnectionHandler::CONNECTION_ERROR_WANTS_READ ){
         ret = mbedtls_ssl_handshake_step( &_ssl );
@@ -342,6 +423,7 @@ int M2MConnectionSecurityPimpl::continue_connecting()
 
 int M2MConnectionSecurityPimpl::send_message(unsigned char *message, int len){
     tr_debug("M2MConnectionSecurityPimpl::send_message");
+    HeapScope heap(*this, M2MConnectionSecurity::HeapRecordIO);
     int ret=-1;
     if(!_init_done){
         return ret;
@@ -356,6 +438,7 @@ int M2MConnectionSecurityPimpl::send_message(unsigned char *message, int len){
 }
 
 int M2MConnectionSecurityPimpl::read(unsigned char* buffer, uint16_t len){
+    HeapScope heap(*this, M2MConnectionSecurity::HeapRecordIO);
     int ret=-1;
     if(!_init_done){
         tr_error("M2MConnectionSecurityPimpl::read - init not done!");
@@ -452,3 +535,25 @@ void M2MConnectionSecurityPimpl::set_entropy_callback(entropy_cb callback)
     __entropy_callback = callback;
 }
 
+bool M2MConnectionSecurityPimpl::heap_usage(M2MConnectionSecurity::HeapPhase phase,
+                                            size_t &peak_bytes, size_t &peak_blocks) const
+{
+    peak_bytes = 0;
+    peak_blocks = 0;
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+    if (!_heap_buf) {
+        return false;
+    }
+    if (phase == M2MConnectionSecurity::HeapTotal) {
+        mbedtls_memory_buffer_arena_max_get(&_heap, &peak_bytes, &peak_blocks);
+    } else {
+        mbedtls_memory_buffer_arena_phase_get(&_heap, heap_phase(phase),
+                                              &peak_bytes, &peak_blocks);
+    }
+    return true;
+#else
+    (void) phase;
+    return false;
+#endif
+}
+
@@ -92,3 +92,8 @@ TEST(M2MConnectionSecurity_mbedtls, test_set_entropy_callback)
     inst->test_set_entropy_callback();
 }
 
+TEST(M2MConnectionSecurity_mbedtls, test_heap_usage)
+{
+    inst->test_heap_usage();
+}
+
@@ -129,6 +129,13 @@ void Test_M2MConnectionSecurity::test_set_entropy_callback()
     impl.set_entropy_callback(ent_cb);
 }
 
+void Test_M2MConnectionSecurity::test_heap_usage()
+{
+    M2MConnectionSecurity impl = M2MConnectionSecurity(M2MConnectionSecurity::TLS);
+    size_t bytes, blocks;
+    CHECK(!impl.heap_usage(M2MConnectionSecurity::HeapTotal, bytes, blocks));
+}
+
 uint32_t test_random_callback(void)
 {
     return 1;
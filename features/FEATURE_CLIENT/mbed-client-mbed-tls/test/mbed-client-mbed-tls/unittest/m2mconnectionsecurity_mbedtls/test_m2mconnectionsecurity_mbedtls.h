@@ -48,6 +48,8 @@ public:
     void test_set_random_number_callback();
 
     void test_set_entropy_callback();
+
+    void test_heap_usage();
 };
 
 
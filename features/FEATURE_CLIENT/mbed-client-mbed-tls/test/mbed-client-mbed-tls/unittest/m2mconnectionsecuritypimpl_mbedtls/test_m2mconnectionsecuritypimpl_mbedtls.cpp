@@ -403,6 +403,49 @@ void Test_M2MConnectionSecurityPimpl::test_set_entropy_callback()
     impl.set_entropy_callback(ent_cb);
 }
 
+void Test_M2MConnectionSecurityPimpl::test_heap_usage()
+{
+    M2MConnectionSecurityPimpl impl = M2MConnectionSecurityPimpl(M2MConnectionSecurity::TLS);
+    size_t bytes = 1;
+    size_t blocks = 1;
+
+    // No heap of its own until the connection is initialised
+    CHECK(!impl.heap_usage(M2MConnectionSecurity::HeapTotal, bytes, blocks));
+    CHECK(bytes == 0);
+    CHECK(blocks == 0);
+
+    m2msecurity_stub::has_value = true;
+    m2msecurity_stub::int_value = M2MSecurity::Psk;
+    M2MSecurity* sec = new M2MSecurity(M2MSecurity::Bootstrap);
+
+    mbedtls_stub::crt_expected_int = 0;
+    mbedtls_stub::useCounter = true;
+    mbedtls_stub::counter = 0;
+    mbedtls_stub::retArray[0] = 0;
+    mbedtls_stub::retArray[1] = 0;
+    mbedtls_stub::retArray[2] = 0;
+    CHECK( 0 == impl.init(sec) );
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+    CHECK(impl.heap_usage(M2MConnectionSecurity::HeapTotal, bytes, blocks) ==
+          (MBED_CLIENT_TLS_HEAP_SIZE > 0));
+    CHECK(impl.heap_usage(M2MConnectionSecurity::HeapKeyExchange, bytes, blocks) ==
+          (MBED_CLIENT_TLS_HEAP_SIZE > 0));
+#else
+    CHECK(!impl.heap_usage(M2MConnectionSecurity::HeapTotal, bytes, blocks));
+#endif
+    CHECK(bytes == 0);
+    CHECK(blocks == 0);
+
+    // Never for a connection without security
+    M2MConnectionSecurityPimpl plain = M2MConnectionSecurityPimpl(M2MConnectionSecurity::NO_SECURITY);
+    mbedtls_stub::counter = 0;
+    CHECK( 0 == plain.init(sec) );
+    CHECK(!plain.heap_usage(M2MConnectionSecurity::HeapTotal, bytes, blocks));
+
+    mbedtls_stub::useCounter = false;
+    delete sec;
+}
+
 uint32_t test_random_callback(void)
 {
     return 1;
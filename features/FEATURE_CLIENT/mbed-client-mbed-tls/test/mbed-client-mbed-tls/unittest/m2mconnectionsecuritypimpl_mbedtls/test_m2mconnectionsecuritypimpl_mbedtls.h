@@ -51,6 +51,8 @@ public:
 
     void test_set_entropy_callback();
 
+    void test_heap_usage();
+
 };
 
 
@@ -74,3 +74,9 @@ void M2MConnectionSecurityPimpl::set_random_number_callback(random_number_cb){
 
 void M2MConnectionSecurityPimpl::set_entropy_callback(entropy_cb){
 }
+
+bool M2MConnectionSecurityPimpl::heap_usage(M2MConnectionSecurity::HeapPhase,
+                                            size_t &, size_t &) const
+{
+    return false;
+}
@@ -284,3 +284,42 @@ void mbedtls_ssl_config_free( mbedtls_ssl_config * )
 
 }
 
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+//From memory_buffer_alloc.h
+void mbedtls_memory_buffer_arena_init( mbedtls_memory_buffer_arena *,
+                                       unsigned char *, size_t )
+{
+
+}
+
+void mbedtls_memory_buffer_arena_free( mbedtls_memory_buffer_arena * )
+{
+
+}
+
+mbedtls_memory_buffer_arena *mbedtls_memory_buffer_arena_select(
+                                        mbedtls_memory_buffer_arena * )
+{
+    return NULL;
+}
+
+void mbedtls_memory_buffer_arena_set_phase( mbedtls_memory_buffer_arena *, int )
+{
+
+}
+
+void mbedtls_memory_buffer_arena_max_get( const mbedtls_memory_buffer_arena *,
+                                          size_t *max_used, size_t *max_blocks )
+{
+    *max_used = 0;
+    *max_blocks = 0;
+}
+
+void mbedtls_memory_buffer_arena_phase_get( const mbedtls_memory_buffer_arena *,
+                                            int, size_t *max_used, size_t *max_blocks )
+{
+    *max_used = 0;
+    *max_blocks = 0;
+}
+#endif
+
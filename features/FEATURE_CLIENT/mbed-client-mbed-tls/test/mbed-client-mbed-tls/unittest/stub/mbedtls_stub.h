@@ -22,6 +22,7 @@
 #include "mbedtls/x509_crt.h"
 #include "mbedtls/entropy.h"
 #include "mbedtls/pk.h"
+#include "mbedtls/memory_buffer_alloc.h"
 
 namespace mbedtls_stub
 {
@@ -37,6 +37,13 @@ public:
         DTLS
     } SecurityMode;
 
+    typedef enum {
+        HeapTotal = 0,
+        HeapCertificateParse,
+        HeapKeyExchange,
+        HeapRecordIO
+    } HeapPhase;
+
 private:
     // Prevents the use of assignment operator by accident.
     M2MConnectionSecurity& operator=( const M2MConnectionSecurity& /*other*/ );
@@ -120,6 +127,16 @@ public:
      */
     void set_entropy_callback(entropy_cb callback);
 
+    /**
+     * \brief Returns the peak heap usage of the secure connection, overall
+     * or during one phase of it, to help size the heap it needs.
+     * \param phase The phase to report, HeapTotal for the whole connection.
+     * \param peak_bytes Set to the peak number of bytes in use.
+     * \param peak_blocks Set to the peak number of blocks in use.
+     * \return True if the connection keeps heap statistics, else false.
+     */
+    bool heap_usage(HeapPhase phase, size_t &peak_bytes, size_t &peak_blocks) const;
+
 private:
 
     M2MConnectionSecurityPimpl* _private_impl;
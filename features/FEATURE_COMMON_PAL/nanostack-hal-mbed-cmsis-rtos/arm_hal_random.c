@@ -20,9 +20,16 @@
 #include "driverRFPhy.h"
 #endif
 #include "mbedtls/entropy_poll.h"
+#ifdef MBEDTLS_ENTROPY_POOL
+#include "mbedtls_entropy_pool.h"
+#endif
 
 void arm_random_module_init(void)
 {
+#ifdef MBEDTLS_ENTROPY_POOL
+    /* Start filling the pool mbedtls_hardware_poll() reads from */
+    mbedtls_entropy_pool_shared();
+#endif
 }
 
 uint32_t arm_random_seed_get(void)
@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * CCM and GCM past the known answers of their self tests. CCM is compared
+ * with a two pass reference built on AES-ECB over every length up to a few
+ * blocks, in place and not. GCM must give the same output and tag whether
+ * the data comes in one call, in pieces of any length or as a scatter list,
+ * and with its table built by setkey or precomputed.
+ */
+
+#include <string.h>
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+#include "mbedtls/aes.h"
+#include "mbedtls/ccm.h"
+#include "mbedtls/gcm.h"
+
+#if !defined(MBEDTLS_AES_C) || !defined(MBEDTLS_CCM_C) || !defined(MBEDTLS_GCM_C)
+  #error [NOT_SUPPORTED] test not supported
+#endif
+
+using namespace utest::v1;
+
+namespace {
+const size_t MAX_LEN = 80;
+
+const unsigned char key[16] = {
+    0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47,
+    0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f
+};
+const unsigned char iv[13] = {
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+    0x18, 0x19, 0x1a, 0x1b, 0x1c
+};
+
+unsigned char plain[MAX_LEN], add[24];
+unsigned char expected[MAX_LEN], output[MAX_LEN], decrypted[MAX_LEN];
+unsigned char expected_tag[16], tag[16];
+}
+
+static void fill(void) {
+    for (size_t i = 0; i < sizeof(plain); i++) {
+        plain[i] = (unsigned char)(i * 37 + 11);
+    }
+    for (size_t i = 0; i < sizeof(add); i++) {
+        add[i] = (unsigned char)(i * 13 + 5);
+    }
+}
+
+/* CBC-MAC then CTR, in two passes, as SP 800-38C describes them */
+static void reference_ccm(size_t len, size_t add_len, size_t tag_len) {
+    mbedtls_aes_context aes;
+    unsigned char b[16], y[16], ctr[16], s[16];
+    const size_t q = 15 - sizeof(iv);
+    size_t i, n;
+
+    mbedtls_aes_init(&aes);
+    TEST_ASSERT_EQUAL(0, mbedtls_aes_setkey_enc(&aes, key, 128));
+
+    memset(b, 0, 16);
+    b[0] = (add_len > 0 ? 0x40 : 0) | ((tag_len - 2) / 2) << 3 | (q - 1);
+    memcpy(b + 1, iv, sizeof(iv));
+    b[14] = (unsigned char)(len >> 8);
+    b[15] = (unsigned char)len;
+    mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_ENCRYPT, b, y);
+
+    if (add_len > 0) {
+        /* Length prefix and additional data, zero padded */
+        unsigned char a[2 + sizeof(add) + 15];
+        memset(a, 0, sizeof(a));
+        a[0] = (unsigned char)(add_len >> 8);
+        a[1] = (unsigned char)add_len;
+        memcpy(a + 2, add, add_len);
+        for (n = 0; n < 2 + add_len; n += 16) {
+            for (i = 0; i < 16; i++) {
+                y[i] ^= a[n + i];
+            }
+            mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_ENCRYPT, y, y);
+        }
+    }
+    for (n = 0; n < len; n += 16) {
+        for (i = 0; i < 16 && n + i < len; i++) {
+            y[i] ^= plain[n + i];
+        }
+        mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_ENCRYPT, y, y);
+    }
+
+    memset(ctr, 0, 16);
+    ctr[0] = q - 1;
+    memcpy(ctr + 1, iv, sizeof(iv));
+    mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_ENCRYPT, ctr, s);
+    for (i = 0; i < tag_len; i++) {
+        expected_tag[i] = y[i] ^ s[i];
+    }
+    for (n = 0; n < len; n += 16) {
+        ctr[15] = (unsigned char)(n / 16 + 1);
+        mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_ENCRYPT, ctr, s);
+        for (i = 0; i < 16 && n + i < len; i++) {
+            expected[n + i] = plain[n + i] ^ s[i];
+        }
+    }
+
+    mbedtls_aes_free(&aes);
+}
+
+void test_self_tests(void) {
+    TEST_ASSERT_EQUAL(0, mbedtls_ccm_self_test(0));
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_self_test(0));
+}
+
+void test_ccm_lengths(void) {
+    mbedtls_ccm_context ctx;
+    const size_t add_lens[] = { 0, 13, 24 };
+
+    fill();
+    mbedtls_ccm_init(&ctx);
+    TEST_ASSERT_EQUAL(0, mbedtls_ccm_setkey(&ctx, MBEDTLS_CIPHER_ID_AES, key, 128));
+
+    for (size_t len = 0; len <= MAX_LEN; len++) {
+        for (size_t a = 0; a < sizeof(add_lens) / sizeof(add_lens[0]); a++) {
+            size_t tag_len = 4 + 2 * ((len + a) % 7);
+
+            reference_ccm(len, add_lens[a], tag_len);
+
+            TEST_ASSERT_EQUAL(0, mbedtls_ccm_encrypt_and_tag(&ctx, len, iv, sizeof(iv),
+                    add, add_lens[a], plain, output, tag, tag_len));
+            TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, output, len);
+            TEST_ASSERT_EQUAL_UINT8_ARRAY(expected_tag, tag, tag_len);
+
+            TEST_ASSERT_EQUAL(0, mbedtls_ccm_auth_decrypt(&ctx, len, iv, sizeof(iv),
+                    add, add_lens[a], output, decrypted, tag, tag_len));
+            TEST_ASSERT_EQUAL_UINT8_ARRAY(plain, decrypted, len);
+
+            /* In place, both ways */
+            memcpy(output, plain, len);
+            TEST_ASSERT_EQUAL(0, mbedtls_ccm_encrypt_and_tag(&ctx, len, iv, sizeof(iv),
+                    add, add_lens[a], output, output, tag, tag_len));
+            TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, output, len);
+            TEST_ASSERT_EQUAL(0, mbedtls_ccm_auth_decrypt(&ctx, len, iv, sizeof(iv),
+                    add, add_lens[a], output, output, tag, tag_len));
+            TEST_ASSERT_EQUAL_UINT8_ARRAY(plain, output, len);
+
+            /* A flipped bit in the tag */
+            tag[0] ^= 1;
+            TEST_ASSERT_EQUAL(MBEDTLS_ERR_CCM_AUTH_FAILED,
+                    mbedtls_ccm_auth_decrypt(&ctx, len, iv, sizeof(iv),
+                    add, add_lens[a], expected, decrypted, tag, tag_len));
+        }
+    }
+
+    mbedtls_ccm_free(&ctx);
+}
+
+static void gcm_reference(mbedtls_gcm_context *ctx, int mode, size_t len) {
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_crypt_and_tag(ctx, mode, len, iv, 12,
+            add, sizeof(add), plain, expected, 16, expected_tag));
+}
+
+void test_gcm_pieces(void) {
+    mbedtls_gcm_context ctx;
+    const size_t pieces[] = { 1, 5, 16, 7, 17, 32 };
+
+    fill();
+    mbedtls_gcm_init(&ctx);
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_setkey(&ctx, MBEDTLS_CIPHER_ID_AES, key, 128));
+
+    for (int mode = MBEDTLS_GCM_DECRYPT; mode <= MBEDTLS_GCM_ENCRYPT; mode++) {
+        for (size_t len = 0; len <= MAX_LEN; len += 3) {
+            gcm_reference(&ctx, mode, len);
+
+            /* Pieces of varying lengths, the last one in place */
+            TEST_ASSERT_EQUAL(0, mbedtls_gcm_starts(&ctx, mode, iv, 12, add, sizeof(add)));
+            size_t done = 0;
+            for (size_t p = 0; done < len; p++) {
+                size_t n = pieces[p % (sizeof(pieces) / sizeof(pieces[0]))];
+                if (n > len - done) {
+                    n = len - done;
+                    memcpy(output + done, plain + done, n);
+                    TEST_ASSERT_EQUAL(0, mbedtls_gcm_update(&ctx, n, output + done, output + done));
+                } else {
+                    TEST_ASSERT_EQUAL(0, mbedtls_gcm_update(&ctx, n, plain + done, output + done));
+                }
+                done += n;
+            }
+            TEST_ASSERT_EQUAL(0, mbedtls_gcm_finish(&ctx, tag, 16));
+            TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, output, len);
+            TEST_ASSERT_EQUAL_UINT8_ARRAY(expected_tag, tag, 16);
+        }
+    }
+
+    mbedtls_gcm_free(&ctx);
+}
+
+void test_gcm_iov(void) {
+    mbedtls_gcm_context ctx;
+    /* A record header, a short option block and the payload */
+    const size_t len = 13 + 3 + 41;
+    unsigned char header[13], payload[41];
+    mbedtls_gcm_iovec iov[3] = {
+        { plain, header, sizeof(header) },
+        { plain + 13, output + 13, 3 },
+        { plain + 16, payload, sizeof(payload) },
+    };
+
+    fill();
+    mbedtls_gcm_init(&ctx);
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_setkey(&ctx, MBEDTLS_CIPHER_ID_AES, key, 128));
+    gcm_reference(&ctx, MBEDTLS_GCM_ENCRYPT, len);
+
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_starts(&ctx, MBEDTLS_GCM_ENCRYPT, iv, 12, add, sizeof(add)));
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_update_iov(&ctx, iov, 3));
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_finish(&ctx, tag, 16));
+
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, header, sizeof(header));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected + 13, output + 13, 3);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected + 16, payload, sizeof(payload));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected_tag, tag, 16);
+
+    mbedtls_gcm_free(&ctx);
+}
+
+void test_gcm_table(void) {
+    static mbedtls_gcm_table table;
+    mbedtls_gcm_context ctx, shared;
+    unsigned char other_key[16];
+
+    fill();
+    mbedtls_gcm_init(&ctx);
+    mbedtls_gcm_init(&shared);
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_setkey(&ctx, MBEDTLS_CIPHER_ID_AES, key, 128));
+    gcm_reference(&ctx, MBEDTLS_GCM_ENCRYPT, MAX_LEN);
+
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_table_gen(&table, MBEDTLS_CIPHER_ID_AES, key, 128));
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_setkey_table(&shared, MBEDTLS_CIPHER_ID_AES,
+                                                  key, 128, &table));
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_crypt_and_tag(&shared, MBEDTLS_GCM_ENCRYPT, MAX_LEN,
+            iv, 12, add, sizeof(add), plain, output, 16, tag));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, output, MAX_LEN);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected_tag, tag, 16);
+
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_auth_decrypt(&shared, MAX_LEN, iv, 12,
+            add, sizeof(add), tag, 16, output, decrypted));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(plain, decrypted, MAX_LEN);
+
+    /* A table for another key is refused */
+    memcpy(other_key, key, sizeof(other_key));
+    other_key[0] ^= 1;
+    TEST_ASSERT_EQUAL(MBEDTLS_ERR_GCM_BAD_INPUT,
+            mbedtls_gcm_setkey_table(&shared, MBEDTLS_CIPHER_ID_AES, other_key, 128, &table));
+
+    /* setkey goes back to the context's own table */
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_setkey(&shared, MBEDTLS_CIPHER_ID_AES, key, 128));
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_crypt_and_tag(&shared, MBEDTLS_GCM_ENCRYPT, MAX_LEN,
+            iv, 12, add, sizeof(add), plain, output, 16, tag));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected_tag, tag, 16);
+
+    mbedtls_gcm_free(&ctx);
+    mbedtls_gcm_free(&shared);
+}
+
+utest::v1::status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+Case cases[] = {
+    Case("CCM and GCM self tests", test_self_tests, greentea_failure_handler),
+    Case("CCM against a two pass reference", test_ccm_lengths, greentea_failure_handler),
+    Case("GCM update in pieces", test_gcm_pieces, greentea_failure_handler),
+    Case("GCM update over a scatter list", test_gcm_iov, greentea_failure_handler),
+    Case("GCM with a precomputed table", test_gcm_table, greentea_failure_handler),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(20, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+
+int main() {
+    Harness::run(specification);
+}
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Entropy pool with fake sources: a counter that passes the health tests,
+ * a stuck source that must be rejected, and a source that never returns
+ * anything, which get must give up on after its timeout. The pool shared
+ * by mbedtls_hardware_poll() is then read from the target's TRNG.
+ */
+
+#include <string.h>
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+#include "mbedtls/entropy.h"
+#include "mbedtls/entropy_poll.h"
+#include "mbedtls_entropy_pool.h"
+
+#if !defined(MBEDTLS_ENTROPY_POOL)
+  #error [NOT_SUPPORTED] test not supported
+#endif
+
+using namespace utest::v1;
+
+namespace {
+mbedtls_entropy_pool pool;
+unsigned char buf[MBED_CONF_MBEDTLS_ENTROPY_POOL_SIZE + 16];
+unsigned char counter;
+int empty_calls;
+Timer timer;
+}
+
+static int counter_source(void *data, unsigned char *output, size_t len, size_t *olen) {
+    (void)data;
+    for (size_t i = 0; i < len; i++) {
+        output[i] = counter++;
+    }
+    *olen = len;
+    return 0;
+}
+
+static int stuck_source(void *data, unsigned char *output, size_t len, size_t *olen) {
+    (void)data;
+    memset(output, 0x5A, len);
+    *olen = len;
+    return 0;
+}
+
+static int empty_source(void *data, unsigned char *output, size_t len, size_t *olen) {
+    (void)data;
+    (void)output;
+    (void)len;
+    empty_calls++;
+    *olen = 0;
+    return 0;
+}
+
+void test_fill_and_get(void) {
+    size_t olen;
+
+    mbedtls_entropy_pool_init(&pool);
+    TEST_ASSERT_EQUAL(MBEDTLS_ERR_ENTROPY_NO_SOURCES_DEFINED, mbedtls_entropy_pool_fill(&pool));
+    TEST_ASSERT_EQUAL(0, mbedtls_entropy_pool_add_source(&pool, counter_source, NULL));
+
+    while (mbedtls_entropy_pool_available(&pool) < MBED_CONF_MBEDTLS_ENTROPY_POOL_SIZE) {
+        TEST_ASSERT_EQUAL(0, mbedtls_entropy_pool_fill(&pool));
+    }
+    TEST_ASSERT_EQUAL(0, mbedtls_entropy_pool_failures(&pool));
+
+    /* A full pool is not polled again */
+    counter = 0;
+    TEST_ASSERT_EQUAL(0, mbedtls_entropy_pool_fill(&pool));
+    TEST_ASSERT_EQUAL(0, counter);
+
+    TEST_ASSERT_EQUAL(0, mbedtls_entropy_pool_get(&pool, buf, 32, &olen, 0));
+    TEST_ASSERT_EQUAL(32, olen);
+    TEST_ASSERT_EQUAL(MBED_CONF_MBEDTLS_ENTROPY_POOL_SIZE - 32,
+                      mbedtls_entropy_pool_available(&pool));
+
+    /* More than the pool holds is refilled from the source */
+    TEST_ASSERT_EQUAL(0, mbedtls_entropy_pool_get(&pool, buf, sizeof(buf), &olen, 1000));
+    TEST_ASSERT_EQUAL(sizeof(buf), olen);
+
+    mbedtls_entropy_pool_free(&pool);
+}
+
+void test_health_tests(void) {
+    size_t olen;
+
+    mbedtls_entropy_pool_init(&pool);
+    TEST_ASSERT_EQUAL(0, mbedtls_entropy_pool_add_source(&pool, stuck_source, NULL));
+
+    TEST_ASSERT_EQUAL(MBEDTLS_ERR_ENTROPY_SOURCE_FAILED, mbedtls_entropy_pool_fill(&pool));
+    TEST_ASSERT_EQUAL(1, mbedtls_entropy_pool_failures(&pool));
+    TEST_ASSERT_EQUAL(0, mbedtls_entropy_pool_available(&pool));
+
+    /* Nothing from a failing source, even after waiting */
+    TEST_ASSERT_EQUAL(MBEDTLS_ERR_ENTROPY_SOURCE_FAILED,
+                      mbedtls_entropy_pool_get(&pool, buf, 16, &olen, 10));
+    TEST_ASSERT_EQUAL(0, olen);
+
+    /* A good source next to it still gets through */
+    TEST_ASSERT_EQUAL(0, mbedtls_entropy_pool_add_source(&pool, counter_source, NULL));
+    TEST_ASSERT_EQUAL(MBEDTLS_ERR_ENTROPY_SOURCE_FAILED, mbedtls_entropy_pool_fill(&pool));
+    TEST_ASSERT_EQUAL(MBEDTLS_ENTROPY_POOL_BLOCK, mbedtls_entropy_pool_available(&pool));
+
+    mbedtls_entropy_pool_free(&pool);
+}
+
+void test_max_sources(void) {
+    mbedtls_entropy_pool_init(&pool);
+    for (int i = 0; i < MBEDTLS_ENTROPY_POOL_MAX_SOURCES; i++) {
+        TEST_ASSERT_EQUAL(0, mbedtls_entropy_pool_add_source(&pool, counter_source, NULL));
+    }
+    TEST_ASSERT_EQUAL(MBEDTLS_ERR_ENTROPY_MAX_SOURCES,
+                      mbedtls_entropy_pool_add_source(&pool, counter_source, NULL));
+    mbedtls_entropy_pool_free(&pool);
+}
+
+void test_bounded_latency(void) {
+    size_t olen;
+
+    mbedtls_entropy_pool_init(&pool);
+    TEST_ASSERT_EQUAL(0, mbedtls_entropy_pool_add_source(&pool, counter_source, NULL));
+    TEST_ASSERT_EQUAL(0, mbedtls_entropy_pool_add_source(&pool, empty_source, NULL));
+    TEST_ASSERT_EQUAL(0, mbedtls_entropy_pool_fill(&pool));
+
+    /* Without a wait, only what is already there */
+    empty_calls = 0;
+    TEST_ASSERT_EQUAL(0, mbedtls_entropy_pool_get(&pool, buf, sizeof(buf), &olen, 0));
+    TEST_ASSERT_EQUAL(MBEDTLS_ENTROPY_POOL_BLOCK, olen);
+    TEST_ASSERT_EQUAL(0, empty_calls);
+    mbedtls_entropy_pool_free(&pool);
+
+    /* A source that never delivers holds get up for the timeout only */
+    mbedtls_entropy_pool_init(&pool);
+    TEST_ASSERT_EQUAL(0, mbedtls_entropy_pool_add_source(&pool, empty_source, NULL));
+    timer.reset();
+    timer.start();
+    TEST_ASSERT_EQUAL(MBEDTLS_ERR_ENTROPY_SOURCE_FAILED,
+                      mbedtls_entropy_pool_get(&pool, buf, 16, &olen, 20));
+    timer.stop();
+    TEST_ASSERT_EQUAL(0, olen);
+    TEST_ASSERT(empty_calls > 0);
+    TEST_ASSERT(timer.read_ms() >= 20 && timer.read_ms() < 100);
+    mbedtls_entropy_pool_free(&pool);
+}
+
+void test_shared_pool(void) {
+    mbedtls_entropy_pool *shared = mbedtls_entropy_pool_shared();
+    size_t olen, total = 0;
+
+    TEST_ASSERT_NOT_NULL(shared);
+    TEST_ASSERT(shared == mbedtls_entropy_pool_shared());
+
+    memset(buf, 0, sizeof(buf));
+    while (total < 64) {
+        TEST_ASSERT_EQUAL(0, mbedtls_hardware_poll(NULL, buf + total, 64 - total, &olen));
+        total += olen;
+    }
+    /* 64 zero bytes from a working TRNG would be a 2^-512 event */
+    for (olen = 0; olen < 64 && buf[olen] == 0; olen++);
+    TEST_ASSERT(olen < 64);
+    printf("%u health test failures\r\n", (unsigned)mbedtls_entropy_pool_failures(shared));
+}
+
+utest::v1::status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+Case cases[] = {
+    Case("Fill and take from a pool", test_fill_and_get, greentea_failure_handler),
+    Case("Health tests reject a stuck source", test_health_tests, greentea_failure_handler),
+    Case("Sources per pool", test_max_sources, greentea_failure_handler),
+    Case("Get returns within its timeout", test_bounded_latency, greentea_failure_handler),
+    Case("Shared pool through mbedtls_hardware_poll", test_shared_pool, greentea_failure_handler),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(20, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+
+int main() {
+    Harness::run(specification);
+}
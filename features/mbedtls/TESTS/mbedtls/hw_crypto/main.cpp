@@ -0,0 +1,404 @@
+/*
+ * Copyright (c) 2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Conformance of the AES, SHA and entropy primitives mbed TLS is built
+ * with on this target. The expected values come from FIPS-197, SP 800-38A
+ * and FIPS 180-2 as computed by the software implementation, so the test
+ * passes unchanged whether device_has routes a primitive to the crypto
+ * engine or not. Beyond the vectors it covers what the engine glue has to
+ * get right: chaining state across calls, chunking, in-place and unaligned
+ * buffers.
+ */
+
+#include <string.h>
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+#include "mbedtls/aes.h"
+#include "mbedtls/sha1.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/entropy_poll.h"
+
+using namespace utest::v1;
+
+namespace {
+const uint8_t sp800_key128[16] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+};
+
+const uint8_t sp800_key256[32] = {
+    0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe,
+    0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+    0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7,
+    0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4,
+};
+
+const uint8_t sp800_plain[64] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+    0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,
+    0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11,
+    0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+    0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17,
+    0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10,
+};
+
+const uint8_t sp800_cbc_iv[16] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+};
+
+const uint8_t sp800_cbc128[64] = {
+    0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46,
+    0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+    0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee,
+    0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+    0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b,
+    0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16,
+    0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09,
+    0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7,
+};
+
+const uint8_t sp800_cbc256[64] = {
+    0xf5, 0x8c, 0x4c, 0x04, 0xd6, 0xe5, 0xf1, 0xba,
+    0x77, 0x9e, 0xab, 0xfb, 0x5f, 0x7b, 0xfb, 0xd6,
+    0x9c, 0xfc, 0x4e, 0x96, 0x7e, 0xdb, 0x80, 0x8d,
+    0x67, 0x9f, 0x77, 0x7b, 0xc6, 0x70, 0x2c, 0x7d,
+    0x39, 0xf2, 0x33, 0x69, 0xa9, 0xd9, 0xba, 0xcf,
+    0xa5, 0x30, 0xe2, 0x63, 0x04, 0x23, 0x14, 0x61,
+    0xb2, 0xeb, 0x05, 0xe2, 0xc3, 0x9b, 0xe9, 0xfc,
+    0xda, 0x6c, 0x19, 0x07, 0x8c, 0x6a, 0x9d, 0x1b,
+};
+
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+const uint8_t sp800_ctr_counter[16] = {
+    0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+    0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff,
+};
+
+const uint8_t sp800_ctr128[64] = {
+    0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26,
+    0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+    0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff,
+    0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff,
+    0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3, 0x5e,
+    0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab,
+    0x1e, 0x03, 0x1d, 0xda, 0x2f, 0xbe, 0x03, 0xd1,
+    0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee,
+};
+
+const uint8_t sp800_ctr256[64] = {
+    0x60, 0x1e, 0xc3, 0x13, 0x77, 0x57, 0x89, 0xa5,
+    0xb7, 0xa7, 0xf5, 0x04, 0xbb, 0xf3, 0xd2, 0x28,
+    0xf4, 0x43, 0xe3, 0xca, 0x4d, 0x62, 0xb5, 0x9a,
+    0xca, 0x84, 0xe9, 0x90, 0xca, 0xca, 0xf5, 0xc5,
+    0x2b, 0x09, 0x30, 0xda, 0xa2, 0x3d, 0xe9, 0x4c,
+    0xe8, 0x70, 0x17, 0xba, 0x2d, 0x84, 0x98, 0x8d,
+    0xdf, 0xc9, 0xc5, 0x8d, 0xb6, 0x7a, 0xad, 0xa6,
+    0x13, 0xc2, 0xdd, 0x08, 0x45, 0x79, 0x41, 0xa6,
+};
+#endif
+
+// FIPS 180-2 "abc", the two block message and 1000 times 'a'
+const char *sha_messages[3] = {
+    "abc",
+    "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+    0,
+};
+
+#if defined(MBEDTLS_SHA1_C)
+const uint8_t sha1_digests[3][20] = {
+    {0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a, 0xba, 0x3e,
+     0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c, 0x9c, 0xd0, 0xd8, 0x9d},
+    {0x84, 0x98, 0x3e, 0x44, 0x1c, 0x3b, 0xd2, 0x6e, 0xba, 0xae,
+     0x4a, 0xa1, 0xf9, 0x51, 0x29, 0xe5, 0xe5, 0x46, 0x70, 0xf1},
+    {0x29, 0x1e, 0x9a, 0x6c, 0x66, 0x99, 0x49, 0x49, 0xb5, 0x7b,
+     0xa5, 0xe6, 0x50, 0x36, 0x1e, 0x98, 0xfc, 0x36, 0xb1, 0xba},
+};
+#endif
+
+const uint8_t sha224_digests[3][28] = {
+    {0x23, 0x09, 0x7d, 0x22, 0x34, 0x05, 0xd8, 0x22, 0x86, 0x42,
+     0xa4, 0x77, 0xbd, 0xa2, 0x55, 0xb3, 0x2a, 0xad, 0xbc, 0xe4,
+     0xbd, 0xa0, 0xb3, 0xf7, 0xe3, 0x6c, 0x9d, 0xa7},
+    {0x75, 0x38, 0x8b, 0x16, 0x51, 0x27, 0x76, 0xcc, 0x5d, 0xba,
+     0x5d, 0xa1, 0xfd, 0x89, 0x01, 0x50, 0xb0, 0xc6, 0x45, 0x5c,
+     0xb4, 0xf5, 0x8b, 0x19, 0x52, 0x52, 0x25, 0x25},
+    {0x4e, 0x8f, 0x0c, 0xe9, 0x0b, 0x64, 0x66, 0x1a, 0x2b, 0x5e,
+     0x84, 0xbe, 0x6d, 0x93, 0xa7, 0xd9, 0xb7, 0x68, 0x71, 0x06,
+     0x2f, 0x18, 0x14, 0x43, 0x3d, 0x04, 0xa0, 0x3d},
+};
+
+const uint8_t sha256_digests[3][32] = {
+    {0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+     0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+     0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+     0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad},
+    {0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8,
+     0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+     0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67,
+     0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1},
+    {0x41, 0xed, 0xec, 0xe4, 0x2d, 0x63, 0xe8, 0xd9,
+     0xbf, 0x51, 0x5a, 0x9b, 0xa6, 0x93, 0x2e, 0x1c,
+     0x20, 0xcb, 0xc9, 0xf5, 0xa5, 0xd1, 0x34, 0x64,
+     0x5a, 0xdb, 0x5d, 0xb1, 0xb9, 0x73, 0x7e, 0xa3},
+};
+
+// Room for 64 bytes of data behind a deliberately misaligned start
+uint32_t work_buffer[20];
+uint8_t sha_buffer[1001];
+
+uint8_t *unaligned(void) {
+    return reinterpret_cast<uint8_t *>(work_buffer) + 1;
+}
+
+size_t sha_message(int i, const uint8_t **message) {
+    if (sha_messages[i]) {
+        *message = reinterpret_cast<const uint8_t *>(sha_messages[i]);
+        return strlen(sha_messages[i]);
+    }
+
+    // Offset by one so blocks reach the compression function unaligned
+    memset(sha_buffer + 1, 'a', 1000);
+    *message = sha_buffer + 1;
+    return 1000;
+}
+}
+
+void test_aes_ecb() {
+    const uint8_t plain[16] = {
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+        0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff,
+    };
+    const uint8_t expected[2][16] = {
+        {0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+         0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a},
+        {0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf,
+         0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89},
+    };
+
+    uint8_t key[32];
+    for (int i = 0; i < 32; i++) {
+        key[i] = i;
+    }
+
+    for (int k = 0; k < 2; k++) {
+        unsigned keybits = k ? 256 : 128;
+        mbedtls_aes_context ctx;
+        uint8_t out[16];
+
+        mbedtls_aes_init(&ctx);
+        TEST_ASSERT_EQUAL(0, mbedtls_aes_setkey_enc(&ctx, key, keybits));
+        TEST_ASSERT_EQUAL(0, mbedtls_aes_crypt_ecb(&ctx, MBEDTLS_AES_ENCRYPT, plain, out));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected[k], out, 16);
+
+        // In place through an unaligned buffer
+        memcpy(unaligned(), plain, 16);
+        TEST_ASSERT_EQUAL(0, mbedtls_aes_crypt_ecb(&ctx, MBEDTLS_AES_ENCRYPT, unaligned(), unaligned()));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected[k], unaligned(), 16);
+
+        TEST_ASSERT_EQUAL(0, mbedtls_aes_setkey_dec(&ctx, key, keybits));
+        TEST_ASSERT_EQUAL(0, mbedtls_aes_crypt_ecb(&ctx, MBEDTLS_AES_DECRYPT, expected[k], out));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(plain, out, 16);
+        mbedtls_aes_free(&ctx);
+    }
+}
+
+void test_aes_cbc() {
+    for (int k = 0; k < 2; k++) {
+        const uint8_t *key = k ? sp800_key256 : sp800_key128;
+        const uint8_t *expected = k ? sp800_cbc256 : sp800_cbc128;
+        unsigned keybits = k ? 256 : 128;
+        mbedtls_aes_context ctx;
+        uint8_t iv[16];
+        uint8_t out[64];
+
+        mbedtls_aes_init(&ctx);
+        TEST_ASSERT_EQUAL(0, mbedtls_aes_setkey_enc(&ctx, key, keybits));
+
+        memcpy(iv, sp800_cbc_iv, 16);
+        TEST_ASSERT_EQUAL(0, mbedtls_aes_crypt_cbc(&ctx, MBEDTLS_AES_ENCRYPT, 64, iv, sp800_plain, out));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, out, 64);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected + 48, iv, 16);
+
+        // The chaining value has to carry over between calls
+        memcpy(iv, sp800_cbc_iv, 16);
+        TEST_ASSERT_EQUAL(0, mbedtls_aes_crypt_cbc(&ctx, MBEDTLS_AES_ENCRYPT, 16, iv, sp800_plain, out));
+        TEST_ASSERT_EQUAL(0, mbedtls_aes_crypt_cbc(&ctx, MBEDTLS_AES_ENCRYPT, 48, iv, sp800_plain + 16, out + 16));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, out, 64);
+
+        TEST_ASSERT_EQUAL(MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH,
+                mbedtls_aes_crypt_cbc(&ctx, MBEDTLS_AES_ENCRYPT, 15, iv, sp800_plain, out));
+
+        TEST_ASSERT_EQUAL(0, mbedtls_aes_setkey_dec(&ctx, key, keybits));
+
+        // In place and unaligned, the way records are decrypted
+        memcpy(unaligned(), expected, 64);
+        memcpy(iv, sp800_cbc_iv, 16);
+        TEST_ASSERT_EQUAL(0, mbedtls_aes_crypt_cbc(&ctx, MBEDTLS_AES_DECRYPT, 32, iv, unaligned(), unaligned()));
+        TEST_ASSERT_EQUAL(0, mbedtls_aes_crypt_cbc(&ctx, MBEDTLS_AES_DECRYPT, 32, iv, unaligned() + 32, unaligned() + 32));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(sp800_plain, unaligned(), 64);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected + 48, iv, 16);
+        mbedtls_aes_free(&ctx);
+    }
+}
+
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+void test_aes_ctr() {
+    // Splits that start and end mid block as well as on block boundaries
+    const size_t splits[] = {64, 1, 5, 16, 27, 32, 63};
+
+    for (int k = 0; k < 2; k++) {
+        const uint8_t *key = k ? sp800_key256 : sp800_key128;
+        const uint8_t *expected = k ? sp800_ctr256 : sp800_ctr128;
+        unsigned keybits = k ? 256 : 128;
+        mbedtls_aes_context ctx;
+
+        mbedtls_aes_init(&ctx);
+        TEST_ASSERT_EQUAL(0, mbedtls_aes_setkey_enc(&ctx, key, keybits));
+
+        for (unsigned s = 0; s < sizeof splits / sizeof splits[0]; s++) {
+            uint8_t counter[16];
+            uint8_t stream[16];
+            size_t offset = 0;
+
+            memcpy(counter, sp800_ctr_counter, 16);
+            memcpy(unaligned(), sp800_plain, 64);
+
+            for (size_t i = 0; i < 64; i += splits[s]) {
+                size_t n = 64 - i < splits[s] ? 64 - i : splits[s];
+                TEST_ASSERT_EQUAL(0, mbedtls_aes_crypt_ctr(&ctx, n, &offset, counter, stream,
+                        unaligned() + i, unaligned() + i));
+            }
+
+            TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, unaligned(), 64);
+        }
+        mbedtls_aes_free(&ctx);
+    }
+}
+#endif
+
+#if defined(MBEDTLS_SHA1_C)
+void test_sha1() {
+    for (int i = 0; i < 3; i++) {
+        const uint8_t *message;
+        size_t size = sha_message(i, &message);
+        mbedtls_sha1_context ctx;
+        uint8_t digest[20];
+
+        mbedtls_sha1(message, size, digest);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(sha1_digests[i], digest, 20);
+
+        // Odd sized updates leave partial blocks in the context
+        mbedtls_sha1_init(&ctx);
+        mbedtls_sha1_starts(&ctx);
+        for (size_t j = 0; j < size; j += 7) {
+            mbedtls_sha1_update(&ctx, message + j, size - j < 7 ? size - j : 7);
+        }
+        mbedtls_sha1_finish(&ctx, digest);
+        mbedtls_sha1_free(&ctx);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(sha1_digests[i], digest, 20);
+    }
+}
+#endif
+
+void test_sha256() {
+    for (int i = 0; i < 3; i++) {
+        const uint8_t *message;
+        size_t size = sha_message(i, &message);
+        mbedtls_sha256_context ctx, clone;
+        uint8_t digest[32];
+
+        mbedtls_sha256(message, size, digest, 0);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(sha256_digests[i], digest, 32);
+        mbedtls_sha256(message, size, digest, 1);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(sha224_digests[i], digest, 28);
+
+        // A clone taken halfway has to finish on its own
+        mbedtls_sha256_init(&ctx);
+        mbedtls_sha256_init(&clone);
+        mbedtls_sha256_starts(&ctx, 0);
+        for (size_t j = 0; j < size; j += 7) {
+            if (j == size / 2 / 7 * 7) {
+                mbedtls_sha256_clone(&clone, &ctx);
+            }
+            mbedtls_sha256_update(&ctx, message + j, size - j < 7 ? size - j : 7);
+        }
+        mbedtls_sha256_finish(&ctx, digest);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(sha256_digests[i], digest, 32);
+
+        size_t half = size / 2 / 7 * 7;
+        mbedtls_sha256_update(&clone, message + half, size - half);
+        mbedtls_sha256_finish(&clone, digest);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(sha256_digests[i], digest, 32);
+
+        mbedtls_sha256_free(&ctx);
+        mbedtls_sha256_free(&clone);
+    }
+}
+
+#if defined(MBEDTLS_ENTROPY_HARDWARE_ALT)
+void test_hardware_poll() {
+    uint8_t first[32];
+    uint8_t second[32];
+    size_t olen;
+
+    TEST_ASSERT_EQUAL(0, mbedtls_hardware_poll(NULL, first, sizeof first, &olen));
+    TEST_ASSERT_EQUAL(sizeof first, olen);
+    TEST_ASSERT_EQUAL(0, mbedtls_hardware_poll(NULL, second, sizeof second, &olen));
+    TEST_ASSERT_EQUAL(sizeof second, olen);
+
+    // Not a statistical test, just a check the generator is running
+    TEST_ASSERT(memcmp(first, second, sizeof first) != 0);
+}
+#endif
+
+utest::v1::status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+Case cases[] = {
+    Case("AES-ECB known answers", test_aes_ecb, greentea_failure_handler),
+    Case("AES-CBC known answers and chaining", test_aes_cbc, greentea_failure_handler),
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+    Case("AES-CTR known answers and partial blocks", test_aes_ctr, greentea_failure_handler),
+#endif
+#if defined(MBEDTLS_SHA1_C)
+    Case("SHA-1 known answers", test_sha1, greentea_failure_handler),
+#endif
+    Case("SHA-224/256 known answers", test_sha256, greentea_failure_handler),
+#if defined(MBEDTLS_ENTROPY_HARDWARE_ALT)
+    Case("Hardware entropy source", test_hardware_poll, greentea_failure_handler),
+#endif
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(20, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+
+int main() {
+    Harness::run(specification);
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Cross-check of the bignum multiply kernel selected in bn_mul.h for the
+ * target. Products are compared with a byte-wise schoolbook multiply that
+ * does not share any code with bignum.c, over sizes that go through the
+ * 16, 8 and single word loops of mpi_mul_hlp(), and modular exponentiation
+ * (Montgomery multiplication) is compared with plain multiply and reduce.
+ */
+
+#include <string.h>
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+#include "mbedtls/bignum.h"
+
+#if !defined(MBEDTLS_BIGNUM_C)
+  #error [NOT_SUPPORTED] test not supported
+#endif
+
+using namespace utest::v1;
+
+namespace {
+/* Up to 75 words of 32 bits, past RSA-2048 and the 16 word loop */
+const size_t MAX_BYTES = 300;
+
+unsigned char a[MAX_BYTES], b[MAX_BYTES];
+unsigned char expected[2 * MAX_BYTES], product[2 * MAX_BYTES];
+uint32_t seed = 0x12345678;
+}
+
+static uint32_t next_random(void) {
+    /* xorshift32, the vectors only need to be reproducible */
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+/*
+ * Fill with random bytes, all ones, or sparse bytes, which are the patterns
+ * that exercise the carries of the kernels
+ */
+static void fill(unsigned char *buf, size_t len, int pattern) {
+    for (size_t i = 0; i < len; i++) {
+        switch (pattern) {
+        case 0:  buf[i] = (unsigned char)next_random(); break;
+        case 1:  buf[i] = 0xFF; break;
+        default: buf[i] = (next_random() & 7) ? 0x00 : 0xFF; break;
+        }
+    }
+    /* Keep the operands at their full length */
+    buf[0] |= 0x80;
+}
+
+/* Big-endian schoolbook multiply, out has alen + blen bytes */
+static void reference_mul(const unsigned char *x, size_t xlen,
+                          const unsigned char *y, size_t ylen,
+                          unsigned char *out) {
+    memset(out, 0, xlen + ylen);
+    for (size_t i = xlen; i-- > 0;) {
+        uint32_t carry = 0;
+        for (size_t j = ylen; j-- > 0;) {
+            uint32_t t = out[i + j + 1] + (uint32_t)x[i] * y[j] + carry;
+            out[i + j + 1] = (unsigned char)t;
+            carry = t >> 8;
+        }
+        out[i] = (unsigned char)carry;
+    }
+}
+
+static void check_mul(size_t alen, size_t blen, int pattern) {
+    mbedtls_mpi A, B, X;
+
+    fill(a, alen, pattern);
+    fill(b, blen, pattern);
+    reference_mul(a, alen, b, blen, expected);
+
+    mbedtls_mpi_init(&A);
+    mbedtls_mpi_init(&B);
+    mbedtls_mpi_init(&X);
+    TEST_ASSERT_EQUAL(0, mbedtls_mpi_read_binary(&A, a, alen));
+    TEST_ASSERT_EQUAL(0, mbedtls_mpi_read_binary(&B, b, blen));
+    TEST_ASSERT_EQUAL(0, mbedtls_mpi_mul_mpi(&X, &A, &B));
+    TEST_ASSERT_EQUAL(0, mbedtls_mpi_write_binary(&X, product, alen + blen));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, product, alen + blen);
+
+    mbedtls_mpi_free(&A);
+    mbedtls_mpi_free(&B);
+    mbedtls_mpi_free(&X);
+}
+
+void test_mul_sizes(void) {
+    for (size_t len = 1; len <= MAX_BYTES; len += (len < 72) ? 1 : 29) {
+        for (int pattern = 0; pattern < 3; pattern++) {
+            check_mul(len, len, pattern);
+            check_mul(len, 1 + len / 3, pattern);
+        }
+    }
+}
+
+void test_mul_int(void) {
+    mbedtls_mpi A, X;
+    const mbedtls_mpi_sint factors[] = { 1, 3, 0xFFFF, 0x7FFFFFFF };
+
+    mbedtls_mpi_init(&A);
+    mbedtls_mpi_init(&X);
+    for (size_t i = 0; i < sizeof(factors) / sizeof(factors[0]); i++) {
+        unsigned char f[4] = {
+            (unsigned char)(factors[i] >> 24), (unsigned char)(factors[i] >> 16),
+            (unsigned char)(factors[i] >> 8), (unsigned char)factors[i],
+        };
+
+        fill(a, 256, i & 1);
+        reference_mul(a, 256, f, sizeof(f), expected);
+
+        TEST_ASSERT_EQUAL(0, mbedtls_mpi_read_binary(&A, a, 256));
+        TEST_ASSERT_EQUAL(0, mbedtls_mpi_mul_int(&X, &A, factors[i]));
+        TEST_ASSERT_EQUAL(0, mbedtls_mpi_write_binary(&X, product, 256 + sizeof(f)));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, product, 256 + sizeof(f));
+    }
+    mbedtls_mpi_free(&A);
+    mbedtls_mpi_free(&X);
+}
+
+void test_exp_mod(void) {
+    mbedtls_mpi A, E, N, X, Y;
+    const size_t sizes[] = { 32, 48, 128, 256 };
+
+    mbedtls_mpi_init(&A);
+    mbedtls_mpi_init(&E);
+    mbedtls_mpi_init(&N);
+    mbedtls_mpi_init(&X);
+    mbedtls_mpi_init(&Y);
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        /* Montgomery multiplication needs an odd modulus */
+        fill(b, sizes[i], 0);
+        b[sizes[i] - 1] |= 1;
+        fill(a, sizes[i], 2);
+        a[0] &= 0x7F;
+
+        TEST_ASSERT_EQUAL(0, mbedtls_mpi_read_binary(&N, b, sizes[i]));
+        TEST_ASSERT_EQUAL(0, mbedtls_mpi_read_binary(&A, a, sizes[i]));
+        TEST_ASSERT_EQUAL(0, mbedtls_mpi_lset(&E, 65537));
+        TEST_ASSERT_EQUAL(0, mbedtls_mpi_exp_mod(&X, &A, &E, &N, NULL));
+
+        /* A^65537 = A^(2^16) * A, by multiply and reduce */
+        TEST_ASSERT_EQUAL(0, mbedtls_mpi_copy(&Y, &A));
+        for (int j = 0; j < 16; j++) {
+            TEST_ASSERT_EQUAL(0, mbedtls_mpi_mul_mpi(&Y, &Y, &Y));
+            TEST_ASSERT_EQUAL(0, mbedtls_mpi_mod_mpi(&Y, &Y, &N));
+        }
+        TEST_ASSERT_EQUAL(0, mbedtls_mpi_mul_mpi(&Y, &Y, &A));
+        TEST_ASSERT_EQUAL(0, mbedtls_mpi_mod_mpi(&Y, &Y, &N));
+
+        TEST_ASSERT_EQUAL(0, mbedtls_mpi_cmp_mpi(&X, &Y));
+    }
+
+    mbedtls_mpi_free(&A);
+    mbedtls_mpi_free(&E);
+    mbedtls_mpi_free(&N);
+    mbedtls_mpi_free(&X);
+    mbedtls_mpi_free(&Y);
+}
+
+utest::v1::status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+Case cases[] = {
+    Case("Multiply against schoolbook reference", test_mul_sizes, greentea_failure_handler),
+    Case("Multiply by a word", test_mul_int, greentea_failure_handler),
+    Case("Montgomery exponentiation against multiply and reduce", test_exp_mod, greentea_failure_handler),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(60, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+
+int main() {
+    Harness::run(specification);
+}
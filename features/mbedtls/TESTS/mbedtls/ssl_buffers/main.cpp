@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Memory profile of the TLS record buffers. A client and a server talk
+ * PSK over in-memory pipes, and the record buffer RAM held by each
+ * connection is reported at every stage: full size during the handshake,
+ * shrunk to the negotiated maximum fragment length, released while idle
+ * and with the server connections sharing one output buffer.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+/* Defines mbedtls_time_t, which ssl.h uses */
+#include "mbedtls/platform.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/ssl_internal.h"
+
+#if !defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH) || \
+    !defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH) || \
+    !defined(MBEDTLS_KEY_EXCHANGE_PSK_ENABLED)
+  #error [NOT_SUPPORTED] test not supported
+#endif
+
+using namespace utest::v1;
+
+namespace {
+const int CONNECTIONS = 3;
+const size_t MESSAGE_SIZE = 1200;
+
+/* One direction of a connection, large enough for a whole flight */
+struct pipe_t {
+    unsigned char data[2048];
+    size_t len;
+};
+
+struct endpoint_t {
+    pipe_t *in;
+    pipe_t *out;
+};
+
+struct connection_t {
+    pipe_t c2s, s2c;
+    endpoint_t client_end, server_end;
+    mbedtls_ssl_context client, server;
+};
+
+const unsigned char psk[16] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+    0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff,
+};
+const unsigned char psk_identity[] = "ssl_buffers";
+
+mbedtls_ssl_config client_conf, server_conf;
+mbedtls_ssl_shared_buf shared;
+unsigned char shared_storage[MBEDTLS_SSL_BUFFER_OVERHEAD + 512];
+connection_t connections[CONNECTIONS];
+unsigned char message[MESSAGE_SIZE], received[MESSAGE_SIZE];
+}
+
+static int pipe_send(void *ctx, const unsigned char *buf, size_t len) {
+    pipe_t *out = static_cast<endpoint_t *>(ctx)->out;
+    if (len > sizeof(out->data) - out->len) {
+        len = sizeof(out->data) - out->len;
+    }
+    if (len == 0) {
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+    }
+    memcpy(out->data + out->len, buf, len);
+    out->len += len;
+    return len;
+}
+
+static int pipe_recv(void *ctx, unsigned char *buf, size_t len) {
+    pipe_t *in = static_cast<endpoint_t *>(ctx)->in;
+    if (in->len == 0) {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+    if (len > in->len) {
+        len = in->len;
+    }
+    memcpy(buf, in->data, len);
+    memmove(in->data, in->data + len, in->len - len);
+    in->len -= len;
+    return len;
+}
+
+/* Only the buffer sizes matter here, not the quality of the keys */
+static int test_rng(void *, unsigned char *output, size_t len) {
+    while (len--) {
+        *output++ = rand();
+    }
+    return 0;
+}
+
+/* Record buffer RAM owned by a connection, the shared buffer excluded */
+static size_t buffer_ram(const mbedtls_ssl_context *ssl) {
+    size_t ram = 0;
+    if (ssl->in_buf != NULL) {
+        ram += ssl->in_buf_len;
+    }
+    if (ssl->out_buf != NULL && ssl->out_buf != shared.buf) {
+        ram += ssl->out_buf_len;
+    }
+    return ram;
+}
+
+static void report(const char *stage, connection_t *conn) {
+    printf("%-32s client %6u bytes, server %6u bytes\r\n", stage,
+           (unsigned)buffer_ram(&conn->client),
+           (unsigned)buffer_ram(&conn->server));
+}
+
+static void setup_conf(mbedtls_ssl_config *conf, int endpoint) {
+    mbedtls_ssl_config_init(conf);
+    TEST_ASSERT_EQUAL(0, mbedtls_ssl_config_defaults(conf, endpoint,
+                         MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT));
+    mbedtls_ssl_conf_rng(conf, test_rng, NULL);
+    TEST_ASSERT_EQUAL(0, mbedtls_ssl_conf_psk(conf, psk, sizeof(psk),
+                         psk_identity, sizeof(psk_identity) - 1));
+}
+
+static void connect(connection_t *conn) {
+    memset(conn, 0, sizeof(*conn));
+    conn->client_end.in = &conn->s2c;
+    conn->client_end.out = &conn->c2s;
+    conn->server_end.in = &conn->c2s;
+    conn->server_end.out = &conn->s2c;
+
+    mbedtls_ssl_init(&conn->client);
+    mbedtls_ssl_init(&conn->server);
+    TEST_ASSERT_EQUAL(0, mbedtls_ssl_setup(&conn->client, &client_conf));
+    TEST_ASSERT_EQUAL(0, mbedtls_ssl_setup(&conn->server, &server_conf));
+    mbedtls_ssl_set_bio(&conn->client, &conn->client_end, pipe_send, pipe_recv, NULL);
+    mbedtls_ssl_set_bio(&conn->server, &conn->server_end, pipe_send, pipe_recv, NULL);
+
+    for (int i = 0; i < 100; i++) {
+        int client_ret = mbedtls_ssl_handshake(&conn->client);
+        int server_ret = mbedtls_ssl_handshake(&conn->server);
+        if (client_ret == 0 && server_ret == 0) {
+            return;
+        }
+        TEST_ASSERT(client_ret == 0 || client_ret == MBEDTLS_ERR_SSL_WANT_READ);
+        TEST_ASSERT(server_ret == 0 || server_ret == MBEDTLS_ERR_SSL_WANT_READ);
+    }
+    TEST_FAIL_MESSAGE("handshake did not complete");
+}
+
+static void disconnect(connection_t *conn) {
+    mbedtls_ssl_free(&conn->client);
+    mbedtls_ssl_free(&conn->server);
+}
+
+/* Send a message that spans several records when a fragment length is set */
+static void transfer(mbedtls_ssl_context *from, mbedtls_ssl_context *to) {
+    size_t sent = 0, got = 0;
+
+    for (size_t i = 0; i < MESSAGE_SIZE; i++) {
+        message[i] = (unsigned char)(i * 7 + rand());
+    }
+
+    for (int i = 0; got < MESSAGE_SIZE && i < 100; i++) {
+        if (sent < MESSAGE_SIZE) {
+            int ret = mbedtls_ssl_write(from, message + sent, MESSAGE_SIZE - sent);
+            TEST_ASSERT(ret > 0);
+            sent += ret;
+        }
+        int ret = mbedtls_ssl_read(to, received + got, MESSAGE_SIZE - got);
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ) {
+            TEST_ASSERT(ret > 0);
+            got += ret;
+        }
+    }
+
+    TEST_ASSERT_EQUAL(MESSAGE_SIZE, got);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(message, received, MESSAGE_SIZE);
+}
+
+void test_full_size() {
+    connection_t *conn = &connections[0];
+
+    setup_conf(&client_conf, MBEDTLS_SSL_IS_CLIENT);
+    setup_conf(&server_conf, MBEDTLS_SSL_IS_SERVER);
+
+    connect(conn);
+    report("no max fragment length", conn);
+    TEST_ASSERT_EQUAL(2 * MBEDTLS_SSL_BUFFER_LEN, buffer_ram(&conn->client));
+    TEST_ASSERT_EQUAL(2 * MBEDTLS_SSL_BUFFER_LEN, buffer_ram(&conn->server));
+
+    transfer(&conn->client, &conn->server);
+    transfer(&conn->server, &conn->client);
+
+    disconnect(conn);
+    mbedtls_ssl_config_free(&client_conf);
+    mbedtls_ssl_config_free(&server_conf);
+}
+
+void test_max_fragment_length() {
+    connection_t *conn = &connections[0];
+    const size_t shrunk = 2 * (MBEDTLS_SSL_BUFFER_OVERHEAD + 512);
+
+    setup_conf(&client_conf, MBEDTLS_SSL_IS_CLIENT);
+    setup_conf(&server_conf, MBEDTLS_SSL_IS_SERVER);
+    TEST_ASSERT_EQUAL(0, mbedtls_ssl_conf_max_frag_len(&client_conf,
+                         MBEDTLS_SSL_MAX_FRAG_LEN_512));
+
+    connect(conn);
+    report("max fragment length 512", conn);
+    TEST_ASSERT_EQUAL(shrunk, buffer_ram(&conn->client));
+    TEST_ASSERT_EQUAL(shrunk, buffer_ram(&conn->server));
+
+    transfer(&conn->client, &conn->server);
+    transfer(&conn->server, &conn->client);
+    TEST_ASSERT_EQUAL(shrunk, buffer_ram(&conn->client));
+    TEST_ASSERT_EQUAL(shrunk, buffer_ram(&conn->server));
+
+    disconnect(conn);
+}
+
+void test_release() {
+    connection_t *conn = &connections[0];
+
+    connect(conn);
+    TEST_ASSERT_EQUAL(0, mbedtls_ssl_release_buffers(&conn->client));
+    TEST_ASSERT_EQUAL(0, mbedtls_ssl_release_buffers(&conn->server));
+    report("idle, buffers released", conn);
+    TEST_ASSERT_EQUAL(0, buffer_ram(&conn->client));
+    TEST_ASSERT_EQUAL(0, buffer_ram(&conn->server));
+
+    /* Allocated again on demand, the connection carries on */
+    transfer(&conn->client, &conn->server);
+    transfer(&conn->server, &conn->client);
+    report("active again", conn);
+
+    /* Not idle while a record is half read */
+    TEST_ASSERT(mbedtls_ssl_write(&conn->client, message, 100) > 0);
+    TEST_ASSERT(mbedtls_ssl_read(&conn->server, received, 10) > 0);
+    TEST_ASSERT_EQUAL(MBEDTLS_ERR_SSL_BAD_INPUT_DATA,
+                      mbedtls_ssl_release_buffers(&conn->server));
+    TEST_ASSERT(mbedtls_ssl_read(&conn->server, received, 90) > 0);
+    TEST_ASSERT_EQUAL(0, mbedtls_ssl_release_buffers(&conn->server));
+
+    disconnect(conn);
+}
+
+void test_shared_out_buf() {
+    mbedtls_ssl_shared_buf_init(&shared, shared_storage, sizeof(shared_storage));
+    mbedtls_ssl_conf_shared_out_buf(&server_conf, &shared);
+
+    for (int i = 0; i < CONNECTIONS; i++) {
+        connect(&connections[i]);
+        TEST_ASSERT_EQUAL(0, mbedtls_ssl_release_buffers(&connections[i].server));
+    }
+
+    /* Connections take turns with the shared buffer */
+    for (int i = 0; i < CONNECTIONS; i++) {
+        connection_t *conn = &connections[i];
+
+        transfer(&conn->client, &conn->server);
+        transfer(&conn->server, &conn->client);
+        TEST_ASSERT(conn->server.out_buf == shared.buf);
+        report("server sending, shared output", conn);
+
+        TEST_ASSERT_EQUAL(0, mbedtls_ssl_release_buffers(&conn->server));
+        TEST_ASSERT(shared.owner == NULL);
+    }
+
+    /* Busy shared buffer: fall back to a private one */
+    transfer(&connections[0].server, &connections[0].client);
+    transfer(&connections[1].server, &connections[1].client);
+    TEST_ASSERT(connections[0].server.out_buf == shared.buf);
+    TEST_ASSERT(connections[1].server.out_buf != shared.buf);
+    TEST_ASSERT(connections[1].server.out_buf != NULL);
+
+    size_t total = 0;
+    for (int i = 0; i < CONNECTIONS; i++) {
+        total += buffer_ram(&connections[i].server);
+        disconnect(&connections[i]);
+    }
+    printf("%d server connections: %u bytes of record buffers, %u shared\r\n",
+           CONNECTIONS, (unsigned)total, (unsigned)sizeof(shared_storage));
+
+    TEST_ASSERT(shared.owner == NULL);
+    mbedtls_ssl_shared_buf_free(&shared);
+    mbedtls_ssl_config_free(&client_conf);
+    mbedtls_ssl_config_free(&server_conf);
+}
+
+utest::v1::status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+Case cases[] = {
+    Case("Full size buffers", test_full_size, greentea_failure_handler),
+    Case("Buffers sized by max fragment length", test_max_fragment_length, greentea_failure_handler),
+    Case("Buffers released while idle", test_release, greentea_failure_handler),
+    Case("Output buffer shared by idle connections", test_shared_out_buf, greentea_failure_handler),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(60, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+
+int main() {
+    Harness::run(specification);
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Certificates used from where they are stored. The test certificates are
+ * turned into DER arrays standing in for certificates in flash, then
+ * parsed without copies and used as a trust store through the trusted CA
+ * callback. The verification results must match those of a parsed CA
+ * chain, whatever the validity dates of the test certificates: an expired
+ * CA is not trusted either way.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+/* Defines mbedtls_time_t, which x509_crt.h uses */
+#include "mbedtls/platform.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/certs.h"
+
+#if !defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK) || \
+    !defined(MBEDTLS_CERTS_C) || !defined(MBEDTLS_PEM_PARSE_C)
+  #error [NOT_SUPPORTED] test not supported
+#endif
+
+using namespace utest::v1;
+
+namespace {
+const size_t MAX_CAS = 2;
+
+/* DER copies of the test certificates */
+unsigned char *ca_der[MAX_CAS];
+size_t ca_der_len[MAX_CAS];
+size_t ca_count;
+unsigned char *srv_der;
+size_t srv_der_len;
+
+/* Candidates handed out by the last verification */
+size_t lookups, candidates;
+}
+
+static unsigned char *pem_to_der(const char *pem, size_t *len) {
+    mbedtls_x509_crt crt;
+    unsigned char *der;
+
+    mbedtls_x509_crt_init(&crt);
+    TEST_ASSERT_EQUAL(0, mbedtls_x509_crt_parse(&crt,
+            (const unsigned char *)pem, strlen(pem) + 1));
+
+    der = (unsigned char *)malloc(crt.raw.len);
+    TEST_ASSERT_NOT_NULL(der);
+    memcpy(der, crt.raw.p, crt.raw.len);
+    *len = crt.raw.len;
+
+    mbedtls_x509_crt_free(&crt);
+    return der;
+}
+
+/* mbedtls_x509_crt_ca_bundle_cb(), counting what it parses */
+static int counting_ca_cb(void *p_bundle, mbedtls_x509_crt const *child,
+                          mbedtls_x509_crt **cas) {
+    int ret = mbedtls_x509_crt_ca_bundle_cb(p_bundle, child, cas);
+
+    lookups++;
+    for (mbedtls_x509_crt *crt = *cas; crt != NULL; crt = crt->next) {
+        TEST_ASSERT_EQUAL(0, crt->own_buffer);
+        candidates++;
+    }
+    return ret;
+}
+
+/* Flags of verifying the server certificate against a parsed CA chain */
+static uint32_t reference_flags(void) {
+    mbedtls_x509_crt srv, ca;
+    uint32_t flags = 0;
+
+    mbedtls_x509_crt_init(&srv);
+    mbedtls_x509_crt_init(&ca);
+    TEST_ASSERT_EQUAL(0, mbedtls_x509_crt_parse_der(&srv, srv_der, srv_der_len));
+    TEST_ASSERT_EQUAL(0, mbedtls_x509_crt_parse(&ca,
+            (const unsigned char *)mbedtls_test_ca_crt,
+            strlen(mbedtls_test_ca_crt) + 1));
+
+    mbedtls_x509_crt_verify_with_profile(&srv, &ca, NULL,
+            &mbedtls_x509_crt_profile_default, NULL, &flags, NULL, NULL);
+
+    mbedtls_x509_crt_free(&ca);
+    mbedtls_x509_crt_free(&srv);
+    return flags;
+}
+
+static uint32_t verify_with_bundle(mbedtls_x509_crt_ca_bundle *bundle, int *ret) {
+    mbedtls_x509_crt srv;
+    uint32_t flags = 0;
+
+    mbedtls_x509_crt_init(&srv);
+    TEST_ASSERT_EQUAL(0, mbedtls_x509_crt_parse_der_nocopy(&srv, srv_der, srv_der_len));
+
+    lookups = candidates = 0;
+    *ret = mbedtls_x509_crt_verify_with_ca_cb(&srv, counting_ca_cb, bundle,
+            &mbedtls_x509_crt_profile_default, NULL, &flags, NULL, NULL);
+
+    mbedtls_x509_crt_free(&srv);
+    return flags;
+}
+
+void test_setup_der(void) {
+    for (ca_count = 0; mbedtls_test_cas[ca_count] != NULL; ca_count++) {
+        TEST_ASSERT(ca_count < MAX_CAS);
+        ca_der[ca_count] = pem_to_der(mbedtls_test_cas[ca_count],
+                                      &ca_der_len[ca_count]);
+    }
+    srv_der = pem_to_der(mbedtls_test_srv_crt, &srv_der_len);
+}
+
+void test_parse_nocopy(void) {
+    mbedtls_x509_crt copy, nocopy;
+
+    mbedtls_x509_crt_init(&copy);
+    mbedtls_x509_crt_init(&nocopy);
+    TEST_ASSERT_EQUAL(0, mbedtls_x509_crt_parse_der(&copy, srv_der, srv_der_len));
+    TEST_ASSERT_EQUAL(0, mbedtls_x509_crt_parse_der_nocopy(&nocopy, srv_der, srv_der_len));
+
+    TEST_ASSERT_EQUAL(1, copy.own_buffer);
+    TEST_ASSERT(copy.raw.p != srv_der);
+    TEST_ASSERT_EQUAL(0, nocopy.own_buffer);
+    TEST_ASSERT(nocopy.raw.p == srv_der);
+    TEST_ASSERT(nocopy.subject_raw.p >= srv_der &&
+                nocopy.subject_raw.p < srv_der + srv_der_len);
+
+    TEST_ASSERT_EQUAL(copy.raw.len, nocopy.raw.len);
+    TEST_ASSERT_EQUAL(copy.version, nocopy.version);
+    TEST_ASSERT_EQUAL(copy.subject_raw.len, nocopy.subject_raw.len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(copy.subject_raw.p, nocopy.subject_raw.p,
+                                  copy.subject_raw.len);
+
+    /* Freeing leaves the caller's DER alone */
+    mbedtls_x509_crt_free(&nocopy);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(copy.raw.p, srv_der, srv_der_len);
+    mbedtls_x509_crt_free(&copy);
+}
+
+void test_verify_bundle(void) {
+    mbedtls_x509_crt_ca_bundle bundle = { ca_der, ca_der_len, ca_count };
+    uint32_t expected = reference_flags();
+    uint32_t flags;
+    int ret;
+
+    flags = verify_with_bundle(&bundle, &ret);
+    TEST_ASSERT_EQUAL_HEX32(expected, flags);
+    TEST_ASSERT_EQUAL(expected ? MBEDTLS_ERR_X509_CERT_VERIFY_FAILED : 0, ret);
+
+    /* Only the issuer was parsed out of the bundle */
+    TEST_ASSERT_EQUAL(1, lookups);
+    TEST_ASSERT_EQUAL(1, candidates);
+    printf("%u trusted CAs, %u parsed\r\n", (unsigned)ca_count,
+           (unsigned)candidates);
+}
+
+void test_verify_not_trusted(void) {
+    /* The server certificate alone, which did not issue itself */
+    mbedtls_x509_crt_ca_bundle bundle = { &srv_der, &srv_der_len, 1 };
+    uint32_t flags;
+    int ret;
+
+    flags = verify_with_bundle(&bundle, &ret);
+    TEST_ASSERT_EQUAL(MBEDTLS_ERR_X509_CERT_VERIFY_FAILED, ret);
+    TEST_ASSERT(flags & MBEDTLS_X509_BADCERT_NOT_TRUSTED);
+    TEST_ASSERT_EQUAL(0, candidates);
+
+    for (size_t i = 0; i < ca_count; i++) {
+        free(ca_der[i]);
+    }
+    free(srv_der);
+}
+
+utest::v1::status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+Case cases[] = {
+    Case("DER copies of the test certificates", test_setup_der, greentea_failure_handler),
+    Case("Parse without copying the DER", test_parse_nocopy, greentea_failure_handler),
+    Case("Verify against a DER bundle", test_verify_bundle, greentea_failure_handler),
+    Case("Verify against a bundle without the issuer", test_verify_not_trusted, greentea_failure_handler),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(20, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+
+int main() {
+    Harness::run(specification);
+}
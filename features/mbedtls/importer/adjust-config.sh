@@ -87,3 +87,7 @@ conf unset MBEDTLS_SSL_TRUNCATED_HMAC
 
 conf unset MBEDTLS_PLATFORM_TIME_TYPE_MACRO
 
+
+# pull in the hardware acceleration selected by the target, see
+# platform/inc/mbedtls_device.h
+perl -0pi -e 's|(//#define YOTTA_CFG_MBEDTLS_USER_CONFIG_FILE[^\n]*\n)|$1\n/* Hardware acceleration picked from the target\x27s device_has on mbed builds */\n#if defined(TARGET_LIKE_MBED)\n#include "mbedtls_device.h"\n#endif\n|' $FILE
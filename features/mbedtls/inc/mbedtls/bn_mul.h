@@ -30,7 +30,7 @@
  *         . IA-32 (SSE2)         . Motorola 68000
  *         . PowerPC, 32-bit      . MicroBlaze
  *         . PowerPC, 64-bit      . TriCore
- *         . SPARC v8             . ARM v3+
+ *         . SPARC v8             . ARM v3+, Thumb
  *         . Alpha                . MIPS32
  *         . C, longlong          . C, generic
  */
@@ -574,7 +574,64 @@
 
 #if defined(__arm__) && !defined(MULADDC_CANNOT_USE_R7)
 
-#if defined(__thumb__) && !defined(__thumb2__)
+#if defined(__thumb__) && !defined(__thumb2__) && \
+    defined(__ARM_ARCH) && __ARM_ARCH >= 6
+
+/*
+ * Thumb-1 on ARMv6 and later, e.g. Cortex-M0/M0+: only 32x32->32 bit
+ * multiplies, so the product is built from four 16x16 bit ones. The halves
+ * of b stay in r8/r9, uxth splits the source word, and the carries of the
+ * middle products, c and d go through three add/adc pairs.
+ */
+#define MULADDC_INIT                                    \
+    asm(                                                \
+            "ldr    r0, %3                      \n\t"   \
+            "ldr    r1, %4                      \n\t"   \
+            "ldr    r2, %5                      \n\t"   \
+            "ldr    r3, %6                      \n\t"   \
+            "uxth   r7, r3                      \n\t"   \
+            "mov    r8, r7                      \n\t"   \
+            "lsr    r7, r3, #16                 \n\t"   \
+            "mov    r9, r7                      \n\t"
+
+#define MULADDC_CORE                                    \
+            "ldmia  r0!, {r4}                   \n\t"   \
+            "lsr    r5, r4, #16                 \n\t"   \
+            "uxth   r4, r4                      \n\t"   \
+            "mov    r6, r8                      \n\t"   \
+            "mov    r7, r9                      \n\t"   \
+            "mov    r3, r6                      \n\t"   \
+            "mul    r3, r5                      \n\t"   \
+            "mul    r5, r7                      \n\t"   \
+            "mul    r7, r4                      \n\t"   \
+            "mul    r4, r6                      \n\t"   \
+            "lsr    r6, r3, #16                 \n\t"   \
+            "lsl    r3, r3, #16                 \n\t"   \
+            "add    r4, r4, r3                  \n\t"   \
+            "adc    r5, r6                      \n\t"   \
+            "lsr    r6, r7, #16                 \n\t"   \
+            "lsl    r7, r7, #16                 \n\t"   \
+            "add    r4, r4, r7                  \n\t"   \
+            "adc    r5, r6                      \n\t"   \
+            "ldr    r3, [r1]                    \n\t"   \
+            "add    r4, r4, r2                  \n\t"   \
+            "mov    r2, #0                      \n\t"   \
+            "adc    r5, r2                      \n\t"   \
+            "add    r4, r4, r3                  \n\t"   \
+            "adc    r2, r5                      \n\t"   \
+            "stmia  r1!, {r4}                   \n\t"
+
+#define MULADDC_STOP                                    \
+            "str    r2, %0                      \n\t"   \
+            "str    r1, %1                      \n\t"   \
+            "str    r0, %2                      \n\t"   \
+         : "=m" (c),  "=m" (d), "=m" (s)        \
+         : "m" (s), "m" (d), "m" (c), "m" (b)   \
+         : "r0", "r1", "r2", "r3", "r4", "r5",  \
+           "r6", "r7", "r8", "r9", "cc"         \
+         );
+
+#elif defined(__thumb__) && !defined(__thumb2__)
 
 #define MULADDC_INIT                                    \
     asm(                                                \
@@ -629,6 +686,48 @@
            "r6", "r7", "r8", "r9", "cc"         \
          );
 
+#elif defined(__ARM_FEATURE_DSP) && ( __ARM_FEATURE_DSP == 1 ) && \
+      defined(__ARM_ARCH) && __ARM_ARCH >= 6
+
+/*
+ * ARMv6 and ARMv7E-M (Cortex-M4/M7) with UMAAL, which adds both c and
+ * the destination word to the product without any flag handling. ARMv5TE
+ * also has the DSP extension, but not UMAAL.
+ */
+#define MULADDC_INIT                                    \
+    asm(                                                \
+            "ldr    r0, %3                      \n\t"   \
+            "ldr    r1, %4                      \n\t"   \
+            "ldr    r2, %5                      \n\t"   \
+            "ldr    r3, %6                      \n\t"
+
+#define MULADDC_CORE                                    \
+            "ldr    r4, [r0], #4                \n\t"   \
+            "ldr    r5, [r1]                    \n\t"   \
+            "umaal  r5, r2, r3, r4              \n\t"   \
+            "str    r5, [r1], #4                \n\t"
+
+#define MULADDC_PAIR                                    \
+            "ldmia  r0!, {r4, r5}               \n\t"   \
+            "ldmia  r1, {r6, r7}                \n\t"   \
+            "umaal  r6, r2, r3, r4              \n\t"   \
+            "umaal  r7, r2, r3, r5              \n\t"   \
+            "stmia  r1!, {r6, r7}               \n\t"
+
+#define MULADDC_HUIT                                    \
+            MULADDC_PAIR MULADDC_PAIR                   \
+            MULADDC_PAIR MULADDC_PAIR
+
+#define MULADDC_STOP                                    \
+            "str    r2, %0                      \n\t"   \
+            "str    r1, %1                      \n\t"   \
+            "str    r0, %2                      \n\t"   \
+         : "=m" (c),  "=m" (d), "=m" (s)        \
+         : "m" (s), "m" (d), "m" (c), "m" (b)   \
+         : "r0", "r1", "r2", "r3", "r4", "r5",  \
+           "r6", "r7", "cc"                     \
+         );
+
 #else
 
 #define MULADDC_INIT                                    \
@@ -109,7 +109,7 @@
  *
  * Enable this layer to allow use of alternative memory allocators.
  */
-//#define MBEDTLS_PLATFORM_MEMORY
+#define MBEDTLS_PLATFORM_MEMORY
 
 /**
  * \def MBEDTLS_PLATFORM_NO_STD_FUNCTIONS
@@ -318,6 +318,26 @@
  */
 //#define MBEDTLS_AES_ROM_TABLES
 
+/**
+ * \def MBEDTLS_AES_COMPACT
+ *
+ * Use a table-free AES round: byte S-box lookups followed by MixColumns
+ * computed on whole 32-bit columns, instead of the four 1 KB T-tables per
+ * direction.
+ *
+ * Only the two 256 byte S-boxes remain, always in ROM, and no table is
+ * generated at run time. On cores without a data cache, such as
+ * Cortex-M0/M0+/M3/M4 running from flash or SRAM that is not cached, the
+ * memory access time does not depend on the address, so the round takes
+ * the same time whatever the key and data. It is slower than the T-table
+ * version, see the AES benchmark in libraries/tests/benchmarks/aes.
+ *
+ * Module:  library/aes.c
+ *
+ * Uncomment this macro to use the compact AES implementation.
+ */
+//#define MBEDTLS_AES_COMPACT
+
 /**
  * \def MBEDTLS_CAMELLIA_SMALL_MEMORY
  *
@@ -457,6 +477,23 @@
  */
 #define MBEDTLS_ECP_NIST_OPTIM
 
+/**
+ * \def MBEDTLS_ECP_ROM_TABLES
+ *
+ * Use constant comb tables for multiplications by the generator, as done
+ * for key generation, ECDSA signing and ECDH, instead of building them on
+ * the first multiplication of each group. They are generated for the
+ * enabled short Weierstrass curves by tools/dev/ecp_comb_tables.py into
+ * ecp_comb_tables.h; curves without a table keep the run-time path.
+ *
+ * The tables are used with the default MBEDTLS_ECP_FIXED_POINT_OPTIM and
+ * an MBEDTLS_ECP_WINDOW_SIZE of 6 or more, and cost about 1.6 KB of ROM
+ * for secp256r1 and 4.2 KB for secp384r1 with 32-bit limbs.
+ *
+ * Comment this macro to compute the tables at run time.
+ */
+#define MBEDTLS_ECP_ROM_TABLES
+
 /**
  * \def MBEDTLS_ECDSA_DETERMINISTIC
  *
@@ -1095,6 +1132,23 @@
  */
 #define MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
 
+/**
+ * \def MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+ *
+ * Size the record buffers of each connection to what it needs rather than
+ * always MBEDTLS_SSL_BUFFER_LEN:
+ * - once a maximum fragment length is negotiated and the handshake is over,
+ *   the buffers shrink to that length plus the record overhead, and grow
+ *   back for a renegotiation;
+ * - mbedtls_ssl_release_buffers() frees the buffers of an idle connection
+ *   until they are needed again;
+ * - mbedtls_ssl_conf_shared_out_buf() lets idle connections use a single
+ *   output buffer provided by the application.
+ *
+ * Comment this macro to always allocate full size buffers.
+ */
+#define MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+
 /**
  * \def MBEDTLS_SSL_PROTO_SSL3
  *
@@ -1365,6 +1419,21 @@
  */
 //#define MBEDTLS_X509_RSASSA_PSS_SUPPORT
 
+/**
+ * \def MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK
+ *
+ * Enable looking up trusted CAs through a callback while verifying a
+ * certificate chain, with mbedtls_x509_crt_verify_with_ca_cb() and
+ * mbedtls_ssl_conf_ca_cb(), instead of keeping the whole trust store
+ * parsed in RAM. mbedtls_x509_crt_ca_bundle_cb() serves CAs from DER
+ * certificates in flash, parsing only the candidates for each issuer.
+ *
+ * Requires: MBEDTLS_X509_CRT_PARSE_C
+ *
+ * Comment this macro to disable the trusted CA callback.
+ */
+#define MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK
+
 /**
  * \def MBEDTLS_ZLIB_SUPPORT
  *
@@ -1937,9 +2006,13 @@
  * Requires: MBEDTLS_PLATFORM_C
  *           MBEDTLS_PLATFORM_MEMORY (to use it within mbed TLS)
  *
+ * Allocations only move to a buffer once mbedtls_memory_buffer_alloc_init()
+ * or mbedtls_memory_buffer_arena_init() is called, mbed Client uses an arena
+ * per connection to bound and profile the memory TLS takes.
+ *
  * Enable this module to enable the buffer memory allocator.
  */
-//#define MBEDTLS_MEMORY_BUFFER_ALLOC_C
+#define MBEDTLS_MEMORY_BUFFER_ALLOC_C
 
 /**
  * \def MBEDTLS_NET_C
@@ -2569,6 +2642,11 @@
 /* Target and application specific configurations */
 //#define YOTTA_CFG_MBEDTLS_USER_CONFIG_FILE "target_config.h"
 
+/* Hardware acceleration picked from the target's device_has on mbed builds */
+#if defined(TARGET_LIKE_MBED)
+#include "mbedtls_device.h"
+#endif
+
 /*
  * Allow user to override any previous default.
  *
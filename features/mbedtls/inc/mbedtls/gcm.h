@@ -37,6 +37,27 @@
 extern "C" {
 #endif
 
+/**
+ * \brief          Multiples of the hash key H for one key, as built by
+ *                 mbedtls_gcm_setkey(). Can be generated ahead of time for
+ *                 a long-lived key and kept in flash.
+ */
+typedef struct {
+    uint64_t HL[16];            /*!< Precalculated HTable, low halves  */
+    uint64_t HH[16];            /*!< Precalculated HTable, high halves */
+}
+mbedtls_gcm_table;
+
+/**
+ * \brief          One segment of a scatter list
+ */
+typedef struct {
+    const unsigned char *input; /*!< data to encrypt or decrypt */
+    unsigned char *output;      /*!< where to write the result, may equal input */
+    size_t len;                 /*!< length of the segment */
+}
+mbedtls_gcm_iovec;
+
 /**
  * \brief          GCM context structure
  */
@@ -44,11 +65,13 @@ typedef struct {
     mbedtls_cipher_context_t cipher_ctx;/*!< cipher context used */
     uint64_t HL[16];            /*!< Precalculated HTable */
     uint64_t HH[16];            /*!< Precalculated HTable */
+    const mbedtls_gcm_table *table; /*!< Precomputed HTable used instead, or NULL */
     uint64_t len;               /*!< Total data length */
     uint64_t add_len;           /*!< Total add length */
     unsigned char base_ectr[16];/*!< First ECTR for tag */
     unsigned char y[16];        /*!< Y working value */
     unsigned char buf[16];      /*!< buf working value */
+    unsigned char ectr[16];     /*!< Keystream of a partial block */
     int mode;                   /*!< Encrypt or Decrypt */
 }
 mbedtls_gcm_context;
@@ -77,6 +100,44 @@ int mbedtls_gcm_setkey( mbedtls_gcm_context *ctx,
                         const unsigned char *key,
                         unsigned int keybits );
 
+/**
+ * \brief           GCM initialization with a precomputed table
+ *
+ * \note            Unlike mbedtls_gcm_setkey(), the table is not built
+ *                  but used where it is, so it can be in flash and shared
+ *                  by several contexts. It must stay valid while ctx uses
+ *                  it.
+ *
+ * \param ctx       GCM context to be initialized
+ * \param cipher    cipher to use (a 128-bit block cipher)
+ * \param key       encryption key
+ * \param keybits   must be 128, 192 or 256
+ * \param table     table from mbedtls_gcm_table_gen() for the same key
+ *
+ * \return          0 if successful, MBEDTLS_ERR_GCM_BAD_INPUT if the table
+ *                  is not for this key, or a cipher specific error code
+ */
+int mbedtls_gcm_setkey_table( mbedtls_gcm_context *ctx,
+                              mbedtls_cipher_id_t cipher,
+                              const unsigned char *key,
+                              unsigned int keybits,
+                              const mbedtls_gcm_table *table );
+
+/**
+ * \brief           Build the table for a key, for mbedtls_gcm_setkey_table()
+ *
+ * \param table     table to fill in
+ * \param cipher    cipher to use (a 128-bit block cipher)
+ * \param key       encryption key
+ * \param keybits   must be 128, 192 or 256
+ *
+ * \return          0 if successful, or a cipher specific error code
+ */
+int mbedtls_gcm_table_gen( mbedtls_gcm_table *table,
+                           mbedtls_cipher_id_t cipher,
+                           const unsigned char *key,
+                           unsigned int keybits );
+
 /**
  * \brief           GCM buffer encryption/decryption using a block cipher
  *
@@ -164,9 +225,8 @@ int mbedtls_gcm_starts( mbedtls_gcm_context *ctx,
 
 /**
  * \brief           Generic GCM update function. Encrypts/decrypts using the
- *                  given GCM context. Expects input to be a multiple of 16
- *                  bytes! Only the last call before mbedtls_gcm_finish() can be less
- *                  than 16 bytes!
+ *                  given GCM context. Calls can be of any length, the data
+ *                  is processed as if it had been passed in a single call.
  *
  * \note On decryption, the output buffer cannot be the same as input buffer.
  *       If buffers overlap, the output buffer must trail at least 8 bytes
@@ -184,6 +244,24 @@ int mbedtls_gcm_update( mbedtls_gcm_context *ctx,
                 const unsigned char *input,
                 unsigned char *output );
 
+/**
+ * \brief           mbedtls_gcm_update() over a scatter list, for records
+ *                  whose header and payload are in separate buffers. The
+ *                  segments can be of any length.
+ *
+ * \note            Each segment has the same restrictions on overlapping
+ *                  input and output as mbedtls_gcm_update().
+ *
+ * \param ctx       GCM context
+ * \param iov       segments, in the order of the data
+ * \param iovcnt    number of segments
+ *
+ * \return          0 if successful or MBEDTLS_ERR_GCM_BAD_INPUT
+ */
+int mbedtls_gcm_update_iov( mbedtls_gcm_context *ctx,
+                            const mbedtls_gcm_iovec *iov,
+                            size_t iovcnt );
+
 /**
  * \brief           Generic GCM finalisation function. Wraps up the GCM stream
  *                  and generates the tag. The tag can have a maximum length of
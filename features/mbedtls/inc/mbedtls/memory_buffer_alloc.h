@@ -31,6 +31,10 @@
 
 #include <stddef.h>
 
+#if defined(MBEDTLS_THREADING_C)
+#include "threading.h"
+#endif
+
 /**
  * \name SECTION: Module settings
  *
@@ -50,10 +54,47 @@
 #define MBEDTLS_MEMORY_VERIFY_FREE         (1 << 1)
 #define MBEDTLS_MEMORY_VERIFY_ALWAYS       (MBEDTLS_MEMORY_VERIFY_ALLOC | MBEDTLS_MEMORY_VERIFY_FREE)
 
+#define MBEDTLS_MEMORY_PHASE_NONE           0 /**< Outside of the phases below */
+#define MBEDTLS_MEMORY_PHASE_CERT_PARSE     1 /**< Parsing certificates and keys */
+#define MBEDTLS_MEMORY_PHASE_KEY_EXCHANGE   2 /**< Handshake */
+#define MBEDTLS_MEMORY_PHASE_RECORD_IO      3 /**< Application data */
+#define MBEDTLS_MEMORY_PHASE_MAX            4
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+struct mbedtls_memory_header;
+
+/**
+ * \brief          Buffer heap. The default heap of
+ *                 mbedtls_memory_buffer_alloc_init() is one, further ones
+ *                 are set up with mbedtls_memory_buffer_arena_init().
+ *                 The fields are private.
+ */
+typedef struct mbedtls_memory_buffer_arena
+{
+    unsigned char   *buf;
+    size_t          len;
+    struct mbedtls_memory_header *first;
+    struct mbedtls_memory_header *first_free;
+    int             verify;
+    size_t          alloc_count;
+    size_t          free_count;
+    size_t          total_used;
+    size_t          maximum_used;
+    size_t          header_count;
+    size_t          maximum_header_count;
+    int             phase;                                  /*!< current phase */
+    size_t          phase_used[MBEDTLS_MEMORY_PHASE_MAX];   /*!< peak bytes per phase */
+    size_t          phase_blocks[MBEDTLS_MEMORY_PHASE_MAX]; /*!< peak blocks per phase */
+    struct mbedtls_memory_buffer_arena *next;
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_threading_mutex_t   mutex;
+#endif
+}
+mbedtls_memory_buffer_arena;
+
 /**
  * \brief   Initialize use of stack-based memory allocator.
  *          The stack-based allocator does memory management inside the
@@ -94,6 +135,7 @@ void mbedtls_memory_buffer_set_verify( int verify );
  *          trace if MBEDTLS_MEMORY_BACKTRACE is defined.
  */
 void mbedtls_memory_buffer_alloc_status( void );
+#endif /* MBEDTLS_MEMORY_DEBUG */
 
 /**
  * \brief   Get the peak heap usage so far
@@ -119,11 +161,95 @@ void mbedtls_memory_buffer_alloc_max_reset( void );
  * \param cur_blocks    Current number of blocks in use, including free and used
  */
 void mbedtls_memory_buffer_alloc_cur_get( size_t *cur_used, size_t *cur_blocks );
-#endif /* MBEDTLS_MEMORY_DEBUG */
 
 /**
- * \brief   Verifies that all headers in the memory buffer are correct
- *          and contain sane values. Helps debug buffer-overflow errors.
+ * \brief   Set up an arena: a heap of its own inside buf, for example
+ *          for one TLS connection, so that its memory use is bounded and
+ *          does not fragment the rest of the heap.
+ *
+ *          While an arena is selected with
+ *          mbedtls_memory_buffer_arena_select(), mbedtls_calloc() takes
+ *          memory from it, and fails once it is full. mbedtls_free()
+ *          always returns memory to the arena that holds it. Without a
+ *          selection, memory comes from the default heap if
+ *          mbedtls_memory_buffer_alloc_init() was called, or from the
+ *          allocator that was installed before otherwise.
+ *
+ * \param arena     arena to set up
+ * \param buf       buffer to use as heap, must outlive the arena
+ * \param len       size of the buffer
+ */
+void mbedtls_memory_buffer_arena_init( mbedtls_memory_buffer_arena *arena,
+                                       unsigned char *buf, size_t len );
+
+/**
+ * \brief   Release an arena. All memory taken from it must have been
+ *          freed.
+ *
+ * \param arena     arena to release
+ */
+void mbedtls_memory_buffer_arena_free( mbedtls_memory_buffer_arena *arena );
+
+/**
+ * \brief   Select the arena new allocations come from.
+ *
+ * \note    The selection is global: with several threads using mbed TLS,
+ *          the calls made while an arena is selected must be serialized.
+ *
+ * \param arena     arena to use, or NULL for the default
+ *
+ * \return          the arena selected before, to restore it afterwards
+ */
+mbedtls_memory_buffer_arena *mbedtls_memory_buffer_arena_select(
+                                        mbedtls_memory_buffer_arena *arena );
+
+/**
+ * \brief   Start a phase. The peak usage of an arena is kept for each
+ *          phase, counting from what is in use when the phase starts.
+ *
+ * \param arena     arena in use
+ * \param phase     one of the MBEDTLS_MEMORY_PHASE_XXX values
+ */
+void mbedtls_memory_buffer_arena_set_phase( mbedtls_memory_buffer_arena *arena,
+                                            int phase );
+
+/**
+ * \brief   Get the peak usage of an arena so far
+ *
+ * \param arena         arena to query
+ * \param max_used      Peak number of bytes in use or committed, see
+ *                      mbedtls_memory_buffer_alloc_max_get()
+ * \param max_blocks    Peak number of blocks in use, including free and used
+ */
+void mbedtls_memory_buffer_arena_max_get( const mbedtls_memory_buffer_arena *arena,
+                                          size_t *max_used, size_t *max_blocks );
+
+/**
+ * \brief   Get the peak usage of an arena during a phase
+ *
+ * \param arena         arena to query
+ * \param phase         one of the MBEDTLS_MEMORY_PHASE_XXX values
+ * \param max_used      Peak number of bytes in use or committed
+ * \param max_blocks    Peak number of blocks in use, including free and used
+ */
+void mbedtls_memory_buffer_arena_phase_get( const mbedtls_memory_buffer_arena *arena,
+                                            int phase,
+                                            size_t *max_used, size_t *max_blocks );
+
+/**
+ * \brief   Get the current usage of an arena
+ *
+ * \param arena         arena to query
+ * \param cur_used      Current number of bytes in use or committed
+ * \param cur_blocks    Current number of blocks in use, including free and used
+ */
+void mbedtls_memory_buffer_arena_cur_get( const mbedtls_memory_buffer_arena *arena,
+                                          size_t *cur_used, size_t *cur_blocks );
+
+/**
+ * \brief   Verifies that all headers in the memory buffer and in the
+ *          arenas are correct and contain sane values. Helps debug
+ *          buffer-overflow errors.
  *
  *          Prints out first failure if MBEDTLS_MEMORY_DEBUG is defined.
  *          Prints out full header information if MBEDTLS_MEMORY_DEBUG
@@ -55,6 +55,10 @@
 #include <time.h>
 #endif
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH) && defined(MBEDTLS_THREADING_C)
+#include "threading.h"
+#endif
+
 /*
  * SSL Error codes
  */
@@ -536,6 +540,23 @@ typedef struct mbedtls_ssl_key_cert mbedtls_ssl_key_cert;
 typedef struct mbedtls_ssl_flight_item mbedtls_ssl_flight_item;
 #endif
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+/**
+ * \brief          Output buffer shared by the idle connections of a
+ *                 configuration, see mbedtls_ssl_conf_shared_out_buf()
+ */
+typedef struct
+{
+    unsigned char *buf;         /*!< storage, provided by the application */
+    size_t len;                 /*!< size of buf                          */
+    const mbedtls_ssl_context *owner; /*!< connection using it, or NULL   */
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_threading_mutex_t mutex;  /*!< protects owner                 */
+#endif
+}
+mbedtls_ssl_shared_buf;
+#endif /* MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH */
+
 /*
  * This structure is used for storing current session data.
  */
@@ -650,6 +671,10 @@ struct mbedtls_ssl_config
     mbedtls_ssl_key_cert *key_cert; /*!< own certificate/key pair(s)        */
     mbedtls_x509_crt *ca_chain;     /*!< trusted CAs                        */
     mbedtls_x509_crl *ca_crl;       /*!< trusted CAs CRLs                   */
+#if defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK)
+    mbedtls_x509_crt_ca_cb_t f_ca_cb; /*!< trusted CA lookup                */
+    void *p_ca_cb;                  /*!< context for trusted CA lookup      */
+#endif
 #endif /* MBEDTLS_X509_CRT_PARSE_C */
 
 #if defined(MBEDTLS_KEY_EXCHANGE__WITH_CERT__ENABLED)
@@ -676,6 +701,11 @@ struct mbedtls_ssl_config
     const char **alpn_list;         /*!< ordered list of protocols          */
 #endif
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    mbedtls_ssl_shared_buf *shared_out_buf; /*!< output buffer for idle
+                                                 connections, or NULL   */
+#endif
+
     /*
      * Numerical settings (int then char)
      */
@@ -851,6 +881,15 @@ struct mbedtls_ssl_context
     size_t out_msglen;          /*!< record header: message length    */
     size_t out_left;            /*!< amount of data not yet written   */
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    size_t in_buf_len;          /*!< size of in_buf                   */
+    size_t out_buf_len;         /*!< usable size of out_buf           */
+    size_t in_msg_offset;       /*!< in_msg - in_buf while released   */
+    size_t out_msg_offset;      /*!< out_msg - out_buf while released */
+    unsigned char in_ctr_saved[8];  /*!< in_ctr while released        */
+    unsigned char out_ctr_saved[8]; /*!< out_ctr while released       */
+#endif
+
 #if defined(MBEDTLS_ZLIB_SUPPORT)
     unsigned char *compress_buf;        /*!<  zlib data buffer        */
 #endif
@@ -1581,6 +1620,27 @@ void mbedtls_ssl_conf_ca_chain( mbedtls_ssl_config *conf,
                                mbedtls_x509_crt *ca_chain,
                                mbedtls_x509_crl *ca_crl );
 
+#if defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK)
+/**
+ * \brief          Look up the trusted CAs through a callback when verifying
+ *                 the peer certificate, instead of a parsed CA chain, see
+ *                 \c mbedtls_x509_crt_verify_with_ca_cb().
+ *
+ * \note           Takes precedence over \c mbedtls_ssl_conf_ca_chain(),
+ *                 but not over \c mbedtls_ssl_set_hs_ca_chain(). A server
+ *                 using it sends an empty list of CA names in its
+ *                 CertificateRequest.
+ *
+ * \param conf     SSL configuration
+ * \param f_ca_cb  trusted CA callback, or NULL to use the CA chain again
+ * \param p_ca_cb  context of the callback, e.g. a mbedtls_x509_crt_ca_bundle
+ *                 for \c mbedtls_x509_crt_ca_bundle_cb()
+ */
+void mbedtls_ssl_conf_ca_cb( mbedtls_ssl_config *conf,
+                             mbedtls_x509_crt_ca_cb_t f_ca_cb,
+                             void *p_ca_cb );
+#endif /* MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK */
+
 /**
  * \brief          Set own certificate chain and private key
  *
@@ -2047,6 +2107,49 @@ void mbedtls_ssl_conf_arc4_support( mbedtls_ssl_config *conf, char arc4 );
 int mbedtls_ssl_conf_max_frag_len( mbedtls_ssl_config *conf, unsigned char mfl_code );
 #endif /* MBEDTLS_SSL_MAX_FRAGMENT_LENGTH */
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+/**
+ * \brief          Initialize an output buffer to be shared between the
+ *                 connections of a configuration
+ *
+ * \param shared   shared buffer context
+ * \param buf      storage for the buffer, usually static; it must outlive
+ *                 all the connections using it
+ * \param len      size of buf. Connections only use the shared buffer when
+ *                 their output buffer fits in it: MBEDTLS_SSL_BUFFER_LEN
+ *                 serves any connection, while the overhead plus the
+ *                 negotiated maximum fragment length serves connections
+ *                 that negotiated it, but only once their handshake is over.
+ */
+void mbedtls_ssl_shared_buf_init( mbedtls_ssl_shared_buf *shared,
+                                  unsigned char *buf, size_t len );
+
+/**
+ * \brief          Free a shared buffer context. The storage itself is
+ *                 zeroized but belongs to the application.
+ *
+ * \param shared   shared buffer context
+ */
+void mbedtls_ssl_shared_buf_free( mbedtls_ssl_shared_buf *shared );
+
+/**
+ * \brief          Set the output buffer shared by the idle connections
+ *                 of this configuration (Default: none)
+ *
+ * \note           After mbedtls_ssl_release_buffers(), a connection that
+ *                 needs to send again borrows the shared buffer if it is
+ *                 free and large enough, or allocates a private one
+ *                 otherwise. It keeps it until it is released again, so
+ *                 releasing a connection as soon as it goes idle lets one
+ *                 buffer serve many connections.
+ *
+ * \param conf     SSL configuration
+ * \param shared   shared buffer, or NULL to disable
+ */
+void mbedtls_ssl_conf_shared_out_buf( mbedtls_ssl_config *conf,
+                                      mbedtls_ssl_shared_buf *shared );
+#endif /* MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH */
+
 #if defined(MBEDTLS_SSL_TRUNCATED_HMAC)
 /**
  * \brief          Activate negotiation of truncated HMAC
@@ -2482,6 +2585,26 @@ int mbedtls_ssl_send_alert_message( mbedtls_ssl_context *ssl,
  */
 int mbedtls_ssl_close_notify( mbedtls_ssl_context *ssl );
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+/**
+ * \brief          Free the record buffers of an idle connection. They are
+ *                 allocated again, or the shared output buffer is
+ *                 borrowed, by the next call that needs them.
+ *
+ * \note           A connection is idle when its handshake is over and no
+ *                 incoming record or outgoing data is pending, typically
+ *                 after mbedtls_ssl_read() returned
+ *                 MBEDTLS_ERR_SSL_WANT_READ and mbedtls_ssl_write()
+ *                 completed.
+ *
+ * \param ssl      SSL context
+ *
+ * \return         0 if successful, or MBEDTLS_ERR_SSL_BAD_INPUT_DATA if
+ *                 the connection is not idle
+ */
+int mbedtls_ssl_release_buffers( mbedtls_ssl_context *ssl );
+#endif /* MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH */
+
 /**
  * \brief          Free referenced items in an SSL context and clear memory
  *
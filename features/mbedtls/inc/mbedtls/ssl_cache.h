@@ -66,17 +66,43 @@ struct mbedtls_ssl_cache_entry
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
     mbedtls_x509_buf peer_cert;         /*!< entry peer_cert    */
 #endif
-    mbedtls_ssl_cache_entry *next;      /*!< chain pointer      */
+    mbedtls_ssl_cache_entry *next;      /*!< hash bucket or free list   */
+    mbedtls_ssl_cache_entry *lru_prev;  /*!< more recently used entry   */
+    mbedtls_ssl_cache_entry *lru_next;  /*!< less recently used entry   */
 };
 
+/**
+ * \brief   Cache statistics, counted since mbedtls_ssl_cache_init()
+ */
+typedef struct
+{
+    unsigned long hits;         /*!< sessions found by get          */
+    unsigned long misses;       /*!< sessions not found or expired  */
+    unsigned long evictions;    /*!< live entries dropped for space */
+    unsigned long expirations;  /*!< entries dropped as expired     */
+    int entries;                /*!< entries currently in use       */
+}
+mbedtls_ssl_cache_stats;
+
 /**
  * \brief Cache context
+ *
+ * Entries live in an arena of max_entries entries allocated on the first
+ * mbedtls_ssl_cache_set(), are found through a hash table on the session
+ * ID and are evicted least recently used first, so get and set take the
+ * same time however many sessions are cached.
  */
 struct mbedtls_ssl_cache_context
 {
-    mbedtls_ssl_cache_entry *chain;     /*!< start of the chain     */
+    mbedtls_ssl_cache_entry *arena;     /*!< max_entries entries    */
+    mbedtls_ssl_cache_entry **buckets;  /*!< hash table             */
+    unsigned int hash_mask;     /*!< number of buckets - 1  */
+    mbedtls_ssl_cache_entry *free;      /*!< unused entries         */
+    mbedtls_ssl_cache_entry *lru_head;  /*!< most recently used     */
+    mbedtls_ssl_cache_entry *lru_tail;  /*!< least recently used    */
     int timeout;                /*!< cache entry timeout    */
     int max_entries;            /*!< maximum entries        */
+    mbedtls_ssl_cache_stats stats;      /*!< statistics             */
 #if defined(MBEDTLS_THREADING_C)
     mbedtls_threading_mutex_t mutex;    /*!< mutex                  */
 #endif
@@ -124,11 +150,25 @@ void mbedtls_ssl_cache_set_timeout( mbedtls_ssl_cache_context *cache, int timeou
  * \brief          Set the maximum number of cache entries
  *                 (Default: MBEDTLS_SSL_CACHE_DEFAULT_MAX_ENTRIES (50))
  *
+ * \note           The entries are allocated in one block when the first
+ *                 session is stored. Changing the maximum afterwards empties
+ *                 the cache.
+ *
  * \param cache    SSL cache context
  * \param max      cache entry maximum
  */
 void mbedtls_ssl_cache_set_max_entries( mbedtls_ssl_cache_context *cache, int max );
 
+/**
+ * \brief          Get the cache statistics
+ *                 (Thread-safe if MBEDTLS_THREADING_C is enabled)
+ *
+ * \param cache    SSL cache context
+ * \param stats    structure to fill
+ */
+void mbedtls_ssl_cache_get_stats( mbedtls_ssl_cache_context *cache,
+                                  mbedtls_ssl_cache_stats *stats );
+
 /**
  * \brief          Free referenced items in a cache context and clear memory
  *
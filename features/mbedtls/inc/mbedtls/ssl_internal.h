@@ -145,6 +145,10 @@
                         + MBEDTLS_SSL_PADDING_ADD                   \
                         )
 
+/* Room needed in a record buffer on top of the record contents */
+#define MBEDTLS_SSL_BUFFER_OVERHEAD ( MBEDTLS_SSL_BUFFER_LEN                \
+                                    - MBEDTLS_SSL_MAX_CONTENT_LEN )
+
 /*
  * TLS extension flags (for extensions with outgoing ServerHello content
  * that need it (e.g. for RENEGOTIATION_INFO the server already knows because
@@ -461,6 +465,30 @@ static inline size_t mbedtls_ssl_hs_hdr_len( const mbedtls_ssl_context *ssl )
     return( 4 );
 }
 
+/*
+ * Size of the record buffers, smaller than MBEDTLS_SSL_BUFFER_LEN once a
+ * maximum fragment length is negotiated with variable length buffers
+ */
+static inline size_t mbedtls_ssl_in_buf_len( const mbedtls_ssl_context *ssl )
+{
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    return( ssl->in_buf_len );
+#else
+    ((void) ssl);
+    return( MBEDTLS_SSL_BUFFER_LEN );
+#endif
+}
+
+static inline size_t mbedtls_ssl_out_buf_len( const mbedtls_ssl_context *ssl )
+{
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    return( ssl->out_buf_len );
+#else
+    ((void) ssl);
+    return( MBEDTLS_SSL_BUFFER_LEN );
+#endif
+}
+
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
 void mbedtls_ssl_send_flight_completed( mbedtls_ssl_context *ssl );
 void mbedtls_ssl_recv_flight_completed( mbedtls_ssl_context *ssl );
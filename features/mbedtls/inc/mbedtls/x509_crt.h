@@ -51,6 +51,7 @@ extern "C" {
  */
 typedef struct mbedtls_x509_crt
 {
+    int own_buffer;                     /**< Whether raw.p was allocated by the parser, or points into the caller's buffer. */
     mbedtls_x509_buf raw;               /**< The raw certificate data (DER). */
     mbedtls_x509_buf tbs;               /**< The raw certificate body (DER). The part that is To Be Signed. */
 
@@ -169,6 +170,24 @@ extern const mbedtls_x509_crt_profile mbedtls_x509_crt_profile_suiteb;
 int mbedtls_x509_crt_parse_der( mbedtls_x509_crt *chain, const unsigned char *buf,
                         size_t buflen );
 
+/**
+ * \brief          Parse a single DER formatted certificate and add it
+ *                 to the chained list, without copying it.
+ *
+ * \note           The certificate points into buf instead of a heap copy,
+ *                 so buf must stay valid and unchanged until the chain is
+ *                 freed, for example DER certificates kept in flash.
+ *
+ * \param chain    points to the start of the chain
+ * \param buf      buffer holding the certificate DER data
+ * \param buflen   size of the buffer
+ *
+ * \return         0 if successful, or a specific X509 or PEM error code
+ */
+int mbedtls_x509_crt_parse_der_nocopy( mbedtls_x509_crt *chain,
+                                       const unsigned char *buf,
+                                       size_t buflen );
+
 /**
  * \brief          Parse one or more certificates and add them
  *                 to the chained list. Parses permissively. If some
@@ -334,6 +353,91 @@ int mbedtls_x509_crt_verify_with_profile( mbedtls_x509_crt *crt,
                      int (*f_vrfy)(void *, mbedtls_x509_crt *, int, uint32_t *),
                      void *p_vrfy );
 
+#if defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK)
+/**
+ * \brief          Trusted CA callback: look up the trusted CAs that may
+ *                 have issued a certificate.
+ *
+ * \param p_ctx    opaque context of the callback
+ * \param child    certificate whose issuer is looked for
+ * \param candidate_cas  set to a chain allocated with mbedtls_calloc()
+ *                 holding the candidates, or NULL if there is none. It is
+ *                 released with mbedtls_x509_crt_free() and mbedtls_free()
+ *                 once the issuer has been checked.
+ *
+ * \return         0 if successful, including when there is no candidate,
+ *                 or an error code that aborts the verification
+ */
+typedef int (*mbedtls_x509_crt_ca_cb_t)( void *p_ctx,
+                                         mbedtls_x509_crt const *child,
+                                         mbedtls_x509_crt **candidate_cas );
+
+/**
+ * \brief          Verify the certificate signature according to profile,
+ *                 with the trusted CAs looked up through a callback
+ *
+ * \note           Same as \c mbedtls_x509_crt_verify_with_profile(), but
+ *                 only the candidate CAs for the certificate being checked
+ *                 are held in memory at any time, instead of the whole
+ *                 trust store. CRLs are not checked.
+ *
+ * \param crt      a certificate (chain) to be verified
+ * \param f_ca_cb  trusted CA callback
+ * \param p_ca_cb  context of the trusted CA callback
+ * \param profile  security profile for verification
+ * \param cn       expected Common Name (can be set to
+ *                 NULL if the CN must not be verified)
+ * \param flags    result of the verification
+ * \param f_vrfy   verification function
+ * \param p_vrfy   verification parameter
+ *
+ * \return         0 if successful or MBEDTLS_ERR_X509_CERT_VERIFY_FAILED
+ *                 in which case *flags will have one or more
+ *                 MBEDTLS_X509_BADCERT_XXX flags set,
+ *                 or another error in case of a fatal error encountered
+ *                 during the verification process, including errors
+ *                 returned by f_ca_cb.
+ */
+int mbedtls_x509_crt_verify_with_ca_cb( mbedtls_x509_crt *crt,
+                     mbedtls_x509_crt_ca_cb_t f_ca_cb,
+                     void *p_ca_cb,
+                     const mbedtls_x509_crt_profile *profile,
+                     const char *cn, uint32_t *flags,
+                     int (*f_vrfy)(void *, mbedtls_x509_crt *, int, uint32_t *),
+                     void *p_vrfy );
+
+/**
+ * A trust store of DER certificates that are not copied to RAM, e.g.
+ * constant arrays in flash, for use with mbedtls_x509_crt_ca_bundle_cb()
+ */
+typedef struct
+{
+    const unsigned char * const *der;   /**< The DER certificates */
+    const size_t *der_len;              /**< Their lengths */
+    size_t count;                       /**< Number of certificates */
+}
+mbedtls_x509_crt_ca_bundle;
+
+/**
+ * \brief          Trusted CA callback over a mbedtls_x509_crt_ca_bundle.
+ *
+ * \note           Only the certificates whose encoded subject is the same
+ *                 as the issuer of child, byte for byte, are parsed, with
+ *                 mbedtls_x509_crt_parse_der_nocopy(). A CA whose subject
+ *                 is encoded differently from the issuer name of the
+ *                 certificates it signs is not found.
+ *
+ * \param p_bundle the mbedtls_x509_crt_ca_bundle
+ * \param child    certificate whose issuer is looked for
+ * \param candidates set to the candidate CAs, or NULL
+ *
+ * \return         0 if successful, or MBEDTLS_ERR_X509_ALLOC_FAILED
+ */
+int mbedtls_x509_crt_ca_bundle_cb( void *p_bundle,
+                                   mbedtls_x509_crt const *child,
+                                   mbedtls_x509_crt **candidates );
+#endif /* MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK */
+
 #if defined(MBEDTLS_X509_CHECK_KEY_USAGE)
 /**
  * \brief          Check usage of certificate against keyUsage extension.
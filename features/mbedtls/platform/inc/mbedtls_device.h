@@ -0,0 +1,69 @@
+/*
+ *  Hardware acceleration selected by the target's device_has
+ *
+ *  Copyright (C) 2016, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#ifndef MBEDTLS_DEVICE_H
+#define MBEDTLS_DEVICE_H
+
+/*
+ * Included from config.h on mbed builds. Each engine a target lists in
+ * device_has replaces the matching software primitive, everything else
+ * keeps the portable implementation:
+ *
+ *  - TRNG:   mbedtls_hardware_poll() on top of trng_get_bytes(), through
+ *            the background entropy pool unless entropy_pool is 0
+ *  - AES:    the whole AES module, 128 and 256-bit keys
+ *  - SHA1:   the SHA-1 compression function only
+ *  - SHA256: the SHA-224/256 compression function only
+ *
+ * The hashes keep the software buffering and padding so that clone,
+ * SHA-224 and partial blocks behave exactly as before.
+ */
+
+#if !defined(MBED_CONF_MBEDTLS_HW_ACCELERATION)
+#define MBED_CONF_MBEDTLS_HW_ACCELERATION 1
+#endif
+
+#if !defined(MBED_CONF_MBEDTLS_ENTROPY_POOL)
+#define MBED_CONF_MBEDTLS_ENTROPY_POOL 1
+#endif
+
+#if MBED_CONF_MBEDTLS_HW_ACCELERATION
+
+#if DEVICE_TRNG && !defined(MBEDTLS_ENTROPY_HARDWARE_ALT)
+#define MBEDTLS_ENTROPY_HARDWARE_ALT
+#endif
+
+#if DEVICE_TRNG && MBED_CONF_MBEDTLS_ENTROPY_POOL
+#define MBEDTLS_ENTROPY_POOL
+#endif
+
+#if DEVICE_AES
+#define MBEDTLS_AES_ALT
+#endif
+
+#if DEVICE_SHA1
+#define MBEDTLS_SHA1_PROCESS_ALT
+#endif
+
+#if DEVICE_SHA256
+#define MBEDTLS_SHA256_PROCESS_ALT
+#endif
+
+#endif
+
+#endif /* MBEDTLS_DEVICE_H */
@@ -0,0 +1,159 @@
+/*
+ *  Entropy pool filled ahead of use
+ *
+ *  Copyright (C) 2016, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#ifndef MBEDTLS_ENTROPY_POOL_H
+#define MBEDTLS_ENTROPY_POOL_H
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mbedtls/entropy.h"
+
+#if !defined(MBED_CONF_MBEDTLS_ENTROPY_POOL_SIZE)
+#define MBED_CONF_MBEDTLS_ENTROPY_POOL_SIZE     128
+#endif
+
+#define MBEDTLS_ENTROPY_POOL_MAX_SOURCES        4   /**< Sources per pool       */
+#define MBEDTLS_ENTROPY_POOL_BLOCK              16  /**< Bytes polled at a time */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          State of the health tests of one source, the repetition
+ *                 count and adaptive proportion tests of NIST SP 800-90B
+ *                 on its output bytes
+ */
+typedef struct
+{
+    unsigned char last;         /*!<  last byte                       */
+    unsigned int repeats;       /*!<  times last was seen in a row    */
+    unsigned char apt_value;    /*!<  byte counted by the window      */
+    unsigned int apt_seen;      /*!<  occurrences of it in the window */
+    unsigned int apt_samples;   /*!<  bytes into the window           */
+    int started;                /*!<  whether last is valid           */
+}
+mbedtls_entropy_pool_health;
+
+/**
+ * \brief          Entropy pool: bytes from the sources that passed the
+ *                 health tests, waiting to be used
+ */
+typedef struct
+{
+    unsigned char buf[MBED_CONF_MBEDTLS_ENTROPY_POOL_SIZE];
+    size_t head;                /*!<  first byte available            */
+    size_t count;               /*!<  bytes available                 */
+    int filling;                /*!<  a fill is polling the sources   */
+    uint32_t failures;          /*!<  blocks rejected by health tests */
+
+    int source_count;
+    mbedtls_entropy_f_source_ptr f_source[MBEDTLS_ENTROPY_POOL_MAX_SOURCES];
+    void *p_source[MBEDTLS_ENTROPY_POOL_MAX_SOURCES];
+    mbedtls_entropy_pool_health health[MBEDTLS_ENTROPY_POOL_MAX_SOURCES];
+}
+mbedtls_entropy_pool;
+
+/**
+ * \brief          Initialize an empty pool without sources
+ */
+void mbedtls_entropy_pool_init( mbedtls_entropy_pool *pool );
+
+/**
+ * \brief          Clear the pool
+ */
+void mbedtls_entropy_pool_free( mbedtls_entropy_pool *pool );
+
+/**
+ * \brief          Add a source. Its output must be full entropy, as from
+ *                 mbedtls_hardware_poll(): the pool hands it out as is.
+ *
+ * \return         0 if successful or MBEDTLS_ERR_ENTROPY_MAX_SOURCES
+ */
+int mbedtls_entropy_pool_add_source( mbedtls_entropy_pool *pool,
+                                     mbedtls_entropy_f_source_ptr f_source,
+                                     void *p_source );
+
+/**
+ * \brief          Poll each source for up to MBEDTLS_ENTROPY_POOL_BLOCK
+ *                 bytes and keep those that pass the health tests, mixed
+ *                 with the jitter of the microsecond ticker.
+ *
+ * \note           Meant for a low priority thread, an idle hook or a
+ *                 low priority interrupt if the sources allow it. Returns
+ *                 at once if another fill is running.
+ *
+ * \return         0 if successful, including when the pool is full,
+ *                 MBEDTLS_ERR_ENTROPY_NO_SOURCES_DEFINED, or
+ *                 MBEDTLS_ERR_ENTROPY_SOURCE_FAILED if a source failed or
+ *                 its output failed a health test
+ */
+int mbedtls_entropy_pool_fill( mbedtls_entropy_pool *pool );
+
+/**
+ * \brief          Take bytes out of the pool, waiting at most timeout_ms
+ *                 for it to be refilled if it runs short.
+ *
+ * \note           The wait is bounded by timeout_ms plus the time a source
+ *                 takes for one block. In an interrupt, or with timeout_ms
+ *                 0, only the bytes already in the pool are returned.
+ *
+ * \param pool     pool
+ * \param output   buffer for the bytes
+ * \param len      bytes wanted
+ * \param olen     bytes written, which may be less than len
+ * \param timeout_ms  longest wait for more bytes
+ *
+ * \return         0 if successful, or MBEDTLS_ERR_ENTROPY_SOURCE_FAILED
+ *                 if nothing at all could be returned
+ */
+int mbedtls_entropy_pool_get( mbedtls_entropy_pool *pool,
+                              unsigned char *output, size_t len,
+                              size_t *olen, uint32_t timeout_ms );
+
+/**
+ * \brief          Bytes in the pool
+ */
+size_t mbedtls_entropy_pool_available( const mbedtls_entropy_pool *pool );
+
+/**
+ * \brief          Blocks rejected by the health tests since init
+ */
+uint32_t mbedtls_entropy_pool_failures( const mbedtls_entropy_pool *pool );
+
+/**
+ * \brief          The pool fed by the target's TRNG and shared by
+ *                 mbedtls_hardware_poll() and randLIB. The first call sets
+ *                 it up. With an RTOS, the first call made from a thread
+ *                 rather than an interrupt starts the low priority thread
+ *                 that keeps it full.
+ */
+mbedtls_entropy_pool *mbedtls_entropy_pool_shared( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MBEDTLS_ENTROPY_POOL_H */
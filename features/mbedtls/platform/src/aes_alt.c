@@ -0,0 +1,349 @@
+/*
+ *  AES on top of the crypto_api HAL
+ *
+ *  Copyright (C) 2016, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_AES_C) && defined(MBEDTLS_AES_ALT)
+
+#include <string.h>
+
+#include "mbedtls/aes.h"
+#include "crypto_api.h"
+#include "critical.h"
+
+/*
+ * Data is handed to the engine this many bytes at a time, which bounds
+ * how long interrupts stay masked and the size of the bounce buffer used
+ * for unaligned data
+ */
+#define AES_CHUNK_SIZE  64
+
+#define AES_OP_ECB      0
+#define AES_OP_CBC      1
+#define AES_OP_CTR      2
+
+#define IS_ALIGNED( p ) ( ( (uintptr_t) ( p ) & 3 ) == 0 )
+
+/* Implementation that should never be optimized out by the compiler */
+static void mbedtls_zeroize( void *v, size_t n ) {
+    volatile unsigned char *p = (unsigned char*)v; while( n-- ) *p++ = 0;
+}
+
+/*
+ * Run length bytes through the engine, chunk by chunk. iv must be word
+ * aligned, it is the chaining value for CBC and the counter for CTR.
+ */
+static void aes_process( mbedtls_aes_context *ctx, int op, int encrypt,
+                         uint32_t iv[4], size_t length,
+                         const unsigned char *input, unsigned char *output )
+{
+    uint32_t bounce[AES_CHUNK_SIZE / 4];
+    int bounced = 0;
+
+    while( length > 0 )
+    {
+        size_t n = length < AES_CHUNK_SIZE ? length : AES_CHUNK_SIZE;
+        const uint8_t *in = input;
+        uint8_t *out = output;
+
+        if( !IS_ALIGNED( input ) || !IS_ALIGNED( output ) )
+        {
+            memcpy( bounce, input, n );
+            in = out = (uint8_t *) bounce;
+            bounced = 1;
+        }
+
+        core_util_critical_section_enter();
+        switch( op )
+        {
+            case AES_OP_ECB:
+                crypto_aes_ecb( out, in, n, (const uint8_t *) ctx->key,
+                                ctx->keybits, encrypt );
+                break;
+            case AES_OP_CBC:
+                crypto_aes_cbc( out, in, n, (const uint8_t *) ctx->key,
+                                ctx->keybits, (uint8_t *) iv, encrypt );
+                break;
+            case AES_OP_CTR:
+                crypto_aes_ctr( out, in, n, (const uint8_t *) ctx->key,
+                                ctx->keybits, (uint8_t *) iv );
+                break;
+        }
+        core_util_critical_section_exit();
+
+        if( out != output )
+            memcpy( output, out, n );
+
+        input  += n;
+        output += n;
+        length -= n;
+    }
+
+    if( bounced )
+        mbedtls_zeroize( bounce, sizeof( bounce ) );
+}
+
+void mbedtls_aes_init( mbedtls_aes_context *ctx )
+{
+    memset( ctx, 0, sizeof( mbedtls_aes_context ) );
+}
+
+void mbedtls_aes_free( mbedtls_aes_context *ctx )
+{
+    if( ctx == NULL )
+        return;
+
+    mbedtls_zeroize( ctx, sizeof( mbedtls_aes_context ) );
+}
+
+/*
+ * AES key schedule (encryption)
+ */
+int mbedtls_aes_setkey_enc( mbedtls_aes_context *ctx, const unsigned char *key,
+                    unsigned int keybits )
+{
+    if( keybits != 128 && keybits != 256 )
+        return( MBEDTLS_ERR_AES_INVALID_KEY_LENGTH );
+
+    memcpy( ctx->key, key, keybits / 8 );
+    ctx->keybits = keybits;
+    ctx->decrypt = 0;
+
+    return( 0 );
+}
+
+/*
+ * AES key schedule (decryption)
+ */
+int mbedtls_aes_setkey_dec( mbedtls_aes_context *ctx, const unsigned char *key,
+                    unsigned int keybits )
+{
+    uint32_t dkey[8];
+    int ret;
+
+    if( ( ret = mbedtls_aes_setkey_enc( ctx, key, keybits ) ) != 0 )
+        return( ret );
+
+    core_util_critical_section_enter();
+    crypto_aes_decrypt_key( (uint8_t *) dkey, (const uint8_t *) ctx->key,
+                            keybits );
+    core_util_critical_section_exit();
+
+    memcpy( ctx->key, dkey, keybits / 8 );
+    ctx->decrypt = 1;
+    mbedtls_zeroize( dkey, sizeof( dkey ) );
+
+    return( 0 );
+}
+
+/*
+ * AES-ECB block encryption/decryption
+ */
+int mbedtls_aes_crypt_ecb( mbedtls_aes_context *ctx,
+                    int mode,
+                    const unsigned char input[16],
+                    unsigned char output[16] )
+{
+    if( ctx->keybits == 0 )
+        return( MBEDTLS_ERR_AES_INVALID_KEY_LENGTH );
+
+    aes_process( ctx, AES_OP_ECB, mode == MBEDTLS_AES_ENCRYPT, NULL, 16,
+                 input, output );
+
+    return( 0 );
+}
+
+void mbedtls_aes_encrypt( mbedtls_aes_context *ctx,
+                          const unsigned char input[16],
+                          unsigned char output[16] )
+{
+    mbedtls_aes_crypt_ecb( ctx, MBEDTLS_AES_ENCRYPT, input, output );
+}
+
+void mbedtls_aes_decrypt( mbedtls_aes_context *ctx,
+                          const unsigned char input[16],
+                          unsigned char output[16] )
+{
+    mbedtls_aes_crypt_ecb( ctx, MBEDTLS_AES_DECRYPT, input, output );
+}
+
+#if defined(MBEDTLS_CIPHER_MODE_CBC)
+/*
+ * AES-CBC buffer encryption/decryption
+ */
+int mbedtls_aes_crypt_cbc( mbedtls_aes_context *ctx,
+                    int mode,
+                    size_t length,
+                    unsigned char iv[16],
+                    const unsigned char *input,
+                    unsigned char *output )
+{
+    uint32_t chain[4];
+
+    if( length % 16 )
+        return( MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH );
+
+    if( ctx->keybits == 0 )
+        return( MBEDTLS_ERR_AES_INVALID_KEY_LENGTH );
+
+    memcpy( chain, iv, 16 );
+    aes_process( ctx, AES_OP_CBC, mode == MBEDTLS_AES_ENCRYPT, chain, length,
+                 input, output );
+    memcpy( iv, chain, 16 );
+
+    return( 0 );
+}
+#endif /* MBEDTLS_CIPHER_MODE_CBC */
+
+#if defined(MBEDTLS_CIPHER_MODE_CFB)
+/*
+ * AES-CFB128 buffer encryption/decryption
+ */
+int mbedtls_aes_crypt_cfb128( mbedtls_aes_context *ctx,
+                       int mode,
+                       size_t length,
+                       size_t *iv_off,
+                       unsigned char iv[16],
+                       const unsigned char *input,
+                       unsigned char *output )
+{
+    int c;
+    size_t n = *iv_off;
+
+    while( length-- )
+    {
+        if( n == 0 )
+            mbedtls_aes_crypt_ecb( ctx, MBEDTLS_AES_ENCRYPT, iv, iv );
+
+        c = *input++;
+        *output = (unsigned char)( c ^ iv[n] );
+        iv[n] = mode == MBEDTLS_AES_DECRYPT ? (unsigned char) c : *output;
+        output++;
+
+        n = ( n + 1 ) & 0x0F;
+    }
+
+    *iv_off = n;
+
+    return( 0 );
+}
+
+/*
+ * AES-CFB8 buffer encryption/decryption
+ */
+int mbedtls_aes_crypt_cfb8( mbedtls_aes_context *ctx,
+                       int mode,
+                       size_t length,
+                       unsigned char iv[16],
+                       const unsigned char *input,
+                       unsigned char *output )
+{
+    unsigned char c;
+    unsigned char ov[17];
+
+    while( length-- )
+    {
+        memcpy( ov, iv, 16 );
+        mbedtls_aes_crypt_ecb( ctx, MBEDTLS_AES_ENCRYPT, iv, iv );
+
+        if( mode == MBEDTLS_AES_DECRYPT )
+            ov[16] = *input;
+
+        c = *output++ = (unsigned char)( iv[0] ^ *input++ );
+
+        if( mode == MBEDTLS_AES_ENCRYPT )
+            ov[16] = c;
+
+        memcpy( iv, ov + 1, 16 );
+    }
+
+    return( 0 );
+}
+#endif /*MBEDTLS_CIPHER_MODE_CFB */
+
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+/*
+ * AES-CTR buffer encryption/decryption
+ *
+ * Whole blocks go to the engine in one pass, only a partial block at
+ * either end goes through stream_block.
+ */
+int mbedtls_aes_crypt_ctr( mbedtls_aes_context *ctx,
+                       size_t length,
+                       size_t *nc_off,
+                       unsigned char nonce_counter[16],
+                       unsigned char stream_block[16],
+                       const unsigned char *input,
+                       unsigned char *output )
+{
+    uint32_t counter[4];
+    uint32_t block[4];
+    size_t n = *nc_off;
+    size_t whole;
+
+    if( ctx->keybits == 0 )
+        return( MBEDTLS_ERR_AES_INVALID_KEY_LENGTH );
+
+    /* Use up what is left of the previous keystream block */
+    while( n != 0 && length > 0 )
+    {
+        *output++ = (unsigned char)( *input++ ^ stream_block[n] );
+        n = ( n + 1 ) & 0x0F;
+        length--;
+    }
+
+    memcpy( counter, nonce_counter, 16 );
+
+    whole = length & ~(size_t) 0x0F;
+    if( whole > 0 )
+    {
+        aes_process( ctx, AES_OP_CTR, 1, counter, whole, input, output );
+        input  += whole;
+        output += whole;
+        length -= whole;
+    }
+
+    if( length > 0 )
+    {
+        /* Keystream for the tail, the counter moves past it */
+        memset( block, 0, sizeof( block ) );
+        aes_process( ctx, AES_OP_CTR, 1, counter, 16,
+                     (const unsigned char *) block, (unsigned char *) block );
+        memcpy( stream_block, block, 16 );
+        mbedtls_zeroize( block, sizeof( block ) );
+
+        while( length-- )
+        {
+            *output++ = (unsigned char)( *input++ ^ stream_block[n] );
+            n++;
+        }
+    }
+
+    memcpy( nonce_counter, counter, 16 );
+    *nc_off = n;
+
+    return( 0 );
+}
+#endif /* MBEDTLS_CIPHER_MODE_CTR */
+
+#endif /* MBEDTLS_AES_C && MBEDTLS_AES_ALT */
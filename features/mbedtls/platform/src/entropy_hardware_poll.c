@@ -0,0 +1,64 @@
+/*
+ *  Hardware entropy source on top of the trng_api HAL
+ *
+ *  Copyright (C) 2016, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+/* Targets without DEVICE_TRNG may still provide their own poll function */
+#if defined(MBEDTLS_ENTROPY_HARDWARE_ALT) && DEVICE_TRNG
+
+#include "mbedtls/entropy.h"
+#include "mbedtls/entropy_poll.h"
+#include "trng_api.h"
+
+#if defined(MBEDTLS_ENTROPY_POOL)
+#include "mbedtls_entropy_pool.h"
+
+#if !defined(MBED_CONF_MBEDTLS_ENTROPY_POOL_TIMEOUT_MS)
+#define MBED_CONF_MBEDTLS_ENTROPY_POOL_TIMEOUT_MS   100
+#endif
+#endif
+
+int mbedtls_hardware_poll( void *data,
+                    unsigned char *output, size_t len, size_t *olen )
+{
+    ((void) data);
+
+#if defined(MBEDTLS_ENTROPY_POOL)
+    /*
+     * Bytes the pool thread read earlier. Returning short after the
+     * timeout is fine: mbedtls_entropy_func() polls again until its
+     * threshold is met.
+     */
+    return( mbedtls_entropy_pool_get( mbedtls_entropy_pool_shared(),
+                                      output, len, olen,
+                                      MBED_CONF_MBEDTLS_ENTROPY_POOL_TIMEOUT_MS ) );
+#else
+    *olen = 0;
+    if( trng_get_bytes( output, len, olen ) != 0 )
+        return( MBEDTLS_ERR_ENTROPY_SOURCE_FAILED );
+
+    return( 0 );
+#endif
+}
+
+#endif /* MBEDTLS_ENTROPY_HARDWARE_ALT && DEVICE_TRNG */
@@ -0,0 +1,400 @@
+/*
+ *  Entropy pool filled ahead of use
+ *
+ *  Copyright (C) 2016, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_ENTROPY_POOL)
+
+#include <string.h>
+
+#include "mbedtls_entropy_pool.h"
+#include "cmsis.h"
+#include "critical.h"
+#include "us_ticker_api.h"
+#include "trng_api.h"
+
+#if defined(MBED_CONF_RTOS_PRESENT)
+#include "cmsis_os.h"
+#endif
+
+#if !defined(MBED_CONF_MBEDTLS_ENTROPY_POOL_THREAD_STACK_SIZE)
+#define MBED_CONF_MBEDTLS_ENTROPY_POOL_THREAD_STACK_SIZE    768
+#endif
+
+/*
+ * Health test cutoffs of NIST SP 800-90B section 4.4 for a false positive
+ * rate of 2^-20, assuming no more than 4 bits of entropy per byte from a
+ * source that claims 8: a byte repeated 6 times in a row, or seen 62
+ * times in a window of 512 bytes, rejects the block it is in.
+ */
+#define POOL_RCT_CUTOFF     6
+#define POOL_APT_WINDOW     512
+#define POOL_APT_CUTOFF     62
+
+/* Implementation that should never be optimized out by the compiler */
+static void mbedtls_zeroize( void *v, size_t n ) {
+    volatile unsigned char *p = v; while( n-- ) *p++ = 0;
+}
+
+static int pool_in_isr( void )
+{
+#if defined(__CORTEX_M)
+    return( __get_IPSR() != 0 );
+#else
+    return( 0 );
+#endif
+}
+
+static void pool_health_reset( mbedtls_entropy_pool_health *h )
+{
+    memset( h, 0, sizeof( mbedtls_entropy_pool_health ) );
+}
+
+/*
+ * Repetition count and adaptive proportion tests over a block, carrying
+ * their state over from the previous blocks of the same source
+ */
+static int pool_health_check( mbedtls_entropy_pool_health *h,
+                              const unsigned char *buf, size_t len )
+{
+    size_t i;
+
+    for( i = 0; i < len; i++ )
+    {
+        if( h->started && buf[i] == h->last )
+        {
+            if( ++h->repeats >= POOL_RCT_CUTOFF )
+                return( -1 );
+        }
+        else
+        {
+            h->last = buf[i];
+            h->repeats = 1;
+            h->started = 1;
+        }
+
+        if( h->apt_samples == 0 )
+        {
+            h->apt_value = buf[i];
+            h->apt_seen = 1;
+        }
+        else if( buf[i] == h->apt_value )
+        {
+            if( ++h->apt_seen >= POOL_APT_CUTOFF )
+                return( -1 );
+        }
+
+        if( ++h->apt_samples == POOL_APT_WINDOW )
+            h->apt_samples = 0;
+    }
+
+    return( 0 );
+}
+
+/*
+ * Timer jitter, XORed into bytes that already passed the health tests.
+ * It is never counted as entropy, so it can only help.
+ */
+static void pool_mix_jitter( unsigned char *buf, size_t len )
+{
+    size_t i;
+    uint32_t t;
+
+    for( i = 0; i < len; i++ )
+    {
+        t = us_ticker_read();
+        buf[i] ^= (unsigned char)( t ^ ( t >> 8 ) );
+    }
+}
+
+/* Append to the ring, as much as fits */
+static void pool_put( mbedtls_entropy_pool *pool,
+                      const unsigned char *buf, size_t len )
+{
+    size_t i, tail;
+
+    core_util_critical_section_enter();
+    for( i = 0; i < len && pool->count < sizeof( pool->buf ); i++ )
+    {
+        tail = ( pool->head + pool->count ) % sizeof( pool->buf );
+        pool->buf[tail] = buf[i];
+        pool->count++;
+    }
+    core_util_critical_section_exit();
+}
+
+/* Take from the ring, wiping what was taken */
+static size_t pool_take( mbedtls_entropy_pool *pool,
+                         unsigned char *output, size_t len )
+{
+    size_t n = 0;
+
+    core_util_critical_section_enter();
+    while( n < len && pool->count > 0 )
+    {
+        output[n++] = pool->buf[pool->head];
+        pool->buf[pool->head] = 0;
+        pool->head = ( pool->head + 1 ) % sizeof( pool->buf );
+        pool->count--;
+    }
+    core_util_critical_section_exit();
+
+    return( n );
+}
+
+void mbedtls_entropy_pool_init( mbedtls_entropy_pool *pool )
+{
+    memset( pool, 0, sizeof( mbedtls_entropy_pool ) );
+}
+
+void mbedtls_entropy_pool_free( mbedtls_entropy_pool *pool )
+{
+    if( pool == NULL )
+        return;
+
+    mbedtls_zeroize( pool, sizeof( mbedtls_entropy_pool ) );
+}
+
+int mbedtls_entropy_pool_add_source( mbedtls_entropy_pool *pool,
+                                     mbedtls_entropy_f_source_ptr f_source,
+                                     void *p_source )
+{
+    int idx;
+
+    core_util_critical_section_enter();
+    idx = pool->source_count;
+    if( idx < MBEDTLS_ENTROPY_POOL_MAX_SOURCES )
+        pool->source_count++;
+    core_util_critical_section_exit();
+
+    if( idx >= MBEDTLS_ENTROPY_POOL_MAX_SOURCES )
+        return( MBEDTLS_ERR_ENTROPY_MAX_SOURCES );
+
+    pool->f_source[idx] = f_source;
+    pool->p_source[idx] = p_source;
+    pool_health_reset( &pool->health[idx] );
+
+    return( 0 );
+}
+
+int mbedtls_entropy_pool_fill( mbedtls_entropy_pool *pool )
+{
+    int ret = 0, i;
+    unsigned char block[MBEDTLS_ENTROPY_POOL_BLOCK];
+    size_t olen;
+
+    if( pool->source_count == 0 )
+        return( MBEDTLS_ERR_ENTROPY_NO_SOURCES_DEFINED );
+
+    /* One fill at a time, so that health state is updated in order */
+    core_util_critical_section_enter();
+    if( pool->filling || pool->count == sizeof( pool->buf ) )
+    {
+        core_util_critical_section_exit();
+        return( 0 );
+    }
+    pool->filling = 1;
+    core_util_critical_section_exit();
+
+    /* Sources may block, so they are polled with interrupts enabled */
+    for( i = 0; i < pool->source_count; i++ )
+    {
+        olen = 0;
+        if( pool->f_source[i]( pool->p_source[i], block, sizeof( block ),
+                               &olen ) != 0 || olen > sizeof( block ) )
+        {
+            ret = MBEDTLS_ERR_ENTROPY_SOURCE_FAILED;
+            continue;
+        }
+
+        if( pool_health_check( &pool->health[i], block, olen ) != 0 )
+        {
+            pool_health_reset( &pool->health[i] );
+            pool->failures++;
+            ret = MBEDTLS_ERR_ENTROPY_SOURCE_FAILED;
+            continue;
+        }
+
+        pool_mix_jitter( block, olen );
+        pool_put( pool, block, olen );
+    }
+
+    mbedtls_zeroize( block, sizeof( block ) );
+    pool->filling = 0;
+
+    return( ret );
+}
+
+size_t mbedtls_entropy_pool_available( const mbedtls_entropy_pool *pool )
+{
+    return( pool->count );
+}
+
+uint32_t mbedtls_entropy_pool_failures( const mbedtls_entropy_pool *pool )
+{
+    return( pool->failures );
+}
+
+#if defined(MBED_CONF_RTOS_PRESENT)
+static mbedtls_entropy_pool shared_pool;
+static osThreadId shared_thread_id;
+
+static void shared_pool_wake( mbedtls_entropy_pool *pool )
+{
+    if( pool == &shared_pool && shared_thread_id != NULL )
+        osSignalSet( shared_thread_id, 1 );
+}
+
+/*
+ * Keeps the shared pool full. It runs below every application thread, so
+ * the TRNG is mostly polled while the system would otherwise be idle.
+ */
+static void shared_pool_thread( void const *arg )
+{
+    size_t before;
+
+    ((void) arg);
+
+    for( ;; )
+    {
+        while( mbedtls_entropy_pool_available( &shared_pool ) <
+               sizeof( shared_pool.buf ) )
+        {
+            before = mbedtls_entropy_pool_available( &shared_pool );
+
+            /* Back off on failures, or while a caller is filling */
+            if( mbedtls_entropy_pool_fill( &shared_pool ) != 0 ||
+                mbedtls_entropy_pool_available( &shared_pool ) == before )
+                osDelay( 1 );
+        }
+
+        osSignalWait( 1, osWaitForever );
+    }
+}
+
+static osThreadDef( shared_pool_thread, osPriorityLow,
+                    MBED_CONF_MBEDTLS_ENTROPY_POOL_THREAD_STACK_SIZE );
+#else
+static mbedtls_entropy_pool shared_pool;
+
+static void shared_pool_wake( mbedtls_entropy_pool *pool )
+{
+    ((void) pool);
+}
+#endif /* MBED_CONF_RTOS_PRESENT */
+
+int mbedtls_entropy_pool_get( mbedtls_entropy_pool *pool,
+                              unsigned char *output, size_t len,
+                              size_t *olen, uint32_t timeout_ms )
+{
+    uint32_t start = us_ticker_read();
+    uint32_t timeout_us;
+    int ret;
+
+    /* us_ticker_read() wraps after 71 minutes */
+    if( timeout_ms > 3600000 )
+        timeout_ms = 3600000;
+    timeout_us = timeout_ms * 1000;
+
+    if( pool_in_isr() )
+        timeout_us = 0;
+
+    *olen = pool_take( pool, output, len );
+
+    while( *olen < len && us_ticker_read() - start < timeout_us )
+    {
+        ret = mbedtls_entropy_pool_fill( pool );
+        if( ret == MBEDTLS_ERR_ENTROPY_NO_SOURCES_DEFINED )
+            break;
+
+#if defined(MBED_CONF_RTOS_PRESENT)
+        /* The filler thread, or another caller, is polling the sources */
+        if( ret == 0 && mbedtls_entropy_pool_available( pool ) == 0 )
+            osDelay( 1 );
+#endif
+
+        *olen += pool_take( pool, output + *olen, len - *olen );
+    }
+
+    shared_pool_wake( pool );
+
+    if( len > 0 && *olen == 0 )
+        return( MBEDTLS_ERR_ENTROPY_SOURCE_FAILED );
+
+    return( 0 );
+}
+
+static int shared_pool_trng( void *data, unsigned char *output, size_t len,
+                             size_t *olen )
+{
+    ((void) data);
+
+    if( trng_get_bytes( output, len, olen ) != 0 )
+        return( MBEDTLS_ERR_ENTROPY_SOURCE_FAILED );
+
+    return( 0 );
+}
+
+mbedtls_entropy_pool *mbedtls_entropy_pool_shared( void )
+{
+    static int started = 0;
+#if defined(MBED_CONF_RTOS_PRESENT)
+    static int thread_started = 0;
+    int start_thread;
+#endif
+
+    /* Cheap enough to set up with interrupts masked */
+    core_util_critical_section_enter();
+    if( !started )
+    {
+        started = 1;
+        mbedtls_entropy_pool_init( &shared_pool );
+        mbedtls_entropy_pool_add_source( &shared_pool, shared_pool_trng, NULL );
+    }
+    core_util_critical_section_exit();
+
+#if defined(MBED_CONF_RTOS_PRESENT)
+    /* Threads can't be created from an interrupt, so the thread is left
+     * to the first call from a thread */
+    if( thread_started || pool_in_isr() )
+        return( &shared_pool );
+
+    core_util_critical_section_enter();
+    start_thread = !thread_started;
+    thread_started = 1;
+    core_util_critical_section_exit();
+
+    if( start_thread )
+    {
+        shared_thread_id = osThreadCreate( osThread( shared_pool_thread ), NULL );
+
+        /* Out of memory for the thread, a later call tries again */
+        if( shared_thread_id == NULL )
+            thread_started = 0;
+    }
+#endif
+
+    return( &shared_pool );
+}
+
+#endif /* MBEDTLS_ENTROPY_POOL */
@@ -0,0 +1,63 @@
+/*
+ *  SHA-1 compression function on top of the crypto_api HAL
+ *
+ *  Copyright (C) 2016, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_SHA1_C) && defined(MBEDTLS_SHA1_PROCESS_ALT)
+
+#include <string.h>
+
+#include "mbedtls/sha1.h"
+#include "crypto_api.h"
+#include "critical.h"
+
+/* Implementation that should never be optimized out by the compiler */
+static void mbedtls_zeroize( void *v, size_t n ) {
+    volatile unsigned char *p = v; while( n-- ) *p++ = 0;
+}
+
+/*
+ * sha1.c keeps buffering, padding and the initial state, only the
+ * compression of each 64 byte block is done by the engine
+ */
+void mbedtls_sha1_process( mbedtls_sha1_context *ctx, const unsigned char data[64] )
+{
+    uint32_t block[16];
+    const unsigned char *p = data;
+
+    /* The engine reads whole words */
+    if( ( (uintptr_t) data & 3 ) != 0 )
+    {
+        memcpy( block, data, 64 );
+        p = (const unsigned char *) block;
+    }
+
+    core_util_critical_section_enter();
+    crypto_sha1_process( ctx->state, p, 1 );
+    core_util_critical_section_exit();
+
+    if( p != data )
+        mbedtls_zeroize( block, sizeof( block ) );
+}
+
+#endif /* MBEDTLS_SHA1_C && MBEDTLS_SHA1_PROCESS_ALT */
@@ -87,7 +87,7 @@ static void mbedtls_zeroize( void *v, size_t n ) {
 static int aes_padlock_ace = -1;
 #endif
 
-#if defined(MBEDTLS_AES_ROM_TABLES)
+#if defined(MBEDTLS_AES_ROM_TABLES) || defined(MBEDTLS_AES_COMPACT)
 /*
  * Forward S-box
  */
@@ -127,6 +127,7 @@ static const unsigned char FSb[256] =
     0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
 };
 
+#if !defined(MBEDTLS_AES_COMPACT)
 /*
  * Forward tables
  */
@@ -214,6 +215,7 @@ static const uint32_t FT3[256] = { FT };
 #undef V
 
 #undef FT
+#endif /* !MBEDTLS_AES_COMPACT */
 
 /*
  * Reverse S-box
@@ -254,6 +256,7 @@ static const unsigned char RSb[256] =
     0xE1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0C, 0x7D
 };
 
+#if !defined(MBEDTLS_AES_COMPACT)
 /*
  * Reverse tables
  */
@@ -341,6 +344,7 @@ static const uint32_t RT3[256] = { RT };
 #undef V
 
 #undef RT
+#endif /* !MBEDTLS_AES_COMPACT */
 
 /*
  * Round constants
@@ -352,7 +356,7 @@ static const uint32_t RCON[10] =
     0x0000001B, 0x00000036
 };
 
-#else /* MBEDTLS_AES_ROM_TABLES */
+#else /* MBEDTLS_AES_ROM_TABLES || MBEDTLS_AES_COMPACT */
 
 /*
  * Forward S-box & tables
@@ -462,7 +466,39 @@ static void aes_gen_tables( void )
     }
 }
 
-#endif /* MBEDTLS_AES_ROM_TABLES */
+#endif /* MBEDTLS_AES_ROM_TABLES || MBEDTLS_AES_COMPACT */
+
+#if defined(MBEDTLS_AES_COMPACT)
+/*
+ * MixColumns on a whole column, one byte per row with row 0 in the low
+ * byte. xtime() is done on all four bytes at once, no table and no
+ * data-dependent branch is involved.
+ */
+#define AES_XTIME4(w)   ( ( ( (w) & 0x7F7F7F7F ) << 1 ) ^       \
+                          ( ( ( (w) >> 7 ) & 0x01010101 ) * 0x1B ) )
+#define AES_ROR(w,n)    ( ( (w) >> (n) ) | ( (w) << ( 32 - (n) ) ) )
+
+static uint32_t aes_mix_column( uint32_t w )
+{
+    uint32_t r = AES_ROR( w, 8 );
+
+    return( AES_XTIME4( w ^ r ) ^ r ^ AES_ROR( w, 16 ) ^ AES_ROR( w, 24 ) );
+}
+
+/*
+ * InvMixColumns, computed as MixColumns of the column with 4 * (a[i] ^
+ * a[i+2]) added to each row
+ */
+static uint32_t aes_inv_mix_column( uint32_t w )
+{
+    uint32_t u = w ^ AES_ROR( w, 16 );
+
+    u = AES_XTIME4( u );
+    u = AES_XTIME4( u );
+
+    return( aes_mix_column( w ^ u ) );
+}
+#endif /* MBEDTLS_AES_COMPACT */
 
 void mbedtls_aes_init( mbedtls_aes_context *ctx )
 {
@@ -487,7 +523,7 @@ int mbedtls_aes_setkey_enc( mbedtls_aes_context *ctx, const unsigned char *key,
     unsigned int i;
     uint32_t *RK;
 
-#if !defined(MBEDTLS_AES_ROM_TABLES)
+#if !defined(MBEDTLS_AES_ROM_TABLES) && !defined(MBEDTLS_AES_COMPACT)
     if( aes_init_done == 0 )
     {
         aes_gen_tables();
@@ -641,10 +677,14 @@ int mbedtls_aes_setkey_dec( mbedtls_aes_context *ctx, const unsigned char *key,
     {
         for( j = 0; j < 4; j++, SK++ )
         {
+#if defined(MBEDTLS_AES_COMPACT)
+            *RK++ = aes_inv_mix_column( *SK );
+#else
             *RK++ = RT0[ FSb[ ( *SK       ) & 0xFF ] ] ^
                     RT1[ FSb[ ( *SK >>  8 ) & 0xFF ] ] ^
                     RT2[ FSb[ ( *SK >> 16 ) & 0xFF ] ] ^
                     RT3[ FSb[ ( *SK >> 24 ) & 0xFF ] ];
+#endif
         }
     }
 
@@ -660,6 +700,42 @@ exit:
 }
 #endif /* !MBEDTLS_AES_SETKEY_DEC_ALT */
 
+#if defined(MBEDTLS_AES_COMPACT)
+
+/*
+ * One S-box lookup per byte then the column mix on the packed word. The
+ * S-boxes are the only tables left, 512 bytes of ROM in total.
+ */
+#define AES_FSUB(Y0,Y1,Y2,Y3)                                   \
+    ( ( (uint32_t) FSb[ ( Y0       ) & 0xFF ]       ) ^         \
+      ( (uint32_t) FSb[ ( Y1 >>  8 ) & 0xFF ] <<  8 ) ^         \
+      ( (uint32_t) FSb[ ( Y2 >> 16 ) & 0xFF ] << 16 ) ^         \
+      ( (uint32_t) FSb[ ( Y3 >> 24 ) & 0xFF ] << 24 ) )
+
+#define AES_RSUB(Y0,Y1,Y2,Y3)                                   \
+    ( ( (uint32_t) RSb[ ( Y0       ) & 0xFF ]       ) ^         \
+      ( (uint32_t) RSb[ ( Y1 >>  8 ) & 0xFF ] <<  8 ) ^         \
+      ( (uint32_t) RSb[ ( Y2 >> 16 ) & 0xFF ] << 16 ) ^         \
+      ( (uint32_t) RSb[ ( Y3 >> 24 ) & 0xFF ] << 24 ) )
+
+#define AES_FROUND(X0,X1,X2,X3,Y0,Y1,Y2,Y3)                     \
+{                                                               \
+    X0 = *RK++ ^ aes_mix_column( AES_FSUB( Y0, Y1, Y2, Y3 ) );  \
+    X1 = *RK++ ^ aes_mix_column( AES_FSUB( Y1, Y2, Y3, Y0 ) );  \
+    X2 = *RK++ ^ aes_mix_column( AES_FSUB( Y2, Y3, Y0, Y1 ) );  \
+    X3 = *RK++ ^ aes_mix_column( AES_FSUB( Y3, Y0, Y1, Y2 ) );  \
+}
+
+#define AES_RROUND(X0,X1,X2,X3,Y0,Y1,Y2,Y3)                         \
+{                                                                   \
+    X0 = *RK++ ^ aes_inv_mix_column( AES_RSUB( Y0, Y3, Y2, Y1 ) );  \
+    X1 = *RK++ ^ aes_inv_mix_column( AES_RSUB( Y1, Y0, Y3, Y2 ) );  \
+    X2 = *RK++ ^ aes_inv_mix_column( AES_RSUB( Y2, Y1, Y0, Y3 ) );  \
+    X3 = *RK++ ^ aes_inv_mix_column( AES_RSUB( Y3, Y2, Y1, Y0 ) );  \
+}
+
+#else /* MBEDTLS_AES_COMPACT */
+
 #define AES_FROUND(X0,X1,X2,X3,Y0,Y1,Y2,Y3)     \
 {                                               \
     X0 = *RK++ ^ FT0[ ( Y0       ) & 0xFF ] ^   \
@@ -706,6 +782,8 @@ exit:
                  RT3[ ( Y0 >> 24 ) & 0xFF ];    \
 }
 
+#endif /* MBEDTLS_AES_COMPACT */
+
 /*
  * AES-ECB block encryption
  */
@@ -37,6 +37,7 @@
 #if defined(MBEDTLS_CCM_C)
 
 #include "mbedtls/ccm.h"
+#include "mbedtls/cipher_internal.h"
 
 #include <string.h>
 
@@ -108,6 +109,16 @@ void mbedtls_ccm_free( mbedtls_ccm_context *ctx )
  * Results in smaller compiled code than static inline functions.
  */
 
+/*
+ * Encrypt one block with the key, calling the block cipher directly rather
+ * than through mbedtls_cipher_update(), which only adds checks per block
+ */
+#define ENCRYPT_BLOCK( in, out )                                            \
+    if( ( ret = ctx->cipher_ctx.cipher_info->base->ecb_func(                \
+                    ctx->cipher_ctx.cipher_ctx, MBEDTLS_ENCRYPT,            \
+                    in, out ) ) != 0 )                                      \
+        return( ret );
+
 /*
  * Update the CBC-MAC state in y using a block in b
  * (Always using b as the source helps the compiler optimise a bit better.)
@@ -116,8 +127,7 @@ void mbedtls_ccm_free( mbedtls_ccm_context *ctx )
     for( i = 0; i < 16; i++ )                                               \
         y[i] ^= b[i];                                                       \
                                                                             \
-    if( ( ret = mbedtls_cipher_update( &ctx->cipher_ctx, y, 16, y, &olen ) ) != 0 ) \
-        return( ret );
+    ENCRYPT_BLOCK( y, y );
 
 /*
  * Encrypt or decrypt a partial block with CTR
@@ -125,8 +135,7 @@ void mbedtls_ccm_free( mbedtls_ccm_context *ctx )
  * This avoids allocating one more 16 bytes buffer while allowing src == dst.
  */
 #define CTR_CRYPT( dst, src, len  )                                            \
-    if( ( ret = mbedtls_cipher_update( &ctx->cipher_ctx, ctr, 16, b, &olen ) ) != 0 )  \
-        return( ret );                                                         \
+    ENCRYPT_BLOCK( ctr, b );                                                   \
                                                                                \
     for( i = 0; i < len; i++ )                                                 \
         dst[i] = src[i] ^ b[i];
@@ -143,8 +152,9 @@ static int ccm_auth_crypt( mbedtls_ccm_context *ctx, int mode, size_t length,
     int ret;
     unsigned char i;
     unsigned char q;
-    size_t len_left, olen;
+    size_t len_left;
     unsigned char b[16];
+    unsigned char p[16];
     unsigned char y[16];
     unsigned char ctr[16];
     const unsigned char *src;
@@ -165,6 +175,10 @@ static int ccm_auth_crypt( mbedtls_ccm_context *ctx, int mode, size_t length,
     if( add_len > 0xFF00 )
         return( MBEDTLS_ERR_CCM_BAD_INPUT );
 
+    /* No key set */
+    if( ctx->cipher_ctx.cipher_info == NULL )
+        return( MBEDTLS_ERR_CCM_BAD_INPUT );
+
     q = 16 - 1 - (unsigned char) iv_len;
 
     /*
@@ -260,17 +274,48 @@ static int ccm_auth_crypt( mbedtls_ccm_context *ctx, int mode, size_t length,
     {
         size_t use_len = len_left > 16 ? 16 : len_left;
 
-        if( mode == CCM_ENCRYPT )
+        if( use_len == 16 )
+        {
+            /*
+             * Whole block: keystream, then CBC-MAC input and output in a
+             * single loop over local buffers, which the compiler can keep
+             * in registers. p holds the block so that src == dst works.
+             */
+            ENCRYPT_BLOCK( ctr, b );
+            memcpy( p, src, 16 );
+
+            if( mode == CCM_ENCRYPT )
+            {
+                for( i = 0; i < 16; i++ )
+                {
+                    y[i] ^= p[i];
+                    p[i] ^= b[i];
+                }
+            }
+            else
+            {
+                for( i = 0; i < 16; i++ )
+                {
+                    p[i] ^= b[i];
+                    y[i] ^= p[i];
+                }
+            }
+
+            memcpy( dst, p, 16 );
+            ENCRYPT_BLOCK( y, y );
+        }
+        else if( mode == CCM_ENCRYPT )
         {
             memset( b, 0, 16 );
             memcpy( b, src, use_len );
             UPDATE_CBC_MAC;
-        }
 
-        CTR_CRYPT( dst, src, use_len );
-
-        if( mode == CCM_DECRYPT )
+            CTR_CRYPT( dst, src, use_len );
+        }
+        else
         {
+            CTR_CRYPT( dst, src, use_len );
+
             memset( b, 0, 16 );
             memcpy( b, dst, use_len );
             UPDATE_CBC_MAC;
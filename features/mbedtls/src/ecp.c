@@ -334,7 +334,8 @@ void mbedtls_ecp_group_free( mbedtls_ecp_group *grp )
         mbedtls_mpi_free( &grp->N );
     }
 
-    if( grp->T != NULL )
+    /* T_size is 0 for the constant tables of MBEDTLS_ECP_ROM_TABLES */
+    if( grp->T != NULL && grp->T_size != 0 )
     {
         for( i = 0; i < grp->T_size; i++ )
             mbedtls_ecp_point_free( &grp->T[i] );
@@ -1362,6 +1363,8 @@ static int ecp_mul_comb( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
     /*
      * Prepare precomputed points: if P == G we want to
      * use grp->T if already initialized, or initialize it.
+     * With MBEDTLS_ECP_ROM_TABLES it is already set to a constant table
+     * built for this w on the curves that have one.
      */
     T = p_eq_g ? grp->T : NULL;
 
@@ -569,6 +569,48 @@ static inline void ecp_mpi_set1( mbedtls_mpi *X )
     X->p = one;
 }
 
+#if defined(MBEDTLS_ECP_ROM_TABLES)
+/*
+ * Precomputed comb tables for the generators, see ecp_mul_comb()
+ */
+#define ECP_MPI_INIT_ARRAY( x )                                         \
+    { 1, sizeof( x ) / sizeof( mbedtls_mpi_uint ), (mbedtls_mpi_uint *) x }
+
+#define ECP_POINT_INIT_XY_Z1( x, y )                                    \
+    { ECP_MPI_INIT_ARRAY( x ), ECP_MPI_INIT_ARRAY( y ),                 \
+      ECP_MPI_INIT_ARRAY( ecp_comb_one ) }
+
+typedef struct
+{
+    mbedtls_ecp_group_id id;
+    const mbedtls_ecp_point *T;
+}
+ecp_comb_table;
+
+static const mbedtls_mpi_uint ecp_comb_one[] = { 1 };
+
+#include "ecp_comb_tables.h"
+
+/*
+ * Attach the constant table for the group, if there is one. T_size stays 0
+ * so that mbedtls_ecp_group_free() leaves it alone.
+ */
+static void ecp_comb_table_load( mbedtls_ecp_group *grp )
+{
+    const ecp_comb_table *t;
+
+    for( t = ecp_comb_tables; t->T != NULL; t++ )
+    {
+        if( t->id == grp->id )
+        {
+            grp->T = (mbedtls_ecp_point *) t->T;
+            grp->T_size = 0;
+            return;
+        }
+    }
+}
+#endif /* MBEDTLS_ECP_ROM_TABLES */
+
 /*
  * Make group available from embedded constants
  */
@@ -595,6 +637,10 @@ static int ecp_group_load( mbedtls_ecp_group *grp,
 
     grp->h = 1;
 
+#if defined(MBEDTLS_ECP_ROM_TABLES)
+    ecp_comb_table_load( grp );
+#endif
+
     return( 0 );
 }
 
@@ -38,6 +38,7 @@
 #if defined(MBEDTLS_GCM_C)
 
 #include "mbedtls/gcm.h"
+#include "mbedtls/cipher_internal.h"
 
 #include <string.h>
 
@@ -91,47 +92,62 @@ void mbedtls_gcm_init( mbedtls_gcm_context *ctx )
 }
 
 /*
- * Precompute small multiples of H, that is set
- *      HH[i] || HL[i] = H times i,
- * where i is seen as a field element as in [MGV], ie high-order bits
- * correspond to low powers of P. The result is stored in the same way, that
- * is the high-order bit of HH corresponds to P^0 and the low-order bit of HL
- * corresponds to P^127.
+ * Encrypt one block with the key, calling the block cipher directly rather
+ * than through mbedtls_cipher_update(), which only adds checks per block
  */
-static int gcm_gen_table( mbedtls_gcm_context *ctx )
+static int gcm_encrypt_block( mbedtls_gcm_context *ctx,
+                              const unsigned char input[16],
+                              unsigned char output[16] )
 {
-    int ret, i, j;
+    return( ctx->cipher_ctx.cipher_info->base->ecb_func(
+                ctx->cipher_ctx.cipher_ctx, MBEDTLS_ENCRYPT, input, output ) );
+}
+
+/*
+ * Compute the hash key H = E(K, 0^128) as two 64-bit ints, big-endian
+ */
+static int gcm_hash_key( mbedtls_gcm_context *ctx, uint64_t *vh, uint64_t *vl )
+{
+    int ret;
     uint64_t hi, lo;
-    uint64_t vl, vh;
     unsigned char h[16];
-    size_t olen = 0;
 
     memset( h, 0, 16 );
-    if( ( ret = mbedtls_cipher_update( &ctx->cipher_ctx, h, 16, h, &olen ) ) != 0 )
+    if( ( ret = gcm_encrypt_block( ctx, h, h ) ) != 0 )
         return( ret );
 
     /* pack h as two 64-bits ints, big-endian */
     GET_UINT32_BE( hi, h,  0  );
     GET_UINT32_BE( lo, h,  4  );
-    vh = (uint64_t) hi << 32 | lo;
+    *vh = (uint64_t) hi << 32 | lo;
 
     GET_UINT32_BE( hi, h,  8  );
     GET_UINT32_BE( lo, h,  12 );
-    vl = (uint64_t) hi << 32 | lo;
+    *vl = (uint64_t) hi << 32 | lo;
 
-    /* 8 = 1000 corresponds to 1 in GF(2^128) */
-    ctx->HL[8] = vl;
-    ctx->HH[8] = vh;
+    return( 0 );
+}
 
-#if defined(MBEDTLS_AESNI_C) && defined(MBEDTLS_HAVE_X86_64)
-    /* With CLMUL support, we need only h, not the rest of the table */
-    if( mbedtls_aesni_has_support( MBEDTLS_AESNI_CLMUL ) )
-        return( 0 );
-#endif
+/*
+ * Precompute small multiples of H, that is set
+ *      HH[i] || HL[i] = H times i,
+ * where i is seen as a field element as in [MGV], ie high-order bits
+ * correspond to low powers of P. The result is stored in the same way, that
+ * is the high-order bit of HH corresponds to P^0 and the low-order bit of HL
+ * corresponds to P^127.
+ */
+static void gcm_fill_table( uint64_t HL[16], uint64_t HH[16],
+                            uint64_t vh, uint64_t vl )
+{
+    int i, j;
+
+    /* 8 = 1000 corresponds to 1 in GF(2^128) */
+    HL[8] = vl;
+    HH[8] = vh;
 
     /* 0 corresponds to 0 in GF(2^128) */
-    ctx->HH[0] = 0;
-    ctx->HL[0] = 0;
+    HH[0] = 0;
+    HL[0] = 0;
 
     for( i = 4; i > 0; i >>= 1 )
     {
@@ -139,29 +155,52 @@ static int gcm_gen_table( mbedtls_gcm_context *ctx )
         vl  = ( vh << 63 ) | ( vl >> 1 );
         vh  = ( vh >> 1 ) ^ ( (uint64_t) T << 32);
 
-        ctx->HL[i] = vl;
-        ctx->HH[i] = vh;
+        HL[i] = vl;
+        HH[i] = vh;
     }
 
     for( i = 2; i <= 8; i *= 2 )
     {
-        uint64_t *HiL = ctx->HL + i, *HiH = ctx->HH + i;
+        uint64_t *HiL = HL + i, *HiH = HH + i;
         vh = *HiH;
         vl = *HiL;
         for( j = 1; j < i; j++ )
         {
-            HiH[j] = vh ^ ctx->HH[j];
-            HiL[j] = vl ^ ctx->HL[j];
+            HiH[j] = vh ^ HH[j];
+            HiL[j] = vl ^ HL[j];
         }
     }
+}
+
+static int gcm_gen_table( mbedtls_gcm_context *ctx )
+{
+    int ret;
+    uint64_t vl, vh;
+
+    if( ( ret = gcm_hash_key( ctx, &vh, &vl ) ) != 0 )
+        return( ret );
+
+    ctx->table = NULL;
+
+#if defined(MBEDTLS_AESNI_C) && defined(MBEDTLS_HAVE_X86_64)
+    /* With CLMUL support, we need only h, not the rest of the table */
+    if( mbedtls_aesni_has_support( MBEDTLS_AESNI_CLMUL ) )
+    {
+        ctx->HL[8] = vl;
+        ctx->HH[8] = vh;
+        return( 0 );
+    }
+#endif
+
+    gcm_fill_table( ctx->HL, ctx->HH, vh, vl );
 
     return( 0 );
 }
 
-int mbedtls_gcm_setkey( mbedtls_gcm_context *ctx,
-                        mbedtls_cipher_id_t cipher,
-                        const unsigned char *key,
-                        unsigned int keybits )
+static int gcm_setkey_cipher( mbedtls_gcm_context *ctx,
+                              mbedtls_cipher_id_t cipher,
+                              const unsigned char *key,
+                              unsigned int keybits )
 {
     int ret;
     const mbedtls_cipher_info_t *cipher_info;
@@ -184,12 +223,75 @@ int mbedtls_gcm_setkey( mbedtls_gcm_context *ctx,
         return( ret );
     }
 
+    return( 0 );
+}
+
+int mbedtls_gcm_setkey( mbedtls_gcm_context *ctx,
+                        mbedtls_cipher_id_t cipher,
+                        const unsigned char *key,
+                        unsigned int keybits )
+{
+    int ret;
+
+    if( ( ret = gcm_setkey_cipher( ctx, cipher, key, keybits ) ) != 0 )
+        return( ret );
+
     if( ( ret = gcm_gen_table( ctx ) ) != 0 )
         return( ret );
 
     return( 0 );
 }
 
+int mbedtls_gcm_setkey_table( mbedtls_gcm_context *ctx,
+                              mbedtls_cipher_id_t cipher,
+                              const unsigned char *key,
+                              unsigned int keybits,
+                              const mbedtls_gcm_table *table )
+{
+    int ret;
+    uint64_t vl, vh;
+
+    if( ( ret = gcm_setkey_cipher( ctx, cipher, key, keybits ) ) != 0 )
+        return( ret );
+
+    /* One block to check that the table is for this key */
+    if( ( ret = gcm_hash_key( ctx, &vh, &vl ) ) != 0 )
+        return( ret );
+
+    if( table->HL[8] != vl || table->HH[8] != vh )
+        return( MBEDTLS_ERR_GCM_BAD_INPUT );
+
+    /* H alone, for CLMUL */
+    ctx->HL[8] = vl;
+    ctx->HH[8] = vh;
+    ctx->table = table;
+
+    return( 0 );
+}
+
+int mbedtls_gcm_table_gen( mbedtls_gcm_table *table,
+                           mbedtls_cipher_id_t cipher,
+                           const unsigned char *key,
+                           unsigned int keybits )
+{
+    int ret;
+    uint64_t vl, vh;
+    mbedtls_gcm_context ctx;
+
+    mbedtls_gcm_init( &ctx );
+
+    if( ( ret = gcm_setkey_cipher( &ctx, cipher, key, keybits ) ) == 0 &&
+        ( ret = gcm_hash_key( &ctx, &vh, &vl ) ) == 0 )
+    {
+        /* The whole table, even where CLMUL would not need it */
+        gcm_fill_table( table->HL, table->HH, vh, vl );
+    }
+
+    mbedtls_gcm_free( &ctx );
+
+    return( ret );
+}
+
 /*
  * Shoup's method for multiplication use this table with
  *      last4[x] = x times P^128
@@ -213,6 +315,7 @@ static void gcm_mult( mbedtls_gcm_context *ctx, const unsigned char x[16],
     int i = 0;
     unsigned char lo, hi, rem;
     uint64_t zh, zl;
+    const uint64_t *HL = ctx->HL, *HH = ctx->HH;
 
 #if defined(MBEDTLS_AESNI_C) && defined(MBEDTLS_HAVE_X86_64)
     if( mbedtls_aesni_has_support( MBEDTLS_AESNI_CLMUL ) ) {
@@ -228,10 +331,16 @@ static void gcm_mult( mbedtls_gcm_context *ctx, const unsigned char x[16],
     }
 #endif /* MBEDTLS_AESNI_C && MBEDTLS_HAVE_X86_64 */
 
+    if( ctx->table != NULL )
+    {
+        HL = ctx->table->HL;
+        HH = ctx->table->HH;
+    }
+
     lo = x[15] & 0xf;
 
-    zh = ctx->HH[lo];
-    zl = ctx->HL[lo];
+    zh = HH[lo];
+    zl = HL[lo];
 
     for( i = 15; i >= 0; i-- )
     {
@@ -244,8 +353,8 @@ static void gcm_mult( mbedtls_gcm_context *ctx, const unsigned char x[16],
             zl = ( zh << 60 ) | ( zl >> 4 );
             zh = ( zh >> 4 );
             zh ^= (uint64_t) last4[rem] << 48;
-            zh ^= ctx->HH[lo];
-            zl ^= ctx->HL[lo];
+            zh ^= HH[lo];
+            zl ^= HL[lo];
 
         }
 
@@ -253,8 +362,8 @@ static void gcm_mult( mbedtls_gcm_context *ctx, const unsigned char x[16],
         zl = ( zh << 60 ) | ( zl >> 4 );
         zh = ( zh >> 4 );
         zh ^= (uint64_t) last4[rem] << 48;
-        zh ^= ctx->HH[hi];
-        zl ^= ctx->HL[hi];
+        zh ^= HH[hi];
+        zl ^= HL[hi];
     }
 
     PUT_UINT32_BE( zh >> 32, output, 0 );
@@ -274,7 +383,7 @@ int mbedtls_gcm_starts( mbedtls_gcm_context *ctx,
     unsigned char work_buf[16];
     size_t i;
     const unsigned char *p;
-    size_t use_len, olen = 0;
+    size_t use_len;
 
     /* IV and AD are limited to 2^64 bits, so 2^61 bytes */
     if( ( (uint64_t) iv_len  ) >> 61 != 0 ||
@@ -283,6 +392,10 @@ int mbedtls_gcm_starts( mbedtls_gcm_context *ctx,
         return( MBEDTLS_ERR_GCM_BAD_INPUT );
     }
 
+    /* No key set */
+    if( ctx->cipher_ctx.cipher_info == NULL )
+        return( MBEDTLS_ERR_GCM_BAD_INPUT );
+
     memset( ctx->y, 0x00, sizeof(ctx->y) );
     memset( ctx->buf, 0x00, sizeof(ctx->buf) );
 
@@ -320,11 +433,8 @@ int mbedtls_gcm_starts( mbedtls_gcm_context *ctx,
         gcm_mult( ctx, ctx->y, ctx->y );
     }
 
-    if( ( ret = mbedtls_cipher_update( &ctx->cipher_ctx, ctx->y, 16, ctx->base_ectr,
-                             &olen ) ) != 0 )
-    {
+    if( ( ret = gcm_encrypt_block( ctx, ctx->y, ctx->base_ectr ) ) != 0 )
         return( ret );
-    }
 
     ctx->add_len = add_len;
     p = add;
@@ -350,11 +460,12 @@ int mbedtls_gcm_update( mbedtls_gcm_context *ctx,
                 unsigned char *output )
 {
     int ret;
-    unsigned char ectr[16];
-    size_t i;
+    size_t i, offset;
     const unsigned char *p;
     unsigned char *out_p = output;
-    size_t use_len, olen = 0;
+    unsigned char c, e;
+    unsigned char block[16];
+    size_t use_len;
 
     if( output > input && (size_t) ( output - input ) < length )
         return( MBEDTLS_ERR_GCM_BAD_INPUT );
@@ -367,33 +478,71 @@ int mbedtls_gcm_update( mbedtls_gcm_context *ctx,
         return( MBEDTLS_ERR_GCM_BAD_INPUT );
     }
 
+    /* Where the previous call stopped in its last block */
+    offset = (size_t)( ctx->len % 16 );
     ctx->len += length;
 
     p = input;
     while( length > 0 )
     {
-        use_len = ( length < 16 ) ? length : 16;
-
-        for( i = 16; i > 12; i-- )
-            if( ++ctx->y[i - 1] != 0 )
-                break;
-
-        if( ( ret = mbedtls_cipher_update( &ctx->cipher_ctx, ctx->y, 16, ectr,
-                                   &olen ) ) != 0 )
+        if( offset == 0 )
         {
-            return( ret );
+            for( i = 16; i > 12; i-- )
+                if( ++ctx->y[i - 1] != 0 )
+                    break;
+
+            if( ( ret = gcm_encrypt_block( ctx, ctx->y, ctx->ectr ) ) != 0 )
+                return( ret );
         }
 
-        for( i = 0; i < use_len; i++ )
+        use_len = ( length < 16 - offset ) ? length : 16 - offset;
+
+        if( use_len == 16 )
         {
-            if( ctx->mode == MBEDTLS_GCM_DECRYPT )
-                ctx->buf[i] ^= p[i];
-            out_p[i] = ectr[i] ^ p[i];
+            /*
+             * Whole block, in a local copy so that the loop only touches
+             * buffers the compiler knows apart, and input == output works
+             */
+            memcpy( block, p, 16 );
+
             if( ctx->mode == MBEDTLS_GCM_ENCRYPT )
-                ctx->buf[i] ^= out_p[i];
+            {
+                for( i = 0; i < 16; i++ )
+                {
+                    block[i] ^= ctx->ectr[i];
+                    ctx->buf[i] ^= block[i];
+                }
+            }
+            else
+            {
+                for( i = 0; i < 16; i++ )
+                {
+                    ctx->buf[i] ^= block[i];
+                    block[i] ^= ctx->ectr[i];
+                }
+            }
+
+            memcpy( out_p, block, 16 );
+        }
+        else
+        {
+            /* c is read before out_p is written, so input == output works */
+            for( i = 0; i < use_len; i++ )
+            {
+                c = p[i];
+                e = ctx->ectr[offset + i] ^ c;
+                out_p[i] = e;
+                ctx->buf[offset + i] ^= ( ctx->mode == MBEDTLS_GCM_ENCRYPT ) ? e : c;
+            }
         }
 
-        gcm_mult( ctx, ctx->buf, ctx->buf );
+        /* A partial block is hashed once complete, or by finish */
+        offset += use_len;
+        if( offset == 16 )
+        {
+            gcm_mult( ctx, ctx->buf, ctx->buf );
+            offset = 0;
+        }
 
         length -= use_len;
         p += use_len;
@@ -403,6 +552,25 @@ int mbedtls_gcm_update( mbedtls_gcm_context *ctx,
     return( 0 );
 }
 
+int mbedtls_gcm_update_iov( mbedtls_gcm_context *ctx,
+                            const mbedtls_gcm_iovec *iov,
+                            size_t iovcnt )
+{
+    int ret;
+    size_t i;
+
+    for( i = 0; i < iovcnt; i++ )
+    {
+        if( ( ret = mbedtls_gcm_update( ctx, iov[i].len, iov[i].input,
+                                        iov[i].output ) ) != 0 )
+        {
+            return( ret );
+        }
+    }
+
+    return( 0 );
+}
+
 int mbedtls_gcm_finish( mbedtls_gcm_context *ctx,
                 unsigned char *tag,
                 size_t tag_len )
@@ -420,6 +588,10 @@ int mbedtls_gcm_finish( mbedtls_gcm_context *ctx,
 
     if( orig_len || orig_add_len )
     {
+        /* Last block of the data, if it was partial */
+        if( ctx->len % 16 != 0 )
+            gcm_mult( ctx, ctx->buf, ctx->buf );
+
         memset( work_buf, 0x00, 16 );
 
         PUT_UINT32_BE( ( orig_add_len >> 32 ), work_buf, 0  );
@@ -436,6 +608,8 @@ int mbedtls_gcm_finish( mbedtls_gcm_context *ctx,
             tag[i] ^= ctx->buf[i];
     }
 
+    mbedtls_zeroize( ctx->ectr, sizeof( ctx->ectr ) );
+
     return( 0 );
 }
 
@@ -51,8 +51,8 @@ static void mbedtls_zeroize( void *v, size_t n ) {
 #define MAGIC2       0xEE119966
 #define MAX_BT 20
 
-typedef struct _memory_header memory_header;
-struct _memory_header
+typedef struct mbedtls_memory_header memory_header;
+struct mbedtls_memory_header
 {
     size_t          magic1;
     size_t          size;
@@ -68,28 +68,20 @@ struct _memory_header
     size_t          magic2;
 };
 
-typedef struct
-{
-    unsigned char   *buf;
-    size_t          len;
-    memory_header   *first;
-    memory_header   *first_free;
-    int             verify;
-#if defined(MBEDTLS_MEMORY_DEBUG)
-    size_t          alloc_count;
-    size_t          free_count;
-    size_t          total_used;
-    size_t          maximum_used;
-    size_t          header_count;
-    size_t          maximum_header_count;
-#endif
-#if defined(MBEDTLS_THREADING_C)
-    mbedtls_threading_mutex_t   mutex;
-#endif
-}
-buffer_alloc_ctx;
+typedef mbedtls_memory_buffer_arena buffer_alloc_ctx;
 
+/*
+ * The default heap, the arenas set up next to it and the one that takes
+ * allocations right now, if any. Allocations that none of them take, and
+ * frees of memory outside all of them, go to the allocator that was
+ * installed before.
+ */
 static buffer_alloc_ctx heap;
+static buffer_alloc_ctx *arenas;
+static buffer_alloc_ctx *selected;
+
+static void * (*fallback_calloc)( size_t, size_t );
+static void (*fallback_free)( void * );
 
 #if defined(MBEDTLS_MEMORY_DEBUG)
 static void debug_header( memory_header *hdr )
@@ -113,9 +105,9 @@ static void debug_header( memory_header *hdr )
 #endif
 }
 
-static void debug_chain()
+static void debug_chain( buffer_alloc_ctx *ctx )
 {
-    memory_header *cur = heap.first;
+    memory_header *cur = ctx->first;
 
     mbedtls_fprintf( stderr, "\nBlock list\n" );
     while( cur != NULL )
@@ -125,7 +117,7 @@ static void debug_chain()
     }
 
     mbedtls_fprintf( stderr, "Free list\n" );
-    cur = heap.first_free;
+    cur = ctx->first_free;
 
     while( cur != NULL )
     {
@@ -180,11 +172,11 @@ static int verify_header( memory_header *hdr )
     return( 0 );
 }
 
-static int verify_chain()
+static int verify_chain( buffer_alloc_ctx *ctx )
 {
-    memory_header *prv = heap.first, *cur = heap.first->next;
+    memory_header *prv = ctx->first, *cur = ctx->first->next;
 
-    if( verify_header( heap.first ) != 0 )
+    if( verify_header( ctx->first ) != 0 )
     {
 #if defined(MBEDTLS_MEMORY_DEBUG)
         mbedtls_fprintf( stderr, "FATAL: verification of first header "
@@ -193,7 +185,7 @@ static int verify_chain()
         return( 1 );
     }
 
-    if( heap.first->prev != NULL )
+    if( ctx->first->prev != NULL )
     {
 #if defined(MBEDTLS_MEMORY_DEBUG)
         mbedtls_fprintf( stderr, "FATAL: verification failed: "
@@ -229,9 +221,25 @@ static int verify_chain()
     return( 0 );
 }
 
-static void *buffer_alloc_calloc( size_t n, size_t size )
+/*
+ * Raise the overall peaks and the ones of the current phase
+ */
+static void update_peaks( buffer_alloc_ctx *ctx )
 {
-    memory_header *new, *cur = heap.first_free;
+    if( ctx->total_used > ctx->maximum_used )
+        ctx->maximum_used = ctx->total_used;
+    if( ctx->header_count > ctx->maximum_header_count )
+        ctx->maximum_header_count = ctx->header_count;
+
+    if( ctx->total_used > ctx->phase_used[ctx->phase] )
+        ctx->phase_used[ctx->phase] = ctx->total_used;
+    if( ctx->header_count > ctx->phase_blocks[ctx->phase] )
+        ctx->phase_blocks[ctx->phase] = ctx->header_count;
+}
+
+static void *arena_calloc( buffer_alloc_ctx *ctx, size_t n, size_t size )
+{
+    memory_header *new, *cur = ctx->first_free;
     unsigned char *p;
     void *ret;
     size_t original_len, len;
@@ -240,7 +248,7 @@ static void *buffer_alloc_calloc( size_t n, size_t size )
     size_t trace_cnt;
 #endif
 
-    if( heap.buf == NULL || heap.first == NULL )
+    if( ctx->buf == NULL || ctx->first == NULL )
         return( NULL );
 
     original_len = len = n * size;
@@ -276,9 +284,7 @@ static void *buffer_alloc_calloc( size_t n, size_t size )
         mbedtls_exit( 1 );
     }
 
-#if defined(MBEDTLS_MEMORY_DEBUG)
-    heap.alloc_count++;
-#endif
+    ctx->alloc_count++;
 
     // Found location, split block if > memory_header + 4 room left
     //
@@ -292,7 +298,7 @@ static void *buffer_alloc_calloc( size_t n, size_t size )
         if( cur->prev_free != NULL )
             cur->prev_free->next_free = cur->next_free;
         else
-            heap.first_free = cur->next_free;
+            ctx->first_free = cur->next_free;
 
         if( cur->next_free != NULL )
             cur->next_free->prev_free = cur->prev_free;
@@ -300,18 +306,15 @@ static void *buffer_alloc_calloc( size_t n, size_t size )
         cur->prev_free = NULL;
         cur->next_free = NULL;
 
-#if defined(MBEDTLS_MEMORY_DEBUG)
-        heap.total_used += cur->size;
-        if( heap.total_used > heap.maximum_used )
-            heap.maximum_used = heap.total_used;
-#endif
+        ctx->total_used += cur->size;
+        update_peaks( ctx );
 #if defined(MBEDTLS_MEMORY_BACKTRACE)
         trace_cnt = backtrace( trace_buffer, MAX_BT );
         cur->trace = backtrace_symbols( trace_buffer, trace_cnt );
         cur->trace_count = trace_cnt;
 #endif
 
-        if( ( heap.verify & MBEDTLS_MEMORY_VERIFY_ALLOC ) && verify_chain() != 0 )
+        if( ( ctx->verify & MBEDTLS_MEMORY_VERIFY_ALLOC ) && verify_chain( ctx ) != 0 )
             mbedtls_exit( 1 );
 
         ret = (unsigned char *) cur + sizeof( memory_header );
@@ -344,7 +347,7 @@ static void *buffer_alloc_calloc( size_t n, size_t size )
     if( new->prev_free != NULL )
         new->prev_free->next_free = new;
     else
-        heap.first_free = new;
+        ctx->first_free = new;
 
     if( new->next_free != NULL )
         new->next_free->prev_free = new;
@@ -355,21 +358,16 @@ static void *buffer_alloc_calloc( size_t n, size_t size )
     cur->prev_free = NULL;
     cur->next_free = NULL;
 
-#if defined(MBEDTLS_MEMORY_DEBUG)
-    heap.header_count++;
-    if( heap.header_count > heap.maximum_header_count )
-        heap.maximum_header_count = heap.header_count;
-    heap.total_used += cur->size;
-    if( heap.total_used > heap.maximum_used )
-        heap.maximum_used = heap.total_used;
-#endif
+    ctx->header_count++;
+    ctx->total_used += cur->size;
+    update_peaks( ctx );
 #if defined(MBEDTLS_MEMORY_BACKTRACE)
     trace_cnt = backtrace( trace_buffer, MAX_BT );
     cur->trace = backtrace_symbols( trace_buffer, trace_cnt );
     cur->trace_count = trace_cnt;
 #endif
 
-    if( ( heap.verify & MBEDTLS_MEMORY_VERIFY_ALLOC ) && verify_chain() != 0 )
+    if( ( ctx->verify & MBEDTLS_MEMORY_VERIFY_ALLOC ) && verify_chain( ctx ) != 0 )
         mbedtls_exit( 1 );
 
     ret = (unsigned char *) cur + sizeof( memory_header );
@@ -378,23 +376,14 @@ static void *buffer_alloc_calloc( size_t n, size_t size )
     return( ret );
 }
 
-static void buffer_alloc_free( void *ptr )
+static void arena_free( buffer_alloc_ctx *ctx, void *ptr )
 {
     memory_header *hdr, *old = NULL;
     unsigned char *p = (unsigned char *) ptr;
 
-    if( ptr == NULL || heap.buf == NULL || heap.first == NULL )
+    if( ptr == NULL || ctx->buf == NULL || ctx->first == NULL )
         return;
 
-    if( p < heap.buf || p > heap.buf + heap.len )
-    {
-#if defined(MBEDTLS_MEMORY_DEBUG)
-        mbedtls_fprintf( stderr, "FATAL: mbedtls_free() outside of managed "
-                                  "space\n" );
-#endif
-        mbedtls_exit( 1 );
-    }
-
     p -= sizeof(memory_header);
     hdr = (memory_header *) p;
 
@@ -412,10 +401,8 @@ static void buffer_alloc_free( void *ptr )
 
     hdr->alloc = 0;
 
-#if defined(MBEDTLS_MEMORY_DEBUG)
-    heap.free_count++;
-    heap.total_used -= hdr->size;
-#endif
+    ctx->free_count++;
+    ctx->total_used -= hdr->size;
 
 #if defined(MBEDTLS_MEMORY_BACKTRACE)
     free( hdr->trace );
@@ -427,9 +414,7 @@ static void buffer_alloc_free( void *ptr )
     //
     if( hdr->prev != NULL && hdr->prev->alloc == 0 )
     {
-#if defined(MBEDTLS_MEMORY_DEBUG)
-        heap.header_count--;
-#endif
+        ctx->header_count--;
         hdr->prev->size += sizeof(memory_header) + hdr->size;
         hdr->prev->next = hdr->next;
         old = hdr;
@@ -445,9 +430,7 @@ static void buffer_alloc_free( void *ptr )
     //
     if( hdr->next != NULL && hdr->next->alloc == 0 )
     {
-#if defined(MBEDTLS_MEMORY_DEBUG)
-        heap.header_count--;
-#endif
+        ctx->header_count--;
         hdr->size += sizeof(memory_header) + hdr->next->size;
         old = hdr->next;
         hdr->next = hdr->next->next;
@@ -457,7 +440,7 @@ static void buffer_alloc_free( void *ptr )
             if( hdr->prev_free != NULL )
                 hdr->prev_free->next_free = hdr->next_free;
             else
-                heap.first_free = hdr->next_free;
+                ctx->first_free = hdr->next_free;
 
             if( hdr->next_free != NULL )
                 hdr->next_free->prev_free = hdr->prev_free;
@@ -469,7 +452,7 @@ static void buffer_alloc_free( void *ptr )
         if( hdr->prev_free != NULL )
             hdr->prev_free->next_free = hdr;
         else
-            heap.first_free = hdr;
+            ctx->first_free = hdr;
 
         if( hdr->next_free != NULL )
             hdr->next_free->prev_free = hdr;
@@ -485,24 +468,161 @@ static void buffer_alloc_free( void *ptr )
     //
     if( old == NULL )
     {
-        hdr->next_free = heap.first_free;
-        if( heap.first_free != NULL )
-            heap.first_free->prev_free = hdr;
-        heap.first_free = hdr;
+        hdr->next_free = ctx->first_free;
+        if( ctx->first_free != NULL )
+            ctx->first_free->prev_free = hdr;
+        ctx->first_free = hdr;
+    }
+
+    if( ( ctx->verify & MBEDTLS_MEMORY_VERIFY_FREE ) && verify_chain( ctx ) != 0 )
+        mbedtls_exit( 1 );
+}
+
+/*
+ * Arena that holds ptr, if any
+ */
+static buffer_alloc_ctx *buffer_alloc_owner( void *ptr )
+{
+    buffer_alloc_ctx *ctx;
+    unsigned char *p = (unsigned char *) ptr;
+
+    if( heap.buf != NULL && p >= heap.buf && p < heap.buf + heap.len )
+        return( &heap );
+
+    for( ctx = arenas; ctx != NULL; ctx = ctx->next )
+    {
+        if( p >= ctx->buf && p < ctx->buf + ctx->len )
+            return( ctx );
     }
 
-    if( ( heap.verify & MBEDTLS_MEMORY_VERIFY_FREE ) && verify_chain() != 0 )
+    return( NULL );
+}
+
+static void *buffer_alloc_calloc( size_t n, size_t size )
+{
+    buffer_alloc_ctx *ctx = selected;
+    void *buf;
+
+    if( ctx == NULL && heap.buf != NULL )
+        ctx = &heap;
+
+    if( ctx == NULL )
+        return( fallback_calloc != NULL ? fallback_calloc( n, size ) : NULL );
+
+#if defined(MBEDTLS_THREADING_C)
+    if( mbedtls_mutex_lock( &ctx->mutex ) != 0 )
+        return( NULL );
+#endif
+    buf = arena_calloc( ctx, n, size );
+#if defined(MBEDTLS_THREADING_C)
+    if( mbedtls_mutex_unlock( &ctx->mutex ) )
+        return( NULL );
+#endif
+    return( buf );
+}
+
+static void buffer_alloc_free( void *ptr )
+{
+    buffer_alloc_ctx *ctx;
+
+    if( ptr == NULL )
+        return;
+
+    if( ( ctx = buffer_alloc_owner( ptr ) ) == NULL )
+    {
+        /* Without a default heap, memory from outside the arenas is
+         * expected and came from the previous allocator */
+        if( heap.buf == NULL && fallback_free != NULL )
+        {
+            fallback_free( ptr );
+            return;
+        }
+
+#if defined(MBEDTLS_MEMORY_DEBUG)
+        mbedtls_fprintf( stderr, "FATAL: mbedtls_free() outside of managed "
+                                  "space\n" );
+#endif
         mbedtls_exit( 1 );
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    /* We have to good option here, but corrupting the heap seems
+     * worse than loosing memory. */
+    if( mbedtls_mutex_lock( &ctx->mutex ) )
+        return;
+#endif
+    arena_free( ctx, ptr );
+#if defined(MBEDTLS_THREADING_C)
+    (void) mbedtls_mutex_unlock( &ctx->mutex );
+#endif
+}
+
+/*
+ * Route mbedtls_calloc() and mbedtls_free() through this module, keeping
+ * whatever was installed before for memory that no arena handles
+ */
+static void buffer_alloc_install( void )
+{
+    if( mbedtls_calloc == buffer_alloc_calloc )
+        return;
+
+    fallback_calloc = mbedtls_calloc;
+    fallback_free = mbedtls_free;
+    mbedtls_platform_set_calloc_free( buffer_alloc_calloc, buffer_alloc_free );
+}
+
+static void buffer_alloc_setup( buffer_alloc_ctx *ctx,
+                                unsigned char *buf, size_t len )
+{
+    memset( ctx, 0, sizeof(buffer_alloc_ctx) );
+    memset( buf, 0, len );
+
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_mutex_init( &ctx->mutex );
+#endif
+
+    if( (size_t) buf % MBEDTLS_MEMORY_ALIGN_MULTIPLE )
+    {
+        /* Adjust len first since buf is used in the computation */
+        len -= MBEDTLS_MEMORY_ALIGN_MULTIPLE
+             - (size_t) buf % MBEDTLS_MEMORY_ALIGN_MULTIPLE;
+        buf += MBEDTLS_MEMORY_ALIGN_MULTIPLE
+             - (size_t) buf % MBEDTLS_MEMORY_ALIGN_MULTIPLE;
+    }
+
+    ctx->buf = buf;
+    ctx->len = len;
+
+    ctx->first = (memory_header *) buf;
+    ctx->first->size = len - sizeof(memory_header);
+    ctx->first->magic1 = MAGIC1;
+    ctx->first->magic2 = MAGIC2;
+    ctx->first_free = ctx->first;
 }
 
 void mbedtls_memory_buffer_set_verify( int verify )
 {
+    buffer_alloc_ctx *ctx;
+
     heap.verify = verify;
+    for( ctx = arenas; ctx != NULL; ctx = ctx->next )
+        ctx->verify = verify;
 }
 
 int mbedtls_memory_buffer_alloc_verify()
 {
-    return verify_chain();
+    buffer_alloc_ctx *ctx;
+
+    if( heap.buf != NULL && verify_chain( &heap ) != 0 )
+        return( 1 );
+
+    for( ctx = arenas; ctx != NULL; ctx = ctx->next )
+    {
+        if( verify_chain( ctx ) != 0 )
+            return( 1 );
+    }
+
+    return( 0 );
 }
 
 #if defined(MBEDTLS_MEMORY_DEBUG)
@@ -522,14 +642,14 @@ void mbedtls_memory_buffer_alloc_status()
     else
     {
         mbedtls_fprintf( stderr, "Memory currently allocated:\n" );
-        debug_chain();
+        debug_chain( &heap );
     }
 }
+#endif /* MBEDTLS_MEMORY_DEBUG */
 
 void mbedtls_memory_buffer_alloc_max_get( size_t *max_used, size_t *max_blocks )
 {
-    *max_used   = heap.maximum_used;
-    *max_blocks = heap.maximum_header_count;
+    mbedtls_memory_buffer_arena_max_get( &heap, max_used, max_blocks );
 }
 
 void mbedtls_memory_buffer_alloc_max_reset( void )
@@ -540,72 +660,108 @@ void mbedtls_memory_buffer_alloc_max_reset( void )
 
 void mbedtls_memory_buffer_alloc_cur_get( size_t *cur_used, size_t *cur_blocks )
 {
-    *cur_used   = heap.total_used;
-    *cur_blocks = heap.header_count;
+    mbedtls_memory_buffer_arena_cur_get( &heap, cur_used, cur_blocks );
 }
-#endif /* MBEDTLS_MEMORY_DEBUG */
 
-#if defined(MBEDTLS_THREADING_C)
-static void *buffer_alloc_calloc_mutexed( size_t n, size_t size )
+void mbedtls_memory_buffer_alloc_init( unsigned char *buf, size_t len )
 {
-    void *buf;
-    if( mbedtls_mutex_lock( &heap.mutex ) != 0 )
-        return( NULL );
-    buf = buffer_alloc_calloc( n, size );
-    if( mbedtls_mutex_unlock( &heap.mutex ) )
-        return( NULL );
-    return( buf );
+    buffer_alloc_setup( &heap, buf, len );
+    buffer_alloc_install();
 }
 
-static void buffer_alloc_free_mutexed( void *ptr )
+void mbedtls_memory_buffer_alloc_free()
 {
-    /* We have to good option here, but corrupting the heap seems
-     * worse than loosing memory. */
-    if( mbedtls_mutex_lock( &heap.mutex ) )
-        return;
-    buffer_alloc_free( ptr );
-    (void) mbedtls_mutex_unlock( &heap.mutex );
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_mutex_free( &heap.mutex );
+#endif
+    mbedtls_zeroize( &heap, sizeof(buffer_alloc_ctx) );
 }
-#endif /* MBEDTLS_THREADING_C */
 
-void mbedtls_memory_buffer_alloc_init( unsigned char *buf, size_t len )
+void mbedtls_memory_buffer_arena_init( mbedtls_memory_buffer_arena *arena,
+                                       unsigned char *buf, size_t len )
 {
-    memset( &heap, 0, sizeof(buffer_alloc_ctx) );
-    memset( buf, 0, len );
+    buffer_alloc_setup( arena, buf, len );
+    arena->verify = heap.verify;
+
+    arena->next = arenas;
+    arenas = arena;
+
+    buffer_alloc_install();
+}
+
+void mbedtls_memory_buffer_arena_free( mbedtls_memory_buffer_arena *arena )
+{
+    buffer_alloc_ctx **cur;
+
+    if( arena == NULL )
+        return;
+
+    for( cur = &arenas; *cur != NULL; cur = &(*cur)->next )
+    {
+        if( *cur == arena )
+        {
+            *cur = arena->next;
+            break;
+        }
+    }
+
+    if( selected == arena )
+        selected = NULL;
 
 #if defined(MBEDTLS_THREADING_C)
-    mbedtls_mutex_init( &heap.mutex );
-    mbedtls_platform_set_calloc_free( buffer_alloc_calloc_mutexed,
-                              buffer_alloc_free_mutexed );
-#else
-    mbedtls_platform_set_calloc_free( buffer_alloc_calloc, buffer_alloc_free );
+    mbedtls_mutex_free( &arena->mutex );
 #endif
+    mbedtls_zeroize( arena, sizeof(buffer_alloc_ctx) );
+}
 
-    if( (size_t) buf % MBEDTLS_MEMORY_ALIGN_MULTIPLE )
+mbedtls_memory_buffer_arena *mbedtls_memory_buffer_arena_select(
+                                        mbedtls_memory_buffer_arena *arena )
+{
+    buffer_alloc_ctx *prev = selected;
+
+    selected = arena;
+
+    return( prev );
+}
+
+void mbedtls_memory_buffer_arena_set_phase( mbedtls_memory_buffer_arena *arena,
+                                            int phase )
+{
+    if( phase < 0 || phase >= MBEDTLS_MEMORY_PHASE_MAX )
+        return;
+
+    arena->phase = phase;
+
+    /* What is in use when the phase starts counts towards its peak */
+    update_peaks( arena );
+}
+
+void mbedtls_memory_buffer_arena_max_get( const mbedtls_memory_buffer_arena *arena,
+                                          size_t *max_used, size_t *max_blocks )
+{
+    *max_used   = arena->maximum_used;
+    *max_blocks = arena->maximum_header_count;
+}
+
+void mbedtls_memory_buffer_arena_phase_get( const mbedtls_memory_buffer_arena *arena,
+                                            int phase,
+                                            size_t *max_used, size_t *max_blocks )
+{
+    if( phase < 0 || phase >= MBEDTLS_MEMORY_PHASE_MAX )
     {
-        /* Adjust len first since buf is used in the computation */
-        len -= MBEDTLS_MEMORY_ALIGN_MULTIPLE
-             - (size_t) buf % MBEDTLS_MEMORY_ALIGN_MULTIPLE;
-        buf += MBEDTLS_MEMORY_ALIGN_MULTIPLE
-             - (size_t) buf % MBEDTLS_MEMORY_ALIGN_MULTIPLE;
+        *max_used = *max_blocks = 0;
+        return;
     }
 
-    heap.buf = buf;
-    heap.len = len;
-
-    heap.first = (memory_header *) buf;
-    heap.first->size = len - sizeof(memory_header);
-    heap.first->magic1 = MAGIC1;
-    heap.first->magic2 = MAGIC2;
-    heap.first_free = heap.first;
+    *max_used   = arena->phase_used[phase];
+    *max_blocks = arena->phase_blocks[phase];
 }
 
-void mbedtls_memory_buffer_alloc_free()
+void mbedtls_memory_buffer_arena_cur_get( const mbedtls_memory_buffer_arena *arena,
+                                          size_t *cur_used, size_t *cur_blocks )
 {
-#if defined(MBEDTLS_THREADING_C)
-    mbedtls_mutex_free( &heap.mutex );
-#endif
-    mbedtls_zeroize( &heap, sizeof(buffer_alloc_ctx) );
+    *cur_used   = arena->total_used;
+    *cur_blocks = arena->header_count;
 }
 
 #if defined(MBEDTLS_SELF_TEST)
@@ -620,14 +776,11 @@ static int check_pointer( void *p )
     return( 0 );
 }
 
-static int check_all_free( )
+static int check_all_free( buffer_alloc_ctx *ctx )
 {
-    if(
-#if defined(MBEDTLS_MEMORY_DEBUG)
-        heap.total_used != 0 ||
-#endif
-        heap.first != heap.first_free ||
-        (void *) heap.first != (void *) heap.buf )
+    if( ctx->total_used != 0 ||
+        ctx->first != ctx->first_free ||
+        (void *) ctx->first != (void *) ctx->buf )
     {
         return( -1 );
     }
@@ -648,9 +801,14 @@ static int check_all_free( )
 int mbedtls_memory_buffer_alloc_self_test( int verbose )
 {
     unsigned char buf[1024];
+    unsigned char abuf[512];
     unsigned char *p, *q, *r, *end;
+    mbedtls_memory_buffer_arena arena, *prev;
+    size_t used, blocks;
     int ret = 0;
 
+    memset( &arena, 0, sizeof( arena ) );
+
     if( verbose != 0 )
         mbedtls_printf( "  MBA test #1 (basic alloc-free cycle): " );
 
@@ -668,7 +826,7 @@ int mbedtls_memory_buffer_alloc_self_test( int verbose )
     mbedtls_free( q );
     mbedtls_free( p );
 
-    TEST_ASSERT( check_all_free( ) == 0 );
+    TEST_ASSERT( check_all_free( &heap ) == 0 );
 
     /* Memorize end to compare with the next test */
     end = heap.buf + heap.len;
@@ -697,7 +855,7 @@ int mbedtls_memory_buffer_alloc_self_test( int verbose )
     mbedtls_free( q );
     mbedtls_free( p );
 
-    TEST_ASSERT( check_all_free( ) == 0 );
+    TEST_ASSERT( check_all_free( &heap ) == 0 );
 
     mbedtls_memory_buffer_alloc_free( );
 
@@ -728,14 +886,62 @@ int mbedtls_memory_buffer_alloc_self_test( int verbose )
 
     mbedtls_free( p );
 
-    TEST_ASSERT( check_all_free( ) == 0 );
+    TEST_ASSERT( check_all_free( &heap ) == 0 );
+
+    mbedtls_memory_buffer_alloc_free( );
+
+    if( verbose != 0 )
+        mbedtls_printf( "passed\n" );
+
+    if( verbose != 0 )
+        mbedtls_printf( "  MBA test #4 (arena and phases): " );
+
+    mbedtls_memory_buffer_alloc_init( buf, sizeof( buf ) );
+    mbedtls_memory_buffer_arena_init( &arena, abuf, sizeof( abuf ) );
+
+    p = mbedtls_calloc( 1, 64 );
+
+    prev = mbedtls_memory_buffer_arena_select( &arena );
+    mbedtls_memory_buffer_arena_set_phase( &arena,
+                                           MBEDTLS_MEMORY_PHASE_CERT_PARSE );
+    q = mbedtls_calloc( 1, 128 );
+    mbedtls_memory_buffer_arena_set_phase( &arena,
+                                           MBEDTLS_MEMORY_PHASE_RECORD_IO );
+    r = mbedtls_calloc( 1, 16 );
+    TEST_ASSERT( mbedtls_memory_buffer_arena_select( prev ) == &arena );
+
+    TEST_ASSERT( check_pointer( p ) == 0 &&
+                 check_pointer( q ) == 0 &&
+                 check_pointer( r ) == 0 );
+    TEST_ASSERT( p >= heap.buf && p < heap.buf + heap.len );
+    TEST_ASSERT( q >= arena.buf && q < arena.buf + arena.len &&
+                 r >= arena.buf && r < arena.buf + arena.len );
+
+    /* Frees find their arena whichever one is selected */
+    mbedtls_free( q );
+    mbedtls_free( r );
+    mbedtls_free( p );
+
+    TEST_ASSERT( check_all_free( &heap ) == 0 &&
+                 check_all_free( &arena ) == 0 );
+
+    mbedtls_memory_buffer_arena_phase_get( &arena,
+                        MBEDTLS_MEMORY_PHASE_CERT_PARSE, &used, &blocks );
+    TEST_ASSERT( used == 128 && blocks == 1 );
+    mbedtls_memory_buffer_arena_phase_get( &arena,
+                        MBEDTLS_MEMORY_PHASE_RECORD_IO, &used, &blocks );
+    TEST_ASSERT( used == 144 && blocks == 2 );
+    mbedtls_memory_buffer_arena_max_get( &arena, &used, &blocks );
+    TEST_ASSERT( used == 144 && blocks == 2 );
 
+    mbedtls_memory_buffer_arena_free( &arena );
     mbedtls_memory_buffer_alloc_free( );
 
     if( verbose != 0 )
         mbedtls_printf( "passed\n" );
 
 cleanup:
+    mbedtls_memory_buffer_arena_free( &arena );
     mbedtls_memory_buffer_alloc_free( );
 
     return( ret );
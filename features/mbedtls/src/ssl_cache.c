@@ -19,8 +19,8 @@
  *  This file is part of mbed TLS (https://tls.mbed.org)
  */
 /*
- * These session callbacks use a simple chained list
- * to store and retrieve the session information.
+ * These session callbacks keep the sessions in a fixed arena, indexed by a
+ * hash of the session ID and ordered by last use for eviction.
  */
 
 #if !defined(MBEDTLS_CONFIG_FILE)
@@ -57,6 +57,183 @@ void mbedtls_ssl_cache_init( mbedtls_ssl_cache_context *cache )
 #endif
 }
 
+/*
+ * FNV-1a over the session ID
+ */
+static unsigned int ssl_cache_hash( const mbedtls_ssl_cache_context *cache,
+                                    const unsigned char *id, size_t id_len )
+{
+    uint32_t h = 2166136261u;
+
+    while( id_len-- )
+        h = ( h ^ *id++ ) * 16777619u;
+
+    return( (unsigned int) h & cache->hash_mask );
+}
+
+/*
+ * Allocate the arena and hash table for max_entries entries, with at least
+ * as many buckets as entries
+ */
+static int ssl_cache_setup( mbedtls_ssl_cache_context *cache )
+{
+    unsigned char *mem;
+    size_t buckets = 1;
+    int i;
+
+    if( cache->max_entries <= 0 )
+        return( 1 );
+
+    while( buckets < (size_t) cache->max_entries )
+        buckets <<= 1;
+
+    mem = mbedtls_calloc( 1, cache->max_entries * sizeof( mbedtls_ssl_cache_entry ) +
+                             buckets * sizeof( mbedtls_ssl_cache_entry * ) );
+    if( mem == NULL )
+        return( 1 );
+
+    cache->arena = (mbedtls_ssl_cache_entry *) mem;
+    cache->buckets = (mbedtls_ssl_cache_entry **)
+        ( mem + cache->max_entries * sizeof( mbedtls_ssl_cache_entry ) );
+    cache->hash_mask = (unsigned int) buckets - 1;
+
+    for( i = cache->max_entries - 1; i >= 0; i-- )
+    {
+        cache->arena[i].next = cache->free;
+        cache->free = &cache->arena[i];
+    }
+
+    return( 0 );
+}
+
+/*
+ * Release the sessions and the arena, the statistics are kept
+ */
+static void ssl_cache_flush( mbedtls_ssl_cache_context *cache )
+{
+    mbedtls_ssl_cache_entry *cur;
+
+    for( cur = cache->lru_head; cur != NULL; cur = cur->lru_next )
+    {
+        mbedtls_ssl_session_free( &cur->session );
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+        mbedtls_free( cur->peer_cert.p );
+#endif /* MBEDTLS_X509_CRT_PARSE_C */
+    }
+
+    mbedtls_free( cache->arena );
+
+    cache->arena = NULL;
+    cache->buckets = NULL;
+    cache->hash_mask = 0;
+    cache->free = NULL;
+    cache->lru_head = NULL;
+    cache->lru_tail = NULL;
+    cache->stats.entries = 0;
+}
+
+static mbedtls_ssl_cache_entry *ssl_cache_find( mbedtls_ssl_cache_context *cache,
+                                                const unsigned char *id,
+                                                size_t id_len )
+{
+    mbedtls_ssl_cache_entry *cur;
+
+    if( cache->buckets == NULL )
+        return( NULL );
+
+    cur = cache->buckets[ssl_cache_hash( cache, id, id_len )];
+
+    while( cur != NULL )
+    {
+        if( cur->session.id_len == id_len &&
+            memcmp( cur->session.id, id, id_len ) == 0 )
+            break;
+
+        cur = cur->next;
+    }
+
+    return( cur );
+}
+
+static void ssl_cache_lru_unlink( mbedtls_ssl_cache_context *cache,
+                                  mbedtls_ssl_cache_entry *entry )
+{
+    if( entry->lru_prev != NULL )
+        entry->lru_prev->lru_next = entry->lru_next;
+    else
+        cache->lru_head = entry->lru_next;
+
+    if( entry->lru_next != NULL )
+        entry->lru_next->lru_prev = entry->lru_prev;
+    else
+        cache->lru_tail = entry->lru_prev;
+
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+}
+
+static void ssl_cache_lru_push( mbedtls_ssl_cache_context *cache,
+                                mbedtls_ssl_cache_entry *entry )
+{
+    entry->lru_prev = NULL;
+    entry->lru_next = cache->lru_head;
+
+    if( cache->lru_head != NULL )
+        cache->lru_head->lru_prev = entry;
+    else
+        cache->lru_tail = entry;
+
+    cache->lru_head = entry;
+}
+
+/*
+ * Take an entry out of its hash bucket and the LRU list, its session and
+ * peer certificate are left for the caller to release or overwrite
+ */
+static void ssl_cache_unlink( mbedtls_ssl_cache_context *cache,
+                              mbedtls_ssl_cache_entry *entry )
+{
+    mbedtls_ssl_cache_entry **pp;
+
+    pp = &cache->buckets[ssl_cache_hash( cache, entry->session.id,
+                                         entry->session.id_len )];
+    while( *pp != entry )
+        pp = &(*pp)->next;
+    *pp = entry->next;
+    entry->next = NULL;
+
+    ssl_cache_lru_unlink( cache, entry );
+    cache->stats.entries--;
+}
+
+/*
+ * Drop an entry and return it to the free list
+ */
+static void ssl_cache_release( mbedtls_ssl_cache_context *cache,
+                               mbedtls_ssl_cache_entry *entry )
+{
+    ssl_cache_unlink( cache, entry );
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    mbedtls_free( entry->peer_cert.p );
+#endif
+    memset( entry, 0, sizeof( mbedtls_ssl_cache_entry ) );
+
+    entry->next = cache->free;
+    cache->free = entry;
+}
+
+#if defined(MBEDTLS_HAVE_TIME)
+static int ssl_cache_expired( const mbedtls_ssl_cache_context *cache,
+                              const mbedtls_ssl_cache_entry *entry,
+                              mbedtls_time_t t )
+{
+    return( cache->timeout != 0 &&
+            (int) ( t - entry->timestamp ) > cache->timeout );
+}
+#endif /* MBEDTLS_HAVE_TIME */
+
 int mbedtls_ssl_cache_get( void *data, mbedtls_ssl_session *session )
 {
     int ret = 1;
@@ -64,68 +241,66 @@ int mbedtls_ssl_cache_get( void *data, mbedtls_ssl_session *session )
     mbedtls_time_t t = mbedtls_time( NULL );
 #endif
     mbedtls_ssl_cache_context *cache = (mbedtls_ssl_cache_context *) data;
-    mbedtls_ssl_cache_entry *cur, *entry;
+    mbedtls_ssl_cache_entry *entry;
 
 #if defined(MBEDTLS_THREADING_C)
     if( mbedtls_mutex_lock( &cache->mutex ) != 0 )
         return( 1 );
 #endif
 
-    cur = cache->chain;
-    entry = NULL;
-
-    while( cur != NULL )
-    {
-        entry = cur;
-        cur = cur->next;
+    entry = ssl_cache_find( cache, session->id, session->id_len );
 
 #if defined(MBEDTLS_HAVE_TIME)
-        if( cache->timeout != 0 &&
-            (int) ( t - entry->timestamp ) > cache->timeout )
-            continue;
+    if( entry != NULL && ssl_cache_expired( cache, entry, t ) )
+    {
+        ssl_cache_release( cache, entry );
+        cache->stats.expirations++;
+        entry = NULL;
+    }
 #endif
 
-        if( session->ciphersuite != entry->session.ciphersuite ||
-            session->compression != entry->session.compression ||
-            session->id_len != entry->session.id_len )
-            continue;
-
-        if( memcmp( session->id, entry->session.id,
-                    entry->session.id_len ) != 0 )
-            continue;
+    if( entry == NULL ||
+        session->ciphersuite != entry->session.ciphersuite ||
+        session->compression != entry->session.compression )
+    {
+        cache->stats.misses++;
+        goto exit;
+    }
 
-        memcpy( session->master, entry->session.master, 48 );
+    memcpy( session->master, entry->session.master, 48 );
 
-        session->verify_result = entry->session.verify_result;
+    session->verify_result = entry->session.verify_result;
 
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
-        /*
-         * Restore peer certificate (without rest of the original chain)
-         */
-        if( entry->peer_cert.p != NULL )
+    /*
+     * Restore peer certificate (without rest of the original chain)
+     */
+    if( entry->peer_cert.p != NULL )
+    {
+        if( ( session->peer_cert = mbedtls_calloc( 1,
+                             sizeof(mbedtls_x509_crt) ) ) == NULL )
         {
-            if( ( session->peer_cert = mbedtls_calloc( 1,
-                                 sizeof(mbedtls_x509_crt) ) ) == NULL )
-            {
-                ret = 1;
-                goto exit;
-            }
-
-            mbedtls_x509_crt_init( session->peer_cert );
-            if( mbedtls_x509_crt_parse( session->peer_cert, entry->peer_cert.p,
-                                entry->peer_cert.len ) != 0 )
-            {
-                mbedtls_free( session->peer_cert );
-                session->peer_cert = NULL;
-                ret = 1;
-                goto exit;
-            }
+            ret = 1;
+            goto exit;
         }
-#endif /* MBEDTLS_X509_CRT_PARSE_C */
 
-        ret = 0;
-        goto exit;
+        mbedtls_x509_crt_init( session->peer_cert );
+        if( mbedtls_x509_crt_parse( session->peer_cert, entry->peer_cert.p,
+                            entry->peer_cert.len ) != 0 )
+        {
+            mbedtls_free( session->peer_cert );
+            session->peer_cert = NULL;
+            ret = 1;
+            goto exit;
+        }
     }
+#endif /* MBEDTLS_X509_CRT_PARSE_C */
+
+    ssl_cache_lru_unlink( cache, entry );
+    ssl_cache_lru_push( cache, entry );
+    cache->stats.hits++;
+
+    ret = 0;
 
 exit:
 #if defined(MBEDTLS_THREADING_C)
@@ -140,100 +315,57 @@ int mbedtls_ssl_cache_set( void *data, const mbedtls_ssl_session *session )
 {
     int ret = 1;
 #if defined(MBEDTLS_HAVE_TIME)
-    mbedtls_time_t t = time( NULL ), oldest = 0;
-    mbedtls_ssl_cache_entry *old = NULL;
+    mbedtls_time_t t = mbedtls_time( NULL );
 #endif
     mbedtls_ssl_cache_context *cache = (mbedtls_ssl_cache_context *) data;
-    mbedtls_ssl_cache_entry *cur, *prv;
-    int count = 0;
+    mbedtls_ssl_cache_entry *cur;
+    unsigned int h;
 
 #if defined(MBEDTLS_THREADING_C)
     if( ( ret = mbedtls_mutex_lock( &cache->mutex ) ) != 0 )
         return( ret );
 #endif
 
-    cur = cache->chain;
-    prv = NULL;
-
-    while( cur != NULL )
+    if( cache->arena == NULL && ssl_cache_setup( cache ) != 0 )
     {
-        count++;
+        ret = 1;
+        goto exit;
+    }
 
-#if defined(MBEDTLS_HAVE_TIME)
-        if( cache->timeout != 0 &&
-            (int) ( t - cur->timestamp ) > cache->timeout )
-        {
-            cur->timestamp = t;
-            break; /* expired, reuse this slot, update timestamp */
-        }
-#endif
+    cur = ssl_cache_find( cache, session->id, session->id_len );
 
-        if( memcmp( session->id, cur->session.id, cur->session.id_len ) == 0 )
-            break; /* client reconnected, keep timestamp for session id */
+    if( cur != NULL )
+    {
+        /* client reconnected, keep timestamp for session id */
+        ssl_cache_unlink( cache, cur );
 
 #if defined(MBEDTLS_HAVE_TIME)
-        if( oldest == 0 || cur->timestamp < oldest )
-        {
-            oldest = cur->timestamp;
-            old = cur;
-        }
+        if( ssl_cache_expired( cache, cur, t ) )
+            cur->timestamp = t; /* expired, reuse this slot, update timestamp */
 #endif
-
-        prv = cur;
-        cur = cur->next;
     }
-
-    if( cur == NULL )
+    else
     {
-#if defined(MBEDTLS_HAVE_TIME)
-        /*
-         * Reuse oldest entry if max_entries reached
-         */
-        if( count >= cache->max_entries )
-        {
-            if( old == NULL )
-            {
-                ret = 1;
-                goto exit;
-            }
-
-            cur = old;
-        }
-#else /* MBEDTLS_HAVE_TIME */
-        /*
-         * Reuse first entry in chain if max_entries reached,
-         * but move to last place
-         */
-        if( count >= cache->max_entries )
+        if( cache->free != NULL )
         {
-            if( cache->chain == NULL )
-            {
-                ret = 1;
-                goto exit;
-            }
-
-            cur = cache->chain;
-            cache->chain = cur->next;
+            cur = cache->free;
+            cache->free = cur->next;
             cur->next = NULL;
-            prv->next = cur;
         }
-#endif /* MBEDTLS_HAVE_TIME */
         else
         {
             /*
-             * max_entries not reached, create new entry
+             * Reuse the least recently used entry
              */
-            cur = mbedtls_calloc( 1, sizeof(mbedtls_ssl_cache_entry) );
-            if( cur == NULL )
-            {
-                ret = 1;
-                goto exit;
-            }
-
-            if( prv == NULL )
-                cache->chain = cur;
+            cur = cache->lru_tail;
+            ssl_cache_unlink( cache, cur );
+
+#if defined(MBEDTLS_HAVE_TIME)
+            if( ssl_cache_expired( cache, cur, t ) )
+                cache->stats.expirations++;
             else
-                prv->next = cur;
+#endif
+                cache->stats.evictions++;
         }
 
 #if defined(MBEDTLS_HAVE_TIME)
@@ -242,6 +374,15 @@ int mbedtls_ssl_cache_set( void *data, const mbedtls_ssl_session *session )
     }
 
     memcpy( &cur->session, session, sizeof( mbedtls_ssl_session ) );
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    cur->session.peer_cert = NULL;
+#endif
+
+    h = ssl_cache_hash( cache, cur->session.id, cur->session.id_len );
+    cur->next = cache->buckets[h];
+    cache->buckets[h] = cur;
+    ssl_cache_lru_push( cache, cur );
+    cache->stats.entries++;
 
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
     /*
@@ -261,6 +402,8 @@ int mbedtls_ssl_cache_set( void *data, const mbedtls_ssl_session *session )
         cur->peer_cert.p = mbedtls_calloc( 1, session->peer_cert->raw.len );
         if( cur->peer_cert.p == NULL )
         {
+            /* Do not leave a session that would resume without its peer */
+            ssl_cache_release( cache, cur );
             ret = 1;
             goto exit;
         }
@@ -268,8 +411,6 @@ int mbedtls_ssl_cache_set( void *data, const mbedtls_ssl_session *session )
         memcpy( cur->peer_cert.p, session->peer_cert->raw.p,
                 session->peer_cert->raw.len );
         cur->peer_cert.len = session->peer_cert->raw.len;
-
-        cur->session.peer_cert = NULL;
     }
 #endif /* MBEDTLS_X509_CRT_PARSE_C */
 
@@ -297,28 +438,42 @@ void mbedtls_ssl_cache_set_max_entries( mbedtls_ssl_cache_context *cache, int ma
 {
     if( max < 0 ) max = 0;
 
+#if defined(MBEDTLS_THREADING_C)
+    if( mbedtls_mutex_lock( &cache->mutex ) != 0 )
+        return;
+#endif
+
+    if( max != cache->max_entries )
+        ssl_cache_flush( cache );
+
     cache->max_entries = max;
+
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_mutex_unlock( &cache->mutex );
+#endif
 }
 
-void mbedtls_ssl_cache_free( mbedtls_ssl_cache_context *cache )
+void mbedtls_ssl_cache_get_stats( mbedtls_ssl_cache_context *cache,
+                                  mbedtls_ssl_cache_stats *stats )
 {
-    mbedtls_ssl_cache_entry *cur, *prv;
-
-    cur = cache->chain;
-
-    while( cur != NULL )
+#if defined(MBEDTLS_THREADING_C)
+    if( mbedtls_mutex_lock( &cache->mutex ) != 0 )
     {
-        prv = cur;
-        cur = cur->next;
+        memset( stats, 0, sizeof( mbedtls_ssl_cache_stats ) );
+        return;
+    }
+#endif
 
-        mbedtls_ssl_session_free( &prv->session );
+    *stats = cache->stats;
 
-#if defined(MBEDTLS_X509_CRT_PARSE_C)
-        mbedtls_free( prv->peer_cert.p );
-#endif /* MBEDTLS_X509_CRT_PARSE_C */
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_mutex_unlock( &cache->mutex );
+#endif
+}
 
-        mbedtls_free( prv );
-    }
+void mbedtls_ssl_cache_free( mbedtls_ssl_cache_context *cache )
+{
+    ssl_cache_flush( cache );
 
 #if defined(MBEDTLS_THREADING_C)
     mbedtls_mutex_free( &cache->mutex );
@@ -2188,7 +2188,7 @@ static int ssl_write_hello_verify_request( mbedtls_ssl_context *ssl )
     cookie_len_byte = p++;
 
     if( ( ret = ssl->conf->f_cookie_write( ssl->conf->p_cookie,
-                                     &p, ssl->out_buf + MBEDTLS_SSL_BUFFER_LEN,
+                                     &p, ssl->out_buf + mbedtls_ssl_out_buf_len( ssl ),
                                      ssl->cli_id, ssl->cli_id_len ) ) != 0 )
     {
         MBEDTLS_SSL_DEBUG_RET( 1, "f_cookie_write", ret );
@@ -2596,6 +2596,12 @@ static int ssl_write_certificate_request( mbedtls_ssl_context *ssl )
     if( ssl->handshake->sni_ca_chain != NULL )
         crt = ssl->handshake->sni_ca_chain;
     else
+#endif
+#if defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK)
+    /* The trusted CAs are not enumerated, the list stays empty */
+    if( ssl->conf->f_ca_cb != NULL )
+        crt = NULL;
+    else
 #endif
         crt = ssl->conf->ca_chain;
 
@@ -72,6 +72,12 @@ static inline size_t ssl_ep_len( const mbedtls_ssl_context *ssl )
     return( 0 );
 }
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+/* Forward declarations, see mbedtls_ssl_release_buffers() */
+static int ssl_acquire_buffers( mbedtls_ssl_context *ssl );
+static void ssl_shrink_buffers( mbedtls_ssl_context *ssl );
+#endif
+
 /*
  * Start a timer.
  * Passing millisecs = 0 cancels a running timer.
@@ -2228,7 +2234,7 @@ int mbedtls_ssl_fetch_input( mbedtls_ssl_context *ssl, size_t nb_want )
         return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
     }
 
-    if( nb_want > MBEDTLS_SSL_BUFFER_LEN - (size_t)( ssl->in_hdr - ssl->in_buf ) )
+    if( nb_want > mbedtls_ssl_in_buf_len( ssl ) - (size_t)( ssl->in_hdr - ssl->in_buf ) )
     {
         MBEDTLS_SSL_DEBUG_MSG( 1, ( "requesting more data than fits" ) );
         return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
@@ -2311,7 +2317,7 @@ int mbedtls_ssl_fetch_input( mbedtls_ssl_context *ssl, size_t nb_want )
             ret = MBEDTLS_ERR_SSL_TIMEOUT;
         else
         {
-            len = MBEDTLS_SSL_BUFFER_LEN - ( ssl->in_hdr - ssl->in_buf );
+            len = mbedtls_ssl_in_buf_len( ssl ) - ( ssl->in_hdr - ssl->in_buf );
 
             if( ssl->state != MBEDTLS_SSL_HANDSHAKE_OVER )
                 timeout = ssl->handshake->retransmit_timeout;
@@ -3062,7 +3068,7 @@ static int ssl_reassemble_dtls_handshake( mbedtls_ssl_context *ssl )
         ssl->next_record_offset = new_remain - ssl->in_hdr;
         ssl->in_left = ssl->next_record_offset + remain_len;
 
-        if( ssl->in_left > MBEDTLS_SSL_BUFFER_LEN -
+        if( ssl->in_left > mbedtls_ssl_in_buf_len( ssl ) -
                            (size_t)( ssl->in_hdr - ssl->in_buf ) )
         {
             MBEDTLS_SSL_DEBUG_MSG( 1, ( "reassembled message too large for buffer" ) );
@@ -3432,7 +3438,8 @@ static int ssl_handle_possible_reconnect( mbedtls_ssl_context *ssl )
             ssl->conf->p_cookie,
             ssl->cli_id, ssl->cli_id_len,
             ssl->in_buf, ssl->in_left,
-            ssl->out_buf, MBEDTLS_SSL_MAX_CONTENT_LEN, &len );
+            ssl->out_buf, mbedtls_ssl_out_buf_len( ssl ) -
+                          MBEDTLS_SSL_BUFFER_OVERHEAD, &len );
 
     MBEDTLS_SSL_DEBUG_RET( 2, "ssl_check_dtls_clihlo_cookie", ret );
 
@@ -3529,7 +3536,7 @@ static int ssl_parse_record_header( mbedtls_ssl_context *ssl )
     }
 
     /* Check length against the size of our buffer */
-    if( ssl->in_msglen > MBEDTLS_SSL_BUFFER_LEN
+    if( ssl->in_msglen > mbedtls_ssl_in_buf_len( ssl )
                          - (size_t)( ssl->in_msg - ssl->in_buf ) )
     {
         MBEDTLS_SSL_DEBUG_MSG( 1, ( "bad message length" ) );
@@ -4002,6 +4009,11 @@ int mbedtls_ssl_send_alert_message( mbedtls_ssl_context *ssl,
 
     MBEDTLS_SSL_DEBUG_MSG( 2, ( "=> send alert message" ) );
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    if( ( ret = ssl_acquire_buffers( ssl ) ) != 0 )
+        return( ret );
+#endif
+
     ssl->out_msgtype = MBEDTLS_SSL_MSG_ALERT;
     ssl->out_msglen = 2;
     ssl->out_msg[0] = level;
@@ -4389,6 +4401,7 @@ int mbedtls_ssl_parse_certificate( mbedtls_ssl_context *ssl )
     {
         mbedtls_x509_crt *ca_chain;
         mbedtls_x509_crl *ca_crl;
+        int use_ca_cb = 0;
 
 #if defined(MBEDTLS_SSL_SERVER_NAME_INDICATION)
         if( ssl->handshake->sni_ca_chain != NULL )
@@ -4401,9 +4414,12 @@ int mbedtls_ssl_parse_certificate( mbedtls_ssl_context *ssl )
         {
             ca_chain = ssl->conf->ca_chain;
             ca_crl   = ssl->conf->ca_crl;
+#if defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK)
+            use_ca_cb = ( ssl->conf->f_ca_cb != NULL );
+#endif
         }
 
-        if( ca_chain == NULL )
+        if( ca_chain == NULL && ! use_ca_cb )
         {
             MBEDTLS_SSL_DEBUG_MSG( 1, ( "got no CA chain" ) );
             return( MBEDTLS_ERR_SSL_CA_CHAIN_REQUIRED );
@@ -4412,6 +4428,17 @@ int mbedtls_ssl_parse_certificate( mbedtls_ssl_context *ssl )
         /*
          * Main check: verify certificate
          */
+#if defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK)
+        if( use_ca_cb )
+            ret = mbedtls_x509_crt_verify_with_ca_cb(
+                                ssl->session_negotiate->peer_cert,
+                                ssl->conf->f_ca_cb, ssl->conf->p_ca_cb,
+                                ssl->conf->cert_profile,
+                                ssl->hostname,
+                               &ssl->session_negotiate->verify_result,
+                                ssl->conf->f_vrfy, ssl->conf->p_vrfy );
+        else
+#endif
         ret = mbedtls_x509_crt_verify_with_profile(
                                 ssl->session_negotiate->peer_cert,
                                 ca_chain, ca_crl,
@@ -4990,6 +5017,12 @@ void mbedtls_ssl_handshake_wrapup( mbedtls_ssl_context *ssl )
 #endif
         ssl_handshake_wrapup_free_hs_transform( ssl );
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    /* A DTLS connection keeping its last flight shrinks when released */
+    if( ssl->handshake == NULL )
+        ssl_shrink_buffers( ssl );
+#endif
+
     ssl->state++;
 
     MBEDTLS_SSL_DEBUG_MSG( 3, ( "<= handshake wrapup" ) );
@@ -5358,6 +5391,398 @@ void mbedtls_ssl_init( mbedtls_ssl_context *ssl )
     memset( ssl, 0, sizeof( mbedtls_ssl_context ) );
 }
 
+/*
+ * Point the record layer at an input or output buffer, keeping the offset
+ * of the message (which depends on the IV length of the transform)
+ */
+static void ssl_set_in_buf( mbedtls_ssl_context *ssl, unsigned char *buf,
+                            size_t msg_offset )
+{
+    ssl->in_buf = buf;
+
+#if defined(MBEDTLS_SSL_PROTO_DTLS)
+    if( ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM )
+    {
+        ssl->in_hdr = buf;
+        ssl->in_ctr = buf +  3;
+    }
+    else
+#endif
+    {
+        ssl->in_ctr = buf;
+        ssl->in_hdr = buf +  8;
+    }
+    ssl->in_len = buf + 11;
+    ssl->in_iv  = buf + 13;
+    ssl->in_msg = buf + msg_offset;
+}
+
+static void ssl_set_out_buf( mbedtls_ssl_context *ssl, unsigned char *buf,
+                             size_t msg_offset )
+{
+    ssl->out_buf = buf;
+
+#if defined(MBEDTLS_SSL_PROTO_DTLS)
+    if( ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM )
+    {
+        ssl->out_hdr = buf;
+        ssl->out_ctr = buf +  3;
+    }
+    else
+#endif
+    {
+        ssl->out_ctr = buf;
+        ssl->out_hdr = buf +  8;
+    }
+    ssl->out_len = buf + 11;
+    ssl->out_iv  = buf + 13;
+    ssl->out_msg = buf + msg_offset;
+}
+
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+void mbedtls_ssl_shared_buf_init( mbedtls_ssl_shared_buf *shared,
+                                  unsigned char *buf, size_t len )
+{
+    memset( shared, 0, sizeof( mbedtls_ssl_shared_buf ) );
+
+    shared->buf = buf;
+    shared->len = len;
+
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_mutex_init( &shared->mutex );
+#endif
+}
+
+void mbedtls_ssl_shared_buf_free( mbedtls_ssl_shared_buf *shared )
+{
+    if( shared == NULL )
+        return;
+
+    if( shared->buf != NULL )
+        mbedtls_zeroize( shared->buf, shared->len );
+
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_mutex_free( &shared->mutex );
+#endif
+
+    mbedtls_zeroize( shared, sizeof( mbedtls_ssl_shared_buf ) );
+}
+
+/*
+ * Try to borrow the shared output buffer, return NULL if there is none,
+ * it is in use or too small
+ */
+static unsigned char *ssl_shared_buf_get( mbedtls_ssl_context *ssl,
+                                          size_t len )
+{
+    mbedtls_ssl_shared_buf *shared = ssl->conf->shared_out_buf;
+    unsigned char *buf = NULL;
+
+    if( shared == NULL || shared->len < len )
+        return( NULL );
+
+#if defined(MBEDTLS_THREADING_C)
+    if( mbedtls_mutex_lock( &shared->mutex ) != 0 )
+        return( NULL );
+#endif
+
+    if( shared->owner == NULL )
+    {
+        shared->owner = ssl;
+        buf = shared->buf;
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    if( mbedtls_mutex_unlock( &shared->mutex ) != 0 )
+        return( NULL );
+#endif
+
+    return( buf );
+}
+
+static int ssl_out_buf_is_shared( const mbedtls_ssl_context *ssl )
+{
+    return( ssl->conf->shared_out_buf != NULL &&
+            ssl->out_buf != NULL &&
+            ssl->out_buf == ssl->conf->shared_out_buf->buf );
+}
+
+/*
+ * Free the output buffer or hand it back if it is the shared one
+ */
+static void ssl_out_buf_free( mbedtls_ssl_context *ssl )
+{
+    mbedtls_ssl_shared_buf *shared;
+
+    if( ssl->out_buf == NULL )
+        return;
+
+    if( ssl_out_buf_is_shared( ssl ) )
+    {
+        shared = ssl->conf->shared_out_buf;
+
+        mbedtls_zeroize( shared->buf, shared->len );
+
+#if defined(MBEDTLS_THREADING_C)
+        if( mbedtls_mutex_lock( &shared->mutex ) != 0 )
+            return;
+#endif
+
+        shared->owner = NULL;
+
+#if defined(MBEDTLS_THREADING_C)
+        mbedtls_mutex_unlock( &shared->mutex );
+#endif
+    }
+    else
+    {
+        mbedtls_zeroize( ssl->out_buf, ssl->out_buf_len );
+        mbedtls_free( ssl->out_buf );
+    }
+
+    ssl->out_buf = NULL;
+}
+
+/*
+ * Bytes of a buffer that hold live data: counter, header and the current
+ * (incoming) or pending (outgoing) records
+ */
+static size_t ssl_in_buf_used( const mbedtls_ssl_context *ssl )
+{
+    size_t used = ( ssl->in_hdr - ssl->in_buf ) + ssl->in_left;
+    size_t msg_end = ( ssl->in_msg - ssl->in_buf ) + ssl->in_msglen;
+
+    return( used > msg_end ? used : msg_end );
+}
+
+static size_t ssl_out_buf_used( const mbedtls_ssl_context *ssl )
+{
+    return( ( ssl->out_msg - ssl->out_buf ) + ssl->out_msglen );
+}
+
+/*
+ * Reallocate the record buffers, keeping their contents. A buffer that
+ * would not hold its current contents keeps its size, so does the buffer
+ * of a released direction, which is only recorded for the next allocation.
+ */
+static int ssl_resize_buffers( mbedtls_ssl_context *ssl,
+                               size_t in_len, size_t out_len )
+{
+    unsigned char *buf, *old;
+    size_t used;
+
+    if( ssl->in_buf == NULL )
+        ssl->in_buf_len = in_len;
+    else if( in_len != ssl->in_buf_len &&
+             ( used = ssl_in_buf_used( ssl ) ) <= in_len )
+    {
+        if( ( buf = mbedtls_calloc( 1, in_len ) ) == NULL )
+        {
+            MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed", in_len ) );
+            return( MBEDTLS_ERR_SSL_ALLOC_FAILED );
+        }
+
+        old = ssl->in_buf;
+        memcpy( buf, old, used );
+
+        if( ssl->in_offt != NULL )
+            ssl->in_offt = buf + ( ssl->in_offt - old );
+        ssl_set_in_buf( ssl, buf, ssl->in_msg - old );
+
+        mbedtls_zeroize( old, ssl->in_buf_len );
+        mbedtls_free( old );
+        ssl->in_buf_len = in_len;
+    }
+
+    if( ssl->out_buf == NULL )
+        ssl->out_buf_len = out_len;
+    else if( out_len != ssl->out_buf_len &&
+             ( used = ssl_out_buf_used( ssl ) ) <= out_len )
+    {
+        size_t msg_offset = ssl->out_msg - ssl->out_buf;
+
+        /* The shared buffer only changes hands when it is too small */
+        if( ssl_out_buf_is_shared( ssl ) &&
+            out_len <= ssl->conf->shared_out_buf->len )
+        {
+            ssl->out_buf_len = out_len;
+            return( 0 );
+        }
+
+        if( ( buf = mbedtls_calloc( 1, out_len ) ) == NULL )
+        {
+            MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed", out_len ) );
+            return( MBEDTLS_ERR_SSL_ALLOC_FAILED );
+        }
+
+        memcpy( buf, ssl->out_buf, used );
+        ssl_out_buf_free( ssl );
+
+        ssl_set_out_buf( ssl, buf, msg_offset );
+        ssl->out_buf_len = out_len;
+    }
+
+    return( 0 );
+}
+
+/*
+ * Buffer sizes once the handshake is over: the records either way are
+ * bounded by the maximum fragment length in effect for that direction
+ */
+static void ssl_record_buf_len( const mbedtls_ssl_context *ssl,
+                                size_t *in_len, size_t *out_len )
+{
+    *in_len = MBEDTLS_SSL_BUFFER_LEN;
+    *out_len = MBEDTLS_SSL_BUFFER_LEN;
+
+#if defined(MBEDTLS_ZLIB_SUPPORT)
+    /* Compression works on full-size buffers */
+    if( ssl->session != NULL &&
+        ssl->session->compression == MBEDTLS_SSL_COMPRESS_DEFLATE )
+    {
+        return;
+    }
+#endif
+
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+    if( ssl->session != NULL )
+    {
+        *in_len = MBEDTLS_SSL_BUFFER_OVERHEAD +
+                  mfl_code_to_length[ssl->session->mfl_code];
+        *out_len = MBEDTLS_SSL_BUFFER_OVERHEAD +
+                   mbedtls_ssl_get_max_frag_len( ssl );
+    }
+#else
+    ((void) ssl);
+#endif
+}
+
+/*
+ * Shrink the buffers to the negotiated fragment length once the handshake
+ * is done. Not fatal if it fails, the connection keeps its buffers.
+ */
+static void ssl_shrink_buffers( mbedtls_ssl_context *ssl )
+{
+    size_t in_len, out_len;
+
+    ssl_record_buf_len( ssl, &in_len, &out_len );
+
+    if( ssl_resize_buffers( ssl, in_len, out_len ) != 0 )
+        MBEDTLS_SSL_DEBUG_MSG( 1, ( "keeping full size record buffers" ) );
+}
+
+/*
+ * Buffers are needed again by a handshake
+ */
+static int ssl_grow_buffers( mbedtls_ssl_context *ssl )
+{
+    return( ssl_resize_buffers( ssl, MBEDTLS_SSL_BUFFER_LEN,
+                                     MBEDTLS_SSL_BUFFER_LEN ) );
+}
+
+/*
+ * Allocate the buffers released by mbedtls_ssl_release_buffers()
+ */
+static int ssl_acquire_buffers( mbedtls_ssl_context *ssl )
+{
+    unsigned char *buf;
+
+    if( ssl->in_buf == NULL )
+    {
+        if( ( buf = mbedtls_calloc( 1, ssl->in_buf_len ) ) == NULL )
+        {
+            MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed",
+                                        ssl->in_buf_len ) );
+            return( MBEDTLS_ERR_SSL_ALLOC_FAILED );
+        }
+
+        ssl_set_in_buf( ssl, buf, ssl->in_msg_offset );
+        memcpy( ssl->in_ctr, ssl->in_ctr_saved, 8 );
+    }
+
+    if( ssl->out_buf == NULL )
+    {
+        if( ( buf = ssl_shared_buf_get( ssl, ssl->out_buf_len ) ) == NULL &&
+            ( buf = mbedtls_calloc( 1, ssl->out_buf_len ) ) == NULL )
+        {
+            MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed",
+                                        ssl->out_buf_len ) );
+            return( MBEDTLS_ERR_SSL_ALLOC_FAILED );
+        }
+
+        ssl_set_out_buf( ssl, buf, ssl->out_msg_offset );
+        memcpy( ssl->out_ctr, ssl->out_ctr_saved, 8 );
+    }
+
+    return( 0 );
+}
+
+/*
+ * Nothing in flight either way and no handshake going on
+ */
+static int ssl_is_idle( const mbedtls_ssl_context *ssl )
+{
+    if( ssl->state != MBEDTLS_SSL_HANDSHAKE_OVER ||
+        ssl->handshake != NULL ||
+        ssl->out_left != 0 ||
+        ssl->in_offt != NULL ||
+        ssl->record_read != 0 ||
+        ( ssl->in_hslen != 0 && ssl->in_hslen < ssl->in_msglen ) )
+    {
+        return( 0 );
+    }
+
+#if defined(MBEDTLS_SSL_PROTO_DTLS)
+    if( ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM )
+        return( ssl->in_left == ssl->next_record_offset );
+#endif
+
+    return( ssl->in_left == 0 );
+}
+
+int mbedtls_ssl_release_buffers( mbedtls_ssl_context *ssl )
+{
+    size_t in_len, out_len;
+
+    if( ssl == NULL || ssl->conf == NULL || ! ssl_is_idle( ssl ) )
+        return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
+
+    MBEDTLS_SSL_DEBUG_MSG( 3, ( "release record buffers" ) );
+
+    if( ssl->in_buf != NULL )
+    {
+        memcpy( ssl->in_ctr_saved, ssl->in_ctr, 8 );
+        ssl->in_msg_offset = ssl->in_msg - ssl->in_buf;
+
+        mbedtls_zeroize( ssl->in_buf, ssl->in_buf_len );
+        mbedtls_free( ssl->in_buf );
+        ssl->in_buf = NULL;
+
+        ssl->in_msglen = 0;
+        ssl->in_hslen = 0;
+        ssl->in_left = 0;
+#if defined(MBEDTLS_SSL_PROTO_DTLS)
+        ssl->next_record_offset = 0;
+#endif
+    }
+
+    if( ssl->out_buf != NULL )
+    {
+        memcpy( ssl->out_ctr_saved, ssl->out_ctr, 8 );
+        ssl->out_msg_offset = ssl->out_msg - ssl->out_buf;
+
+        ssl_out_buf_free( ssl );
+
+        ssl->out_msglen = 0;
+    }
+
+    /* Allocate them again at the size they should have had */
+    ssl_record_buf_len( ssl, &in_len, &out_len );
+
+    return( ssl_resize_buffers( ssl, in_len, out_len ) );
+}
+#endif /* MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH */
+
 /*
  * Setup an SSL context
  */
@@ -5366,51 +5791,27 @@ int mbedtls_ssl_setup( mbedtls_ssl_context *ssl,
 {
     int ret;
     const size_t len = MBEDTLS_SSL_BUFFER_LEN;
+    unsigned char *in_buf, *out_buf = NULL;
 
     ssl->conf = conf;
 
     /*
      * Prepare base structures
      */
-    if( ( ssl-> in_buf = mbedtls_calloc( 1, len ) ) == NULL ||
-        ( ssl->out_buf = mbedtls_calloc( 1, len ) ) == NULL )
+    if( ( in_buf = mbedtls_calloc( 1, len ) ) == NULL ||
+        ( out_buf = mbedtls_calloc( 1, len ) ) == NULL )
     {
         MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed", len ) );
-        mbedtls_free( ssl->in_buf );
-        ssl->in_buf = NULL;
+        mbedtls_free( in_buf );
         return( MBEDTLS_ERR_SSL_ALLOC_FAILED );
     }
 
-#if defined(MBEDTLS_SSL_PROTO_DTLS)
-    if( conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM )
-    {
-        ssl->out_hdr = ssl->out_buf;
-        ssl->out_ctr = ssl->out_buf +  3;
-        ssl->out_len = ssl->out_buf + 11;
-        ssl->out_iv  = ssl->out_buf + 13;
-        ssl->out_msg = ssl->out_buf + 13;
-
-        ssl->in_hdr = ssl->in_buf;
-        ssl->in_ctr = ssl->in_buf +  3;
-        ssl->in_len = ssl->in_buf + 11;
-        ssl->in_iv  = ssl->in_buf + 13;
-        ssl->in_msg = ssl->in_buf + 13;
-    }
-    else
+    ssl_set_in_buf( ssl, in_buf, 13 );
+    ssl_set_out_buf( ssl, out_buf, 13 );
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    ssl->in_buf_len = len;
+    ssl->out_buf_len = len;
 #endif
-    {
-        ssl->out_ctr = ssl->out_buf;
-        ssl->out_hdr = ssl->out_buf +  8;
-        ssl->out_len = ssl->out_buf + 11;
-        ssl->out_iv  = ssl->out_buf + 13;
-        ssl->out_msg = ssl->out_buf + 13;
-
-        ssl->in_ctr = ssl->in_buf;
-        ssl->in_hdr = ssl->in_buf +  8;
-        ssl->in_len = ssl->in_buf + 11;
-        ssl->in_iv  = ssl->in_buf + 13;
-        ssl->in_msg = ssl->in_buf + 13;
-    }
 
     if( ( ret = ssl_handshake_init( ssl ) ) != 0 )
         return( ret );
@@ -5429,6 +5830,15 @@ static int ssl_session_reset_int( mbedtls_ssl_context *ssl, int partial )
 {
     int ret;
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    /* The next handshake needs full size buffers */
+    if( ( ret = ssl_grow_buffers( ssl ) ) != 0 ||
+        ( ret = ssl_acquire_buffers( ssl ) ) != 0 )
+    {
+        return( ret );
+    }
+#endif
+
     ssl->state = MBEDTLS_SSL_HELLO_REQUEST;
 
     /* Cancel any possibly running timer */
@@ -5475,9 +5885,9 @@ static int ssl_session_reset_int( mbedtls_ssl_context *ssl, int partial )
     ssl->transform_in = NULL;
     ssl->transform_out = NULL;
 
-    memset( ssl->out_buf, 0, MBEDTLS_SSL_BUFFER_LEN );
+    memset( ssl->out_buf, 0, mbedtls_ssl_out_buf_len( ssl ) );
     if( partial == 0 )
-        memset( ssl->in_buf, 0, MBEDTLS_SSL_BUFFER_LEN );
+        memset( ssl->in_buf, 0, mbedtls_ssl_in_buf_len( ssl ) );
 
 #if defined(MBEDTLS_SSL_HW_RECORD_ACCEL)
     if( mbedtls_ssl_hw_record_reset != NULL )
@@ -5737,6 +6147,16 @@ void mbedtls_ssl_conf_ca_chain( mbedtls_ssl_config *conf,
     conf->ca_chain   = ca_chain;
     conf->ca_crl     = ca_crl;
 }
+
+#if defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK)
+void mbedtls_ssl_conf_ca_cb( mbedtls_ssl_config *conf,
+                             mbedtls_x509_crt_ca_cb_t f_ca_cb,
+                             void *p_ca_cb )
+{
+    conf->f_ca_cb    = f_ca_cb;
+    conf->p_ca_cb    = p_ca_cb;
+}
+#endif /* MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK */
 #endif /* MBEDTLS_X509_CRT_PARSE_C */
 
 #if defined(MBEDTLS_SSL_SERVER_NAME_INDICATION)
@@ -6056,6 +6476,14 @@ int mbedtls_ssl_conf_max_frag_len( mbedtls_ssl_config *conf, unsigned char mfl_c
 }
 #endif /* MBEDTLS_SSL_MAX_FRAGMENT_LENGTH */
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+void mbedtls_ssl_conf_shared_out_buf( mbedtls_ssl_config *conf,
+                                      mbedtls_ssl_shared_buf *shared )
+{
+    conf->shared_out_buf = shared;
+}
+#endif
+
 #if defined(MBEDTLS_SSL_TRUNCATED_HMAC)
 void mbedtls_ssl_conf_truncated_hmac( mbedtls_ssl_config *conf, int truncate )
 {
@@ -6281,6 +6709,11 @@ int mbedtls_ssl_handshake_step( mbedtls_ssl_context *ssl )
     if( ssl == NULL || ssl->conf == NULL )
         return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    if( ( ret = ssl_acquire_buffers( ssl ) ) != 0 )
+        return( ret );
+#endif
+
 #if defined(MBEDTLS_SSL_CLI_C)
     if( ssl->conf->endpoint == MBEDTLS_SSL_IS_CLIENT )
         ret = mbedtls_ssl_handshake_client_step( ssl );
@@ -6360,6 +6793,11 @@ static int ssl_start_renegotiation( mbedtls_ssl_context *ssl )
 
     MBEDTLS_SSL_DEBUG_MSG( 2, ( "=> renegotiate" ) );
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    if( ( ret = ssl_grow_buffers( ssl ) ) != 0 )
+        return( ret );
+#endif
+
     if( ( ret = ssl_handshake_init( ssl ) ) != 0 )
         return( ret );
 
@@ -6401,6 +6839,11 @@ int mbedtls_ssl_renegotiate( mbedtls_ssl_context *ssl )
     if( ssl == NULL || ssl->conf == NULL )
         return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    if( ( ret = ssl_acquire_buffers( ssl ) ) != 0 )
+        return( ret );
+#endif
+
 #if defined(MBEDTLS_SSL_SRV_C)
     /* On server, just send the request */
     if( ssl->conf->endpoint == MBEDTLS_SSL_IS_SERVER )
@@ -6483,6 +6926,11 @@ int mbedtls_ssl_read( mbedtls_ssl_context *ssl, unsigned char *buf, size_t len )
 
     MBEDTLS_SSL_DEBUG_MSG( 2, ( "=> read" ) );
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    if( ( ret = ssl_acquire_buffers( ssl ) ) != 0 )
+        return( ret );
+#endif
+
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
     if( ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM )
     {
@@ -6827,6 +7275,11 @@ int mbedtls_ssl_write( mbedtls_ssl_context *ssl, const unsigned char *buf, size_
     if( ssl == NULL || ssl->conf == NULL )
         return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    if( ( ret = ssl_acquire_buffers( ssl ) ) != 0 )
+        return( ret );
+#endif
+
 #if defined(MBEDTLS_SSL_RENEGOTIATION)
     if( ( ret = ssl_check_ctr_renegotiate( ssl ) ) != 0 )
     {
@@ -6867,6 +7320,11 @@ int mbedtls_ssl_close_notify( mbedtls_ssl_context *ssl )
 
     MBEDTLS_SSL_DEBUG_MSG( 2, ( "=> write close notify" ) );
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    if( ( ret = ssl_acquire_buffers( ssl ) ) != 0 )
+        return( ret );
+#endif
+
     if( ssl->out_left != 0 )
         return( mbedtls_ssl_flush_output( ssl ) );
 
@@ -7025,15 +7483,19 @@ void mbedtls_ssl_free( mbedtls_ssl_context *ssl )
 
     MBEDTLS_SSL_DEBUG_MSG( 2, ( "=> free" ) );
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    ssl_out_buf_free( ssl );
+#else
     if( ssl->out_buf != NULL )
     {
         mbedtls_zeroize( ssl->out_buf, MBEDTLS_SSL_BUFFER_LEN );
         mbedtls_free( ssl->out_buf );
     }
+#endif
 
     if( ssl->in_buf != NULL )
     {
-        mbedtls_zeroize( ssl->in_buf, MBEDTLS_SSL_BUFFER_LEN );
+        mbedtls_zeroize( ssl->in_buf, mbedtls_ssl_in_buf_len( ssl ) );
         mbedtls_free( ssl->in_buf );
     }
 
@@ -657,10 +657,11 @@ static int x509_get_crt_ext( unsigned char **p,
 }
 
 /*
- * Parse and fill a single X.509 certificate in DER format
+ * Parse and fill a single X.509 certificate in DER format. Without make_copy
+ * the certificate points into buf, which has to outlive it.
  */
 static int x509_crt_parse_der_core( mbedtls_x509_crt *crt, const unsigned char *buf,
-                                    size_t buflen )
+                                    size_t buflen, int make_copy )
 {
     int ret;
     size_t len;
@@ -703,15 +704,22 @@ static int x509_crt_parse_der_core( mbedtls_x509_crt *crt, const unsigned char *
     }
     crt_end = p + len;
 
-    // Create and populate a new buffer for the raw field
     crt->raw.len = crt_end - buf;
-    crt->raw.p = p = mbedtls_calloc( 1, crt->raw.len );
-    if( p == NULL )
-        return( MBEDTLS_ERR_X509_ALLOC_FAILED );
+    crt->own_buffer = make_copy;
 
-    memcpy( p, buf, crt->raw.len );
+    if( make_copy )
+    {
+        // Create and populate a new buffer for the raw field
+        crt->raw.p = p = mbedtls_calloc( 1, crt->raw.len );
+        if( p == NULL )
+            return( MBEDTLS_ERR_X509_ALLOC_FAILED );
+
+        memcpy( p, buf, crt->raw.len );
+    }
+    else
+        crt->raw.p = p = (unsigned char *) buf;
 
-    // Direct pointers to the new buffer 
+    // Direct pointers to the raw buffer
     p += crt->raw.len - len;
     end = crt_end = p + len;
 
@@ -916,8 +924,9 @@ static int x509_crt_parse_der_core( mbedtls_x509_crt *crt, const unsigned char *
  * Parse one X.509 certificate in DER format from a buffer and add them to a
  * chained list
  */
-int mbedtls_x509_crt_parse_der( mbedtls_x509_crt *chain, const unsigned char *buf,
-                        size_t buflen )
+static int x509_crt_parse_der_internal( mbedtls_x509_crt *chain,
+                                        const unsigned char *buf,
+                                        size_t buflen, int make_copy )
 {
     int ret;
     mbedtls_x509_crt *crt = chain, *prev = NULL;
@@ -949,7 +958,7 @@ int mbedtls_x509_crt_parse_der( mbedtls_x509_crt *chain, const unsigned char *bu
         crt = crt->next;
     }
 
-    if( ( ret = x509_crt_parse_der_core( crt, buf, buflen ) ) != 0 )
+    if( ( ret = x509_crt_parse_der_core( crt, buf, buflen, make_copy ) ) != 0 )
     {
         if( prev )
             prev->next = NULL;
@@ -963,6 +972,19 @@ int mbedtls_x509_crt_parse_der( mbedtls_x509_crt *chain, const unsigned char *bu
     return( 0 );
 }
 
+int mbedtls_x509_crt_parse_der( mbedtls_x509_crt *chain, const unsigned char *buf,
+                        size_t buflen )
+{
+    return( x509_crt_parse_der_internal( chain, buf, buflen, 1 ) );
+}
+
+int mbedtls_x509_crt_parse_der_nocopy( mbedtls_x509_crt *chain,
+                                       const unsigned char *buf,
+                                       size_t buflen )
+{
+    return( x509_crt_parse_der_internal( chain, buf, buflen, 0 ) );
+}
+
 /*
  * Parse one or more PEM certificates from a buffer and add them to the chained
  * list
@@ -2018,9 +2040,58 @@ static int x509_crt_verify_top(
     return( 0 );
 }
 
+/*
+ * Where the trusted CAs come from: a list, or a callback that hands out the
+ * candidates for each certificate whose issuer is looked up
+ */
+typedef struct
+{
+    mbedtls_x509_crt *ca_chain;
+#if defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK)
+    mbedtls_x509_crt_ca_cb_t f_ca_cb;
+    void *p_ca_cb;
+#endif
+}
+x509_crt_trust;
+
+/*
+ * Get the trusted CAs that may have issued child, to be released with
+ * x509_crt_trusted_cas_free()
+ */
+static int x509_crt_trusted_cas( const x509_crt_trust *trust,
+                                 const mbedtls_x509_crt *child,
+                                 mbedtls_x509_crt **cas )
+{
+#if defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK)
+    if( trust->f_ca_cb != NULL )
+    {
+        *cas = NULL;
+        return( trust->f_ca_cb( trust->p_ca_cb, child, cas ) );
+    }
+#endif
+
+    *cas = trust->ca_chain;
+    return( 0 );
+}
+
+static void x509_crt_trusted_cas_free( const x509_crt_trust *trust,
+                                       mbedtls_x509_crt *cas )
+{
+#if defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK)
+    if( trust->f_ca_cb != NULL && cas != NULL )
+    {
+        mbedtls_x509_crt_free( cas );
+        mbedtls_free( cas );
+    }
+#else
+    ((void) trust);
+    ((void) cas);
+#endif
+}
+
 static int x509_crt_verify_child(
                 mbedtls_x509_crt *child, mbedtls_x509_crt *parent,
-                mbedtls_x509_crt *trust_ca, mbedtls_x509_crl *ca_crl,
+                const x509_crt_trust *trust, mbedtls_x509_crl *ca_crl,
                 const mbedtls_x509_crt_profile *profile,
                 int path_cnt, int self_cnt, uint32_t *flags,
                 int (*f_vrfy)(void *, mbedtls_x509_crt *, int, uint32_t *),
@@ -2029,6 +2100,7 @@ static int x509_crt_verify_child(
     int ret;
     uint32_t parent_flags = 0;
     unsigned char hash[MBEDTLS_MD_MAX_SIZE];
+    mbedtls_x509_crt *trust_ca;
     mbedtls_x509_crt *grandparent;
     const mbedtls_md_info_t *md_info;
 
@@ -2084,6 +2156,9 @@ static int x509_crt_verify_child(
 #endif
 
     /* Look for a grandparent in trusted CAs */
+    if( ( ret = x509_crt_trusted_cas( trust, parent, &trust_ca ) ) != 0 )
+        return( ret );
+
     for( grandparent = trust_ca;
          grandparent != NULL;
          grandparent = grandparent->next )
@@ -2097,8 +2172,6 @@ static int x509_crt_verify_child(
     {
         ret = x509_crt_verify_top( parent, grandparent, ca_crl, profile,
                                 path_cnt + 1, self_cnt, &parent_flags, f_vrfy, p_vrfy );
-        if( ret != 0 )
-            return( ret );
     }
     else
     {
@@ -2124,22 +2197,27 @@ static int x509_crt_verify_child(
         /* Is our parent part of the chain or at the top? */
         if( grandparent != NULL )
         {
-            ret = x509_crt_verify_child( parent, grandparent, trust_ca, ca_crl,
+            /* Only the candidates for the grandparent are needed up there */
+            x509_crt_trusted_cas_free( trust, trust_ca );
+            trust_ca = NULL;
+
+            ret = x509_crt_verify_child( parent, grandparent, trust, ca_crl,
                                          profile, path_cnt + 1, self_cnt, &parent_flags,
                                          f_vrfy, p_vrfy );
-            if( ret != 0 )
-                return( ret );
         }
         else
         {
             ret = x509_crt_verify_top( parent, trust_ca, ca_crl, profile,
                                        path_cnt + 1, self_cnt, &parent_flags,
                                        f_vrfy, p_vrfy );
-            if( ret != 0 )
-                return( ret );
         }
     }
 
+    x509_crt_trusted_cas_free( trust, trust_ca );
+
+    if( ret != 0 )
+        return( ret );
+
     /* child is verified to be a child of the parent, call verify callback */
     if( NULL != f_vrfy )
         if( ( ret = f_vrfy( p_vrfy, child, path_cnt, flags ) ) != 0 )
@@ -2166,10 +2244,10 @@ int mbedtls_x509_crt_verify( mbedtls_x509_crt *crt,
 
 
 /*
- * Verify the certificate validity, with profile
+ * Verify the certificate validity against the trusted CAs
  */
-int mbedtls_x509_crt_verify_with_profile( mbedtls_x509_crt *crt,
-                     mbedtls_x509_crt *trust_ca,
+static int x509_crt_verify_internal( mbedtls_x509_crt *crt,
+                     const x509_crt_trust *trust,
                      mbedtls_x509_crl *ca_crl,
                      const mbedtls_x509_crt_profile *profile,
                      const char *cn, uint32_t *flags,
@@ -2179,6 +2257,7 @@ int mbedtls_x509_crt_verify_with_profile( mbedtls_x509_crt *crt,
     size_t cn_len;
     int ret;
     int pathlen = 0, selfsigned = 0;
+    mbedtls_x509_crt *trust_ca;
     mbedtls_x509_crt *parent;
     mbedtls_x509_name *name;
     mbedtls_x509_sequence *cur = NULL;
@@ -2251,6 +2330,9 @@ int mbedtls_x509_crt_verify_with_profile( mbedtls_x509_crt *crt,
         *flags |= MBEDTLS_X509_BADCERT_BAD_KEY;
 
     /* Look for a parent in trusted CAs */
+    if( ( ret = x509_crt_trusted_cas( trust, crt, &trust_ca ) ) != 0 )
+        return( ret );
+
     for( parent = trust_ca; parent != NULL; parent = parent->next )
     {
         if( x509_crt_check_parent( crt, parent, 0, pathlen == 0 ) == 0 )
@@ -2261,8 +2343,6 @@ int mbedtls_x509_crt_verify_with_profile( mbedtls_x509_crt *crt,
     {
         ret = x509_crt_verify_top( crt, parent, ca_crl, profile,
                                    pathlen, selfsigned, flags, f_vrfy, p_vrfy );
-        if( ret != 0 )
-            return( ret );
     }
     else
     {
@@ -2274,26 +2354,194 @@ int mbedtls_x509_crt_verify_with_profile( mbedtls_x509_crt *crt,
         /* Are we part of the chain or at the top? */
         if( parent != NULL )
         {
-            ret = x509_crt_verify_child( crt, parent, trust_ca, ca_crl, profile,
+            x509_crt_trusted_cas_free( trust, trust_ca );
+            trust_ca = NULL;
+
+            ret = x509_crt_verify_child( crt, parent, trust, ca_crl, profile,
                                          pathlen, selfsigned, flags, f_vrfy, p_vrfy );
-            if( ret != 0 )
-                return( ret );
         }
         else
         {
             ret = x509_crt_verify_top( crt, trust_ca, ca_crl, profile,
                                        pathlen, selfsigned, flags, f_vrfy, p_vrfy );
-            if( ret != 0 )
-                return( ret );
         }
     }
 
+    x509_crt_trusted_cas_free( trust, trust_ca );
+
+    if( ret != 0 )
+        return( ret );
+
     if( *flags != 0 )
         return( MBEDTLS_ERR_X509_CERT_VERIFY_FAILED );
 
     return( 0 );
 }
 
+/*
+ * Verify the certificate validity, with profile
+ */
+int mbedtls_x509_crt_verify_with_profile( mbedtls_x509_crt *crt,
+                     mbedtls_x509_crt *trust_ca,
+                     mbedtls_x509_crl *ca_crl,
+                     const mbedtls_x509_crt_profile *profile,
+                     const char *cn, uint32_t *flags,
+                     int (*f_vrfy)(void *, mbedtls_x509_crt *, int, uint32_t *),
+                     void *p_vrfy )
+{
+    x509_crt_trust trust;
+
+    memset( &trust, 0, sizeof( trust ) );
+    trust.ca_chain = trust_ca;
+
+    return( x509_crt_verify_internal( crt, &trust, ca_crl, profile, cn, flags,
+                                      f_vrfy, p_vrfy ) );
+}
+
+#if defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK)
+/*
+ * Verify the certificate validity, with the trusted CAs from a callback
+ */
+int mbedtls_x509_crt_verify_with_ca_cb( mbedtls_x509_crt *crt,
+                     mbedtls_x509_crt_ca_cb_t f_ca_cb,
+                     void *p_ca_cb,
+                     const mbedtls_x509_crt_profile *profile,
+                     const char *cn, uint32_t *flags,
+                     int (*f_vrfy)(void *, mbedtls_x509_crt *, int, uint32_t *),
+                     void *p_vrfy )
+{
+    x509_crt_trust trust;
+
+    if( f_ca_cb == NULL )
+        return( MBEDTLS_ERR_X509_BAD_INPUT_DATA );
+
+    memset( &trust, 0, sizeof( trust ) );
+    trust.f_ca_cb = f_ca_cb;
+    trust.p_ca_cb = p_ca_cb;
+
+    return( x509_crt_verify_internal( crt, &trust, NULL, profile, cn, flags,
+                                      f_vrfy, p_vrfy ) );
+}
+
+/*
+ * Skip to the subject of a certificate without parsing it. Returns 0 and
+ * the raw subject, or an error for anything that does not look like a
+ * certificate.
+ */
+static int x509_crt_der_subject( const unsigned char *der, size_t der_len,
+                                 mbedtls_x509_buf *subject )
+{
+    int ret;
+    size_t len;
+    unsigned char *p = (unsigned char *) der;
+    const unsigned char *end = der + der_len;
+
+    /* Certificate and TBSCertificate */
+    if( ( ret = mbedtls_asn1_get_tag( &p, end, &len,
+            MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE ) ) != 0 ||
+        ( ret = mbedtls_asn1_get_tag( &p, end, &len,
+            MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE ) ) != 0 )
+        return( ret );
+
+    end = p + len;
+
+    /* Optional version */
+    ret = mbedtls_asn1_get_tag( &p, end, &len, MBEDTLS_ASN1_CONTEXT_SPECIFIC |
+                                               MBEDTLS_ASN1_CONSTRUCTED | 0 );
+    if( ret == 0 )
+        p += len;
+    else if( ret != MBEDTLS_ERR_ASN1_UNEXPECTED_TAG )
+        return( ret );
+
+    /* serialNumber, signature, issuer, validity */
+    if( ( ret = mbedtls_asn1_get_tag( &p, end, &len, MBEDTLS_ASN1_INTEGER ) ) != 0 )
+        return( ret );
+    p += len;
+
+    if( ( ret = mbedtls_asn1_get_tag( &p, end, &len,
+            MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE ) ) != 0 )
+        return( ret );
+    p += len;
+
+    if( ( ret = mbedtls_asn1_get_tag( &p, end, &len,
+            MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE ) ) != 0 )
+        return( ret );
+    p += len;
+
+    if( ( ret = mbedtls_asn1_get_tag( &p, end, &len,
+            MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE ) ) != 0 )
+        return( ret );
+    p += len;
+
+    /* subject, with its header */
+    subject->p = p;
+    if( ( ret = mbedtls_asn1_get_tag( &p, end, &len,
+            MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE ) ) != 0 )
+        return( ret );
+    subject->len = p + len - subject->p;
+
+    return( 0 );
+}
+
+/*
+ * Trusted CA callback over DER certificates that stay where they are, for
+ * example in flash: only the candidates are parsed, and without copies
+ */
+int mbedtls_x509_crt_ca_bundle_cb( void *p_bundle,
+                                   mbedtls_x509_crt const *child,
+                                   mbedtls_x509_crt **candidates )
+{
+    const mbedtls_x509_crt_ca_bundle *bundle = p_bundle;
+    mbedtls_x509_crt *cas = NULL;
+    mbedtls_x509_buf subject;
+    size_t i;
+    int ret;
+
+    *candidates = NULL;
+
+    for( i = 0; i < bundle->count; i++ )
+    {
+        if( x509_crt_der_subject( bundle->der[i], bundle->der_len[i],
+                                  &subject ) != 0 ||
+            subject.len != child->issuer_raw.len ||
+            memcmp( subject.p, child->issuer_raw.p, subject.len ) != 0 )
+        {
+            continue;
+        }
+
+        if( cas == NULL )
+        {
+            cas = mbedtls_calloc( 1, sizeof( mbedtls_x509_crt ) );
+            if( cas == NULL )
+                return( MBEDTLS_ERR_X509_ALLOC_FAILED );
+
+            mbedtls_x509_crt_init( cas );
+        }
+
+        ret = mbedtls_x509_crt_parse_der_nocopy( cas, bundle->der[i],
+                                                 bundle->der_len[i] );
+        if( ret == MBEDTLS_ERR_X509_ALLOC_FAILED )
+        {
+            mbedtls_x509_crt_free( cas );
+            mbedtls_free( cas );
+            return( ret );
+        }
+    }
+
+    /* Nothing parsed, no candidates */
+    if( cas != NULL && cas->version == 0 )
+    {
+        mbedtls_x509_crt_free( cas );
+        mbedtls_free( cas );
+        cas = NULL;
+    }
+
+    *candidates = cas;
+
+    return( 0 );
+}
+#endif /* MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK */
+
 /*
  * Initialize a certificate chain
  */
@@ -2361,7 +2609,7 @@ void mbedtls_x509_crt_free( mbedtls_x509_crt *crt )
             mbedtls_free( seq_prv );
         }
 
-        if( cert_cur->raw.p != NULL )
+        if( cert_cur->raw.p != NULL && cert_cur->own_buffer )
         {
             mbedtls_zeroize( cert_cur->raw.p, cert_cur->raw.len );
             mbedtls_free( cert_cur->raw.p );
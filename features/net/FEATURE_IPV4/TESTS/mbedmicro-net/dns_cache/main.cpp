@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * DNS cache against a fake stack that answers the first server it is
+ * asked, so no network is needed. Answers are cached for their TTL, and
+ * forged answers are neither taken nor cached.
+ */
+
+#include <string.h>
+#include "mbed.h"
+#include "NetworkStack.h"
+#include "SocketAddress.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+using namespace utest::v1;
+
+namespace {
+enum forgery {
+    FORGE_NONE,
+    FORGE_ID,       // answer with another query ID
+    FORGE_NAME,     // answer for another name
+    FORGE_SERVER,   // answer from a server that wasn't asked
+};
+
+class FakeDnsStack : public NetworkStack {
+public:
+    FakeDnsStack() : sends(0), ttl(60), forge(FORGE_NONE), _pending(0) {}
+
+    int sends;
+    uint32_t ttl;
+    forgery forge;
+
+    virtual const char *get_ip_address() { return "10.0.0.2"; }
+
+    virtual int socket_open(nsapi_socket_t *handle, nsapi_protocol_t proto) {
+        *handle = this;
+        _pending = 0;
+        return 0;
+    }
+
+    virtual int socket_close(nsapi_socket_t handle) { return 0; }
+    virtual int socket_bind(nsapi_socket_t handle, const SocketAddress &address) { return 0; }
+    virtual int socket_listen(nsapi_socket_t handle, int backlog) { return NSAPI_ERROR_UNSUPPORTED; }
+    virtual int socket_connect(nsapi_socket_t handle, const SocketAddress &address) { return NSAPI_ERROR_UNSUPPORTED; }
+    virtual int socket_accept(nsapi_socket_t *handle, nsapi_socket_t server) { return NSAPI_ERROR_UNSUPPORTED; }
+    virtual int socket_send(nsapi_socket_t handle, const void *data, unsigned size) { return NSAPI_ERROR_UNSUPPORTED; }
+    virtual int socket_recv(nsapi_socket_t handle, void *data, unsigned size) { return NSAPI_ERROR_UNSUPPORTED; }
+    virtual void socket_attach(nsapi_socket_t handle, void (*callback)(void *), void *data) {}
+
+    virtual int socket_sendto(nsapi_socket_t handle, const SocketAddress &address, const void *data, unsigned size) {
+        // only the first server asked is answered
+        sends++;
+        if (!_pending) {
+            memcpy(_query, data, size);
+            _query_size = size;
+            _server = address;
+            _pending = (forge == FORGE_NONE) ? 1 : 2;
+        }
+        return size;
+    }
+
+    virtual int socket_recvfrom(nsapi_socket_t handle, SocketAddress *address, void *buffer, unsigned size) {
+        if (!_pending) {
+            return NSAPI_ERROR_WOULD_BLOCK;
+        }
+
+        // a forged answer comes first, for 6.6.6.6, then the real one
+        bool forged = (_pending == 2);
+        _pending--;
+
+        uint8_t *p = (uint8_t *)buffer;
+        memcpy(p, _query, _query_size);
+        p[2] = 0x81;
+        p[3] = 0x80;
+        p[7] = 1;
+        unsigned len = _query_size;
+        const uint8_t rr[] = {0xc0, 12, 0, 1, 0, 1,
+                              (uint8_t)(ttl >> 24), (uint8_t)(ttl >> 16), (uint8_t)(ttl >> 8), (uint8_t)ttl,
+                              0, 4, 10, 1, 2, 3};
+        memcpy(p + len, rr, sizeof rr);
+        len += sizeof rr;
+
+        *address = _server;
+        if (forged) {
+            memset(p + len - 4, 6, 4);
+            if (forge == FORGE_ID) {
+                p[1] ^= 1;
+            } else if (forge == FORGE_NAME) {
+                p[13] ^= 1;
+            } else if (forge == FORGE_SERVER) {
+                address->set_ip_address("6.6.6.6");
+            }
+        }
+
+        return len;
+    }
+
+private:
+    uint8_t _query[160];
+    unsigned _query_size;
+    SocketAddress _server;
+    int _pending;
+};
+
+FakeDnsStack stack;
+}
+
+void test_cache_hit() {
+    SocketAddress addr;
+    stack.sends = 0;
+    stack.ttl = 60;
+    stack.forge = FORGE_NONE;
+
+    TEST_ASSERT_EQUAL(0, stack.gethostbyname(&addr, "hit.example.com"));
+    TEST_ASSERT_EQUAL_STRING("10.1.2.3", addr.get_ip_address());
+    int sends = stack.sends;
+    TEST_ASSERT(sends > 0);
+
+    TEST_ASSERT_EQUAL(0, stack.gethostbyname(&addr, "hit.example.com"));
+    TEST_ASSERT_EQUAL_STRING("10.1.2.3", addr.get_ip_address());
+    TEST_ASSERT_EQUAL(sends, stack.sends);
+}
+
+void test_ttl_expiry() {
+    SocketAddress addr;
+    stack.sends = 0;
+    stack.ttl = 2;
+    stack.forge = FORGE_NONE;
+
+    TEST_ASSERT_EQUAL(0, stack.gethostbyname(&addr, "ttl.example.com"));
+    int sends = stack.sends;
+
+    wait(1.0f);
+    TEST_ASSERT_EQUAL(0, stack.gethostbyname(&addr, "ttl.example.com"));
+    TEST_ASSERT_EQUAL(sends, stack.sends);
+
+    wait(2.0f);
+    TEST_ASSERT_EQUAL(0, stack.gethostbyname(&addr, "ttl.example.com"));
+    TEST_ASSERT(stack.sends > sends);
+}
+
+template <forgery F>
+void test_forged() {
+    SocketAddress addr;
+    stack.sends = 0;
+    stack.ttl = 60;
+    stack.forge = F;
+
+    const char *host = (F == FORGE_ID) ? "id.example.com" :
+                       (F == FORGE_NAME) ? "name.example.com" : "server.example.com";
+
+    TEST_ASSERT_EQUAL(0, stack.gethostbyname(&addr, host));
+    TEST_ASSERT_EQUAL_STRING("10.1.2.3", addr.get_ip_address());
+
+    int sends = stack.sends;
+    TEST_ASSERT_EQUAL(0, stack.gethostbyname(&addr, host));
+    TEST_ASSERT_EQUAL_STRING("10.1.2.3", addr.get_ip_address());
+    TEST_ASSERT_EQUAL(sends, stack.sends);
+}
+
+utest::v1::status_t greentea_failure_handler(const Case *const source, const failure_t reason) {
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+Case cases[] = {
+    Case("DNS cache hit", test_cache_hit, greentea_failure_handler),
+    Case("DNS cache TTL expiry", test_ttl_expiry, greentea_failure_handler),
+    Case("DNS answer with a forged ID", test_forged<FORGE_ID>, greentea_failure_handler),
+    Case("DNS answer for another name", test_forged<FORGE_NAME>, greentea_failure_handler),
+    Case("DNS answer from another server", test_forged<FORGE_SERVER>, greentea_failure_handler),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(30, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+
+int main() {
+    Harness::run(specification);
+}
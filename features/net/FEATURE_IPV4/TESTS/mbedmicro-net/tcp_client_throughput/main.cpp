@@ -0,0 +1,140 @@
+#if !FEATURE_IPV4
+    #error [NOT_SUPPORTED] IPV4 not supported for this target
+#endif
+
+#include "mbed.h"
+#include "EthernetInterface.h"
+#include "TCPSocket.h"
+#include "lwip_stack.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+
+
+#ifndef MBED_CFG_TCP_CLIENT_THROUGHPUT_BUFFER_SIZE
+#define MBED_CFG_TCP_CLIENT_THROUGHPUT_BUFFER_SIZE 1460
+#endif
+
+#ifndef MBED_CFG_TCP_CLIENT_THROUGHPUT_ROUNDS
+#define MBED_CFG_TCP_CLIENT_THROUGHPUT_ROUNDS 64
+#endif
+
+namespace {
+    // word aligned so the EMAC can transmit zero-copy data in place
+    uint32_t tx_words[(MBED_CFG_TCP_CLIENT_THROUGHPUT_BUFFER_SIZE + 3) / 4];
+    char *tx_buffer = (char *)tx_words;
+    char rx_buffer[MBED_CFG_TCP_CLIENT_THROUGHPUT_BUFFER_SIZE] = {0};
+}
+
+void prep_buffer(char *tx_buffer, size_t tx_size) {
+    for (size_t i=0; i<tx_size; ++i) {
+        tx_buffer[i] = (rand() % 10) + '0';
+    }
+}
+
+// Sends the buffer to the echo server repeatedly and returns the
+// throughput in kbit/s, or a negative value if the echo didn't match
+int run_rounds(TCPSocket *sock, bool nocopy) {
+    const size_t size = MBED_CFG_TCP_CLIENT_THROUGHPUT_BUFFER_SIZE;
+    Timer timer;
+    timer.start();
+
+    for (int round = 0; round < MBED_CFG_TCP_CLIENT_THROUGHPUT_ROUNDS; round++) {
+        int sent = nocopy ? sock->send_nocopy(tx_buffer, size)
+                          : sock->send(tx_buffer, size);
+        if (sent != (int)size) {
+            printf("MBED: send failed (%d)\r\n", sent);
+            return -1;
+        }
+
+        size_t recvd = 0;
+        while (recvd < size) {
+            int ret = sock->recv(rx_buffer + recvd, size - recvd);
+            if (ret <= 0) {
+                printf("MBED: recv failed (%d)\r\n", ret);
+                return -1;
+            }
+            recvd += ret;
+        }
+
+        if (memcmp(tx_buffer, rx_buffer, size) != 0) {
+            printf("MBED: echo mismatch in round %d\r\n", round);
+            return -1;
+        }
+    }
+
+    // the echo has come back, so the stack must be done with the buffer
+    TEST_ASSERT_EQUAL(0, sock->send_pending());
+
+    timer.stop();
+    int bits = 8 * 2 * size * MBED_CFG_TCP_CLIENT_THROUGHPUT_ROUNDS;
+    return bits / (timer.read_ms() ? timer.read_ms() : 1);
+}
+
+// Throughput depends on lwip.memory_profile, so report which one was
+// built along with the stack's counters when they are enabled
+#define STRINGIFY(x) #x
+#define XSTRINGIFY(x) STRINGIFY(x)
+
+void print_stack_info() {
+#ifdef MBED_CONF_LWIP_MEMORY_PROFILE
+    printf("MBED: lwip memory profile: %s\r\n", XSTRINGIFY(MBED_CONF_LWIP_MEMORY_PROFILE));
+#endif
+
+    lwip_stack_stats_t stats;
+    unsigned len = sizeof stats;
+    NetworkStack *stack = nsapi_create_stack(&lwip_stack);
+    if (stack->getstackopt(NSAPI_STACK, LWIP_STACKOPT_STATS, &stats, &len) == 0) {
+        printf("MBED: tcp xmit %lu recv %lu drop %lu memerr %lu\r\n",
+                stats.tcp_xmit, stats.tcp_recv, stats.tcp_drop, stats.tcp_memerr);
+        printf("MBED: link drop %lu, heap used %lu max %lu err %lu\r\n",
+                stats.link_drop, stats.mem_used, stats.mem_max, stats.mem_err);
+    }
+}
+
+int main() {
+    GREENTEA_SETUP(60, "tcp_echo_client");
+
+    EthernetInterface eth;
+    eth.connect();
+
+    printf("MBED: TCPClient IP address is '%s'\n", eth.get_ip_address());
+    printf("MBED: TCPClient waiting for server IP and port...\n");
+
+    greentea_send_kv("target_ip", eth.get_ip_address());
+
+    bool result = false;
+
+    char recv_key[] = "host_port";
+    char ipbuf[60] = {0};
+    char portbuf[16] = {0};
+    unsigned int port = 0;
+
+    greentea_send_kv("host_ip", " ");
+    greentea_parse_kv(recv_key, ipbuf, sizeof(recv_key), sizeof(ipbuf));
+
+    greentea_send_kv("host_port", " ");
+    greentea_parse_kv(recv_key, portbuf, sizeof(recv_key), sizeof(ipbuf));
+    sscanf(portbuf, "%u", &port);
+
+    printf("MBED: Server IP address received: %s:%d \n", ipbuf, port);
+
+    TCPSocket sock(&eth);
+    SocketAddress tcp_addr(ipbuf, port);
+    if (sock.connect(tcp_addr) == 0) {
+        printf("MBED: Connected to %s:%d\r\n", ipbuf, port);
+        prep_buffer(tx_buffer, MBED_CFG_TCP_CLIENT_THROUGHPUT_BUFFER_SIZE);
+
+        int copy_kbps = run_rounds(&sock, false);
+        int nocopy_kbps = run_rounds(&sock, true);
+        printf("MBED: send() throughput: %d kbps\r\n", copy_kbps);
+        printf("MBED: send_nocopy() throughput: %d kbps\r\n", nocopy_kbps);
+        print_stack_info();
+
+        result = (copy_kbps > 0) && (nocopy_kbps > 0);
+        TEST_ASSERT_EQUAL(true, result);
+    }
+
+    sock.close();
+    eth.disconnect();
+    GREENTEA_TESTSUITE_RESULT(result);
+}
@@ -0,0 +1,119 @@
+#if !FEATURE_IPV4
+    #error [NOT_SUPPORTED] IPV4 not supported for this target
+#endif
+
+#include "mbed.h"
+#include "EthernetInterface.h"
+#include "UDPSocket.h"
+#include "greentea-client/test_env.h"
+
+#ifndef MBED_CFG_UDP_CLIENT_ECHO_BUFFER_SIZE
+#define MBED_CFG_UDP_CLIENT_ECHO_BUFFER_SIZE 64
+#endif
+
+#ifndef MBED_CFG_UDP_CLIENT_ECHO_BATCH_SIZE
+#define MBED_CFG_UDP_CLIENT_ECHO_BATCH_SIZE 4
+#endif
+
+namespace {
+    const int BATCH = MBED_CFG_UDP_CLIENT_ECHO_BATCH_SIZE;
+    char tx_buffer[BATCH][MBED_CFG_UDP_CLIENT_ECHO_BUFFER_SIZE] = {{0}};
+    char rx_buffer[BATCH][MBED_CFG_UDP_CLIENT_ECHO_BUFFER_SIZE] = {{0}};
+    const int ECHO_LOOPS = 16;
+}
+
+void prep_buffer(char *tx_buffer, size_t tx_size) {
+    for (size_t i=0; i<tx_size; ++i) {
+        tx_buffer[i] = (rand() % 10) + '0';
+    }
+}
+
+int main() {
+    GREENTEA_SETUP(20, "udp_echo_client");
+
+    EthernetInterface eth;
+    eth.connect();
+    printf("UDP client IP Address is %s\n", eth.get_ip_address());
+
+    greentea_send_kv("target_ip", eth.get_ip_address());
+
+    bool result = true;
+
+    char recv_key[] = "host_port";
+    char ipbuf[60] = {0};
+    char portbuf[16] = {0};
+    unsigned int port = 0;
+
+    UDPSocket sock;
+    sock.open(&eth);
+    sock.set_timeout(5000);
+
+    greentea_send_kv("host_ip", " ");
+    greentea_parse_kv(recv_key, ipbuf, sizeof(recv_key), sizeof(ipbuf));
+
+    greentea_send_kv("host_port", " ");
+    greentea_parse_kv(recv_key, portbuf, sizeof(recv_key), sizeof(ipbuf));
+    sscanf(portbuf, "%u", &port);
+
+    printf("MBED: UDP Server IP address received: %s:%d \n", ipbuf, port);
+
+    SocketAddress addr(ipbuf, port);
+
+    for (int i=0; i < ECHO_LOOPS && result; ++i) {
+        nsapi_datagram_t tx[BATCH];
+        for (int j=0; j < BATCH; ++j) {
+            prep_buffer(tx_buffer[j], sizeof(tx_buffer[j]));
+            tx[j].addr = addr.get_addr();
+            tx[j].port = addr.get_port();
+            tx[j].data = tx_buffer[j];
+            tx[j].size = sizeof(tx_buffer[j]);
+        }
+
+        int sent = 0;
+        while (sent < BATCH) {
+            int ret = sock.sendto_batch(tx + sent, BATCH - sent);
+            if (ret <= 0) {
+                printf("MBED: sendto_batch failed (%d)\r\n", ret);
+                result = false;
+                break;
+            }
+            sent += ret;
+        }
+        printf("[%02d] sent...%d datagrams \n", i, sent);
+
+        // the echoes may trickle in over several calls
+        int recvd = 0;
+        while (result && recvd < BATCH) {
+            nsapi_datagram_t rx[BATCH];
+            for (int j=0; j < BATCH - recvd; ++j) {
+                rx[j].data = rx_buffer[recvd + j];
+                rx[j].size = sizeof(rx_buffer[recvd + j]);
+            }
+
+            int ret = sock.recvfrom_batch(rx, BATCH - recvd);
+            if (ret <= 0) {
+                printf("MBED: recvfrom_batch failed (%d)\r\n", ret);
+                result = false;
+                break;
+            }
+
+            for (int j=0; j < ret; ++j) {
+                if (rx[j].size != sizeof(tx_buffer[0])) {
+                    result = false;
+                }
+            }
+            recvd += ret;
+        }
+
+        for (int j=0; j < BATCH && result; ++j) {
+            if (memcmp(tx_buffer[j], rx_buffer[j], sizeof(tx_buffer[j]))) {
+                result = false;
+            }
+        }
+        printf("[%02d] recv...%d datagrams \n", i, recvd);
+    }
+
+    sock.close();
+    eth.disconnect();
+    GREENTEA_TESTSUITE_RESULT(result);
+}
@@ -0,0 +1,99 @@
+#if !FEATURE_IPV4
+    #error [NOT_SUPPORTED] IPV4 not supported for this target
+#endif
+
+#include "mbed.h"
+#include "EthernetInterface.h"
+#include "UDPSocket.h"
+#include "SocketSet.h"
+#include "greentea-client/test_env.h"
+
+#ifndef MBED_CFG_UDP_CLIENT_ECHO_BUFFER_SIZE
+#define MBED_CFG_UDP_CLIENT_ECHO_BUFFER_SIZE 256
+#endif
+
+#define ECHO_SOCKETS 4
+
+namespace {
+    char tx_buffer[ECHO_SOCKETS][MBED_CFG_UDP_CLIENT_ECHO_BUFFER_SIZE] = {{0}};
+    char rx_buffer[MBED_CFG_UDP_CLIENT_ECHO_BUFFER_SIZE] = {0};
+    const int ECHO_LOOPS = 16;
+}
+
+void prep_buffer(char *tx_buffer, size_t tx_size) {
+    for (size_t i=0; i<tx_size; ++i) {
+        tx_buffer[i] = (rand() % 10) + '0';
+    }
+}
+
+int main() {
+    GREENTEA_SETUP(20, "udp_echo_client");
+
+    EthernetInterface eth;
+    eth.connect();
+    printf("UDP client IP Address is %s\n", eth.get_ip_address());
+
+    greentea_send_kv("target_ip", eth.get_ip_address());
+
+    bool result = true;
+
+    char recv_key[] = "host_port";
+    char ipbuf[60] = {0};
+    char portbuf[16] = {0};
+    unsigned int port = 0;
+
+    greentea_send_kv("host_ip", " ");
+    greentea_parse_kv(recv_key, ipbuf, sizeof(recv_key), sizeof(ipbuf));
+
+    greentea_send_kv("host_port", " ");
+    greentea_parse_kv(recv_key, portbuf, sizeof(recv_key), sizeof(ipbuf));
+    sscanf(portbuf, "%u", &port);
+
+    printf("MBED: UDP Server IP address received: %s:%d \n", ipbuf, port);
+
+    SocketAddress addr(ipbuf, port);
+
+    // All sockets are serviced from this one thread
+    UDPSocket sock[ECHO_SOCKETS];
+    SocketSet set;
+    for (int s = 0; s < ECHO_SOCKETS; s++) {
+        sock[s].open(&eth);
+        sock[s].set_blocking(false);
+        set.add(&sock[s]);
+    }
+
+    for (int i=0; i < ECHO_LOOPS && result; ++i) {
+        for (int s = 0; s < ECHO_SOCKETS; s++) {
+            prep_buffer(tx_buffer[s], sizeof(tx_buffer[s]));
+            sock[s].sendto(addr, tx_buffer[s], sizeof(tx_buffer[s]));
+        }
+
+        int pending = ECHO_SOCKETS;
+        while (pending > 0) {
+            if (set.poll(5000) < 0) {
+                printf("[%02d] poll timed out, %d echoes missing\n", i, pending);
+                result = false;
+                break;
+            }
+
+            while (UDPSocket *ready = static_cast<UDPSocket *>(set.next())) {
+                int s = ready - sock;
+                int n;
+                while ((n = ready->recvfrom(0, rx_buffer, sizeof(rx_buffer))) > 0) {
+                    if (n != (int)sizeof(rx_buffer) || memcmp(rx_buffer, tx_buffer[s], n)) {
+                        result = false;
+                    }
+                    pending -= 1;
+                }
+            }
+        }
+        printf("[%02d] echoed on %d sockets\n", i, ECHO_SOCKETS);
+    }
+
+    for (int s = 0; s < ECHO_SOCKETS; s++) {
+        set.remove(&sock[s]);
+        sock[s].close();
+    }
+    eth.disconnect();
+    GREENTEA_TESTSUITE_RESULT(result);
+}
@@ -0,0 +1,93 @@
+#if !FEATURE_IPV4
+    #error [NOT_SUPPORTED] IPV4 not supported for this target
+#endif
+
+#include "mbed.h"
+#include "EthernetInterface.h"
+#include "UDPSocket.h"
+#include "greentea-client/test_env.h"
+
+#ifndef MBED_CFG_UDP_CLIENT_ECHO_BUFFER_SIZE
+#define MBED_CFG_UDP_CLIENT_ECHO_BUFFER_SIZE 256
+#endif
+
+namespace {
+    char tx_buffer[MBED_CFG_UDP_CLIENT_ECHO_BUFFER_SIZE] = {0};
+    const int ECHO_LOOPS = 16;
+}
+
+void prep_buffer(char *tx_buffer, size_t tx_size) {
+    for (size_t i=0; i<tx_size; ++i) {
+        tx_buffer[i] = (rand() % 10) + '0';
+    }
+}
+
+// Compares the echoed packet against tx_buffer one borrowed
+// segment at a time, releasing each segment back to the stack
+bool check_echo(UDPSocket *sock, SocketAddress *addr) {
+    size_t recvd = 0;
+    while (recvd < sizeof(tx_buffer)) {
+        const void *data;
+        int n = sock->recvfrom_view(addr, &data);
+        if (n <= 0 || recvd + n > sizeof(tx_buffer)) {
+            printf("MBED: recvfrom_view failed (%d)\r\n", n);
+            return false;
+        }
+
+        bool match = !memcmp(data, tx_buffer + recvd, n);
+        sock->release(n);
+        if (!match) {
+            return false;
+        }
+        recvd += n;
+    }
+
+    return true;
+}
+
+int main() {
+    GREENTEA_SETUP(20, "udp_echo_client");
+
+    EthernetInterface eth;
+    eth.connect();
+    printf("UDP client IP Address is %s\n", eth.get_ip_address());
+
+    greentea_send_kv("target_ip", eth.get_ip_address());
+
+    bool result = true;
+
+    char recv_key[] = "host_port";
+    char ipbuf[60] = {0};
+    char portbuf[16] = {0};
+    unsigned int port = 0;
+
+    UDPSocket sock;
+    sock.open(&eth);
+
+    greentea_send_kv("host_ip", " ");
+    greentea_parse_kv(recv_key, ipbuf, sizeof(recv_key), sizeof(ipbuf));
+
+    greentea_send_kv("host_port", " ");
+    greentea_parse_kv(recv_key, portbuf, sizeof(recv_key), sizeof(ipbuf));
+    sscanf(portbuf, "%u", &port);
+
+    printf("MBED: UDP Server IP address received: %s:%d \n", ipbuf, port);
+
+    SocketAddress addr(ipbuf, port);
+
+    for (int i=0; i < ECHO_LOOPS; ++i) {
+        prep_buffer(tx_buffer, sizeof(tx_buffer));
+        const int ret = sock.sendto(addr, tx_buffer, sizeof(tx_buffer));
+        printf("[%02d] sent...%d Bytes \n", i, ret);
+
+        if (!check_echo(&sock, &addr)) {
+            result = false;
+            break;
+        }
+        printf("[%02d] recv...%d Bytes \n", i, ret);
+    }
+
+    sock.close();
+    eth.disconnect();
+    GREENTEA_TESTSUITE_RESULT(result);
+}
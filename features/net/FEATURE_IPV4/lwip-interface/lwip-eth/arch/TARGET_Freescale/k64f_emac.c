@@ -28,8 +28,8 @@ uint8_t *tx_desc_start_addr;
 uint8_t *rx_desc_start_addr;
 // RX packet buffer pointers
 struct pbuf *rx_buff[ENET_RX_RING_LEN];
-// TX packet buffer pointers
-struct pbuf *tx_buff[ENET_RX_RING_LEN];
+// TX packet buffer pointers, set on the last descriptor of each frame
+struct pbuf *tx_buff[ENET_TX_RING_LEN];
 // RX packet payload pointers
 uint32_t *rx_ptr[ENET_RX_RING_LEN];
 
@@ -107,7 +107,11 @@ static void k64f_tx_reclaim(struct k64f_enetdata *k64f_enet)
   i = k64f_enet->tx_consume_index;
   // Traverse all descriptors, looking for the ones modified by the uDMA
   while((i != k64f_enet->tx_produce_index) && (!(g_handle.txBdDirty->control & ENET_BUFFDESCRIPTOR_TX_READY_MASK))) {
-      pbuf_free(tx_buff[i]);
+      if (tx_buff[i] != NULL) {
+        pbuf_free(tx_buff[i]);
+        tx_buff[i] = NULL;
+      }
+      osSemaphoreRelease(k64f_enet->xTXDCountSem.id);
       if (g_handle.txBdDirty->control & ENET_BUFFDESCRIPTOR_TX_WRAP_MASK)
         g_handle.txBdDirty = g_handle.txBdBase;
       else
@@ -227,6 +231,12 @@ static err_t low_level_init(struct netif *netif)
   config.macSpecialConfig = kENET_ControlFlowControlEnable;
   config.txAccelerConfig = kENET_TxAccelIsShift16Enabled;
   config.rxAccelerConfig = kENET_RxAccelisShift16Enabled | kENET_RxAccelMacCheckEnabled;
+#if LWIP_CHECKSUM_OFFLOAD
+  /* Insert checksums into outgoing frames and drop incoming frames
+     with bad checksums, lwIP leaves the checksum fields cleared */
+  config.txAccelerConfig |= kENET_TxAccelIpCheckEnabled | kENET_TxAccelProtoCheckEnabled;
+  config.rxAccelerConfig |= kENET_RxAccelIpCheckEnabled | kENET_RxAccelProtoCheckEnabled;
+#endif
   ENET_Init(ENET, &g_handle, &config, &buffCfg, netif->hwaddr, sysClock);
   ENET_SetCallback(&g_handle, ethernet_callback, netif);
   ENET_ActiveRead(ENET);
@@ -429,47 +439,89 @@ static err_t k64f_low_level_output(struct netif *netif, struct pbuf *p)
 {
   struct k64f_enetdata *k64f_enet = netif->state;
   struct pbuf *q;
-  struct pbuf *temp_pbuf;
-  uint8_t *psend = NULL, *dst;
-
+  struct pbuf *frame = NULL;
+  uint8_t *seg_buff[ENET_TX_MAX_SEGMENTS];
+  uint16_t seg_len[ENET_TX_MAX_SEGMENTS];
+  volatile enet_tx_bd_struct_t *first;
+  uint8_t *dst;
+  int count = 0;
+  int i;
+
+  /* Scatter the frame over one descriptor per pbuf so the uDMA reads it
+     straight from the pbufs, provided they are suitably aligned. PBUF_REF
+     and PBUF_ROM payloads belong to the application, which may reuse them
+     as soon as this returns, so those frames are always copied */
+  for (q = p; q != NULL; q = q->next) {
+    if (q->len == 0)
+      continue;
+    if ((count == ENET_TX_MAX_SEGMENTS) ||
+        ((q->type != PBUF_RAM) && (q->type != PBUF_POOL)) ||
+        ((uint32_t)q->payload % ENET_TX_BUFF_ALIGNMENT)) {
+      count = 0;
+      break;
+    }
+    seg_buff[count] = q->payload;
+    seg_len[count] = q->len;
+    count++;
+  }
 
-  temp_pbuf = pbuf_alloc(PBUF_RAW, p->tot_len + ENET_BUFF_ALIGNMENT, PBUF_RAM);
-  if (NULL == temp_pbuf)
-    return ERR_MEM;
+  if (count > 0) {
+    /* hold on to the chain until the uDMA is done with it */
+    frame = p;
+    pbuf_ref(frame);
+  } else {
+    frame = pbuf_alloc(PBUF_RAW, p->tot_len + ENET_BUFF_ALIGNMENT, PBUF_RAM);
+    if (NULL == frame)
+      return ERR_MEM;
 
-  /* K64F note: the next line ensures that the RX buffer is properly aligned for the K64F
-     RX descriptors (16 bytes alignment). However, by doing so, we're effectively changing
-     a data structure which is internal to lwIP. This might not prove to be a good idea
-     in the long run, but a better fix would probably involve modifying lwIP itself */
-  psend = (uint8_t *)ENET_ALIGN((uint32_t)temp_pbuf->payload, ENET_BUFF_ALIGNMENT);
+    /* K64F note: the next line ensures that the TX buffer is properly aligned for the K64F
+       TX descriptors (16 bytes alignment). However, by doing so, we're effectively changing
+       a data structure which is internal to lwIP. This might not prove to be a good idea
+       in the long run, but a better fix would probably involve modifying lwIP itself */
+    seg_buff[0] = (uint8_t *)ENET_ALIGN((uint32_t)frame->payload, ENET_BUFF_ALIGNMENT);
+    seg_len[0] = p->tot_len;
+    count = 1;
 
-  for (q = p, dst = psend; q != NULL; q = q->next) {
-    MEMCPY(dst, q->payload, q->len);
-    dst += q->len;
+    for (q = p, dst = seg_buff[0]; q != NULL; q = q->next) {
+      MEMCPY(dst, q->payload, q->len);
+      dst += q->len;
+    }
   }
 
-  /* Wait until a descriptor is available for the transfer. */
-  /* THIS WILL BLOCK UNTIL THERE ARE A DESCRIPTOR AVAILABLE */
-  while (g_handle.txBdCurrent->control & ENET_BUFFDESCRIPTOR_TX_READY_MASK)
+  /* Wait until a descriptor is available for each segment. */
+  /* THIS WILL BLOCK UNTIL THERE ARE DESCRIPTORS AVAILABLE */
+  for (i = 0; i < count; i++)
     osSemaphoreWait(k64f_enet->xTXDCountSem.id, osWaitForever);
 
   /* Get exclusive access */
   sys_mutex_lock(&k64f_enet->TXLockMutex);
 
-  /* Save the buffer so that it can be freed when transmit is done */
-  tx_buff[k64f_enet->tx_produce_index] = temp_pbuf;
-  k64f_enet->tx_produce_index = (k64f_enet->tx_produce_index + 1) % ENET_TX_RING_LEN;
-
-  /* Setup transfers */
-  g_handle.txBdCurrent->buffer = psend;
-  g_handle.txBdCurrent->length = p->tot_len;
-  g_handle.txBdCurrent->control |= (ENET_BUFFDESCRIPTOR_TX_READY_MASK | ENET_BUFFDESCRIPTOR_TX_LAST_MASK);
-
-  /* Increase the buffer descriptor address. */
-  if (g_handle.txBdCurrent->control & ENET_BUFFDESCRIPTOR_TX_WRAP_MASK)
-    g_handle.txBdCurrent = g_handle.txBdBase;
-  else
-    g_handle.txBdCurrent++;
+  first = g_handle.txBdCurrent;
+  for (i = 0; i < count; i++) {
+    volatile enet_tx_bd_struct_t *bd = g_handle.txBdCurrent;
+    uint16_t control = bd->control & ~(ENET_BUFFDESCRIPTOR_TX_READY_MASK | ENET_BUFFDESCRIPTOR_TX_LAST_MASK);
+
+    /* Save the buffer on the last descriptor so that it can be freed when transmit is done */
+    tx_buff[k64f_enet->tx_produce_index] = (i == count - 1) ? frame : NULL;
+    k64f_enet->tx_produce_index = (k64f_enet->tx_produce_index + 1) % ENET_TX_RING_LEN;
+
+    /* Setup transfers, the first descriptor is handed over last so the
+       uDMA never sees a partial frame */
+    bd->buffer = seg_buff[i];
+    bd->length = seg_len[i];
+    if (i == count - 1)
+      control |= ENET_BUFFDESCRIPTOR_TX_LAST_MASK;
+    if (i > 0)
+      control |= ENET_BUFFDESCRIPTOR_TX_READY_MASK;
+    bd->control = control;
+
+    /* Increase the buffer descriptor address. */
+    if (bd->control & ENET_BUFFDESCRIPTOR_TX_WRAP_MASK)
+      g_handle.txBdCurrent = g_handle.txBdBase;
+    else
+      g_handle.txBdCurrent++;
+  }
+  first->control |= ENET_BUFFDESCRIPTOR_TX_READY_MASK;
 
   /* Active the transmit buffer descriptor. */
   ENET->TDAR = ENET_TDAR_TDAR_MASK;
@@ -600,7 +652,8 @@ err_t eth_arch_enetif_init(struct netif *netif)
   memset(k64f_enetdata.xTXDCountSem.data, 0, sizeof(k64f_enetdata.xTXDCountSem.data));
   k64f_enetdata.xTXDCountSem.def.semaphore = k64f_enetdata.xTXDCountSem.data;
 #endif
-  k64f_enetdata.xTXDCountSem.id = osSemaphoreCreate(&k64f_enetdata.xTXDCountSem.def, ENET_TX_RING_LEN);
+  /* one descriptor is kept back so that a full ring can be told apart from an empty one */
+  k64f_enetdata.xTXDCountSem.id = osSemaphoreCreate(&k64f_enetdata.xTXDCountSem.def, ENET_TX_RING_LEN - 1);
 
   LWIP_ASSERT("xTXDCountSem creation error", (k64f_enetdata.xTXDCountSem.id != NULL));
 
@@ -35,6 +35,13 @@
 #define ENET_RX_RING_LEN              (16)
 #define ENET_TX_RING_LEN              (8)
 
+/* Frames are transmitted in place from their pbufs, one TX descriptor per
+ * pbuf, when the chain has at most ENET_TX_MAX_SEGMENTS PBUF_RAM or PBUF_POOL
+ * pbufs and each payload is aligned as the ENET uDMA requires of transmit
+ * buffers. Other frames are copied into a single aligned buffer. */
+#define ENET_TX_MAX_SEGMENTS          (4)
+#define ENET_TX_BUFF_ALIGNMENT        ENET_BUFF_ALIGNMENT
+
 #define ENET_ETH_MAX_FLEN             (1522) // recommended size for a VLAN frame
 
 #if defined(__cplusplus)
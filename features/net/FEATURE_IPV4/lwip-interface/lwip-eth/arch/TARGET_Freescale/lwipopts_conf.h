@@ -22,6 +22,7 @@
 #include "k64f_emac_config.h"
 
 #define LWIP_TRANSPORT_ETHERNET       1
+#define LWIP_EMAC_CHECKSUM_OFFLOAD    1
 #define ETH_PAD_SIZE                  2
 
 #define MEM_SIZE                      (ENET_RX_RING_LEN * (ENET_ETH_MAX_FLEN + ENET_BUFF_ALIGNMENT) + ENET_TX_RING_LEN * ENET_ETH_MAX_FLEN)
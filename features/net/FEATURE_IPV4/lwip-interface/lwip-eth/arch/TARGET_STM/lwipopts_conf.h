@@ -20,6 +20,7 @@
 #define LWIPOPTS_CONF_H
 
 #define LWIP_TRANSPORT_ETHERNET       1
+#define LWIP_EMAC_CHECKSUM_OFFLOAD    1
 
 #define MEM_SIZE                      (1600 * 16)
 
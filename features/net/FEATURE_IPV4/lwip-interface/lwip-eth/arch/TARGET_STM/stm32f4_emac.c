@@ -194,7 +194,11 @@ static void stm32f4_low_level_init(struct netif *netif)
 #endif
     heth.Init.MACAddr = &MACAddr[0];
     heth.Init.RxMode = ETH_RXINTERRUPT_MODE;
+#if LWIP_CHECKSUM_OFFLOAD
     heth.Init.ChecksumMode = ETH_CHECKSUM_BY_HARDWARE;
+#else
+    heth.Init.ChecksumMode = ETH_CHECKSUM_BY_SOFTWARE;
+#endif
     heth.Init.MediaInterface = ETH_MEDIA_INTERFACE_RMII;
     hal_eth_init_status = HAL_ETH_Init(&heth);
 
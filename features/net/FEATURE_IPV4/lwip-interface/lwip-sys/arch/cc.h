@@ -87,17 +87,26 @@ typedef uintptr_t          mem_ptr_t;
 #if defined(TOOLCHAIN_GCC) && defined(__thumb2__)
     #define MEMCPY(dst,src,len)     thumb2_memcpy(dst,src,len)
     #define LWIP_CHKSUM             thumb2_checksum
-    /* Set algorithm to 0 so that unused lwip_standard_chksum function
-       doesn't generate compiler warning */
-    #define LWIP_CHKSUM_ALGORITHM   0
 
     void* thumb2_memcpy(void* pDest, const void* pSource, size_t length);
     u16_t thumb2_checksum(void* pData, int length);
 #else
-    /* Used with IP headers only */
-    #define LWIP_CHKSUM_ALGORITHM   1
+    /* Word at a time C routine for ARMCC, IAR and Thumb-1 targets */
+    #define LWIP_CHKSUM             word_checksum
+
+    u16_t word_checksum(const void* pData, int length);
 #endif
 
+/* Set algorithm to 0 so that unused lwip_standard_chksum function
+   doesn't generate compiler warning */
+#define LWIP_CHKSUM_ALGORITHM   0
+
+/* Checksum data while copying it out of application buffers, used by
+   LWIP_CHECKSUM_ON_COPY */
+#define LWIP_CHKSUM_COPY(dst,src,len)   copy_checksum(dst,src,len)
+
+u16_t copy_checksum(void* pDest, const void* pSource, u16_t length);
+
 
 #ifdef LWIP_DEBUG
 
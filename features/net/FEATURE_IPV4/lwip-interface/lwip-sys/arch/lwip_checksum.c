@@ -124,3 +124,136 @@ __attribute__((naked)) void /*uint16_t*/ thumb2_checksum(const void* pData, int
 }
 
 #endif
+
+
+#include <stdint.h>
+#include <string.h>
+
+/* Folds a 64-bit 1's complement sum of 32-bit words into 16 bits. */
+static inline uint16_t fold_checksum(uint64_t sum)
+{
+    sum = (sum & 0xffffffff) + (sum >> 32);
+    sum = (sum & 0xffffffff) + (sum >> 32);
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    return (uint16_t)sum;
+}
+
+/* Portable C version of the algorithm used by thumb2_checksum. The data is
+   summed 32-bits at a time into a 64-bit accumulator, which ARMCC, IAR and
+   GCC all turn into add/add-with-carry pairs, so no per-word carry checks
+   are needed. The loop is unrolled to sum four words per iteration.
+
+   Returns:
+        16-bit 1's complement summation (not inversed).
+*/
+uint16_t word_checksum(const void* pData, int length)
+{
+    const uint8_t* pb = (const uint8_t*)pData;
+    uint64_t sum = 0;
+    uint16_t t = 0;
+    int odd = (uintptr_t)pb & 1;
+
+    // Place a leading odd byte in the odd summation location, the result
+    // is swapped at the end
+    if (odd && length > 0) {
+        ((uint8_t*)&t)[1] = *pb++;
+        length--;
+    }
+
+    // 4-byte align
+    if (((uintptr_t)pb & 2) && length > 1) {
+        sum += *(const uint16_t*)pb;
+        pb += 2;
+        length -= 2;
+    }
+
+    const uint32_t* pl = (const uint32_t*)pb;
+    while (length > 15) {
+        sum += pl[0];
+        sum += pl[1];
+        sum += pl[2];
+        sum += pl[3];
+        pl += 4;
+        length -= 16;
+    }
+
+    while (length > 3) {
+        sum += *pl++;
+        length -= 4;
+    }
+
+    pb = (const uint8_t*)pl;
+    if (length > 1) {
+        sum += *(const uint16_t*)pb;
+        pb += 2;
+        length -= 2;
+    }
+
+    // Trailing byte
+    if (length > 0) {
+        ((uint8_t*)&t)[0] = *pb;
+    }
+    sum += t;
+
+    uint16_t result = fold_checksum(sum);
+    if (odd) {
+        result = (uint16_t)((result << 8) | (result >> 8));
+    }
+    return result;
+}
+
+/* Copies length bytes from pSource to pDest and returns the checksum of
+   the data, as word_checksum(pDest, length) would. When both buffers are
+   word aligned, which is the common case for pbuf payloads and application
+   buffers, each word is summed as it is copied so the data only passes
+   through the core once. Otherwise this falls back to a copy followed by a
+   checksum of the destination.
+*/
+uint16_t copy_checksum(void* pDest, const void* pSource, uint16_t length)
+{
+    if ((((uintptr_t)pDest | (uintptr_t)pSource) & 3) != 0) {
+        memcpy(pDest, pSource, length);
+        return word_checksum(pDest, length);
+    }
+
+    uint32_t* d = (uint32_t*)pDest;
+    const uint32_t* s = (const uint32_t*)pSource;
+    uint64_t sum = 0;
+    int len = length;
+
+    while (len > 15) {
+        uint32_t w0 = s[0];
+        uint32_t w1 = s[1];
+        uint32_t w2 = s[2];
+        uint32_t w3 = s[3];
+        d[0] = w0;
+        d[1] = w1;
+        d[2] = w2;
+        d[3] = w3;
+        sum += w0;
+        sum += w1;
+        sum += w2;
+        sum += w3;
+        d += 4;
+        s += 4;
+        len -= 16;
+    }
+
+    while (len > 3) {
+        uint32_t w = *s++;
+        *d++ = w;
+        sum += w;
+        len -= 4;
+    }
+
+    // Trailing bytes are summed in their in-memory positions
+    if (len > 0) {
+        uint32_t t = 0;
+        memcpy(&t, s, len);
+        memcpy(d, &t, len);
+        sum += t;
+    }
+
+    return fold_checksum(sum);
+}
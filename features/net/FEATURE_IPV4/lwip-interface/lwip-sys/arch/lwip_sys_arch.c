@@ -21,6 +21,8 @@
 #include "mbed_error.h"
 #include "mbed_interface.h"
 #include "us_ticker_api.h"
+#include "critical.h"
+#include <stdbool.h>
 
 /* lwIP includes. */
 #include "lwip/opt.h"
@@ -67,6 +69,65 @@ u32_t sys_now(void) {
 /* CMSIS-RTOS implementation of the lwip operating system abstraction */
 #include "arch/sys_arch.h"
 
+/* Mailboxes are fixed size rings. Posting and fetching only mask
+ * interrupts for the few instructions it takes to move an index, so a
+ * busy tcpip_thread drains a burst of messages without any kernel calls.
+ * The semaphores are only used to put a thread to sleep when the ring is
+ * empty (fetch) or full (post), and are only signalled if someone is
+ * actually waiting. A woken thread always rechecks the ring, so a stale
+ * token just costs an extra loop.
+ */
+static bool sys_mbox_put(sys_mbox_t *mbox, void *msg, bool *wake) {
+    core_util_critical_section_enter();
+    if (mbox->count >= mbox->size) {
+        core_util_critical_section_exit();
+        return false;
+    }
+
+    mbox->queue[mbox->post_idx] = msg;
+    mbox->post_idx = (mbox->post_idx + 1) % mbox->size;
+    mbox->count++;
+    *wake = mbox->fetch_waiting != 0;
+    core_util_critical_section_exit();
+    return true;
+}
+
+static bool sys_mbox_get(sys_mbox_t *mbox, void **msg, bool *wake) {
+    core_util_critical_section_enter();
+    if (mbox->count == 0) {
+        core_util_critical_section_exit();
+        return false;
+    }
+
+    void *m = mbox->queue[mbox->fetch_idx];
+    mbox->fetch_idx = (mbox->fetch_idx + 1) % mbox->size;
+    mbox->count--;
+    *wake = mbox->post_waiting != 0;
+    core_util_critical_section_exit();
+
+    if (msg)
+        *msg = m;
+    return true;
+}
+
+/* Sleeps on sem until woken or timeout ms pass, 0 waits forever.
+ * Callers raise their waiting count before rechecking the ring, so a
+ * post or fetch that races with going to sleep still signals the
+ * semaphore.
+ */
+static bool sys_mbox_wait(sys_sem_t *sem, u32_t start, u32_t timeout) {
+    u32_t wait = osWaitForever;
+    if (timeout != 0) {
+        u32_t elapsed = (us_ticker_read() - start) / 1000;
+        if (elapsed >= timeout)
+            return false;
+        wait = timeout - elapsed;
+    }
+
+    osSemaphoreWait(sem->id, wait);
+    return true;
+}
+
 /*---------------------------------------------------------------------------*
  * Routine:  sys_mbox_new
  *---------------------------------------------------------------------------*
@@ -79,16 +140,20 @@ u32_t sys_now(void) {
  *      err_t                   -- ERR_OK if message posted, else ERR_MEM
  *---------------------------------------------------------------------------*/
 err_t sys_mbox_new(sys_mbox_t *mbox, int queue_sz) {
-    if (queue_sz > MB_SIZE)
+    if (queue_sz > MB_SIZE || queue_sz <= 0)
         error("sys_mbox_new size error\n");
-    
-#ifdef CMSIS_OS_RTX
-    memset(mbox->queue, 0, sizeof(mbox->queue));
-    mbox->def.pool = mbox->queue;
-    mbox->def.queue_sz = queue_sz;
-#endif
-    mbox->id = osMessageCreate(&mbox->def, NULL);
-    return (mbox->id == NULL) ? (ERR_MEM) : (ERR_OK);
+
+    /* the mailbox stays invalid, size 0, unless both semaphores exist */
+    memset(mbox, 0, sizeof(*mbox));
+    if (sys_sem_new(&mbox->not_full, 0) != ERR_OK)
+        return ERR_MEM;
+    if (sys_sem_new(&mbox->not_empty, 0) != ERR_OK) {
+        sys_sem_free(&mbox->not_full);
+        return ERR_MEM;
+    }
+
+    mbox->size = queue_sz;
+    return ERR_OK;
 }
 
 /*---------------------------------------------------------------------------*
@@ -102,9 +167,10 @@ err_t sys_mbox_new(sys_mbox_t *mbox, int queue_sz) {
  *      sys_mbox_t *mbox         -- Handle of mailbox
  *---------------------------------------------------------------------------*/
 void sys_mbox_free(sys_mbox_t *mbox) {
-    osEvent event = osMessageGet(mbox->id, 0);
-    if (event.status == osEventMessage)
+    if (mbox->count != 0)
         error("sys_mbox_free error\n");
+    sys_sem_free(&mbox->not_full);
+    sys_sem_free(&mbox->not_empty);
 }
 
 /*---------------------------------------------------------------------------*
@@ -117,8 +183,22 @@ void sys_mbox_free(sys_mbox_t *mbox) {
  *      void *msg              -- Pointer to data to post
  *---------------------------------------------------------------------------*/
 void sys_mbox_post(sys_mbox_t *mbox, void *msg) {
-    if (osMessagePut(mbox->id, (uint32_t)msg, osWaitForever) != osOK)
-        error("sys_mbox_post error\n");
+    bool wake;
+    if (!sys_mbox_put(mbox, msg, &wake)) {
+        core_util_critical_section_enter();
+        mbox->post_waiting++;
+        core_util_critical_section_exit();
+
+        while (!sys_mbox_put(mbox, msg, &wake))
+            sys_mbox_wait(&mbox->not_full, 0, 0);
+
+        core_util_critical_section_enter();
+        mbox->post_waiting--;
+        core_util_critical_section_exit();
+    }
+
+    if (wake)
+        sys_sem_signal(&mbox->not_empty);
 }
 
 /*---------------------------------------------------------------------------*
@@ -126,7 +206,7 @@ void sys_mbox_post(sys_mbox_t *mbox, void *msg) {
  *---------------------------------------------------------------------------*
  * Description:
  *      Try to post the "msg" to the mailbox.  Returns immediately with
- *      error if cannot.
+ *      error if cannot. Safe to call from an ISR.
  * Inputs:
  *      sys_mbox_t mbox         -- Handle of mailbox
  *      void *msg               -- Pointer to data to post
@@ -135,8 +215,13 @@ void sys_mbox_post(sys_mbox_t *mbox, void *msg) {
  *                                  if not.
  *---------------------------------------------------------------------------*/
 err_t sys_mbox_trypost(sys_mbox_t *mbox, void *msg) {
-    osStatus status = osMessagePut(mbox->id, (uint32_t)msg, 0);
-    return (status == osOK) ? (ERR_OK) : (ERR_MEM);
+    bool wake;
+    if (!sys_mbox_put(mbox, msg, &wake))
+        return ERR_MEM;
+
+    if (wake)
+        sys_sem_signal(&mbox->not_empty);
+    return ERR_OK;
 }
 
 /*---------------------------------------------------------------------------*
@@ -165,14 +250,36 @@ err_t sys_mbox_trypost(sys_mbox_t *mbox, void *msg) {
  *                                  of milliseconds until received.
  *---------------------------------------------------------------------------*/
 u32_t sys_arch_mbox_fetch(sys_mbox_t *mbox, void **msg, u32_t timeout) {
+    bool wake;
+
+    // Fast path, no kernel calls while there are messages queued
+    if (sys_mbox_get(mbox, msg, &wake)) {
+        if (wake)
+            sys_sem_signal(&mbox->not_full);
+        return 0;
+    }
+
     u32_t start = us_ticker_read();
-    
-    osEvent event = osMessageGet(mbox->id, (timeout != 0)?(timeout):(osWaitForever));
-    if (event.status != osEventMessage)
+    bool got = false;
+
+    core_util_critical_section_enter();
+    mbox->fetch_waiting++;
+    core_util_critical_section_exit();
+
+    while (!(got = sys_mbox_get(mbox, msg, &wake))) {
+        if (!sys_mbox_wait(&mbox->not_empty, start, timeout))
+            break;
+    }
+
+    core_util_critical_section_enter();
+    mbox->fetch_waiting--;
+    core_util_critical_section_exit();
+
+    if (!got)
         return SYS_ARCH_TIMEOUT;
-    
-    *msg = (void *)event.value.v;
-    
+
+    if (wake)
+        sys_sem_signal(&mbox->not_full);
     return (us_ticker_read() - start) / 1000;
 }
 
@@ -191,12 +298,12 @@ u32_t sys_arch_mbox_fetch(sys_mbox_t *mbox, void **msg, u32_t timeout) {
  *                                  return ERR_OK.
  *---------------------------------------------------------------------------*/
 u32_t sys_arch_mbox_tryfetch(sys_mbox_t *mbox, void **msg) {
-    osEvent event = osMessageGet(mbox->id, 0);
-    if (event.status != osEventMessage)
+    bool wake;
+    if (!sys_mbox_get(mbox, msg, &wake))
         return SYS_MBOX_EMPTY;
-    
-    *msg = (void *)event.value.v;
-    
+
+    if (wake)
+        sys_sem_signal(&mbox->not_full);
     return ERR_OK;
 }
 
@@ -49,25 +49,34 @@ typedef struct {
 } sys_mutex_t;
 
 // === MAIL BOX ===
-#define MB_SIZE      8
+// Mailboxes are rings guarded by short critical sections, the
+// semaphores are only touched when a thread has to block. They are
+// sized for the largest mailbox lwipopts.h asks for, so each memory
+// profile picks its mailbox sizes in one place
+#define MB_MAX(a, b) ((a) > (b) ? (a) : (b))
+#define MB_SIZE      MB_MAX(MB_MAX(MB_MAX(TCPIP_MBOX_SIZE,            \
+                                          DEFAULT_ACCEPTMBOX_SIZE),    \
+                                   MB_MAX(DEFAULT_TCP_RECVMBOX_SIZE,   \
+                                          DEFAULT_UDP_RECVMBOX_SIZE)), \
+                            DEFAULT_RAW_RECVMBOX_SIZE)
 
 typedef struct {
-    osMessageQId    id;
-    osMessageQDef_t def;
-#ifdef CMSIS_OS_RTX
-    uint32_t        queue[4+MB_SIZE]; /* The +4 is required for RTX OS_MCB overhead. */
-#endif
+    void             *queue[MB_SIZE];
+    uint16_t          size;
+    volatile uint16_t count;
+    uint16_t          post_idx;
+    uint16_t          fetch_idx;
+    volatile uint8_t  post_waiting;
+    volatile uint8_t  fetch_waiting;
+    sys_sem_t         not_full;
+    sys_sem_t         not_empty;
 } sys_mbox_t;
 
 #define SYS_MBOX_NULL               ((uint32_t) NULL)
-#define sys_mbox_valid(x)           (((*x).id == NULL) ? 0 : 1 )
-#define sys_mbox_set_invalid(x)     ( (*x).id = NULL )
-
-#if ((DEFAULT_RAW_RECVMBOX_SIZE) > (MB_SIZE)) || \
-    ((DEFAULT_UDP_RECVMBOX_SIZE) > (MB_SIZE)) || \
-    ((DEFAULT_TCP_RECVMBOX_SIZE) > (MB_SIZE)) || \
-    ((DEFAULT_ACCEPTMBOX_SIZE)   > (MB_SIZE)) || \
-    ((TCPIP_MBOX_SIZE)           > (MB_SIZE))
+#define sys_mbox_valid(x)           (((*x).size == 0) ? 0 : 1 )
+#define sys_mbox_set_invalid(x)     ( (*x).size = 0 )
+
+#if (MB_SIZE) > 0xffff
 #   error Mailbox size not supported
 #endif
 
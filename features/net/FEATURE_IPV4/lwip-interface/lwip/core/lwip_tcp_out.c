@@ -1052,6 +1052,13 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb)
   struct netif *netif;
   u32_t *opts;
 
+  if (seg->p->ref != 1) {
+    /* This segment is still referenced by the netif driver (e.g. queued for
+       DMA by a scatter-gather driver), so its headers must not be rewritten.
+       It is sent again by the retransmission timer. */
+    return;
+  }
+
   /** @bug Exclude retransmitted segments from this count. */
   snmp_inc_tcpoutsegs();
 
@@ -15,6 +15,7 @@
  */
 
 #include "nsapi.h"
+#include "lwip_stack.h"
 #include "mbed_interface.h"
 #include <stdio.h>
 #include <stdbool.h>
@@ -28,57 +29,105 @@
 #include "lwip/dhcp.h"
 #include "lwip/tcpip.h"
 #include "lwip/tcp.h"
+#include "lwip/tcp_impl.h"
+#include "lwip/stats.h"
 
 
-/* Static arena of sockets */
+#if !LWIP_SOCKET
+#error "lwip_stack keeps the socket index in netconn->socket, which needs LWIP_SOCKET"
+#endif
+
+/* Static arena of sockets
+ *
+ * The index of each socket is stored in its netconn so events can find
+ * the socket directly, and unused sockets are kept on a free list.
+ */
 static struct lwip_socket {
     bool in_use;
+    struct lwip_socket *next_free;
 
     struct netconn *conn;
     struct netbuf *buf;
     u16_t offset;
 
+    // sequence number following the last zero-copy byte,
+    // valid while nocopy_pending is set
+    bool nocopy_pending;
+    u32_t nocopy_end;
+
+    // datagrams queued on the netconn, lets batched receives
+    // stop without waiting on an empty socket
+    volatile s16_t recv_queued;
+
     void (*cb)(void *);
     void *data;
 } lwip_arena[MEMP_NUM_NETCONN];
 
+static struct lwip_socket *lwip_arena_free;
+
 static void lwip_arena_init(void)
 {
     memset(lwip_arena, 0, sizeof lwip_arena);
+
+    lwip_arena_free = 0;
+    for (int i = MEMP_NUM_NETCONN-1; i >= 0; i--) {
+        lwip_arena[i].next_free = lwip_arena_free;
+        lwip_arena_free = &lwip_arena[i];
+    }
 }
 
 static struct lwip_socket *lwip_arena_alloc(void)
 {
     sys_prot_t prot = sys_arch_protect();
 
-    for (int i = 0; i < MEMP_NUM_NETCONN; i++) {
-        if (!lwip_arena[i].in_use) {
-            struct lwip_socket *s = &lwip_arena[i];
-            memset(s, 0, sizeof *s);
-            s->in_use = true;
-            sys_arch_unprotect(prot);
-            return s;
-        }
+    struct lwip_socket *s = lwip_arena_free;
+    if (s) {
+        lwip_arena_free = s->next_free;
+        memset(s, 0, sizeof *s);
+        s->in_use = true;
     }
 
     sys_arch_unprotect(prot);
-    return 0;
+    return s;
 }
 
 static void lwip_arena_dealloc(struct lwip_socket *s)
 {
+    sys_prot_t prot = sys_arch_protect();
+
     s->in_use = false;
+    s->next_free = lwip_arena_free;
+    lwip_arena_free = s;
+
+    sys_arch_unprotect(prot);
+}
+
+static void lwip_arena_attach(struct lwip_socket *s, struct netconn *conn)
+{
+    sys_prot_t prot = sys_arch_protect();
+    conn->socket = s - lwip_arena;
+    sys_arch_unprotect(prot);
 }
 
 static void lwip_socket_callback(struct netconn *nc, enum netconn_evt eh, u16_t len)
 {
     sys_prot_t prot = sys_arch_protect();
 
-    for (int i = 0; i < MEMP_NUM_NETCONN; i++) {
-        if (lwip_arena[i].in_use
-            && lwip_arena[i].conn == nc
-            && lwip_arena[i].cb) {
-            lwip_arena[i].cb(lwip_arena[i].data);
+    // accepted connections have no socket until lwip_socket_accept
+    // returns, events before then are picked up by the first recv
+    int i = nc->socket;
+    if (i >= 0 && i < MEMP_NUM_NETCONN) {
+        struct lwip_socket *s = &lwip_arena[i];
+        if (s->in_use && s->conn == nc) {
+            if (eh == NETCONN_EVT_RCVPLUS) {
+                s->recv_queued += 1;
+            } else if (eh == NETCONN_EVT_RCVMINUS && s->recv_queued > 0) {
+                s->recv_queued -= 1;
+            }
+
+            if (s->cb) {
+                s->cb(s->data);
+            }
         }
     }
 
@@ -244,6 +293,7 @@ static int lwip_socket_open(nsapi_stack_t *stack, nsapi_socket_t *handle, nsapi_
         return NSAPI_ERROR_NO_SOCKET;
     }
 
+    lwip_arena_attach(s, s->conn);
     netconn_set_recvtimeout(s->conn, 1);
     *(struct lwip_socket **)handle = s;
     return 0;
@@ -253,6 +303,11 @@ static int lwip_socket_close(nsapi_stack_t *stack, nsapi_socket_t handle)
 {
     struct lwip_socket *s = (struct lwip_socket *)handle;
 
+    if (s->buf) {
+        netbuf_delete(s->buf);
+        s->buf = 0;
+    }
+
     err_t err = netconn_delete(s->conn);
     lwip_arena_dealloc(s);
     return lwip_err_remap(err);
@@ -296,6 +351,9 @@ static int lwip_socket_accept(nsapi_stack_t *stack, nsapi_socket_t *handle, nsap
 {
     struct lwip_socket *s = (struct lwip_socket *)server;
     struct lwip_socket *ns = lwip_arena_alloc();
+    if (!ns) {
+        return NSAPI_ERROR_NO_SOCKET;
+    }
 
     err_t err = netconn_accept(s->conn, &ns->conn);
     if (err != ERR_OK) {
@@ -303,6 +361,8 @@ static int lwip_socket_accept(nsapi_stack_t *stack, nsapi_socket_t *handle, nsap
         return lwip_err_remap(err);
     }
 
+    lwip_arena_attach(ns, ns->conn);
+
     *(struct lwip_socket **)handle = ns;
     return 0;
 }
@@ -319,6 +379,97 @@ static int lwip_socket_send(nsapi_stack_t *stack, nsapi_socket_t handle, const v
     return size;
 }
 
+// the pcb belongs to the tcpip thread, so its sequence numbers are
+// read there rather than from the application thread
+struct lwip_tcp_seq {
+    struct netconn *conn;
+    sys_sem_t done;
+    bool valid;
+    u32_t snd_lbb;
+    u32_t lastack;
+};
+
+static void lwip_tcp_seq_read(void *ctx)
+{
+    struct lwip_tcp_seq *seq = (struct lwip_tcp_seq *)ctx;
+    struct tcp_pcb *pcb = seq->conn->pcb.tcp;
+
+    seq->valid = pcb != NULL;
+    if (pcb) {
+        seq->snd_lbb = pcb->snd_lbb;
+        seq->lastack = pcb->lastack;
+    }
+
+    sys_sem_signal(&seq->done);
+}
+
+static int lwip_tcp_seq_get(struct netconn *conn, struct lwip_tcp_seq *seq)
+{
+    seq->conn = conn;
+    seq->valid = false;
+    if (sys_sem_new(&seq->done, 0) != ERR_OK) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    err_t err = tcpip_callback(lwip_tcp_seq_read, seq);
+    if (err == ERR_OK) {
+        sys_arch_sem_wait(&seq->done, 0);
+    }
+
+    sys_sem_free(&seq->done);
+    return lwip_err_remap(err);
+}
+
+static int lwip_socket_send_nocopy(nsapi_stack_t *stack, nsapi_socket_t handle, const void *data, unsigned size)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+    if (s->conn->type != NETCONN_TCP) {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+    // without NETCONN_COPY tcp_write queues PBUF_ROM pbufs pointing at the
+    // caller's buffer, which are only freed once the data is acknowledged
+    err_t err = netconn_write(s->conn, data, size, NETCONN_NOCOPY);
+    if (err != ERR_OK) {
+        return lwip_err_remap(err);
+    }
+
+    struct lwip_tcp_seq seq;
+    int ret = lwip_tcp_seq_get(s->conn, &seq);
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (seq.valid) {
+        s->nocopy_end = seq.snd_lbb;
+        s->nocopy_pending = true;
+    }
+
+    return size;
+}
+
+static int lwip_socket_send_pending(nsapi_stack_t *stack, nsapi_socket_t handle)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+    if (!s->nocopy_pending) {
+        return 0;
+    }
+
+    struct lwip_tcp_seq seq;
+    int ret = lwip_tcp_seq_get(s->conn, &seq);
+    if (ret < 0) {
+        return ret;
+    }
+
+    // the pcb is gone if the connection was reset, its segments with it
+    if (!seq.valid || TCP_SEQ_GEQ(seq.lastack, s->nocopy_end)) {
+        s->nocopy_pending = false;
+        return 0;
+    }
+
+    return s->nocopy_end - seq.lastack;
+}
+
 static int lwip_socket_recv(nsapi_stack_t *stack, nsapi_socket_t handle, void *data, unsigned size)
 {
     struct lwip_socket *s = (struct lwip_socket *)handle;
@@ -370,22 +521,147 @@ static int lwip_socket_recvfrom(nsapi_stack_t *stack, nsapi_socket_t handle, nsa
 {
     struct lwip_socket *s = (struct lwip_socket *)handle;
 
-    struct netbuf *buf;
-    err_t err = netconn_recv(s->conn, &buf);
-    if (err != ERR_OK) {
-        return lwip_err_remap(err);
+    // finish off a packet that was partially consumed through views
+    struct netbuf *buf = s->buf;
+    u16_t offset = s->offset;
+    s->buf = 0;
+
+    if (!buf) {
+        err_t err = netconn_recv(s->conn, &buf);
+        offset = 0;
+
+        if (err != ERR_OK) {
+            return lwip_err_remap(err);
+        }
     }
 
     addr->version = NSAPI_IPv4;
     memcpy(addr->bytes, netbuf_fromaddr(buf), sizeof addr->bytes);
     *port = netbuf_fromport(buf);
 
-    u16_t recv = netbuf_copy(buf, data, (u16_t)size);
+    u16_t recv = netbuf_copy_partial(buf, data, (u16_t)size, offset);
     netbuf_delete(buf);
 
     return recv;
 }
 
+static int lwip_socket_sendto_batch(nsapi_stack_t *stack, nsapi_socket_t handle, const nsapi_datagram_t *datagrams, unsigned count)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+
+    // a single netbuf is reused for the whole batch,
+    // netbuf_ref frees the previous datagram's pbuf
+    struct netbuf *buf = netbuf_new();
+    if (!buf) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    int ret = 0;
+    unsigned i;
+    for (i = 0; i < count; i++) {
+        if (datagrams[i].addr.version != NSAPI_IPv4) {
+            ret = NSAPI_ERROR_PARAMETER;
+            break;
+        }
+
+        err_t err = netbuf_ref(buf, datagrams[i].data, (u16_t)datagrams[i].size);
+        if (err == ERR_OK) {
+            err = netconn_sendto(s->conn, buf,
+                    (ip_addr_t *)datagrams[i].addr.bytes, datagrams[i].port);
+        }
+
+        if (err != ERR_OK) {
+            ret = lwip_err_remap(err);
+            break;
+        }
+    }
+
+    netbuf_delete(buf);
+    return i > 0 ? (int)i : ret;
+}
+
+static int lwip_socket_recvfrom_batch(nsapi_stack_t *stack, nsapi_socket_t handle, nsapi_datagram_t *datagrams, unsigned count)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+
+    unsigned i;
+    for (i = 0; i < count; i++) {
+        // only take what is already queued after the first datagram
+        if (i > 0 && s->recv_queued <= 0) {
+            break;
+        }
+
+        int recv = lwip_socket_recvfrom(stack, handle,
+                &datagrams[i].addr, &datagrams[i].port,
+                datagrams[i].data, datagrams[i].size);
+        if (recv < 0) {
+            return i > 0 ? (int)i : recv;
+        }
+
+        datagrams[i].size = recv;
+    }
+
+    return i;
+}
+
+static int lwip_socket_recv_view(nsapi_stack_t *stack, nsapi_socket_t handle, nsapi_addr_t *addr, uint16_t *port, const void **data)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+
+    if (!s->buf) {
+        err_t err = netconn_recv(s->conn, &s->buf);
+        s->offset = 0;
+
+        if (err != ERR_OK) {
+            return (err == ERR_CLSD) ? 0 : lwip_err_remap(err);
+        }
+    }
+
+    if (addr) {
+        addr->version = NSAPI_IPv4;
+        memcpy(addr->bytes, netbuf_fromaddr(s->buf), sizeof addr->bytes);
+        *port = netbuf_fromport(s->buf);
+    }
+
+    // find the pbuf holding the current offset, chains are short
+    // so walking from the head each time is cheap
+    struct pbuf *p = s->buf->p;
+    u16_t offset = s->offset;
+    while (p && offset >= p->len) {
+        offset -= p->len;
+        p = p->next;
+    }
+
+    if (!p) {
+        return 0;
+    }
+
+    *data = (const u8_t *)p->payload + offset;
+    return p->len - offset;
+}
+
+static int lwip_socket_recv_release(nsapi_stack_t *stack, nsapi_socket_t handle, unsigned size)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+
+    if (!s->buf) {
+        return (size == 0) ? 0 : NSAPI_ERROR_PARAMETER;
+    }
+
+    if (size > (unsigned)(netbuf_len(s->buf) - s->offset)) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    s->offset += size;
+
+    if (s->offset >= netbuf_len(s->buf)) {
+        netbuf_delete(s->buf);
+        s->buf = 0;
+    }
+
+    return 0;
+}
+
 static int lwip_setsockopt(nsapi_stack_t *stack, nsapi_socket_t handle, int level, int optname, const void *optval, unsigned optlen)
 {
     struct lwip_socket *s = (struct lwip_socket *)handle;
@@ -420,6 +696,60 @@ static int lwip_setsockopt(nsapi_stack_t *stack, nsapi_socket_t handle, int leve
     }
 }
 
+static int lwip_getstackopt(nsapi_stack_t *stack, int level, int optname, void *optval, unsigned *optlen)
+{
+    if (level != NSAPI_STACK) {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+    switch (optname) {
+#if LWIP_STATS
+        case LWIP_STACKOPT_STATS: {
+            if (*optlen < sizeof(lwip_stack_stats_t)) {
+                return NSAPI_ERROR_PARAMETER;
+            }
+
+            lwip_stack_stats_t *stats = (lwip_stack_stats_t *)optval;
+            memset(stats, 0, sizeof *stats);
+
+            // counters are updated from the tcpip thread and drivers
+            sys_prot_t prot = sys_arch_protect();
+#if LINK_STATS
+            stats->link_xmit  = lwip_stats.link.xmit;
+            stats->link_recv  = lwip_stats.link.recv;
+            stats->link_drop  = lwip_stats.link.drop;
+#endif
+#if IP_STATS
+            stats->ip_drop    = lwip_stats.ip.drop;
+#endif
+#if TCP_STATS
+            stats->tcp_xmit   = lwip_stats.tcp.xmit;
+            stats->tcp_recv   = lwip_stats.tcp.recv;
+            stats->tcp_drop   = lwip_stats.tcp.drop;
+            stats->tcp_memerr = lwip_stats.tcp.memerr;
+#endif
+#if UDP_STATS
+            stats->udp_xmit   = lwip_stats.udp.xmit;
+            stats->udp_recv   = lwip_stats.udp.recv;
+            stats->udp_drop   = lwip_stats.udp.drop;
+#endif
+#if MEM_STATS
+            stats->mem_used   = lwip_stats.mem.used;
+            stats->mem_max    = lwip_stats.mem.max;
+            stats->mem_err    = lwip_stats.mem.err;
+#endif
+            sys_arch_unprotect(prot);
+
+            *optlen = sizeof(lwip_stack_stats_t);
+            return 0;
+        }
+#endif
+
+        default:
+            return NSAPI_ERROR_UNSUPPORTED;
+    }
+}
+
 static void lwip_socket_attach(nsapi_stack_t *stack, nsapi_socket_t handle, void (*callback)(void *), void *data)
 {
     struct lwip_socket *s = (struct lwip_socket *)handle;
@@ -442,8 +772,15 @@ const nsapi_stack_api_t lwip_stack_api = {
     .socket_recv        = lwip_socket_recv,
     .socket_sendto      = lwip_socket_sendto,
     .socket_recvfrom    = lwip_socket_recvfrom,
+    .getstackopt        = lwip_getstackopt,
     .setsockopt         = lwip_setsockopt,
     .socket_attach      = lwip_socket_attach,
+    .socket_send_nocopy = lwip_socket_send_nocopy,
+    .socket_send_pending = lwip_socket_send_pending,
+    .socket_recv_view   = lwip_socket_recv_view,
+    .socket_recv_release = lwip_socket_recv_release,
+    .socket_sendto_batch = lwip_socket_sendto_batch,
+    .socket_recvfrom_batch = lwip_socket_recvfrom_batch,
 };
 
 nsapi_stack_t lwip_stack = {
@@ -33,6 +33,29 @@ extern nsapi_stack_t lwip_stack;
 const char *lwip_get_mac_address(void);
 const char *lwip_get_ip_address(void);
 
+// Stack options read through getstackopt at the NSAPI_STACK level
+enum lwip_stackopt {
+    LWIP_STACKOPT_STATS = 0x100, /*!< Copies out a lwip_stack_stats_t */
+};
+
+// Counters collected when lwip.stats_enabled is set
+typedef struct lwip_stack_stats {
+    uint32_t link_xmit;     /*!< Frames handed to the driver */
+    uint32_t link_recv;     /*!< Frames received from the driver */
+    uint32_t link_drop;     /*!< Frames dropped by the driver */
+    uint32_t ip_drop;       /*!< IP packets dropped */
+    uint32_t tcp_xmit;      /*!< TCP segments sent */
+    uint32_t tcp_recv;      /*!< TCP segments received */
+    uint32_t tcp_drop;      /*!< TCP segments dropped */
+    uint32_t tcp_memerr;    /*!< TCP out of memory errors */
+    uint32_t udp_xmit;      /*!< UDP datagrams sent */
+    uint32_t udp_recv;      /*!< UDP datagrams received */
+    uint32_t udp_drop;      /*!< UDP datagrams dropped */
+    uint32_t mem_used;      /*!< Bytes of the lwIP heap in use */
+    uint32_t mem_max;       /*!< Most bytes of the lwIP heap ever in use */
+    uint32_t mem_err;       /*!< Failed lwIP heap allocations */
+} lwip_stack_stats_t;
+
 
 #ifdef __cplusplus
 }
@@ -21,6 +21,47 @@
 
 #include "lwipopts_conf.h"
 
+// Memory profiles, selected with lwip.memory_profile in mbed_lib.json
+#define LWIP_PROFILE_LOW_RAM        0
+#define LWIP_PROFILE_BALANCED       1
+#define LWIP_PROFILE_THROUGHPUT     2
+
+#ifndef MBED_CONF_LWIP_MEMORY_PROFILE
+#define MBED_CONF_LWIP_MEMORY_PROFILE   LWIP_PROFILE_BALANCED
+#endif
+
+#if MBED_CONF_LWIP_MEMORY_PROFILE == LWIP_PROFILE_LOW_RAM
+#define LWIP_PROFILE_MBOX_SIZE      4
+#define LWIP_PROFILE_POOL_SIZE      3
+#define LWIP_PROFILE_NUM_PBUF       4
+#define LWIP_PROFILE_TCP_WND_MSS    2
+#define LWIP_PROFILE_TCP_SND_MSS    2
+#define LWIP_PROFILE_TCP_SEG        16
+#define LWIP_PROFILE_OOSEQ          0
+#define LWIP_PROFILE_OVERSIZE       0
+#elif MBED_CONF_LWIP_MEMORY_PROFILE == LWIP_PROFILE_BALANCED
+#define LWIP_PROFILE_MBOX_SIZE      8
+#define LWIP_PROFILE_POOL_SIZE      5
+#define LWIP_PROFILE_NUM_PBUF       8
+#define LWIP_PROFILE_TCP_WND_MSS    4
+#define LWIP_PROFILE_TCP_SND_MSS    2
+#define LWIP_PROFILE_TCP_SEG        16
+#define LWIP_PROFILE_OOSEQ          1
+#define LWIP_PROFILE_OVERSIZE       (TCP_MSS/4)
+#elif MBED_CONF_LWIP_MEMORY_PROFILE == LWIP_PROFILE_THROUGHPUT
+// lwIP 1.4 has no window scaling, so the window is kept below 64KB
+#define LWIP_PROFILE_MBOX_SIZE      16
+#define LWIP_PROFILE_POOL_SIZE      16
+#define LWIP_PROFILE_NUM_PBUF       16
+#define LWIP_PROFILE_TCP_WND_MSS    8
+#define LWIP_PROFILE_TCP_SND_MSS    8
+#define LWIP_PROFILE_TCP_SEG        32
+#define LWIP_PROFILE_OOSEQ          1
+#define LWIP_PROFILE_OVERSIZE       TCP_MSS
+#else
+#error "lwip.memory_profile must be LWIP_PROFILE_LOW_RAM, LWIP_PROFILE_BALANCED or LWIP_PROFILE_THROUGHPUT"
+#endif
+
 // Workaround for Linux timeval
 #if defined (TOOLCHAIN_GCC)
 #define LWIP_TIMEVAL_PRIVATE 0
@@ -37,11 +78,11 @@
 
 #define LWIP_RAW                    0
 
-#define TCPIP_MBOX_SIZE             8
-#define DEFAULT_TCP_RECVMBOX_SIZE   8
-#define DEFAULT_UDP_RECVMBOX_SIZE   8
-#define DEFAULT_RAW_RECVMBOX_SIZE   8
-#define DEFAULT_ACCEPTMBOX_SIZE     8
+#define TCPIP_MBOX_SIZE             LWIP_PROFILE_MBOX_SIZE
+#define DEFAULT_TCP_RECVMBOX_SIZE   LWIP_PROFILE_MBOX_SIZE
+#define DEFAULT_UDP_RECVMBOX_SIZE   LWIP_PROFILE_MBOX_SIZE
+#define DEFAULT_RAW_RECVMBOX_SIZE   LWIP_PROFILE_MBOX_SIZE
+#define DEFAULT_ACCEPTMBOX_SIZE     LWIP_PROFILE_MBOX_SIZE
 
 #define TCPIP_THREAD_STACKSIZE      1024
 #define TCPIP_THREAD_PRIO           (osPriorityNormal)
@@ -54,15 +95,32 @@
 // 32-bit alignment
 #define MEM_ALIGNMENT               4
 
-#define PBUF_POOL_SIZE              5
-#define MEMP_NUM_TCP_PCB_LISTEN     4
-#define MEMP_NUM_TCP_PCB            4
-#define MEMP_NUM_UDP_PCB            4
-#define MEMP_NUM_PBUF               8
-#define MEMP_NUM_NETBUF             8
+#define PBUF_POOL_SIZE              LWIP_PROFILE_POOL_SIZE
+
+// Socket counts, see mbed_lib.json
+#ifndef MBED_CONF_LWIP_SOCKET_MAX
+#define MBED_CONF_LWIP_SOCKET_MAX       8
+#endif
+#ifndef MBED_CONF_LWIP_TCP_SOCKET_MAX
+#define MBED_CONF_LWIP_TCP_SOCKET_MAX   4
+#endif
+#ifndef MBED_CONF_LWIP_UDP_SOCKET_MAX
+#define MBED_CONF_LWIP_UDP_SOCKET_MAX   4
+#endif
+#ifndef MBED_CONF_LWIP_TCP_SERVER_MAX
+#define MBED_CONF_LWIP_TCP_SERVER_MAX   4
+#endif
+
+#define MEMP_NUM_NETCONN            MBED_CONF_LWIP_SOCKET_MAX
+#define MEMP_NUM_TCP_PCB_LISTEN     MBED_CONF_LWIP_TCP_SERVER_MAX
+#define MEMP_NUM_TCP_PCB            MBED_CONF_LWIP_TCP_SOCKET_MAX
+#define MEMP_NUM_UDP_PCB            MBED_CONF_LWIP_UDP_SOCKET_MAX
+#define MEMP_NUM_PBUF               LWIP_PROFILE_NUM_PBUF
+#define MEMP_NUM_NETBUF             LWIP_PROFILE_NUM_PBUF
+#define MEMP_NUM_TCP_SEG            LWIP_PROFILE_TCP_SEG
 
-#define TCP_QUEUE_OOSEQ             0
-#define TCP_OVERSIZE                0
+#define TCP_QUEUE_OOSEQ             LWIP_PROFILE_OOSEQ
+#define TCP_OVERSIZE                LWIP_PROFILE_OVERSIZE
 
 #define LWIP_DHCP                   1
 #define LWIP_DNS                    1
@@ -108,17 +166,43 @@
 #define MEMP_SANITY_CHECK           1
 #else
 #define LWIP_NOASSERT               1
+#if !MBED_CONF_LWIP_STATS_ENABLED
 #define LWIP_STATS                  0
 #endif
+#endif
+
+#define LWIP_STATS_DISPLAY          0
 
 #define LWIP_PLATFORM_BYTESWAP      1
 
+// Checksum offload, EMAC drivers whose MAC inserts and verifies the
+// IP/ICMP/TCP/UDP checksums define LWIP_EMAC_CHECKSUM_OFFLOAD in their
+// lwipopts_conf.h. lwip.checksum_offload falls back to software checksums.
+#ifndef MBED_CONF_LWIP_CHECKSUM_OFFLOAD
+#define MBED_CONF_LWIP_CHECKSUM_OFFLOAD 1
+#endif
+
+#if defined(LWIP_EMAC_CHECKSUM_OFFLOAD) && MBED_CONF_LWIP_CHECKSUM_OFFLOAD
+#define LWIP_CHECKSUM_OFFLOAD       LWIP_EMAC_CHECKSUM_OFFLOAD
+#else
+#define LWIP_CHECKSUM_OFFLOAD       0
+#endif
+
+#define CHECKSUM_GEN_IP             (!LWIP_CHECKSUM_OFFLOAD)
+#define CHECKSUM_GEN_ICMP           (!LWIP_CHECKSUM_OFFLOAD)
+#define CHECKSUM_GEN_UDP            (!LWIP_CHECKSUM_OFFLOAD)
+#define CHECKSUM_GEN_TCP            (!LWIP_CHECKSUM_OFFLOAD)
+#define CHECKSUM_CHECK_IP           (!LWIP_CHECKSUM_OFFLOAD)
+#define CHECKSUM_CHECK_ICMP         (!LWIP_CHECKSUM_OFFLOAD)
+#define CHECKSUM_CHECK_UDP          (!LWIP_CHECKSUM_OFFLOAD)
+#define CHECKSUM_CHECK_TCP          (!LWIP_CHECKSUM_OFFLOAD)
+
 #if LWIP_TRANSPORT_ETHERNET
 
 /* MSS should match the hardware packet size */
 #define TCP_MSS                     1460
-#define TCP_SND_BUF                 (2 * TCP_MSS)
-#define TCP_WND                     (2 * TCP_MSS)
+#define TCP_SND_BUF                 (LWIP_PROFILE_TCP_SND_MSS * TCP_MSS)
+#define TCP_WND                     (LWIP_PROFILE_TCP_WND_MSS * TCP_MSS)
 #define TCP_SND_QUEUELEN            (2 * TCP_SND_BUF/TCP_MSS)
 
 // Broadcast
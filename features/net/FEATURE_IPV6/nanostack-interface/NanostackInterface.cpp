@@ -60,6 +60,7 @@ public:
     NanostackBuffer *next;      /*<! next buffer */
     ns_address_t ns_address;    /*<! address where data is received */
     uint16_t length;            /*<! data length in this buffer */
+    uint16_t offset;            /*<! data already consumed from payload */
     uint8_t payload[1];          /*<! Trailing buffer data */
 };
 
@@ -95,6 +96,8 @@ public:
 
     bool data_available(void);
     size_t data_copy_and_free(void *dest, size_t len, SocketAddress *address, bool stream);
+    size_t data_view(const void **data, SocketAddress *address);
+    bool data_release(size_t len);
     void data_free_all(void);
     void data_attach(NanostackBuffer *data_buf);
 
@@ -345,14 +348,13 @@ size_t NanostackSocket::data_copy_and_free(void *dest, size_t len,
         convert_ns_addr_to_mbed(address, &data_buf->ns_address);
     }
 
-    size_t copy_size = (len > data_buf->length) ? data_buf->length : len;
-    memcpy(dest, data_buf->payload, copy_size);
+    size_t remaining = data_buf->length - data_buf->offset;
+    size_t copy_size = (len > remaining) ? remaining : len;
+    memcpy(dest, data_buf->payload + data_buf->offset, copy_size);
 
-    if (stream && (copy_size < data_buf->length)) {
-        // Update the size in the buffer
-        size_t new_buf_size = data_buf->length - copy_size;
-        memmove(data_buf->payload, data_buf->payload + copy_size, new_buf_size);
-        data_buf->length = new_buf_size;
+    if (stream && (copy_size < remaining)) {
+        // Skip over the copied data rather than moving the rest down
+        data_buf->offset += copy_size;
     } else {
         // Entire packet used so free it
         rxBufChain = data_buf->next;
@@ -362,6 +364,50 @@ size_t NanostackSocket::data_copy_and_free(void *dest, size_t len,
     return copy_size;
 }
 
+size_t NanostackSocket::data_view(const void **data, SocketAddress *address)
+{
+    nanostack_assert_locked();
+    MBED_ASSERT((SOCKET_MODE_DATAGRAM == mode) ||
+                (mode == SOCKET_MODE_STREAM));
+
+    NanostackBuffer *data_buf = rxBufChain;
+    if (NULL == data_buf) {
+        // No data
+        return 0;
+    }
+
+    if (address) {
+        convert_ns_addr_to_mbed(address, &data_buf->ns_address);
+    }
+
+    *data = data_buf->payload + data_buf->offset;
+    return data_buf->length - data_buf->offset;
+}
+
+bool NanostackSocket::data_release(size_t len)
+{
+    nanostack_assert_locked();
+    MBED_ASSERT((SOCKET_MODE_DATAGRAM == mode) ||
+                (mode == SOCKET_MODE_STREAM));
+
+    NanostackBuffer *data_buf = rxBufChain;
+    if (NULL == data_buf) {
+        return 0 == len;
+    }
+    if (len > (size_t)(data_buf->length - data_buf->offset)) {
+        return false;
+    }
+
+    data_buf->offset += len;
+    if (data_buf->offset >= data_buf->length) {
+        // Entire packet used so free it
+        rxBufChain = data_buf->next;
+        FREE(data_buf);
+    }
+
+    return true;
+}
+
 void NanostackSocket::data_free_all(void)
 {
     nanostack_assert_locked();
@@ -409,6 +455,7 @@ void NanostackSocket::event_data(socket_callback_t *sock_cb)
         return;
     }
     recv_buff->next = NULL;
+    recv_buff->offset = 0;
 
     // Write data to buffer
     int16_t length = socket_read(sock_cb->socket_id,
@@ -922,6 +969,62 @@ int NanostackInterface::socket_recv(void *handle, void *data, unsigned size)
     return ret;
 }
 
+int NanostackInterface::socket_recv_view(void *handle, SocketAddress *address, const void **data)
+{
+    // Validate parameters
+    NanostackSocket * socket = static_cast<NanostackSocket *>(handle);
+    if (NULL == handle) {
+        MBED_ASSERT(false);
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+    if (NULL == data) {
+        MBED_ASSERT(false);
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    nanostack_lock();
+
+    int ret;
+    if (socket->closed()) {
+        ret = NSAPI_ERROR_NO_CONNECTION;
+    } else if (socket->data_available()) {
+        ret = socket->data_view(data, address);
+    } else {
+        ret = NSAPI_ERROR_WOULD_BLOCK;
+    }
+
+    nanostack_unlock();
+
+    tr_debug("socket_recv_view(socket=%p) sock_id=%d, ret=%i", socket, socket->socket_id, ret);
+
+    return ret;
+}
+
+int NanostackInterface::socket_recv_release(void *handle, unsigned size)
+{
+    // Validate parameters
+    NanostackSocket * socket = static_cast<NanostackSocket *>(handle);
+    if (NULL == handle) {
+        MBED_ASSERT(false);
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+
+    nanostack_lock();
+
+    int ret;
+    if (socket->closed()) {
+        ret = NSAPI_ERROR_NO_CONNECTION;
+    } else if (socket->data_release(size)) {
+        ret = 0;
+    } else {
+        ret = NSAPI_ERROR_PARAMETER;
+    }
+
+    nanostack_unlock();
+
+    return ret;
+}
+
 void NanostackInterface::socket_attach(void *handle, void (*callback)(void *), void *id)
 {
     // Validate parameters
@@ -167,6 +167,34 @@ protected:
      */
     virtual int socket_recvfrom(void *handle, SocketAddress *address, void *buffer, unsigned size);
 
+    /** Borrow the next segment of received data without copying it
+     *
+     *  Points data at the payload of the oldest received buffer, past any
+     *  data already consumed, and returns its size. The sender is stored
+     *  in address if address is not NULL.
+     *
+     *  This call is non-blocking. If no data is available,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param handle   Socket handle
+     *  @param address  Destination for the source address or NULL
+     *  @param data     Destination for a pointer to the segment
+     *  @return         Size of the segment in bytes on success, negative
+     *                  error code on failure
+     */
+    virtual int socket_recv_view(void *handle, SocketAddress *address, const void **data);
+
+    /** Release data borrowed with socket_recv_view
+     *
+     *  Consumes size bytes of the oldest received buffer, freeing it once
+     *  it has been fully consumed.
+     *
+     *  @param handle   Socket handle
+     *  @param size     Number of bytes to consume
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int socket_recv_release(void *handle, unsigned size);
+
     /** Register a callback on state change of the socket
      *
      *  The specified callback will be called on state changes such as when
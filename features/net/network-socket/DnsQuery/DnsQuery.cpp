@@ -16,10 +16,50 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 #include "DnsQuery.h"
+#include "mbed.h"
+#include "critical.h"
+#include "SingletonPtr.h"
+#include "rtos/Mutex.h"
+#include "rtos/Mail.h"
+#include "rtos/Thread.h"
+#include "trng_api.h"
 #include <stdio.h>
 #include <string.h>
+#include <ctype.h>
 
 
+#ifndef MBED_CONF_NSAPI_DNS_CACHE_SIZE
+#define MBED_CONF_NSAPI_DNS_CACHE_SIZE 4
+#endif
+
+#ifndef MBED_CONF_NSAPI_DNS_CACHE_TTL_MAX
+#define MBED_CONF_NSAPI_DNS_CACHE_TTL_MAX 3600
+#endif
+
+#ifndef MBED_CONF_NSAPI_DNS_CACHE_NEGATIVE_TTL
+#define MBED_CONF_NSAPI_DNS_CACHE_NEGATIVE_TTL 30
+#endif
+
+#ifndef MBED_CONF_NSAPI_DNS_RESPONSE_TIMEOUT
+#define MBED_CONF_NSAPI_DNS_RESPONSE_TIMEOUT 5000
+#endif
+
+#ifndef MBED_CONF_NSAPI_DNS_PARALLEL_QUERIES
+#define MBED_CONF_NSAPI_DNS_PARALLEL_QUERIES 2
+#endif
+
+#ifndef MBED_CONF_NSAPI_DNS_ASYNC_QUEUE_SIZE
+#define MBED_CONF_NSAPI_DNS_ASYNC_QUEUE_SIZE 4
+#endif
+
+#ifndef MBED_CONF_NSAPI_DNS_ASYNC_STACK_SIZE
+#define MBED_CONF_NSAPI_DNS_ASYNC_STACK_SIZE 2048
+#endif
+
+#define DNS_HOST_MAX    128
+#define DNS_PACKET_MAX  512
+#define DNS_QUERY_MAX   (12 + DNS_HOST_MAX + 2 + 4)
+
 #define DNS_COUNT (sizeof DNS_IPS / sizeof DNS_IPS[0])
 const char *DNS_IPS[] = {
     "8.8.8.8",
@@ -29,6 +69,12 @@ const char *DNS_IPS[] = {
     "208.67.222.222"
 };
 
+enum dns_result {
+    DNS_RESULT_ADDRESS,     // A record found
+    DNS_RESULT_NO_ADDRESS,  // name does not exist or has no A record
+    DNS_RESULT_INVALID,     // not a usable answer, try another server
+};
+
 static bool isIP(const char *host)
 {
     int i;
@@ -48,10 +94,166 @@ static bool isIP(const char *host)
 }
 
 
-static bool parseRR(uint8_t *resp, int &c, char *adr)
+/* Query IDs
+ *
+ * Answers are cached, so a forged one sticks for its TTL. IDs are drawn
+ * from the TRNG where there is one so they can't be guessed ahead of the
+ * query. Without one they are only as unpredictable as the query's timing.
+ */
+static uint16_t dns_random_id()
+{
+    uint16_t id;
+
+#if DEVICE_TRNG
+    size_t olen;
+    if (trng_get_bytes((uint8_t *)&id, sizeof id, &olen) == 0 && olen == sizeof id) {
+        return id;
+    }
+#endif
+
+    static uint32_t state;
+    state = state*1103515245 + 12345 + us_ticker_read();
+    id = (uint16_t)(state >> 16);
+    return id;
+}
+
+
+/* Seconds clock for cache expiry
+ *
+ * The us ticker wraps after about 71 minutes, longer than most TTLs, so
+ * elapsed ticks are folded into a seconds count. A ticker keeps folding
+ * while the cache is idle so a wrap is never missed.
+ */
+static uint32_t dns_seconds;
+static uint32_t dns_ticks;
+static SingletonPtr<Ticker> dns_time_ticker;
+
+static uint32_t dns_time()
+{
+    core_util_critical_section_enter();
+    uint32_t elapsed = (us_ticker_read() - dns_ticks) / 1000000;
+    dns_seconds += elapsed;
+    dns_ticks += elapsed * 1000000;
+    uint32_t seconds = dns_seconds;
+    core_util_critical_section_exit();
+
+    return seconds;
+}
+
+static void dns_time_fold()
+{
+    dns_time();
+}
+
+
+#if MBED_CONF_NSAPI_DNS_CACHE_SIZE > 0
+/* Resolver cache
+ *
+ * Small LRU cache of recent answers, including names that failed to
+ * resolve, so repeated connects to the same host skip the round trip.
+ */
+struct dns_cache_entry {
+    char host[DNS_HOST_MAX+1];
+    uint8_t addr[4];
+    bool negative;
+    uint32_t expires;
+    uint32_t used;
+};
+
+static dns_cache_entry dns_cache[MBED_CONF_NSAPI_DNS_CACHE_SIZE];
+static uint32_t dns_cache_stamp;
+static SingletonPtr<rtos::Mutex> dns_cache_lock;
+
+static bool dns_cache_find(const char *host, char *ip, int32_t *err)
+{
+    bool found = false;
+    uint32_t now = dns_time();
+    dns_cache_lock->lock();
+
+    for (int i = 0; i < MBED_CONF_NSAPI_DNS_CACHE_SIZE; i++) {
+        dns_cache_entry *e = &dns_cache[i];
+        if (!e->host[0] || (int32_t)(e->expires - now) <= 0) {
+            continue;
+        }
+
+        if (strcmp(e->host, host) == 0) {
+            e->used = ++dns_cache_stamp;
+            if (e->negative) {
+                *err = NSAPI_ERROR_DNS_FAILURE;
+            } else {
+                sprintf(ip, "%d.%d.%d.%d", e->addr[0], e->addr[1], e->addr[2], e->addr[3]);
+                *err = 0;
+            }
+            found = true;
+            break;
+        }
+    }
+
+    dns_cache_lock->unlock();
+    return found;
+}
+
+static void dns_cache_add(const char *host, const uint8_t *addr, uint32_t ttl)
+{
+    if (ttl == 0 || strlen(host) > DNS_HOST_MAX) {
+        return;
+    }
+    if (ttl > MBED_CONF_NSAPI_DNS_CACHE_TTL_MAX) {
+        ttl = MBED_CONF_NSAPI_DNS_CACHE_TTL_MAX;
+    }
+
+    uint32_t now = dns_time();
+    dns_cache_lock->lock();
+
+    // Replace the same host, else an expired entry, else the least
+    // recently used one
+    dns_cache_entry *e = &dns_cache[0];
+    for (int i = 0; i < MBED_CONF_NSAPI_DNS_CACHE_SIZE; i++) {
+        dns_cache_entry *c = &dns_cache[i];
+        if (strcmp(c->host, host) == 0) {
+            e = c;
+            break;
+        } else if (!c->host[0] || (int32_t)(c->expires - now) <= 0) {
+            e = c;
+        } else if ((e->host[0] && (int32_t)(e->expires - now) > 0) &&
+                   (int32_t)(c->used - e->used) < 0) {
+            e = c;
+        }
+    }
+
+    strcpy(e->host, host);
+    e->negative = !addr;
+    if (addr) {
+        memcpy(e->addr, addr, sizeof e->addr);
+    }
+    e->expires = now + ttl;
+    e->used = ++dns_cache_stamp;
+
+    dns_cache_lock->unlock();
+
+    // Keep the clock folding so expiry survives a ticker wrap
+    static bool dns_time_running = false;
+    if (!dns_time_running) {
+        dns_time_running = true;
+        dns_time_ticker->attach(dns_time_fold, 1800.0f);
+    }
+}
+#else
+static bool dns_cache_find(const char *host, char *ip, int32_t *err)
+{
+    return false;
+}
+
+static void dns_cache_add(const char *host, const uint8_t *addr, uint32_t ttl)
+{
+}
+#endif
+
+
+static bool parseRR(uint8_t *resp, int len, int &c, uint8_t *addr, uint32_t *ttl)
 {
     int n = 0;
-    while((n=resp[c++]) != 0) {
+    while (c < len && (n=resp[c++]) != 0) {
         if ((n & 0xc0) != 0) {
             //  This is a link
             c++;
@@ -62,13 +264,21 @@ static bool parseRR(uint8_t *resp, int &c, char *adr)
         }
     }
 
+    if (c + 10 > len) {
+        c = len;
+        return false;
+    }
+
     int TYPE = (((int)resp[c])<<8) + resp[c+1];
     int CLASS = (((int)resp[c+2])<<8) + resp[c+3];
+    uint32_t TTL = (((uint32_t)resp[c+4])<<24) + (((uint32_t)resp[c+5])<<16)
+                 + (((uint32_t)resp[c+6])<<8) + resp[c+7];
     int RDLENGTH = (((int)resp[c+8])<<8) + resp[c+9];
 
     c+= 10;
-    if ((CLASS == 1) && (TYPE == 1)) {
-        sprintf(adr,"%d.%d.%d.%d", resp[c], resp[c+1], resp[c+2], resp[c+3]);
+    if ((CLASS == 1) && (TYPE == 1) && (RDLENGTH == 4) && (c + 4 <= len)) {
+        memcpy(addr, &resp[c], 4);
+        *ttl = TTL;
         c+= RDLENGTH;
         return true;
     }
@@ -78,57 +288,66 @@ static bool parseRR(uint8_t *resp, int &c, char *adr)
 }
 
 
-static bool resolve(unsigned char *resp, char *ipaddress)
+// The answer must repeat the question, the name compared as DNS does,
+// without regard to case
+static bool question_matches(const uint8_t *resp, int len, const uint8_t *query, int qlen)
 {
+    if (len < qlen || resp[4] != 0 || resp[5] != 1) {
+        return false;
+    }
+
+    for (int i = 12; i < qlen; i++) {
+        if (tolower(resp[i]) != tolower(query[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Parses an answer already known to repeat our question
+static dns_result resolve(unsigned char *resp, int len, int qlen, uint8_t *addr, uint32_t *ttl)
+{
+    if (len < 12) {
+        return DNS_RESULT_INVALID;
+    }
 
-    int ID = (((int)resp[0]) <<8) + resp[1];
     int QR = resp[2] >>7;
     int Opcode = (resp[2]>>3) & 0x0F;
     int RCODE = (resp[3] & 0x0F);
     int ANCOUNT = (((int)resp[6])<<8)+ resp[7];
 
-    if ((ID != 1) || (QR != 1) || (Opcode != 0) || (RCODE != 0)) {
-        return false;
+    if ((QR != 1) || (Opcode != 0)) {
+        return DNS_RESULT_INVALID;
     }
 
-    int c = 12;
-    int d;
-    //  Skip domain question
-    while(  (d=resp[c++]) != 0) {
-        c+=d;
+    if (RCODE == 3) {
+        // NXDOMAIN, the name does not exist
+        return DNS_RESULT_NO_ADDRESS;
+    } else if (RCODE != 0) {
+        return DNS_RESULT_INVALID;
     }
-    c+= 4; //   skip QTYPE and QCLASS
+
+    //  Skip the question
+    int c = qlen;
 
     //  Here comes the resource record
-    for (int ans = 0 ; ans < ANCOUNT; ans++) {
-        if (parseRR(resp, c, ipaddress)) {
-            return true;
+    for (int ans = 0 ; ans < ANCOUNT && c < len; ans++) {
+        if (parseRR(resp, len, c, addr, ttl)) {
+            return DNS_RESULT_ADDRESS;
         }
     }
 
-    return false;
+    return DNS_RESULT_NO_ADDRESS;
 }
 
-static int32_t query(UDPSocket *socket, const SocketAddress &addr, const char *hostname, char *ipaddress)
+static int build(uint8_t *packet, const char *hostname)
 {
-    int len = 0;
-    if (hostname == NULL) {
-        return false;
-    }
-    len = strlen(hostname);
-    if ((len > 128) || (len == 0)) {
-        return false;
-    }
-
+    int len = strlen(hostname);
     int packetlen = /* size of HEADER structure */ 12 + /* size of QUESTION Structure */5 + len + 1;
-    uint8_t *packet = new uint8_t[packetlen]; /* this is the UDP packet to send to the DNS */
-    if (packet == NULL) {
-        return false;
-    }
 
-    //  Fill the header
+    //  Fill the header, the ID is set per server when sending
     memset(packet, 0, packetlen);
-    packet[1] = 1;      //  ID = 1
     packet[5] = 1;      // QDCOUNT = 1 (contains one question)
     packet[2] = 1;      // recursion requested
 
@@ -157,32 +376,121 @@ static int32_t query(UDPSocket *socket, const SocketAddress &addr, const char *h
     packet[c++] = 0;
     packet[c++] = 1;
 
+    return packetlen;
+}
 
-    if (socket->sendto(addr, packet, packetlen) < 0) {
-        delete packet;
-        return false;
+static bool same_addr(const SocketAddress &a, const SocketAddress &b)
+{
+    nsapi_addr_t x = a.get_addr();
+    nsapi_addr_t y = b.get_addr();
+    return a.get_port() == b.get_port() && x.version == y.version &&
+           memcmp(x.bytes, y.bytes, sizeof x.bytes) == 0;
+}
+
+// Sends the question to servers [first, last) and waits for their answers.
+// Only an answer from a queried server, carrying that server's ID and
+// our question, is taken. Returns NSAPI_ERROR_WOULD_BLOCK if none of them
+// gave a usable answer.
+static int32_t query_servers(UDPSocket *socket, uint8_t *query, uint8_t *packet,
+        const char *hostname, unsigned first, unsigned last, char *ipaddress)
+{
+    uint16_t ids[MBED_CONF_NSAPI_DNS_PARALLEL_QUERIES];
+    bool waiting[MBED_CONF_NSAPI_DNS_PARALLEL_QUERIES];
+    unsigned pending = 0;
+
+    int querylen = build(query, hostname);
+    for (unsigned i = first; i < last; i++) {
+        ids[i-first] = dns_random_id();
+        query[0] = (uint8_t)(ids[i-first] >> 8);
+        query[1] = (uint8_t)ids[i-first];
+        waiting[i-first] = socket->sendto(SocketAddress(DNS_IPS[i], 53), query, querylen) >= 0;
+        if (waiting[i-first]) {
+            pending++;
+        }
     }
-    delete packet;
 
-    packet = new uint8_t [1024];
+    //  Receive the answers from DNS, discarding anything that isn't one
+    //  until every server answered or the response timeout runs out
+    Timer timer;
+    timer.start();
+    int elapsed;
+    while (pending > 0 && (elapsed = timer.read_ms()) < MBED_CONF_NSAPI_DNS_RESPONSE_TIMEOUT) {
+        socket->set_timeout(MBED_CONF_NSAPI_DNS_RESPONSE_TIMEOUT - elapsed);
+
+        SocketAddress from;
+        int response_length = socket->recvfrom(&from, packet, DNS_PACKET_MAX);
+        if (response_length < 0) {
+            break;
+        } else if (response_length < 12) {
+            continue;
+        }
+
+        uint16_t id = (((uint16_t)packet[0]) << 8) | packet[1];
+        unsigned server = last;
+        for (unsigned i = first; i < last; i++) {
+            if (waiting[i-first] && ids[i-first] == id &&
+                    same_addr(from, SocketAddress(DNS_IPS[i], 53))) {
+                server = i;
+                break;
+            }
+        }
 
-    //  Receive the answer from DNS
-    int response_length = 0;
-    response_length = socket->recvfrom(NULL, packet, 1024);
+        //  A forged or stale packet doesn't stop us waiting for the real answer
+        if (server == last || !question_matches(packet, response_length, query, querylen)) {
+            continue;
+        }
 
-    if (response_length > 0 ) {
-        if (!resolve(packet, ipaddress)) {
-            delete packet;
+        uint8_t addr[4];
+        uint32_t ttl = 0;
+        dns_result result = resolve(packet, response_length, querylen, addr, &ttl);
+        if (result == DNS_RESULT_ADDRESS) {
+            sprintf(ipaddress, "%d.%d.%d.%d", addr[0], addr[1], addr[2], addr[3]);
+            dns_cache_add(hostname, addr, ttl);
+            return 0;
+        } else if (result == DNS_RESULT_NO_ADDRESS) {
+            dns_cache_add(hostname, NULL, MBED_CONF_NSAPI_DNS_CACHE_NEGATIVE_TTL);
             return NSAPI_ERROR_DNS_FAILURE;
         }
-        
-        //  cleanup and return
-        delete packet;
-        return 0;
+
+        waiting[server-first] = false;
+        pending--;
+    }
+
+    return NSAPI_ERROR_WOULD_BLOCK;
+}
+
+static int32_t query(UDPSocket *socket, const char *hostname, char *ipaddress)
+{
+    if (hostname == NULL) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+    int len = strlen(hostname);
+    if ((len > DNS_HOST_MAX) || (len == 0)) {
+        return NSAPI_ERROR_PARAMETER;
     }
-    
-    delete packet;
-    return NSAPI_ERROR_DNS_FAILURE;
+
+    /* the question sent to the DNS, followed by room for the answer */
+    uint8_t *query = new uint8_t[DNS_QUERY_MAX + DNS_PACKET_MAX];
+    if (query == NULL) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+    uint8_t *packet = query + DNS_QUERY_MAX;
+
+    //  Ask a group of servers at once and take the first good answer,
+    //  moving on to the next group only if none of them respond
+    int32_t ret = NSAPI_ERROR_WOULD_BLOCK;
+    for (unsigned first = 0; first < DNS_COUNT && ret == NSAPI_ERROR_WOULD_BLOCK;
+            first += MBED_CONF_NSAPI_DNS_PARALLEL_QUERIES) {
+        unsigned last = first + MBED_CONF_NSAPI_DNS_PARALLEL_QUERIES;
+        if (last > DNS_COUNT) {
+            last = DNS_COUNT;
+        }
+
+        ret = query_servers(socket, query, packet, hostname, first, last, ipaddress);
+    }
+
+    delete[] query;
+    return (ret == NSAPI_ERROR_WOULD_BLOCK) ? NSAPI_ERROR_DNS_FAILURE : ret;
 }
 
 int32_t dnsQuery(NetworkStack *iface, const char *host, char *ip)
@@ -192,13 +500,13 @@ int32_t dnsQuery(NetworkStack *iface, const char *host, char *ip)
         return 0;
     }
 
-    UDPSocket sock(iface);
-
-    for (unsigned i = 0; i < DNS_COUNT; i++) {
-        return query(&sock, SocketAddress(DNS_IPS[0], 53), host, ip);
+    int32_t err;
+    if (dns_cache_find(host, ip, &err)) {
+        return err;
     }
 
-    return NSAPI_ERROR_DNS_FAILURE;
+    UDPSocket sock(iface);
+    return query(&sock, host, ip);
 }
 
 int32_t dnsQuery(UDPSocket *socket, const char *host, char *ip)
@@ -208,9 +516,86 @@ int32_t dnsQuery(UDPSocket *socket, const char *host, char *ip)
         return 0;
     }
 
-    for (unsigned i = 0; i < DNS_COUNT; i++) {
-        return query(socket, SocketAddress(DNS_IPS[0], 53), host, ip);
+    int32_t err;
+    if (dns_cache_find(host, ip, &err)) {
+        return err;
+    }
+
+    return query(socket, host, ip);
+}
+
+
+/* Asynchronous queries
+ *
+ * Requests are queued to a resolver thread that is started on first use,
+ * so callers only pay for the thread if they need it.
+ */
+struct dns_request {
+    NetworkStack *iface;
+    char host[DNS_HOST_MAX+1];
+    mbed::Callback<void(int32_t, const char *)> callback;
+};
+
+typedef rtos::Mail<dns_request, MBED_CONF_NSAPI_DNS_ASYNC_QUEUE_SIZE> dns_queue_t;
+static SingletonPtr<dns_queue_t> dns_queue;
+static SingletonPtr<rtos::Mutex> dns_thread_lock;
+static rtos::Thread *dns_thread;
+
+static void dns_worker()
+{
+    while (true) {
+        osEvent evt = dns_queue->get();
+        if (evt.status != osEventMail) {
+            continue;
+        }
+
+        dns_request *req = (dns_request *)evt.value.p;
+        char ip[NSAPI_IP_SIZE];
+        int32_t err = dnsQuery(req->iface, req->host, ip);
+        mbed::Callback<void(int32_t, const char *)> callback = req->callback;
+        dns_queue->free(req);
+
+        callback(err, err ? NULL : ip);
+    }
+}
+
+int32_t dnsQueryAsync(NetworkStack *iface, const char *host,
+        mbed::Callback<void(int32_t, const char *)> callback)
+{
+    if (host == NULL || strlen(host) > DNS_HOST_MAX) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    char ip[NSAPI_IP_SIZE];
+    int32_t err;
+    if (isIP(host)) {
+        callback(0, host);
+        return 0;
+    } else if (dns_cache_find(host, ip, &err)) {
+        callback(err, err ? NULL : ip);
+        return 0;
+    }
+
+    dns_thread_lock->lock();
+    if (!dns_thread) {
+        dns_thread = new rtos::Thread(osPriorityNormal, MBED_CONF_NSAPI_DNS_ASYNC_STACK_SIZE);
+        if (!dns_thread || dns_thread->start(dns_worker) != osOK) {
+            delete dns_thread;
+            dns_thread = NULL;
+            dns_thread_lock->unlock();
+            return NSAPI_ERROR_NO_MEMORY;
+        }
+    }
+    dns_thread_lock->unlock();
+
+    dns_request *req = dns_queue->alloc();
+    if (!req) {
+        return NSAPI_ERROR_NO_MEMORY;
     }
 
-    return NSAPI_ERROR_DNS_FAILURE;
+    req->iface = iface;
+    strcpy(req->host, host);
+    req->callback = callback;
+    dns_queue->put(req);
+    return 0;
 }
@@ -20,6 +20,7 @@
 
 #include "NetworkStack.h"
 #include "UDPSocket.h"
+#include "Callback.h"
 
 
 /** Function dnsQuery implements the functionality to query a domain name 
@@ -33,9 +34,29 @@
   *     the resolved IP Address of the host in question.
   * @returns 0 on succes, NS_DNS_FAILURE if host is not found,
   *     or a negative value for other errors.
+  *
+  * Answers are kept in a small cache for the TTL of the record, and names
+  * that fail to resolve are remembered for a short while, so repeated
+  * queries for the same host are answered without network traffic. The
+  * question is sent to several servers at once and the first usable
+  * answer is taken. The socket's timeout is changed by the query.
   */
 int32_t dnsQuery(NetworkStack *iface, const char *host, char *ip);
 int32_t dnsQuery(UDPSocket *sock, const char *host, char *ip);
 
+/** Function dnsQueryAsync resolves a hostname without blocking the caller.
+  * Cached answers are passed to the callback before dnsQueryAsync returns,
+  * otherwise the query is handed to a resolver thread, started on first
+  * use, which calls the callback once the query completes.
+  * @param iface : Network interface to use for DNS resolution.
+  * @param host : The hostname of interest as a string, copied by the call.
+  * @param callback : Called with 0 and the resolved IP Address as a string
+  *     on success, or a negative error code and NULL on failure.
+  * @returns 0 if the query was answered or queued,
+  *     or a negative value if it could not be queued.
+  */
+int32_t dnsQueryAsync(NetworkStack *iface, const char *host,
+        mbed::Callback<void(int32_t, const char *)> callback);
+
 
 #endif // __DNSQUERY_H__
@@ -54,6 +54,58 @@ int NetworkStack::getsockopt(void *handle, int level, int optname, void *optval,
     return NSAPI_ERROR_UNSUPPORTED;
 }
 
+int NetworkStack::socket_send_nocopy(nsapi_socket_t handle, const void *data, unsigned size)
+{
+    // copying is always a valid way to send without holding on to the buffer
+    return socket_send(handle, data, size);
+}
+
+int NetworkStack::socket_send_pending(nsapi_socket_t handle)
+{
+    return 0;
+}
+
+int NetworkStack::socket_recv_view(nsapi_socket_t handle, SocketAddress *address, const void **data)
+{
+    return NSAPI_ERROR_UNSUPPORTED;
+}
+
+int NetworkStack::socket_recv_release(nsapi_socket_t handle, unsigned size)
+{
+    return NSAPI_ERROR_UNSUPPORTED;
+}
+
+int NetworkStack::socket_sendto_batch(nsapi_socket_t handle, const nsapi_datagram_t *datagrams, unsigned count)
+{
+    // sending one datagram at a time is always a valid way to send a batch
+    for (unsigned i = 0; i < count; i++) {
+        SocketAddress address(datagrams[i].addr, datagrams[i].port);
+        int err = socket_sendto(handle, address, datagrams[i].data, datagrams[i].size);
+        if (err < 0) {
+            return i > 0 ? i : err;
+        }
+    }
+
+    return count;
+}
+
+int NetworkStack::socket_recvfrom_batch(nsapi_socket_t handle, nsapi_datagram_t *datagrams, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++) {
+        SocketAddress address;
+        int recv = socket_recvfrom(handle, &address, datagrams[i].data, datagrams[i].size);
+        if (recv < 0) {
+            return i > 0 ? i : recv;
+        }
+
+        datagrams[i].addr = address.get_addr();
+        datagrams[i].port = address.get_port();
+        datagrams[i].size = recv;
+    }
+
+    return count;
+}
+
 
 // NetworkStackWrapper class for encapsulating the raw nsapi_stack structure
 class NetworkStackWrapper : public NetworkStack
@@ -240,6 +292,71 @@ protected:
 
         return _stack_api()->getsockopt(_stack(), socket, level, optname, optval, optlen);
     }
+
+    virtual int socket_send_nocopy(nsapi_socket_t socket, const void *data, unsigned size)
+    {
+        if (!_stack_api()->socket_send_nocopy) {
+            return NetworkStack::socket_send_nocopy(socket, data, size);
+        }
+
+        return _stack_api()->socket_send_nocopy(_stack(), socket, data, size);
+    }
+
+    virtual int socket_send_pending(nsapi_socket_t socket)
+    {
+        if (!_stack_api()->socket_send_pending) {
+            return NetworkStack::socket_send_pending(socket);
+        }
+
+        return _stack_api()->socket_send_pending(_stack(), socket);
+    }
+
+    virtual int socket_recv_view(nsapi_socket_t socket, SocketAddress *address, const void **data)
+    {
+        if (!_stack_api()->socket_recv_view) {
+            return NetworkStack::socket_recv_view(socket, address, data);
+        }
+
+        nsapi_addr_t addr = {NSAPI_IPv4, 0};
+        uint16_t port = 0;
+
+        int err = _stack_api()->socket_recv_view(_stack(), socket,
+                address ? &addr : 0, address ? &port : 0, data);
+
+        if (address) {
+            address->set_addr(addr);
+            address->set_port(port);
+        }
+
+        return err;
+    }
+
+    virtual int socket_recv_release(nsapi_socket_t socket, unsigned size)
+    {
+        if (!_stack_api()->socket_recv_release) {
+            return NetworkStack::socket_recv_release(socket, size);
+        }
+
+        return _stack_api()->socket_recv_release(_stack(), socket, size);
+    }
+
+    virtual int socket_sendto_batch(nsapi_socket_t socket, const nsapi_datagram_t *datagrams, unsigned count)
+    {
+        if (!_stack_api()->socket_sendto_batch) {
+            return NetworkStack::socket_sendto_batch(socket, datagrams, count);
+        }
+
+        return _stack_api()->socket_sendto_batch(_stack(), socket, datagrams, count);
+    }
+
+    virtual int socket_recvfrom_batch(nsapi_socket_t socket, nsapi_datagram_t *datagrams, unsigned count)
+    {
+        if (!_stack_api()->socket_recvfrom_batch) {
+            return NetworkStack::socket_recvfrom_batch(socket, datagrams, count);
+        }
+
+        return _stack_api()->socket_recvfrom_batch(_stack(), socket, datagrams, count);
+    }
 };
 
 
@@ -276,6 +276,112 @@ protected:
      *  @return         0 on success, negative error code on failure
      */    
     virtual int getsockopt(nsapi_socket_t handle, int level, int optname, void *optval, unsigned *optlen);
+
+    /** Send data over a TCP socket without copying it
+     *
+     *  Behaves as socket_send, except that the stack references the
+     *  buffer instead of copying the data into its own memory. The buffer
+     *  must not be modified or freed until socket_send_pending reports
+     *  that the stack no longer references it.
+     *
+     *  By default the data is copied with socket_send.
+     *
+     *  @param handle   Socket handle
+     *  @param data     Buffer of data to send to the host
+     *  @param size     Size of the buffer in bytes
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    virtual int socket_send_nocopy(nsapi_socket_t handle, const void *data, unsigned size);
+
+    /** Get the amount of zero-copy data still referenced by the stack
+     *
+     *  Returns the number of bytes, up to the end of the most recent
+     *  buffer passed to socket_send_nocopy, that the stack has not yet
+     *  released. Zero-copy buffers may be reused once this returns 0.
+     *
+     *  By default no data is referenced and 0 is returned.
+     *
+     *  @param handle   Socket handle
+     *  @return         Number of referenced bytes on success, negative
+     *                  error code on failure
+     */
+    virtual int socket_send_pending(nsapi_socket_t handle);
+
+    /** Borrow the next segment of received data without copying it
+     *
+     *  Points data at the next contiguous segment of received data held
+     *  in the stack's own buffers and returns its size. The segment stays
+     *  valid and is returned again by later calls until it is consumed
+     *  with socket_recv_release. The sender is stored in address if
+     *  address is not NULL.
+     *
+     *  This call is non-blocking. If no data is available,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  By default zero-copy receive is not supported and
+     *  NSAPI_ERROR_UNSUPPORTED is returned.
+     *
+     *  @param handle   Socket handle
+     *  @param address  Destination for the source address or NULL
+     *  @param data     Destination for a pointer to the segment
+     *  @return         Size of the segment in bytes on success, 0 if the
+     *                  connection has been closed, negative error code
+     *                  on failure
+     */
+    virtual int socket_recv_view(nsapi_socket_t handle, SocketAddress *address, const void **data);
+
+    /** Release data borrowed with socket_recv_view
+     *
+     *  Consumes size bytes from the front of the received data. Once a
+     *  segment is fully consumed the stack may reuse its buffer.
+     *
+     *  By default zero-copy receive is not supported and
+     *  NSAPI_ERROR_UNSUPPORTED is returned.
+     *
+     *  @param handle   Socket handle
+     *  @param size     Number of bytes to consume
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int socket_recv_release(nsapi_socket_t handle, unsigned size);
+
+    /** Send a batch of datagrams over a UDP socket
+     *
+     *  Sends each datagram to its own address in order, stopping at the
+     *  first one that can not be sent.
+     *
+     *  This call is non-blocking. If no datagram can be sent,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  By default datagrams are sent one at a time with socket_sendto.
+     *
+     *  @param handle   Socket handle
+     *  @param datagrams Array of datagrams to send
+     *  @param count    Number of datagrams in the array
+     *  @return         Number of datagrams sent on success, negative error
+     *                  code on failure
+     */
+    virtual int socket_sendto_batch(nsapi_socket_t handle, const nsapi_datagram_t *datagrams, unsigned count);
+
+    /** Receive a batch of datagrams over a UDP socket
+     *
+     *  Receives datagrams that are already queued on the socket into the
+     *  array in order, updating each entry with the source address, port
+     *  and number of bytes received.
+     *
+     *  This call is non-blocking. If no datagram is available,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  By default datagrams are received one at a time with
+     *  socket_recvfrom.
+     *
+     *  @param handle   Socket handle
+     *  @param datagrams Array of datagram buffers
+     *  @param count    Number of datagrams in the array
+     *  @return         Number of datagrams received on success, negative
+     *                  error code on failure
+     */
+    virtual int socket_recvfrom_batch(nsapi_socket_t handle, nsapi_datagram_t *datagrams, unsigned count);
 };
 
 
@@ -148,6 +148,21 @@ int Socket::getsockopt(int level, int optname, void *optval, unsigned *optlen)
 
 }
 
+int Socket::release(unsigned size)
+{
+    _lock.lock();
+    int ret;
+
+    if (!_socket) {
+        ret = NSAPI_ERROR_NO_SOCKET;
+    } else {
+        ret = _stack->socket_recv_release(_socket, size);
+    }
+
+    _lock.unlock();
+    return ret;
+}
+
 void Socket::attach(Callback<void()> callback)
 {
     _lock.lock();
@@ -144,6 +144,18 @@ public:
      */    
     int getsockopt(int level, int optname, void *optval, unsigned *optlen);
 
+    /** Release data borrowed with a zero-copy receive
+     *
+     *  Consumes size bytes of the segment returned by the most recent
+     *  TCPSocket::recv_view or UDPSocket::recvfrom_view call. Once the
+     *  whole segment is released its memory is handed back to the stack
+     *  and the pointer to it must no longer be used.
+     *
+     *  @param size     Number of bytes to release
+     *  @return         0 on success, negative error code on failure
+     */
+    int release(unsigned size);
+
     /** Register a callback on state change of the socket
      *
      *  The specified callback will be called on state changes such as when
@@ -0,0 +1,164 @@
+/* SocketSet
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SocketSet.h"
+#include "mbed.h"
+#include "critical.h"
+
+SocketSet::SocketSet()
+    : _sem(0), _wake_pending(false)
+{
+    memset(_entries, 0, sizeof _entries);
+}
+
+SocketSet::~SocketSet()
+{
+    for (int i = 0; i < MBED_CONF_NSAPI_SOCKET_SET_SIZE; i++) {
+        if (_entries[i].socket) {
+            remove(_entries[i].socket);
+        }
+    }
+}
+
+int SocketSet::add(Socket *socket)
+{
+    if (!socket) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    _lock.lock();
+
+    entry *free_entry = 0;
+    for (int i = 0; i < MBED_CONF_NSAPI_SOCKET_SET_SIZE; i++) {
+        if (_entries[i].socket == socket) {
+            _lock.unlock();
+            return NSAPI_ERROR_PARAMETER;
+        } else if (!_entries[i].socket && !free_entry) {
+            free_entry = &_entries[i];
+        }
+    }
+
+    if (!free_entry) {
+        _lock.unlock();
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    // Events that happened before the socket joined the set were not
+    // seen, so start out ready and let the first recv/send find out
+    free_entry->set = this;
+    free_entry->socket = socket;
+    free_entry->ready = true;
+    socket->set_blocking(false);
+    socket->attach(free_entry, &entry::event);
+
+    _lock.unlock();
+    return 0;
+}
+
+int SocketSet::remove(Socket *socket)
+{
+    _lock.lock();
+
+    for (int i = 0; i < MBED_CONF_NSAPI_SOCKET_SET_SIZE; i++) {
+        if (_entries[i].socket == socket) {
+            socket->attach(mbed::Callback<void()>());
+            _entries[i].socket = 0;
+            _entries[i].ready = false;
+            _lock.unlock();
+            return 0;
+        }
+    }
+
+    _lock.unlock();
+    return NSAPI_ERROR_PARAMETER;
+}
+
+int SocketSet::poll(int timeout)
+{
+    Timer timer;
+    timer.start();
+
+    while (true) {
+        int ready = count_ready();
+        if (ready) {
+            return ready;
+        }
+
+        uint32_t wait = osWaitForever;
+        if (timeout >= 0) {
+            int elapsed = timer.read_ms();
+            if (elapsed >= timeout) {
+                return NSAPI_ERROR_WOULD_BLOCK;
+            }
+            wait = timeout - elapsed;
+        }
+
+        // Tokens may be left over from sockets that were already
+        // serviced, so always recheck the set after waking up
+        if (_sem.wait(wait) > 0) {
+            _wake_pending = false;
+        }
+    }
+}
+
+Socket *SocketSet::next()
+{
+    _lock.lock();
+
+    for (int i = 0; i < MBED_CONF_NSAPI_SOCKET_SET_SIZE; i++) {
+        if (_entries[i].socket && _entries[i].ready) {
+            _entries[i].ready = false;
+            Socket *socket = _entries[i].socket;
+            _lock.unlock();
+            return socket;
+        }
+    }
+
+    _lock.unlock();
+    return 0;
+}
+
+int SocketSet::count_ready()
+{
+    _lock.lock();
+
+    int ready = 0;
+    for (int i = 0; i < MBED_CONF_NSAPI_SOCKET_SET_SIZE; i++) {
+        if (_entries[i].socket && _entries[i].ready) {
+            ready += 1;
+        }
+    }
+
+    _lock.unlock();
+    return ready;
+}
+
+void SocketSet::entry::event()
+{
+    // May be called from interrupt context, so only flag the socket
+    // and wake up the polling thread, releasing at most one token until
+    // the poller has taken it
+    ready = true;
+
+    core_util_critical_section_enter();
+    bool wake = !set->_wake_pending;
+    set->_wake_pending = true;
+    core_util_critical_section_exit();
+
+    if (wake) {
+        set->_sem.release();
+    }
+}
@@ -0,0 +1,129 @@
+/* SocketSet
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOCKETSET_H
+#define SOCKETSET_H
+
+#include "network-socket/Socket.h"
+#include "rtos/Mutex.h"
+#include "rtos/Semaphore.h"
+
+#ifndef MBED_CONF_NSAPI_SOCKET_SET_SIZE
+#define MBED_CONF_NSAPI_SOCKET_SET_SIZE 8
+#endif
+
+
+/** Set of sockets that can be waited on from a single thread
+ *
+ *  A SocketSet lets one thread wait for activity on many sockets at once,
+ *  instead of dedicating a thread to each blocking socket. Sockets are
+ *  added to the set and set to non-blocking, poll waits until at least
+ *  one of them may be able to make progress, and next returns each such
+ *  socket in turn.
+ *
+ *  Readiness follows the socket's state change callback, so a socket
+ *  returned by next may still return NSAPI_ERROR_WOULD_BLOCK from
+ *  send/recv/accept. A socket is reported again after its next state
+ *  change, which only happens once send/recv/accept has been called on
+ *  it, so each ready socket should be serviced until it would block.
+ *
+ *  The set takes over the callback registered with Socket::attach while
+ *  a socket is a member, and a socket must be removed from the set before
+ *  it is destroyed.
+ *
+ *  @code
+ *  SocketSet set;
+ *  set.add(&sock1);
+ *  set.add(&sock2);
+ *
+ *  while (true) {
+ *      set.poll(1000);
+ *      while (Socket *sock = set.next()) {
+ *          // service sock until it returns NSAPI_ERROR_WOULD_BLOCK
+ *      }
+ *  }
+ *  @endcode
+ */
+class SocketSet {
+public:
+    /** Create an empty socket set
+     */
+    SocketSet();
+
+    /** Destroy a socket set
+     *
+     *  Removes any sockets still in the set.
+     */
+    ~SocketSet();
+
+    /** Add a socket to the set
+     *
+     *  The socket is set to non-blocking and is reported as ready by the
+     *  first poll, since it may already have pending data.
+     *
+     *  @param socket   Socket to add
+     *  @return         0 on success, negative error code on failure
+     */
+    int add(Socket *socket);
+
+    /** Remove a socket from the set
+     *
+     *  Detaches the callback installed by add.
+     *
+     *  @param socket   Socket to remove
+     *  @return         0 on success, negative error code on failure
+     */
+    int remove(Socket *socket);
+
+    /** Wait for activity on any socket in the set
+     *
+     *  Blocks until at least one socket in the set is ready. A timeout of
+     *  0 checks the set without blocking and a negative timeout waits
+     *  forever.
+     *
+     *  @param timeout  Timeout in milliseconds
+     *  @return         Number of ready sockets on success,
+     *                  NSAPI_ERROR_WOULD_BLOCK if the timeout expired
+     */
+    int poll(int timeout = -1);
+
+    /** Get the next ready socket
+     *
+     *  Returns a socket that had activity and clears its ready state.
+     *
+     *  @return         Ready socket, or NULL if no sockets are ready
+     */
+    Socket *next();
+
+private:
+    struct entry {
+        void event();
+
+        SocketSet *set;
+        Socket *socket;
+        volatile bool ready;
+    };
+
+    int count_ready();
+
+    entry _entries[MBED_CONF_NSAPI_SOCKET_SET_SIZE];
+    rtos::Semaphore _sem;
+    volatile bool _wake_pending;
+    rtos::Mutex _lock;
+};
+
+
+#endif
@@ -61,6 +61,31 @@ int TCPSocket::connect(const char *host, uint16_t port)
 }
 
 int TCPSocket::send(const void *data, unsigned size)
+{
+    return send_data(data, size, true);
+}
+
+int TCPSocket::send_nocopy(const void *data, unsigned size)
+{
+    return send_data(data, size, false);
+}
+
+int TCPSocket::send_pending()
+{
+    _lock.lock();
+    int ret;
+
+    if (!_socket) {
+        ret = NSAPI_ERROR_NO_SOCKET;
+    } else {
+        ret = _stack->socket_send_pending(_socket);
+    }
+
+    _lock.unlock();
+    return ret;
+}
+
+int TCPSocket::send_data(const void *data, unsigned size, bool copy)
 {
     _lock.lock();
     int ret;
@@ -78,7 +103,9 @@ int TCPSocket::send(const void *data, unsigned size)
         }
 
         _pending = 0;
-        int sent = _stack->socket_send(_socket, data, size);
+        int sent = copy
+                ? _stack->socket_send(_socket, data, size)
+                : _stack->socket_send_nocopy(_socket, data, size);
         if ((0 == _timeout) || (NSAPI_ERROR_WOULD_BLOCK != sent)) {
             ret = sent;
             break;
@@ -105,6 +132,16 @@ int TCPSocket::send(const void *data, unsigned size)
 }
 
 int TCPSocket::recv(void *data, unsigned size)
+{
+    return recv_data(data, size, 0);
+}
+
+int TCPSocket::recv_view(const void **data)
+{
+    return recv_data(0, 0, data);
+}
+
+int TCPSocket::recv_data(void *data, unsigned size, const void **view)
 {
     _lock.lock();
     int ret;
@@ -122,7 +159,9 @@ int TCPSocket::recv(void *data, unsigned size)
         }
 
         _pending = 0;
-        int recv = _stack->socket_recv(_socket, data, size);
+        int recv = view
+                ? _stack->socket_recv_view(_socket, 0, view)
+                : _stack->socket_recv(_socket, data, size);
         if ((0 == _timeout) || (NSAPI_ERROR_WOULD_BLOCK != recv)) {
             ret = recv;
             break;
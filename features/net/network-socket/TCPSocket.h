@@ -90,6 +90,34 @@ public:
      *                  code on failure
      */
     int send(const void *data, unsigned size);
+
+    /** Send data over a TCP socket without copying it
+     *
+     *  Behaves as send, except that the network stack references the
+     *  buffer instead of copying the data. The buffer must not be modified
+     *  or freed until send_pending returns 0. Progress is signalled through
+     *  the callback registered with attach.
+     *
+     *  Stacks without zero-copy support copy the data, in which case the
+     *  buffer is released as soon as send_nocopy returns.
+     *
+     *  @param data     Buffer of data to send to the host
+     *  @param size     Size of the buffer in bytes
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    int send_nocopy(const void *data, unsigned size);
+
+    /** Get the amount of zero-copy data still referenced by the stack
+     *
+     *  Returns the number of bytes, up to the end of the most recent
+     *  buffer passed to send_nocopy, that the network stack has not yet
+     *  released.
+     *
+     *  @return         Number of referenced bytes on success, negative
+     *                  error code on failure
+     */
+    int send_pending();
     
     /** Receive data over a TCP socket
      *
@@ -107,11 +135,32 @@ public:
      */
     int recv(void *data, unsigned size);
 
+    /** Receive data over a TCP socket without copying it
+     *
+     *  Points data at the next segment of received data held in the
+     *  network stack's buffers and returns its size. The segment is
+     *  read-only and remains valid until it is consumed with release.
+     *  Calling recv_view again before releasing returns the same segment.
+     *
+     *  By default, recv_view blocks until data is sent. If socket is set
+     *  to non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is returned
+     *  immediately. Stacks without zero-copy support return
+     *  NSAPI_ERROR_UNSUPPORTED, in which case recv should be used.
+     *
+     *  @param data     Destination for a pointer to the received segment
+     *  @return         Size of the segment in bytes on success, 0 if the
+     *                  connection has been closed, negative error code
+     *                  on failure
+     */
+    int recv_view(const void **data);
+
 protected:
     friend class TCPServer;
 
     virtual nsapi_protocol_t get_proto();
     virtual void event();
+    int send_data(const void *data, unsigned size, bool copy);
+    int recv_data(void *data, unsigned size, const void **view);
 
     volatile unsigned _pending;
     rtos::Semaphore _read_sem;
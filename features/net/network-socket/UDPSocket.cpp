@@ -89,7 +89,105 @@ int UDPSocket::sendto(const SocketAddress &address, const void *data, unsigned s
     return ret;
 }
 
+int UDPSocket::sendto_batch(const nsapi_datagram_t *datagrams, unsigned count)
+{
+    _lock.lock();
+    int ret;
+
+    // If this assert is hit then there are two threads
+    // performing a send at the same time which is undefined
+    // behavior
+    MBED_ASSERT(!_write_in_progress);
+    _write_in_progress = true;
+
+    while (true) {
+        if (!_socket) {
+            ret = NSAPI_ERROR_NO_SOCKET;
+            break;
+        }
+
+        _pending = 0;
+        int sent = _stack->socket_sendto_batch(_socket, datagrams, count);
+        if ((0 == _timeout) || (NSAPI_ERROR_WOULD_BLOCK != sent)) {
+            ret = sent;
+            break;
+        } else {
+            int32_t sem_count;
+
+            // Release lock before blocking so other threads
+            // accessing this object aren't blocked
+            _lock.unlock();
+            sem_count = _write_sem.wait(_timeout);
+            _lock.lock();
+
+            if (sem_count < 1) {
+                // Semaphore wait timed out so break out and return
+                ret = NSAPI_ERROR_WOULD_BLOCK;
+                break;
+            }
+        }
+    }
+
+    _write_in_progress = false;
+    _lock.unlock();
+    return ret;
+}
+
+int UDPSocket::recvfrom_batch(nsapi_datagram_t *datagrams, unsigned count)
+{
+    _lock.lock();
+    int ret;
+
+    // If this assert is hit then there are two threads
+    // performing a recv at the same time which is undefined
+    // behavior
+    MBED_ASSERT(!_read_in_progress);
+    _read_in_progress = true;
+
+    while (true) {
+        if (!_socket) {
+            ret = NSAPI_ERROR_NO_SOCKET;
+            break;
+        }
+
+        _pending = 0;
+        int recv = _stack->socket_recvfrom_batch(_socket, datagrams, count);
+        if ((0 == _timeout) || (NSAPI_ERROR_WOULD_BLOCK != recv)) {
+            ret = recv;
+            break;
+        } else {
+            int32_t sem_count;
+
+            // Release lock before blocking so other threads
+            // accessing this object aren't blocked
+            _lock.unlock();
+            sem_count = _read_sem.wait(_timeout);
+            _lock.lock();
+
+            if (sem_count < 1) {
+                // Semaphore wait timed out so break out and return
+                ret = NSAPI_ERROR_WOULD_BLOCK;
+                break;
+            }
+        }
+    }
+
+    _read_in_progress = false;
+    _lock.unlock();
+    return ret;
+}
+
 int UDPSocket::recvfrom(SocketAddress *address, void *buffer, unsigned size)
+{
+    return recv_data(address, buffer, size, 0);
+}
+
+int UDPSocket::recvfrom_view(SocketAddress *address, const void **data)
+{
+    return recv_data(address, 0, 0, data);
+}
+
+int UDPSocket::recv_data(SocketAddress *address, void *buffer, unsigned size, const void **view)
 {
     _lock.lock();
     int ret;
@@ -107,7 +205,9 @@ int UDPSocket::recvfrom(SocketAddress *address, void *buffer, unsigned size)
         }
 
         _pending = 0;
-        int recv = _stack->socket_recvfrom(_socket, address, buffer, size);
+        int recv = view
+                ? _stack->socket_recv_view(_socket, address, view)
+                : _stack->socket_recvfrom(_socket, address, buffer, size);
         if ((0 == _timeout) || (NSAPI_ERROR_WOULD_BLOCK != recv)) {
             ret = recv;
             break;
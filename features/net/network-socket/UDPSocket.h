@@ -107,9 +107,68 @@ public:
      */
     int recvfrom(SocketAddress *address, void *data, unsigned size);
 
+    /** Receive a packet over a UDP socket without copying it
+     *
+     *  Points data at the next segment of the current packet held in the
+     *  network stack's buffers, stores the source address in address if
+     *  address is not NULL, and returns the size of the segment. The
+     *  segment is read-only and remains valid until it is consumed with
+     *  release. Large packets may be split over several segments, which
+     *  are returned in order as each one is released.
+     *
+     *  By default, recvfrom_view blocks until data is sent. If socket is
+     *  set to non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is
+     *  returned immediately. Stacks without zero-copy support return
+     *  NSAPI_ERROR_UNSUPPORTED, in which case recvfrom should be used.
+     *
+     *  @param address  Destination for the source address or NULL
+     *  @param data     Destination for a pointer to the received segment
+     *  @return         Size of the segment in bytes on success, negative
+     *                  error code on failure
+     */
+    int recvfrom_view(SocketAddress *address, const void **data);
+
+    /** Send a batch of packets over a UDP socket
+     *
+     *  Sends each datagram to its own address in a single call into the
+     *  network stack. Returns the number of datagrams sent, which may be
+     *  less than count if the stack runs out of buffers part way through.
+     *
+     *  By default, sendto_batch blocks until at least one datagram is
+     *  sent. If socket is set to non-blocking or times out,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param datagrams Array of datagrams to send
+     *  @param count    Number of datagrams in the array
+     *  @return         Number of sent datagrams on success, negative error
+     *                  code on failure
+     */
+    int sendto_batch(const nsapi_datagram_t *datagrams, unsigned count);
+
+    /** Receive a batch of packets over a UDP socket
+     *
+     *  Receives up to count datagrams in a single call into the network
+     *  stack. Each entry's data and size describe a buffer, and are
+     *  updated with the source address, port and number of bytes received.
+     *  Returns the number of datagrams received.
+     *
+     *  By default, recvfrom_batch blocks until at least one datagram is
+     *  received, and then returns whatever else is already queued on the
+     *  socket without waiting for the rest of the batch. If socket is set
+     *  to non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is returned
+     *  immediately.
+     *
+     *  @param datagrams Array of datagram buffers
+     *  @param count    Number of datagrams in the array
+     *  @return         Number of received datagrams on success, negative
+     *                  error code on failure
+     */
+    int recvfrom_batch(nsapi_datagram_t *datagrams, unsigned count);
+
 protected:
     virtual nsapi_protocol_t get_proto();
     virtual void event();
+    int recv_data(SocketAddress *address, void *buffer, unsigned size, const void **view);
 
     volatile unsigned _pending;
     rtos::Semaphore _read_sem;
@@ -37,6 +37,7 @@
 #include "network-socket/UDPSocket.h"
 #include "network-socket/TCPSocket.h"
 #include "network-socket/TCPServer.h"
+#include "network-socket/SocketSet.h"
 
 #endif
 
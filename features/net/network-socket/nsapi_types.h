@@ -104,6 +104,30 @@ typedef struct nsapi_addr {
 } nsapi_addr_t;
 
 
+/** Datagram descriptor for batched sends and receives
+ */
+typedef struct nsapi_datagram {
+    /** Address of the remote host
+     *  Destination on send, filled in with the source on receive
+     */
+    nsapi_addr_t addr;
+
+    /** Port of the remote host
+     */
+    uint16_t port;
+
+    /** Buffer holding the datagram, only read from on send
+     */
+    void *data;
+
+    /** Size of the datagram in bytes
+     *  On receive, the size of the buffer, updated with the number of
+     *  bytes received
+     */
+    unsigned size;
+} nsapi_datagram_t;
+
+
 /** Opaque handle for network sockets
  */
 typedef void *nsapi_socket_t;
@@ -435,6 +459,121 @@ typedef struct nsapi_stack_api
      *  @return         0 on success, negative error code on failure
      */    
     int (*getsockopt)(nsapi_stack_t *stack, nsapi_socket_t socket, int level, int optname, void *optval, unsigned *optlen);
+
+    /** Send data over a TCP socket without copying it
+     *
+     *  Behaves as socket_send, except that the stack references the
+     *  buffer instead of copying the data into its own memory. The buffer
+     *  must not be modified or freed until socket_send_pending reports
+     *  that the stack no longer references it.
+     *
+     *  If NULL, socket_send is used, which copies the data.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param data     Buffer of data to send to the host
+     *  @param size     Size of the buffer in bytes
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    int (*socket_send_nocopy)(nsapi_stack_t *stack, nsapi_socket_t socket, const void *data, unsigned size);
+
+    /** Get the amount of zero-copy data still referenced by the stack
+     *
+     *  Returns the number of bytes, up to the end of the most recent
+     *  buffer passed to socket_send_nocopy, that the stack has not yet
+     *  released. Zero-copy buffers may be reused once this returns 0.
+     *
+     *  If NULL, no data is ever referenced.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @return         Number of referenced bytes on success, negative
+     *                  error code on failure
+     */
+    int (*socket_send_pending)(nsapi_stack_t *stack, nsapi_socket_t socket);
+
+    /** Borrow the next segment of received data without copying it
+     *
+     *  Points data at the next contiguous segment of received data held
+     *  in the stack's own buffers and returns its size. The segment stays
+     *  valid and is returned again by later calls until it is consumed
+     *  with socket_recv_release. The address and port of the sender are
+     *  stored in addr and port if addr is not NULL.
+     *
+     *  This call is non-blocking. If no data is available,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  If NULL, zero-copy receive is not supported.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param addr     Destination for the source address or NULL
+     *  @param port     Destination for the source port or NULL
+     *  @param data     Destination for a pointer to the segment
+     *  @return         Size of the segment in bytes on success, 0 if the
+     *                  connection has been closed, negative error code
+     *                  on failure
+     */
+    int (*socket_recv_view)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            nsapi_addr_t *addr, uint16_t *port, const void **data);
+
+    /** Release data borrowed with socket_recv_view
+     *
+     *  Consumes size bytes from the front of the received data. Once a
+     *  segment is fully consumed the stack may reuse its buffer, and
+     *  pointers previously returned by socket_recv_view become invalid.
+     *
+     *  If NULL, zero-copy receive is not supported.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param size     Number of bytes to consume
+     *  @return         0 on success, negative error code on failure
+     */
+    int (*socket_recv_release)(nsapi_stack_t *stack, nsapi_socket_t socket, unsigned size);
+
+    /** Send a batch of datagrams over a UDP socket
+     *
+     *  Sends each datagram to its own address in order, stopping at the
+     *  first one that can not be sent.
+     *
+     *  This call is non-blocking. If no datagram can be sent,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  If NULL, datagrams are sent one at a time with socket_sendto.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param datagrams Array of datagrams to send
+     *  @param count    Number of datagrams in the array
+     *  @return         Number of datagrams sent on success, negative error
+     *                  code on failure
+     */
+    int (*socket_sendto_batch)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            const nsapi_datagram_t *datagrams, unsigned count);
+
+    /** Receive a batch of datagrams over a UDP socket
+     *
+     *  Receives datagrams that are already queued on the socket into the
+     *  array in order, updating each entry with the source address, port
+     *  and number of bytes received. Datagrams larger than their buffer
+     *  are truncated.
+     *
+     *  This call is non-blocking. If no datagram is available,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  If NULL, datagrams are received one at a time with socket_recvfrom.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param datagrams Array of datagram buffers
+     *  @param count    Number of datagrams in the array
+     *  @return         Number of datagrams received on success, negative
+     *                  error code on failure
+     */
+    int (*socket_recvfrom_batch)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            nsapi_datagram_t *datagrams, unsigned count);
 } nsapi_stack_api_t;
 
 
@@ -0,0 +1,627 @@
+/*
+ * mbed Microcontroller Library
+ * Copyright (c) 2006-2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/** @file paging.cpp Test cases for KVs held in several pages of the CFSTORE SRAM area.
+ *
+ * The SRAM area is made of CFSTORE_AREA_PAGE_SIZE pages. These test cases
+ * create enough KVs to fill several pages and check that the KVs and the
+ * handles open on them survive the KVs being moved between and within pages.
+ *
+ * Please consult the documentation under the test-case functions for
+ * a description of the individual test case.
+ */
+
+#include "mbed.h"
+#include "cfstore_config.h"
+#include "Driver_Common.h"
+#include "cfstore_debug.h"
+#include "cfstore_test.h"
+#include "configuration_store.h"
+#include "utest/utest.h"
+#include "unity/unity.h"
+#include "greentea-client/test_env.h"
+#include "cfstore_utest.h"
+
+#ifdef YOTTA_CFG_CFSTORE_UVISOR
+#include "uvisor-lib/uvisor-lib.h"
+#include "cfstore_uvisor.h"
+#endif /* YOTTA_CFG_CFSTORE_UVISOR */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+using namespace utest::v1;
+
+/// @cond CFSTORE_DOXYGEN_DISABLE
+#define CFSTORE_PAGING_NUM_KVS          48
+#define CFSTORE_PAGING_VALUE_LEN        40
+#define CFSTORE_PAGING_LARGE_LEN        (3 * CFSTORE_AREA_PAGE_SIZE)
+#define CFSTORE_PAGING_KEY_NAME_LEN     32
+/// @endcond
+
+static char cfstore_paging_utest_msg_g[CFSTORE_UTEST_MSG_BUF_SIZE];
+static char cfstore_paging_value_g[CFSTORE_PAGING_LARGE_LEN];
+static char cfstore_paging_read_g[CFSTORE_PAGING_LARGE_LEN];
+
+#ifdef YOTTA_CFG_CFSTORE_UVISOR
+/* Create the main box ACL list for the application.
+ * The main ACL gets inherited by all the other boxes
+ */
+CFSTORE_UVISOR_MAIN_ACL(cfstore_acl_uvisor_box_paging_g);
+
+/* Enable uVisor. */
+UVISOR_SET_MODE_ACL(UVISOR_ENABLED, cfstore_acl_uvisor_box_paging_g);
+#endif /* YOTTA_CFG_CFSTORE_UVISOR */
+
+
+/* @brief   generate the key name of the i-th KV */
+static void cfstore_paging_key_name(char* key_name, int i)
+{
+    snprintf(key_name, CFSTORE_PAGING_KEY_NAME_LEN, "com.arm.mbed.paging.kv%02d", i);
+}
+
+/* @brief   generate the value of the i-th KV, so that KVs of different
+ *          lengths and indices have different data */
+static void cfstore_paging_value(char* value, int i, ARM_CFSTORE_SIZE len)
+{
+    ARM_CFSTORE_SIZE j;
+
+    for(j = 0; j < len; j++){
+        value[j] = 'a' + (i + j + len) % 26;
+    }
+}
+
+/* @brief   create the i-th KV with a value of len octets */
+static void cfstore_paging_create(int i, ARM_CFSTORE_SIZE len)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    char key_name[CFSTORE_PAGING_KEY_NAME_LEN];
+    ARM_CFSTORE_KEYDESC kdesc;
+
+    memset(&kdesc, 0, sizeof(kdesc));
+    cfstore_paging_key_name(key_name, i);
+    cfstore_paging_value(cfstore_paging_value_g, i, len);
+    ret = cfstore_test_create(key_name, cfstore_paging_value_g, &len, &kdesc);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to create KV (key_name=%s, ret=%d).\n", __func__, key_name, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+}
+
+/* @brief   check the value read through hkey is that of the i-th KV with len octets */
+static void cfstore_paging_check_hkey(ARM_CFSTORE_HANDLE hkey, int i, ARM_CFSTORE_SIZE len)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    ARM_CFSTORE_SIZE read_len = CFSTORE_PAGING_LARGE_LEN;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+
+    ret = drv->Rseek(hkey, 0);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Rseek() failed (kv=%d, ret=%d).\n", __func__, i, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+
+    memset(cfstore_paging_read_g, 0, sizeof(cfstore_paging_read_g));
+    ret = drv->Read(hkey, cfstore_paging_read_g, &read_len);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Read() failed (kv=%d, ret=%d).\n", __func__, i, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: read %d octets of kv%02d, expected %d.\n", __func__, (int) read_len, i, (int) len);
+    TEST_ASSERT_MESSAGE(read_len == len, cfstore_paging_utest_msg_g);
+
+    cfstore_paging_value(cfstore_paging_value_g, i, len);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: value of kv%02d is corrupt.\n", __func__, i);
+    TEST_ASSERT_MESSAGE(memcmp(cfstore_paging_read_g, cfstore_paging_value_g, len) == 0, cfstore_paging_utest_msg_g);
+}
+
+/* @brief   check the i-th KV is in the store with a value of len octets */
+static void cfstore_paging_check(int i, ARM_CFSTORE_SIZE len)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    char key_name[CFSTORE_PAGING_KEY_NAME_LEN];
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+    ARM_CFSTORE_HANDLE_INIT(hkey);
+    ARM_CFSTORE_FMODE flags;
+
+    memset(&flags, 0, sizeof(flags));
+    flags.read = true;
+    cfstore_paging_key_name(key_name, i);
+    ret = drv->Open(key_name, flags, hkey);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to open KV (key_name=%s, ret=%d).\n", __func__, key_name, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+
+    cfstore_paging_check_hkey(hkey, i, len);
+    drv->Close(hkey);
+}
+
+/* @brief   check the i-th KV isn't in the store */
+static void cfstore_paging_check_not_found(int i)
+{
+    bool bfound = false;
+    int32_t ret = ARM_DRIVER_ERROR;
+    char key_name[CFSTORE_PAGING_KEY_NAME_LEN];
+
+    cfstore_paging_key_name(key_name, i);
+    ret = cfstore_test_kv_is_found(key_name, &bfound);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: found KV that was previously deleted (key_name=%s, ret=%d).\n", __func__, key_name, (int) ret);
+    TEST_ASSERT_MESSAGE(ret == ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND && bfound == false, cfstore_paging_utest_msg_g);
+}
+
+/* @brief   delete the i-th KV */
+static void cfstore_paging_delete(int i)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    char key_name[CFSTORE_PAGING_KEY_NAME_LEN];
+
+    cfstore_paging_key_name(key_name, i);
+    ret = cfstore_test_delete(key_name);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to delete KV (key_name=%s, ret=%d).\n", __func__, key_name, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+}
+
+/* @brief   resize the value of the i-th KV to len octets and rewrite it */
+static void cfstore_paging_resize(int i, ARM_CFSTORE_SIZE len)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    char key_name[CFSTORE_PAGING_KEY_NAME_LEN];
+    ARM_CFSTORE_SIZE write_len = len;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+    ARM_CFSTORE_HANDLE_INIT(hkey);
+
+    cfstore_paging_key_name(key_name, i);
+    ret = drv->Create(key_name, len, NULL, hkey);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to resize KV (key_name=%s, len=%d, ret=%d).\n", __func__, key_name, (int) len, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+
+    cfstore_paging_value(cfstore_paging_value_g, i, len);
+    ret = drv->Write(hkey, cfstore_paging_value_g, &write_len);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to write resized KV (key_name=%s, ret=%d).\n", __func__, key_name, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK && write_len == len, cfstore_paging_utest_msg_g);
+    drv->Close(hkey);
+}
+
+
+/* report whether built/configured for flash sync or async mode */
+static control_t cfstore_paging_test_00(const size_t call_count)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+
+    (void) call_count;
+    ret = cfstore_test_startup();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to perform test startup (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+    return CaseNext;
+}
+
+
+/** @brief
+ *
+ * This test case does the following:
+ * - creates enough KVs to fill several pages and checks their values.
+ * - deletes every other KV, so every page is compacted and neighbouring
+ *   pages can be merged, and checks the remaining KVs.
+ * - recreates the deleted KVs at the end of the area and checks all KVs.
+ *
+ * @return on success returns CaseNext to continue to next test case, otherwise will assert on errors.
+ */
+control_t cfstore_paging_test_01_end(const size_t call_count)
+{
+    int i = 0;
+    int32_t ret = ARM_DRIVER_ERROR;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    (void) call_count;
+
+    for(i = 0; i < CFSTORE_PAGING_NUM_KVS; i++){
+        cfstore_paging_create(i, CFSTORE_PAGING_VALUE_LEN);
+    }
+    for(i = 0; i < CFSTORE_PAGING_NUM_KVS; i++){
+        cfstore_paging_check(i, CFSTORE_PAGING_VALUE_LEN);
+    }
+
+    for(i = 1; i < CFSTORE_PAGING_NUM_KVS; i += 2){
+        cfstore_paging_delete(i);
+    }
+    for(i = 0; i < CFSTORE_PAGING_NUM_KVS; i++){
+        if(i % 2){
+            cfstore_paging_check_not_found(i);
+        } else {
+            cfstore_paging_check(i, CFSTORE_PAGING_VALUE_LEN);
+        }
+    }
+
+    for(i = 1; i < CFSTORE_PAGING_NUM_KVS; i += 2){
+        cfstore_paging_create(i, CFSTORE_PAGING_VALUE_LEN);
+    }
+    for(i = 0; i < CFSTORE_PAGING_NUM_KVS; i++){
+        cfstore_paging_check(i, CFSTORE_PAGING_VALUE_LEN);
+    }
+
+    ret = cfstore_test_delete_all();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to delete all KVs (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+
+    ret = drv->Uninitialize();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Uninitialize() call failed.\n", __func__);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+    return CaseNext;
+}
+
+
+/** @brief
+ *
+ * This test case checks that open handles follow their KV when it moves:
+ * - creates enough KVs to fill several pages and opens a KV in the middle.
+ * - deletes the KVs before it, so it moves within its page or into the
+ *   previous page.
+ * - grows the KV after it beyond the page size, so the page is relocated.
+ * - grows the open KV through a second handle.
+ * - checks the value through the first handle after each step.
+ *
+ * @return on success returns CaseNext to continue to next test case, otherwise will assert on errors.
+ */
+control_t cfstore_paging_test_02_end(const size_t call_count)
+{
+    int i = 0;
+    const int held = CFSTORE_PAGING_NUM_KVS / 2;
+    int32_t ret = ARM_DRIVER_ERROR;
+    char key_name[CFSTORE_PAGING_KEY_NAME_LEN];
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+    ARM_CFSTORE_HANDLE_INIT(hkey);
+    ARM_CFSTORE_FMODE flags;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    (void) call_count;
+    memset(&flags, 0, sizeof(flags));
+
+    for(i = 0; i < CFSTORE_PAGING_NUM_KVS; i++){
+        cfstore_paging_create(i, CFSTORE_PAGING_VALUE_LEN);
+    }
+
+    flags.read = true;
+    cfstore_paging_key_name(key_name, held);
+    ret = drv->Open(key_name, flags, hkey);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to open KV (key_name=%s, ret=%d).\n", __func__, key_name, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+    cfstore_paging_check_hkey(hkey, held, CFSTORE_PAGING_VALUE_LEN);
+
+    for(i = held - 8; i < held; i++){
+        cfstore_paging_delete(i);
+        cfstore_paging_check_hkey(hkey, held, CFSTORE_PAGING_VALUE_LEN);
+    }
+
+    cfstore_paging_resize(held + 1, CFSTORE_PAGING_LARGE_LEN);
+    cfstore_paging_check_hkey(hkey, held, CFSTORE_PAGING_VALUE_LEN);
+    cfstore_paging_check(held + 1, CFSTORE_PAGING_LARGE_LEN);
+
+    cfstore_paging_resize(held, 4 * CFSTORE_PAGING_VALUE_LEN);
+    cfstore_paging_check_hkey(hkey, held, 4 * CFSTORE_PAGING_VALUE_LEN);
+
+    cfstore_paging_resize(held + 1, CFSTORE_PAGING_VALUE_LEN);
+    cfstore_paging_check_hkey(hkey, held, 4 * CFSTORE_PAGING_VALUE_LEN);
+
+    ret = drv->Close(hkey);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Close() failed (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+
+    for(i = 0; i < CFSTORE_PAGING_NUM_KVS; i++){
+        if(i >= held - 8 && i < held){
+            cfstore_paging_check_not_found(i);
+        } else if(i == held){
+            cfstore_paging_check(i, 4 * CFSTORE_PAGING_VALUE_LEN);
+        } else {
+            cfstore_paging_check(i, CFSTORE_PAGING_VALUE_LEN);
+        }
+    }
+
+    ret = cfstore_test_delete_all();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to delete all KVs (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+
+    ret = drv->Uninitialize();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Uninitialize() call failed.\n", __func__);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+    return CaseNext;
+}
+
+
+/** @brief
+ *
+ * This test case checks KVs larger than a page:
+ * - creates a KV of several pages between two small KVs and checks them.
+ * - checks that Find() returns all three KVs.
+ * - shrinks the large KV to fit in a page, and deletes it, checking the
+ *   small KVs each time.
+ *
+ * @return on success returns CaseNext to continue to next test case, otherwise will assert on errors.
+ */
+control_t cfstore_paging_test_03_end(const size_t call_count)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    int found = 0;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+    ARM_CFSTORE_HANDLE_INIT(next);
+    ARM_CFSTORE_HANDLE_INIT(prev);
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    (void) call_count;
+
+    cfstore_paging_create(0, CFSTORE_PAGING_VALUE_LEN);
+    cfstore_paging_create(1, CFSTORE_PAGING_LARGE_LEN);
+    cfstore_paging_create(2, CFSTORE_PAGING_VALUE_LEN);
+    cfstore_paging_check(0, CFSTORE_PAGING_VALUE_LEN);
+    cfstore_paging_check(1, CFSTORE_PAGING_LARGE_LEN);
+    cfstore_paging_check(2, CFSTORE_PAGING_VALUE_LEN);
+
+    while((ret = drv->Find("com.arm.mbed.paging.*", prev, next)) == ARM_DRIVER_OK)
+    {
+        found++;
+        CFSTORE_HANDLE_SWAP(prev, next);
+    }
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Find() returned %d KVs, expected 3 (ret=%d).\n", __func__, found, (int) ret);
+    TEST_ASSERT_MESSAGE(ret == ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND && found == 3, cfstore_paging_utest_msg_g);
+
+    cfstore_paging_resize(1, CFSTORE_PAGING_VALUE_LEN);
+    cfstore_paging_check(0, CFSTORE_PAGING_VALUE_LEN);
+    cfstore_paging_check(1, CFSTORE_PAGING_VALUE_LEN);
+    cfstore_paging_check(2, CFSTORE_PAGING_VALUE_LEN);
+
+    cfstore_paging_delete(1);
+    cfstore_paging_check(0, CFSTORE_PAGING_VALUE_LEN);
+    cfstore_paging_check_not_found(1);
+    cfstore_paging_check(2, CFSTORE_PAGING_VALUE_LEN);
+
+    ret = cfstore_test_delete_all();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to delete all KVs (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+
+    ret = drv->Uninitialize();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Uninitialize() call failed.\n", __func__);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+    return CaseNext;
+}
+
+
+/* used for sync mode build only */
+#if defined STORAGE_DRIVER_CONFIG_HARDWARE_MTD_ASYNC_OPS && STORAGE_DRIVER_CONFIG_HARDWARE_MTD_ASYNC_OPS==0
+
+/** @brief
+ *
+ * This test case checks that the pages are flushed and read back in order:
+ * - creates enough KVs to fill several pages, including a KV larger than a
+ *   page, and flushes them to flash.
+ * - uninitializes and reinitializes cfstore, so the area is reloaded from
+ *   flash and split into pages again, and checks all KVs.
+ *
+ * @return on success returns CaseNext to continue to next test case, otherwise will assert on errors.
+ */
+control_t cfstore_paging_test_04(const size_t call_count)
+{
+    int i = 0;
+    int32_t ret = ARM_DRIVER_ERROR;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    (void) call_count;
+
+    ret = drv->Initialize(NULL, NULL);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Initialize() failed (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+
+    for(i = 0; i < CFSTORE_PAGING_NUM_KVS; i++){
+        cfstore_paging_create(i, i == CFSTORE_PAGING_NUM_KVS / 2 ? CFSTORE_PAGING_LARGE_LEN : CFSTORE_PAGING_VALUE_LEN);
+    }
+    ret = drv->Flush();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Flush() failed (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+
+    ret = drv->Uninitialize();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Uninitialize() failed (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+
+    ret = drv->Initialize(NULL, NULL);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Initialize() failed (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+
+    for(i = 0; i < CFSTORE_PAGING_NUM_KVS; i++){
+        cfstore_paging_check(i, i == CFSTORE_PAGING_NUM_KVS / 2 ? CFSTORE_PAGING_LARGE_LEN : CFSTORE_PAGING_VALUE_LEN);
+    }
+
+    /* clean up so later tests start with an empty store */
+    ret = cfstore_test_delete_all();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to delete all KVs (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+
+    ret = drv->Flush();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Flush() failed (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+
+    ret = drv->Uninitialize();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Uninitialize() failed (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+    return CaseNext;
+}
+
+/* @brief   get the flush statistics */
+static void cfstore_paging_get_flush_info(ARM_CFSTORE_FLUSH_INFO* info)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+
+    ret = drv->GetFlushInfo(info);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: GetFlushInfo() failed (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+}
+
+/* @brief   flush and check that everything changed was committed */
+static void cfstore_paging_flush(void)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+    ARM_CFSTORE_FLUSH_INFO info;
+
+    ret = drv->Flush();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Flush() failed (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+
+    cfstore_paging_get_flush_info(&info);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: %d octets still dirty after Flush().\n", __func__, (int) info.dirty_len);
+    TEST_ASSERT_MESSAGE(info.dirty_len == 0, cfstore_paging_utest_msg_g);
+}
+
+/* @brief   uninitialize and initialize, so the area is reloaded from flash */
+static void cfstore_paging_reload(void)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+
+    ret = drv->Uninitialize();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Uninitialize() failed (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+
+    ret = drv->Initialize(NULL, NULL);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Initialize() failed (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+}
+
+/** @brief
+ *
+ * This test case checks flushes changing part of the area, which with the
+ * log strategy only log the pages which have changed:
+ * - creates enough KVs to fill several pages and flushes them, checking
+ *   GetFlushInfo() reports the flash programmed.
+ * - checks a Flush() with nothing changed programs nothing.
+ * - repeatedly resizes, deletes and recreates single KVs, with handles
+ *   opened and closed in between, flushing after each change and
+ *   reloading the area from flash every few changes to check all KVs.
+ *
+ * @return on success returns CaseNext to continue to next test case, otherwise will assert on errors.
+ */
+control_t cfstore_paging_test_05(const size_t call_count)
+{
+    int i = 0;
+    int round = 0;
+    int32_t ret = ARM_DRIVER_ERROR;
+    uint64_t total = 0;
+    ARM_CFSTORE_SIZE len[CFSTORE_PAGING_NUM_KVS];
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+    ARM_CFSTORE_FLUSH_INFO info;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    (void) call_count;
+
+    ret = drv->Initialize(NULL, NULL);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Initialize() failed (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+
+    for(i = 0; i < CFSTORE_PAGING_NUM_KVS; i++){
+        len[i] = CFSTORE_PAGING_VALUE_LEN;
+        cfstore_paging_create(i, len[i]);
+    }
+    cfstore_paging_get_flush_info(&info);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: GetFlushInfo() reported %d dirty octets, expected at least %d.\n", __func__, (int) info.dirty_len, (int) (CFSTORE_PAGING_NUM_KVS * CFSTORE_PAGING_VALUE_LEN));
+    TEST_ASSERT_MESSAGE(info.dirty_len >= CFSTORE_PAGING_NUM_KVS * CFSTORE_PAGING_VALUE_LEN, cfstore_paging_utest_msg_g);
+
+    cfstore_paging_flush();
+    cfstore_paging_get_flush_info(&info);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Flush() reported programming %d octets (total=%d).\n", __func__, (int) info.last_flush_len, (int) info.total_flush_len);
+    TEST_ASSERT_MESSAGE(info.last_flush_len > 0 && info.total_flush_len >= info.last_flush_len, cfstore_paging_utest_msg_g);
+    total = info.total_flush_len;
+
+    /* nothing has changed so nothing is committed */
+    cfstore_paging_flush();
+    cfstore_paging_get_flush_info(&info);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Flush() of an unchanged area reported programming %d octets.\n", __func__, (int) info.last_flush_len);
+    TEST_ASSERT_MESSAGE(info.last_flush_len == 0 && info.total_flush_len == total, cfstore_paging_utest_msg_g);
+
+    for(round = 0; round < 12; round++){
+        i = (round * 7) % CFSTORE_PAGING_NUM_KVS;
+        switch(round % 3){
+        case 0:
+            len[i] = len[i] == CFSTORE_PAGING_VALUE_LEN ? 2 * CFSTORE_PAGING_VALUE_LEN : CFSTORE_PAGING_VALUE_LEN;
+            cfstore_paging_resize(i, len[i]);
+            break;
+        case 1:
+            cfstore_paging_delete(i);
+            cfstore_paging_flush();
+            cfstore_paging_check_not_found(i);
+            cfstore_paging_create(i, len[i]);
+            break;
+        default:
+            /* opening and closing a KV changes its header */
+            cfstore_paging_check(i, len[i]);
+            cfstore_paging_check((i + 1) % CFSTORE_PAGING_NUM_KVS, len[(i + 1) % CFSTORE_PAGING_NUM_KVS]);
+            len[i] = CFSTORE_PAGING_VALUE_LEN / 2;
+            cfstore_paging_resize(i, len[i]);
+            break;
+        }
+        cfstore_paging_flush();
+
+        if(round % 4 == 3){
+            cfstore_paging_reload();
+            for(i = 0; i < CFSTORE_PAGING_NUM_KVS; i++){
+                cfstore_paging_check(i, len[i]);
+            }
+        }
+    }
+
+    /* clean up so later tests start with an empty store */
+    ret = cfstore_test_delete_all();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to delete all KVs (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+    cfstore_paging_flush();
+
+    ret = drv->Uninitialize();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_paging_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Uninitialize() failed (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_paging_utest_msg_g);
+    return CaseNext;
+}
+#endif // STORAGE_DRIVER_CONFIG_HARDWARE_MTD_ASYNC_OPS
+
+
+/// @cond CFSTORE_DOXYGEN_DISABLE
+utest::v1::status_t greentea_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(100, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+           /*          1         2         3         4         5         6        7  */
+           /* 1234567890123456789012345678901234567890123456789012345678901234567890 */
+        Case("PAGING_test_00", cfstore_paging_test_00),
+        Case("PAGING_test_01_start", cfstore_utest_default_start),
+        Case("PAGING_test_01_end", cfstore_paging_test_01_end),
+        Case("PAGING_test_02_start", cfstore_utest_default_start),
+        Case("PAGING_test_02_end", cfstore_paging_test_02_end),
+        Case("PAGING_test_03_start", cfstore_utest_default_start),
+        Case("PAGING_test_03_end", cfstore_paging_test_03_end),
+#if defined STORAGE_DRIVER_CONFIG_HARDWARE_MTD_ASYNC_OPS && STORAGE_DRIVER_CONFIG_HARDWARE_MTD_ASYNC_OPS==0
+        Case("PAGING_test_04", cfstore_paging_test_04),
+        Case("PAGING_test_05", cfstore_paging_test_05),
+#endif // STORAGE_DRIVER_CONFIG_HARDWARE_MTD_ASYNC_OPS
+};
+
+
+/* Declare your test specification with a custom setup handler */
+Specification specification(greentea_setup, cases);
+
+int main()
+{
+    return !Harness::run(specification);
+}
+/// @endcond
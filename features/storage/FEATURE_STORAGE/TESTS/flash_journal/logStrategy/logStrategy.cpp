@@ -0,0 +1,528 @@
+/*
+ * Copyright (c) 2006-2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !DEVICE_STORAGE
+    #error [NOT_SUPPORTED] Storage not supported for this target
+#endif
+
+#ifdef TARGET_LIKE_POSIX
+#define AVOID_GREENTEA
+#endif
+
+#ifndef AVOID_GREENTEA
+#include "greentea-client/test_env.h"
+#endif
+#include "utest/utest.h"
+#include "unity/unity.h"
+
+#include "flash-journal-strategy-log/flash_journal_strategy_log.h"
+#include "flash-journal-strategy-log/config.h"
+#include <string.h>
+#include <inttypes.h>
+
+using namespace utest::v1;
+
+extern ARM_DRIVER_STORAGE ARM_Driver_Storage_(0);
+ARM_DRIVER_STORAGE *drv = &ARM_Driver_Storage_(0);
+
+FlashJournal_t      journal;
+
+static const size_t BUFFER_SIZE = 1024;
+static uint8_t      buffer[BUFFER_SIZE];
+static uint8_t      expected[BUFFER_SIZE];
+static size_t       sizeofExpected;
+
+void callbackHandler(int32_t status, FlashJournal_OpCode_t cmd_code)
+{
+    /* the log strategy only supports synchronous MTDs */
+    TEST_FAIL_MESSAGE("unexpected callback");
+}
+
+static void initializeJournal(void)
+{
+    int32_t rc = FlashJournal_initialize(&journal, drv, &FLASH_JOURNAL_STRATEGY_LOG, callbackHandler);
+    TEST_ASSERT_EQUAL(1, rc); /* synchronous completion of initialize() is expected to return 1 */
+}
+
+static void commitBlob(const uint8_t *blob, size_t size, size_t chunk)
+{
+    for (size_t offset = 0; offset < size; offset += chunk) {
+        size_t n = (size - offset < chunk) ? (size - offset) : chunk;
+        int32_t rc = FlashJournal_log(&journal, blob + offset, n);
+        TEST_ASSERT_EQUAL(n, rc);
+    }
+
+    int32_t rc = FlashJournal_commit(&journal);
+    TEST_ASSERT_EQUAL(1, rc);
+
+    memcpy(expected, blob, size);
+    sizeofExpected = size;
+}
+
+static void verifyBlob(void)
+{
+    FlashJournal_Info_t info;
+    int32_t rc = FlashJournal_getInfo(&journal, &info);
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, rc);
+    TEST_ASSERT_EQUAL(sizeofExpected, info.sizeofJournaledBlob);
+
+    if (sizeofExpected == 0) {
+        rc = FlashJournal_read(&journal, buffer, BUFFER_SIZE);
+        TEST_ASSERT_EQUAL(JOURNAL_STATUS_EMPTY, rc);
+        return;
+    }
+
+    /* read in odd-sized chunks to exercise reads across record boundaries */
+    memset(buffer, 0, BUFFER_SIZE);
+    size_t offset = 0;
+    while (offset < sizeofExpected) {
+        rc = FlashJournal_read(&journal, buffer + offset, 37);
+        TEST_ASSERT(rc > 0);
+        offset += rc;
+    }
+    TEST_ASSERT_EQUAL(sizeofExpected, offset);
+    TEST_ASSERT_EQUAL(0, memcmp(buffer, expected, sizeofExpected));
+}
+
+/* true if the journal holds the n bytes at 'data'. The blob is read to the
+ * end, so that the next read starts again from its beginning. */
+static bool journalHolds(const uint8_t *data, size_t n)
+{
+    FlashJournal_Info_t info;
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, FlashJournal_getInfo(&journal, &info));
+    if (info.sizeofJournaledBlob != n) {
+        return false;
+    }
+    if (n == 0) {
+        return true;
+    }
+
+    bool   same   = true;
+    size_t offset = 0;
+    while (offset < n) {
+        size_t  chunk = (n - offset < BUFFER_SIZE) ? (n - offset) : BUFFER_SIZE;
+        int32_t rc    = FlashJournal_read(&journal, buffer, chunk);
+        TEST_ASSERT(rc > 0);
+        same    = same && (memcmp(buffer, data + offset, rc) == 0);
+        offset += rc;
+    }
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_EMPTY, FlashJournal_read(&journal, buffer, 1));
+    return same;
+}
+
+/*
+ * An MTD made of the first few sectors of 'drv', which loses power after a
+ * given number of erase and program operations. The operation during which
+ * power goes only programs the first half of its data, or completes if it is
+ * an erase; every operation after it fails until power is restored.
+ */
+static const uint32_t     POWER_LOSS_SECTORS     = 3;    /* the fewest the log strategy accepts */
+static const size_t       POWER_LOSS_BUFFER_SIZE = 4096; /* records must be able to fill most of a sector */
+static ARM_STORAGE_BLOCK  powerLossBlock;
+static uint32_t           powerLossUnit;
+static int32_t            powerLossBudget = -1; /* operations before power goes; -1 for never */
+static bool               powerLost       = false;
+
+static void powerLossRestore(void)
+{
+    powerLossBudget = -1;
+    powerLost       = false;
+}
+
+static int32_t powerLossGetInfo(ARM_STORAGE_INFO *info)
+{
+    int32_t rc = drv->GetInfo(info);
+    info->total_storage = powerLossBlock.size;
+    return rc;
+}
+
+static int32_t powerLossGetNextBlock(const ARM_STORAGE_BLOCK *prev, ARM_STORAGE_BLOCK *next)
+{
+    if (prev != NULL) {
+        return ARM_DRIVER_ERROR;
+    }
+    if (next != NULL) {
+        *next = powerLossBlock;
+    }
+    return ARM_DRIVER_OK;
+}
+
+static int32_t powerLossGetBlock(uint64_t addr, ARM_STORAGE_BLOCK *block)
+{
+    if ((addr < powerLossBlock.addr) || (addr >= powerLossBlock.addr + powerLossBlock.size)) {
+        return ARM_DRIVER_ERROR;
+    }
+    return powerLossGetNextBlock(NULL, block);
+}
+
+static int32_t powerLossProgramData(uint64_t addr, const void *data, uint32_t size)
+{
+    if (powerLost) {
+        return ARM_DRIVER_ERROR;
+    }
+    if (powerLossBudget == 0) {
+        /* power goes while this is being programmed */
+        uint32_t torn = ((size / 2) / powerLossUnit) * powerLossUnit;
+        if (torn > 0) {
+            drv->ProgramData(addr, data, torn);
+        }
+        powerLost = true;
+        return ARM_DRIVER_ERROR;
+    }
+    if (powerLossBudget > 0) {
+        powerLossBudget--;
+    }
+    return drv->ProgramData(addr, data, size);
+}
+
+static int32_t powerLossErase(uint64_t addr, uint32_t size)
+{
+    if (powerLost) {
+        return ARM_DRIVER_ERROR;
+    }
+    if (powerLossBudget == 0) {
+        /* power goes once the sector has been erased */
+        drv->Erase(addr, size);
+        powerLost = true;
+        return ARM_DRIVER_ERROR;
+    }
+    if (powerLossBudget > 0) {
+        powerLossBudget--;
+    }
+    return drv->Erase(addr, size);
+}
+
+static ARM_DRIVER_VERSION powerLossGetVersion(void)                      { return drv->GetVersion(); }
+static ARM_STORAGE_CAPABILITIES powerLossGetCapabilities(void)           { return drv->GetCapabilities(); }
+static int32_t powerLossInitialize(ARM_Storage_Callback_t callback)      { return drv->Initialize(callback); }
+static int32_t powerLossUninitialize(void)                               { return drv->Uninitialize(); }
+static int32_t powerLossPowerControl(ARM_POWER_STATE state)              { return drv->PowerControl(state); }
+static int32_t powerLossReadData(uint64_t addr, void *data, uint32_t size) { return drv->ReadData(addr, data, size); }
+static int32_t powerLossEraseAll(void)                                   { return ARM_DRIVER_ERROR_UNSUPPORTED; }
+static ARM_STORAGE_STATUS powerLossGetStatus(void)                       { return drv->GetStatus(); }
+static uint32_t powerLossResolveAddress(uint64_t addr)                   { return drv->ResolveAddress(addr); }
+
+static ARM_DRIVER_STORAGE powerLossDrv = {
+    powerLossGetVersion,
+    powerLossGetCapabilities,
+    powerLossInitialize,
+    powerLossUninitialize,
+    powerLossPowerControl,
+    powerLossReadData,
+    powerLossProgramData,
+    powerLossErase,
+    powerLossEraseAll,
+    powerLossGetStatus,
+    powerLossGetInfo,
+    powerLossResolveAddress,
+    powerLossGetNextBlock,
+    powerLossGetBlock
+};
+
+control_t test_resetAndInitialize()
+{
+    if (drv->GetCapabilities().asynchronous_ops) {
+        printf("test_resetAndInitialize: log strategy requires a synchronous MTD, skipping\n");
+        return CaseNext;
+    }
+
+    initializeJournal();
+    TEST_ASSERT_EQUAL(1, FlashJournal_reset(&journal));
+
+    initializeJournal();
+    sizeofExpected = 0;
+    verifyBlob();
+
+    FlashJournal_Info_t info;
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, FlashJournal_getInfo(&journal, &info));
+    TEST_ASSERT(info.capacity >= BUFFER_SIZE);
+    TEST_ASSERT_EQUAL(1, info.program_unit);
+
+    return CaseNext;
+}
+
+control_t test_commitAndReinitialize()
+{
+    if (drv->GetCapabilities().asynchronous_ops) {
+        return CaseNext;
+    }
+
+    static uint8_t blob[BUFFER_SIZE];
+    memset(blob, 0xAA, sizeof(blob));
+    commitBlob(blob, sizeof(blob), 101);
+    verifyBlob();
+
+    initializeJournal();
+    verifyBlob();
+
+    return CaseNext;
+}
+
+control_t test_partialUpdates()
+{
+    if (drv->GetCapabilities().asynchronous_ops) {
+        return CaseNext;
+    }
+
+    /* commit the same blob over and over with a few bytes changed each time;
+     * enough commits to cycle through the log several times */
+    static uint8_t blob[BUFFER_SIZE];
+    memcpy(blob, expected, sizeofExpected);
+    for (unsigned i = 0; i < 200; i++) {
+        blob[(i * 97) % BUFFER_SIZE]  = (uint8_t)i;
+        blob[(i * 389) % BUFFER_SIZE] = (uint8_t)~i;
+        commitBlob(blob, BUFFER_SIZE, (i % 2) ? BUFFER_SIZE : 255);
+
+        if ((i % 50) == 49) {
+            initializeJournal();
+        }
+        verifyBlob();
+    }
+
+    return CaseNext;
+}
+
+control_t test_sizeofLastCommit()
+{
+    if (drv->GetCapabilities().asynchronous_ops) {
+        return CaseNext;
+    }
+
+    /* a commit changing a single byte is logged as a delta record, which
+     * programs far less than the blob; base records are still written
+     * periodically to bound the chain */
+    static uint8_t blob[BUFFER_SIZE];
+    memcpy(blob, expected, sizeofExpected);
+    unsigned deltas = 0;
+    for (unsigned i = 0; i < 2 * (LOG_FLASH_JOURNAL_MAX_DELTAS + 1); i++) {
+        blob[(i * 131) % BUFFER_SIZE]++;
+        commitBlob(blob, BUFFER_SIZE, BUFFER_SIZE);
+
+        FlashJournal_Info_t info;
+        TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, FlashJournal_getInfo(&journal, &info));
+        TEST_ASSERT(info.sizeofLastCommit > 0);
+        if (info.sizeofLastCommit < BUFFER_SIZE / 4) {
+            deltas++;
+        } else {
+            TEST_ASSERT(info.sizeofLastCommit > BUFFER_SIZE);
+        }
+    }
+    TEST_ASSERT(deltas > 0);
+
+    /* nothing has been committed since initialization */
+    initializeJournal();
+    FlashJournal_Info_t info;
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, FlashJournal_getInfo(&journal, &info));
+    TEST_ASSERT_EQUAL(0, info.sizeofLastCommit);
+    verifyBlob();
+
+    return CaseNext;
+}
+
+control_t test_changeSize()
+{
+    if (drv->GetCapabilities().asynchronous_ops) {
+        return CaseNext;
+    }
+
+    static uint8_t blob[BUFFER_SIZE];
+    memcpy(blob, expected, sizeofExpected);
+    commitBlob(blob, BUFFER_SIZE / 3, BUFFER_SIZE);
+    verifyBlob();
+
+    commitBlob(blob, 0, 1);
+    initializeJournal();
+    verifyBlob();
+
+    commitBlob(blob, BUFFER_SIZE, 64);
+    initializeJournal();
+    verifyBlob();
+
+    return CaseNext;
+}
+
+control_t test_skipUnchanged()
+{
+    if (drv->GetCapabilities().asynchronous_ops) {
+        return CaseNext;
+    }
+
+    /* skip() the middle third of the blob while logging the rest with
+     * changes; enough commits to write both delta and base records */
+    static uint8_t blob[BUFFER_SIZE];
+    memcpy(blob, expected, sizeofExpected);
+    commitBlob(blob, BUFFER_SIZE, BUFFER_SIZE);
+    const size_t third = BUFFER_SIZE / 3;
+    for (unsigned i = 0; i < 2 * (LOG_FLASH_JOURNAL_MAX_DELTAS + 1); i++) {
+        blob[i % third]++;
+        blob[BUFFER_SIZE - 1 - (i % third)]--;
+
+        TEST_ASSERT_EQUAL(third, FlashJournal_log(&journal, blob, third));
+        TEST_ASSERT_EQUAL(third, flashJournalStrategyLog_skip(&journal, third));
+        TEST_ASSERT_EQUAL(BUFFER_SIZE - 2 * third, FlashJournal_log(&journal, blob + 2 * third, BUFFER_SIZE - 2 * third));
+        TEST_ASSERT_EQUAL(1, FlashJournal_commit(&journal));
+        memcpy(expected, blob, BUFFER_SIZE);
+        verifyBlob();
+
+        if ((i % 4) == 3) {
+            initializeJournal();
+            verifyBlob();
+        }
+    }
+
+    /* a skip must lie within the committed blob */
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_PARAMETER, flashJournalStrategyLog_skip(&journal, BUFFER_SIZE + 1));
+    TEST_ASSERT_EQUAL(BUFFER_SIZE, flashJournalStrategyLog_skip(&journal, BUFFER_SIZE));
+    TEST_ASSERT_EQUAL(1, FlashJournal_commit(&journal));
+    initializeJournal();
+    verifyBlob();
+
+    return CaseNext;
+}
+
+control_t test_logWithoutCommit()
+{
+    if (drv->GetCapabilities().asynchronous_ops) {
+        return CaseNext;
+    }
+
+    /* logged data which isn't committed doesn't replace the committed blob */
+    memset(buffer, 0x55, BUFFER_SIZE);
+    TEST_ASSERT_EQUAL(BUFFER_SIZE, FlashJournal_log(&journal, buffer, BUFFER_SIZE));
+
+    initializeJournal();
+    verifyBlob();
+
+    return CaseNext;
+}
+
+control_t test_powerLoss()
+{
+    if (drv->GetCapabilities().asynchronous_ops) {
+        return CaseNext;
+    }
+
+    /* a small ring makes the log wrap around, and sectors holding part of
+     * the committed state get erased, within a few commits */
+    ARM_STORAGE_INFO mtdInfo;
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, drv->GetInfo(&mtdInfo));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, drv->GetNextBlock(NULL, &powerLossBlock));
+    uint64_t blockSize   = powerLossBlock.size;
+    uint32_t sectors     = POWER_LOSS_SECTORS;
+    powerLossUnit        = (mtdInfo.program_unit > 1) ? mtdInfo.program_unit : 1;
+    powerLossRestore();
+    int32_t rc;
+    do {
+        /* small sectors may need a few more of them to hold a record */
+        if (blockSize < sectors * powerLossBlock.attributes.erase_unit) {
+            printf("test_powerLoss: first storage block too small, skipping\n");
+            return CaseNext;
+        }
+        powerLossBlock.size = sectors++ * powerLossBlock.attributes.erase_unit;
+        rc = FlashJournal_initialize(&journal, &powerLossDrv, &FLASH_JOURNAL_STRATEGY_LOG, callbackHandler);
+    } while (rc == JOURNAL_STATUS_BOUNDED_CAPACITY);
+    TEST_ASSERT_EQUAL(1, rc);
+    TEST_ASSERT_EQUAL(1, FlashJournal_reset(&journal));
+    FlashJournal_Info_t info;
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, FlashJournal_getInfo(&journal, &info));
+    size_t size = (info.capacity < POWER_LOSS_BUFFER_SIZE) ? info.capacity : POWER_LOSS_BUFFER_SIZE;
+
+    static uint8_t blob[POWER_LOSS_BUFFER_SIZE];
+    static uint8_t committed[POWER_LOSS_BUFFER_SIZE];
+    memset(blob, 0x5A, sizeof(blob));
+    TEST_ASSERT_EQUAL(size, FlashJournal_log(&journal, blob, size));
+    TEST_ASSERT_EQUAL(1, FlashJournal_commit(&journal));
+    memcpy(committed, blob, size);
+
+    /* cut the power at pseudo-random points of commits writing delta and
+     * base records; each time, the journal must recover either the blob
+     * being committed or the one committed before it */
+    uint32_t random = 1;
+    for (unsigned i = 0; i < 400; i++) {
+        random = random * 1103515245 + 12345;
+        blob[(random >> 8) % size]++;
+        if ((i % 5) == 0) {
+            memset(blob, (uint8_t)i, (random >> 4) % size);
+        }
+
+        random = random * 1103515245 + 12345;
+        powerLossBudget = (int32_t)((random >> 16) % 16);
+        rc = FlashJournal_log(&journal, blob, size);
+        if (rc == (int32_t)size) {
+            rc = FlashJournal_commit(&journal);
+        }
+
+        powerLossRestore();
+        TEST_ASSERT_EQUAL(1, FlashJournal_initialize(&journal, &powerLossDrv, &FLASH_JOURNAL_STRATEGY_LOG, callbackHandler));
+        if ((rc == 1) || journalHolds(blob, size)) {
+            memcpy(committed, blob, size);
+        } else {
+            memcpy(blob, committed, size);
+        }
+        TEST_ASSERT(journalHolds(committed, size));
+    }
+
+    /* the sectors used above no longer hold a journal on 'drv' */
+    initializeJournal();
+    TEST_ASSERT_EQUAL(1, FlashJournal_reset(&journal));
+    initializeJournal();
+    sizeofExpected = 0;
+    verifyBlob();
+
+    return CaseNext;
+}
+
+#ifndef AVOID_GREENTEA
+// Custom setup handler required for proper Greentea support
+utest::v1::status_t greentea_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(60, "default_auto");
+    // Call the default reporting function
+    return greentea_test_setup_handler(number_of_cases);
+}
+#else
+status_t default_setup(const size_t)
+{
+    return STATUS_CONTINUE;
+}
+#endif
+
+// Specify all your test cases here
+Case cases[] = {
+    Case("reset and initialize",                        test_resetAndInitialize),
+    Case("commit and reinitialize",                     test_commitAndReinitialize),
+    Case("partial updates",                             test_partialUpdates),
+    Case("size of last commit",                         test_sizeofLastCommit),
+    Case("change size of blob",                         test_changeSize),
+    Case("skip unchanged data",                         test_skipUnchanged),
+    Case("log without commit",                          test_logWithoutCommit),
+    Case("power loss",                                  test_powerLoss),
+    Case("reset and initialize",                        test_resetAndInitialize),
+};
+
+// Declare your test specification with a custom setup handler
+#ifndef AVOID_GREENTEA
+Specification specification(greentea_setup, cases);
+#else
+Specification specification(default_setup, cases);
+#endif
+
+int main(int argc, char** argv)
+{
+    // Run the test specification
+    Harness::run(specification);
+}
@@ -312,6 +312,16 @@ typedef struct ARM_CFSTORE_CAPABILITIES
 } ARM_CFSTORE_CAPABILITIES;
 
 
+/** @brief   Flush statistics returned from the \ref ARM_CFSTORE_DRIVER (*GetFlushInfo)() function. */
+typedef struct _ARM_CFSTORE_FLUSH_INFO
+{
+    ARM_CFSTORE_SIZE dirty_len;             //!< Number of octets of KV data changed since the last Flush() committed to flash.
+                                            //!< A client can use this to decide when a Flush() is worthwhile.
+    uint32_t last_flush_len;                //!< Number of octets programmed into flash by the last Flush(), 0 if there was nothing to commit.
+    uint64_t total_flush_len;               //!< Number of octets programmed into flash by all Flush() calls since initialisation.
+} ARM_CFSTORE_FLUSH_INFO;
+
+
 /**
  * This is the set of operations constituting the Configuration Store driver.
  *
@@ -869,6 +879,25 @@ typedef struct _ARM_DRIVER_CFSTORE
      */
     int32_t (*Write)(ARM_CFSTORE_HANDLE hkey, const char* data, ARM_CFSTORE_SIZE* len);
 
+
+    /** @brief  Get the flush statistics of the configuration store.
+     *
+     * This synchronous function fills in an ARM_CFSTORE_FLUSH_INFO structure
+     * describing the changes not yet flushed and the flash programmed by
+     * previous flushes. The flush lengths are 0 when there is no flash
+     * backend. There is no callback notification for this call.
+     *
+     * @note    This is the last member of the driver so that clients built
+     *          against an earlier version of this header are unaffected.
+     *
+     * @param   info
+     *          OUT: the structure to fill in.
+     *
+     * @return
+     *          ARM_DRIVER_OK => success, else failure.
+     */
+    int32_t (*GetFlushInfo)(ARM_CFSTORE_FLUSH_INFO* info);
+
 } const ARM_CFSTORE_DRIVER;
 
 
@@ -56,4 +56,35 @@
 #define CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
 #endif
 
+/* CFSTORE_KEY_INDEX_DISABLE
+ *   Disable the in-RAM key index. The index keeps a hash table and a sorted
+ *   list of the KVs in the area so Open() and Find() don't have to walk every
+ *   KV. The index is allocated from the heap.
+ */
+#if CFSTORE_KEY_INDEX_DISABLE==0
+#define CFSTORE_CONFIG_KEY_INDEX_ENABLED
+#endif
+
+/* CFSTORE_AREA_PAGE_SIZE
+ *   Size in bytes of the heap pages holding the KVs in SRAM. Creating,
+ *   resizing or deleting a KV only moves data within the page holding it, so
+ *   this bounds the cost of those operations. KVs larger than a page are
+ *   given a page of their own.
+ */
+#ifndef CFSTORE_AREA_PAGE_SIZE
+#define CFSTORE_AREA_PAGE_SIZE  512
+#endif
+
+/* CFSTORE_JOURNAL_LOG_STRATEGY
+ *   Persist the area with the log-structured flash journal strategy rather
+ *   than the sequential one. A flush then only programs the parts of the area
+ *   which changed since the previous flush, and erases are spread over the
+ *   whole of storage. The log strategy requires a synchronous storage driver,
+ *   and doesn't share its flash format with the sequential strategy so
+ *   changing this setting loses the KVs previously stored on a device.
+ */
+#if defined CFSTORE_CONFIG_BACKEND_FLASH_ENABLED && CFSTORE_JOURNAL_LOG_STRATEGY==1
+#define CFSTORE_CONFIG_JOURNAL_LOG_STRATEGY_ENABLED
+#endif
+
 #endif /*__CFSTORE_CONFIG_H*/
@@ -31,7 +31,13 @@
 #endif /* YOTTA_CFG_CFSTORE_UVISOR */
 
 #ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
+#ifdef CFSTORE_CONFIG_JOURNAL_LOG_STRATEGY_ENABLED
+#include "flash_journal_strategy_log.h"
+#define CFSTORE_FLASH_JOURNAL_STRATEGY          FLASH_JOURNAL_STRATEGY_LOG
+#else
 #include "flash_journal_strategy_sequential.h"
+#define CFSTORE_FLASH_JOURNAL_STRATEGY          FLASH_JOURNAL_STRATEGY_SEQUENTIAL
+#endif /* CFSTORE_CONFIG_JOURNAL_LOG_STRATEGY_ENABLED */
 #include "flash_journal.h"
 #include "Driver_Common.h"
 #endif /* CFSTORE_CONFIG_BACKEND_FLASH_ENABLED */
@@ -62,8 +68,9 @@ ARM_DRIVER_STORAGE *cfstore_storage_drv = &ARM_Driver_Storage_(0);
  * Defines
  *
  * CFSTORE_FLASH_STACK_BUF_SIZE
- *  when performing flush, if the program_unit <= CFSTORE_FLASH_STACK_BUF_SIZE octets then a
- *  stack buffer is used to perform the tail write. Otherwise a buffer is malloced
+ *  when performing flush, the KV data straddling page boundaries and the padding at the end of
+ *  the area are staged in a buffer of this size so that each log() is a multiple of the
+ *  program_unit. The program_unit must not be larger than this value.
  *
  * CFSTORE_FLASH_AREA_SIZE_MIN
  *  valid sizes of areas should always be greater than the size of the header, and therefore
@@ -142,6 +149,41 @@ typedef struct cfstore_area_header_t
 } cfstore_area_header_t;
 
 
+/* @brief   page of the sram area holding KVs. The KV data follows the struct.
+ *
+ * @param   node
+ *          node on the cfstore_ctx_t::area_0_pages list, which is in area order.
+ *
+ * @param   seq
+ *          sequence number increasing along the page list so that the area
+ *          order of KVs in different pages can be determined without walking
+ *          the list.
+ *
+ * @param   size
+ *          size of the memory following the struct for KV data.
+ *
+ * @param   used
+ *          number of bytes of KV data in the page. KVs are packed from the
+ *          start of the page data without gaps.
+ *
+ * @param   flash_offset
+ *          offset of the page data in the blob last committed to flash, or
+ *          CFSTORE_AREA_PAGE_DIRTY if the page has changed since. A flush
+ *          with the log strategy doesn't log the pages which are unchanged
+ *          and at the same offset.
+ */
+typedef struct cfstore_area_page_t
+{
+    cfstore_list_node_t node;
+    uint32_t seq;
+    uint32_t size;
+    uint32_t used;
+    uint32_t flash_offset;
+} cfstore_area_page_t;
+
+#define CFSTORE_AREA_PAGE_DIRTY     0xffffffff
+
+
 /* helper struct */
 typedef struct cfstore_area_hkvt_t
 {
@@ -149,6 +191,7 @@ typedef struct cfstore_area_hkvt_t
     uint8_t *key;
     uint8_t *value;
     uint8_t *tail;
+    cfstore_area_page_t *page;
 } cfstore_area_hkvt_t;
 
 
@@ -256,14 +299,16 @@ static int32_t cfstore_get_key_name_ex(cfstore_area_hkvt_t *hkvt, char* key_name
  * - Walking the KVs in area_0 is performed using the header structures,
  *   which contain key and value lengths required to find the start of the
  *   next hkvt. These must not change under the client.
- * - The Find() walk is terminated when the hkvt header pointer is found to
- *   point to cfstore_ctx_g.area_0_tail i.e. when this arises then the
- *   iterator knows its come to the end of the hkvt's in the area.
+ * - KVs are stored in a list of pages (see cfstore_area_page_t). The Find()
+ *   walk moves to the next page when the hkvt tail pointer reaches the end
+ *   of the data used in the page, and is terminated at the end of the last
+ *   page i.e. when this arises then the iterator knows its come to the end
+ *   of the hkvt's in the area.
  * - When inserting a new KV, the last operation to be performed is to
- *   update cfstore_ctx_g.area_0_tail to point to the new tail. This
- *   operation also reveals the new KV to other operations including
- *   the Find(). All the header, key, value and tail data for the
- *   HKVT must be setup correctly before the tail pointer is updated.
+ *   update the used count of the page holding it. This operation also
+ *   reveals the new KV to other operations including the Find(). All the
+ *   header, key, value and tail data for the HKVT must be setup correctly
+ *   before the used count is updated.
  *
  * Memory Management (todo: future support)
  * Implementation Note 2 [NOTE2]
@@ -291,6 +336,9 @@ static int32_t cfstore_get_key_name_ex(cfstore_area_hkvt_t *hkvt, char* key_name
  *     creating handles.
  * - currently neither target.json nor config.json allow a symbol in yotta_config.h to be defined
  *   for the current case of CFSTORE being a yotta module/library.
+ * - the partial slab support keyed on CFSTORE_YOTTA_CFG_CFSTORE_SRAM_ADDR, which no build
+ *   configuration defined, was removed when the area was split into pages. Slab support would
+ *   now mean carving the area pages out of the slab in place of CFSTORE_MALLOC().
  *
  * UVISOR Integration (todo)
  * Implementation Note 3 [NOTE3]
@@ -320,31 +368,29 @@ static int32_t cfstore_get_key_name_ex(cfstore_area_hkvt_t *hkvt, char* key_name
 /*
  * @brief   CS global context that maintains state
  *
- * @param   area_0_start
- *          pointer to start of malloc-ed memory block for containing area_0
- *
- * @param   area_0_head
- *          pointer to area_0 header struct within the memblock.
- *          - ((cfstore_area_header_t*) area_0)->refcount is the number of
- *            open handles in the whole of area_0.
+ * @param   area_0_pages
+ *          list of cfstore_area_page_t holding the KVs of area_0. The area
+ *          is the concatenation of the data of the pages in list order.
+ *          Pages hold up to CFSTORE_AREA_PAGE_SIZE bytes of KVs so that
+ *          creating, resizing and deleting a KV only moves data within one
+ *          page, and pages are freed as soon as they are empty.
  *          - accessed in app & intr context; hence needs CS protection.
  *
- * @param   area_0_tail
- *          pointer to address in the sram after the last byte of the last
- *          KV. Note there can be padding after the area_0_tail to align the
- *          sram area with flash program_unit (or 1 if SRAM only version)
- *          to facilitate reading/writing to flash.
+ * @param   area_0_len
+ *          number of bytes of KV data in area_0 i.e. the sum of the used
+ *          bytes of the pages. When flushed to flash the area is padded to
+ *          a multiple of the flash program_unit (or 1 if SRAM only version).
  *          - accessed in app & intr context; hence needs CS protection.
  *
- * @param   area_0_end
- *          pointer to end area_0 of area_0 memblock (last memory address).
+ * @param   area_0_seq
+ *          sequence number for the next page appended to area_0_pages.
  *
  * @param   rw_area0_lock
  *          lock used to make CS re-entrant e.g. only 1 flush operation can be
  *          performed at a time while no readers/writers have handles open
  *          to KVs. The lock is to protect access to the following:
- *          - cfstore_ctx_g.area_0_head/cfstore_ctx_g.area_0_tail. Realloc()
- *            in Delete() and Create() can cause these pointers to change.
+ *          - cfstore_ctx_g.area_0_pages. Delete() and Create() can move KVs
+ *            within and between pages.
  *
  * @param   client_notify_data
  *          fsm handler functions set a flag for a client notification call
@@ -355,7 +401,15 @@ static int32_t cfstore_get_key_name_ex(cfstore_area_hkvt_t *hkvt, char* key_name
  *          flag indicating that the area has been written and therefore is
  *          dirty with respect to the data persisted to flash.
  *
- * @expected_blob_size  expected_blob_size = area_0_tail - area_0_head + pad
+ * @param   area_dirty_len
+ *          number of bytes of KV data changed since the last commit to flash,
+ *          reported by GetFlushInfo() so clients can decide when to Flush().
+ *
+ * @param   index
+ *          in-RAM index of the KVs in the area, see cfstore_index_t. Modified
+ *          together with the area so needs the same CS protection.
+ *
+ * @expected_blob_size  expected_blob_size = area_0_len + pad
  *          In the case of reading from flash into sram, this will be be size
  *          of the flash blob (rounded to a multiple program_unit if not
  *          already so).
@@ -363,15 +417,82 @@ static int32_t cfstore_get_key_name_ex(cfstore_area_hkvt_t *hkvt, char* key_name
  *          plus padding so the sram blob size is a multiple of flash
  *          program_unit.
  *          - accessed in app & intr context; hence needs CS protection.
+ *
+ * @param   log_page, log_offset
+ *          position in the area of the next data to be logged by the flush.
+ *
+ * @param   log_len
+ *          number of bytes of the area (including padding) logged so far by
+ *          the flush.
+ *
+ * @param   log_req
+ *          size of the FlashJournal_log() request in progress.
+ *
+ * @param   log_buf
+ *          buffer used to log the data straddling page boundaries and the
+ *          padding at the end of the area. log_from_buf is set when the
+ *          request in progress is from log_buf rather than a page.
+ *
+ * @param   flush_bytes, flush_bytes_total
+ *          number of bytes programmed into flash by the last flush (0 if
+ *          there was nothing to commit) and by all flushes since
+ *          initialisation, as reported by the flash journal and returned by
+ *          GetFlushInfo().
+ */
+/*
+ * @brief   in-RAM index of the KVs stored in the area.
+ *
+ * KVs are identified by their page and header pointer. When a KV is moved
+ * within or between pages its entries are updated (see cfstore_index_move()),
+ * which only concerns the KVs of the pages involved.
+ *
+ * @param   table
+ *          open addressing hash table keyed on the key name. A slot with a
+ *          NULL head is empty. Used for exact key lookups.
+ * @param   table_size
+ *          number of slots in table, always a power of 2.
+ * @param   sorted
+ *          KVs sorted by key name so that the KVs matching a query with a
+ *          literal prefix are found with a binary search.
+ * @param   sorted_size
+ *          number of entries allocated for sorted.
+ * @param   count
+ *          number of KVs in the index.
+ * @param   valid
+ *          the index reflects the area. If memory for the index couldn't
+ *          be allocated, the index is dropped and lookups walk the area.
  */
+#ifdef CFSTORE_CONFIG_KEY_INDEX_ENABLED
+typedef struct cfstore_index_entry_t
+{
+    cfstore_area_page_t *page;
+    uint8_t *head;
+} cfstore_index_entry_t;
+
+typedef struct cfstore_index_t
+{
+    cfstore_index_entry_t *table;
+    uint32_t table_size;
+    cfstore_index_entry_t *sorted;
+    uint32_t sorted_size;
+    uint32_t count;
+    bool valid;
+} cfstore_index_t;
+#endif /* CFSTORE_CONFIG_KEY_INDEX_ENABLED */
+
+
 typedef struct cfstore_ctx_t
 {
     cfstore_list_node_t file_list;
     int32_t init_ref_count;
     CFSTORE_LOCK rw_area0_lock;
     ARM_POWER_STATE power_state;
-    uint8_t *area_0_head;
-    uint8_t *area_0_tail;
+    cfstore_list_node_t area_0_pages;
+    ARM_CFSTORE_SIZE area_0_len;
+    uint32_t area_0_seq;
+#ifdef CFSTORE_CONFIG_KEY_INDEX_ENABLED
+    cfstore_index_t index;
+#endif /* CFSTORE_CONFIG_KEY_INDEX_ENABLED */
     cfstore_fsm_t fsm;
     int32_t status;
 
@@ -384,6 +505,7 @@ typedef struct cfstore_ctx_t
     uint32_t client_callback_notify_flag : 1;
     uint32_t area_dirty_flag : 1;
     uint32_t f_reserved0 : 30;
+    ARM_CFSTORE_SIZE area_dirty_len;
 
 #ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
     /* flash journal related data */
@@ -391,6 +513,18 @@ typedef struct cfstore_ctx_t
     FlashJournal_Info_t info;
     FlashJournal_OpCode_t cmd_code;
     uint64_t expected_blob_size;
+
+    /* chunked logging of the area */
+    cfstore_area_page_t *log_page;
+    uint32_t log_offset;
+    uint64_t log_len;
+    uint32_t log_req;
+    bool log_from_buf;
+    uint8_t log_buf[CFSTORE_FLASH_STACK_BUF_SIZE];
+
+    /* flush statistics */
+    uint32_t flush_bytes;
+    uint64_t flush_bytes_total;
 #endif /* CFSTORE_CONFIG_BACKEND_FLASH_ENABLED */
 } cfstore_ctx_t;
 
@@ -399,7 +533,8 @@ typedef struct cfstore_ctx_t
  * @brief   file structure for KV, one per open file handle.
  *
  * @param   head
- *          pointer to head of KV
+ *          pointer to head of KV. The page holding the KV is found from it
+ *          (see cfstore_area_page_find()) to keep the handle small.
  *
  * @param   rlocation
  *          read location of rseek to move
@@ -456,8 +591,10 @@ static cfstore_ctx_t cfstore_ctx_g = {
         .init_ref_count = 0,
         .rw_area0_lock = 0,
         .power_state = ARM_POWER_FULL,
-        .area_0_head = NULL,
-        .area_0_tail = NULL,
+        .area_0_pages.next = NULL,
+        .area_0_pages.prev = NULL,
+        .area_0_len = 0,
+        .area_0_seq = 0,
         .client_callback = NULL,
         .client_context = NULL,
         .f_reserved0 = 0,
@@ -573,15 +710,20 @@ static void cfstore_client_notify_data_init(cfstore_client_notify_data_t* data,
  * cfstore_ctx_t methods
  */
 
+static void cfstore_index_free(cfstore_ctx_t* ctx);
+static void cfstore_area_free(cfstore_ctx_t* ctx);
+
+#ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
 /* @brief   helper function to reset cfstore_ctx_g state when out of memory is received from malloc */
 static void cfstore_ctx_reset(cfstore_ctx_t* ctx)
 {
     CFSTORE_ASSERT(ctx!= NULL);
     CFSTORE_INIT_LIST_HEAD(&ctx->file_list);
-    ctx->area_0_head = NULL;
-    ctx->area_0_tail = NULL;
+    cfstore_area_free(ctx);
+    cfstore_index_free(ctx);
     return;
 }
+#endif /* CFSTORE_CONFIG_BACKEND_FLASH_ENABLED */
 
 /* @brief   helper function to report whether the initialisation flag has been set in the cfstore_ctx_g */
 static bool cfstore_ctx_is_initialised(cfstore_ctx_t* ctx)
@@ -602,15 +744,33 @@ static inline cfstore_ctx_t* cfstore_ctx_get(void)
 #endif
 }
 
+/* @brief   helper function to mark the area dirty so the changes are persisted
+ *          to backing store when flushed. len is the number of bytes changed. */
+static void cfstore_ctx_set_dirty(cfstore_ctx_t* ctx, ARM_CFSTORE_SIZE len)
+{
+    ctx->area_dirty_flag = true;
+    ctx->area_dirty_len = ctx->area_dirty_len + len < ctx->area_dirty_len ? (ARM_CFSTORE_SIZE) -1 : ctx->area_dirty_len + len;
+}
+
+/* @brief   helper function to mark a page as changed since the last commit */
+static CFSTORE_INLINE void cfstore_area_page_set_dirty(cfstore_area_page_t* page)
+{
+    if(page != NULL){
+        page->flash_offset = CFSTORE_AREA_PAGE_DIRTY;
+    }
+}
+
+#ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
 /* @brief   helper function to compute the size of the sram area in bytes */
 static ARM_CFSTORE_SIZE cfstore_ctx_get_area_len(void)
 {
     ARM_CFSTORE_SIZE size = 0;
     cfstore_ctx_t* ctx = cfstore_ctx_get();
 
-    size = (ARM_CFSTORE_SIZE) (ctx->area_0_tail - ctx->area_0_head);
+    size = ctx->area_0_len;
     return size;
 }
+#endif /* CFSTORE_CONFIG_BACKEND_FLASH_ENABLED */
 
 /* @brief   helper function to get the program_unit */
 static inline uint32_t cfstore_ctx_get_program_unit(cfstore_ctx_t* ctx)
@@ -637,100 +797,30 @@ static inline void cfstore_ctx_client_notify(cfstore_ctx_t* ctx, cfstore_client_
 }
 
 /*
- * CFSTORE_YOTTA_CFG_CFSTORE_SRAM_ADDR
- *  client can supply a SRAM slab address and size for
- *  CFSTORE internal use. This is a default addr
- *  for development use. Should be defined by client
- * CFSTORE_YOTTA_CFG_CFSTORE_SRAM_SIZE
- *  size of sram area. Should be define by client
+ * memory allocation for the area pages, traced in debug builds
  */
-#ifndef CFSTORE_YOTTA_CFG_CFSTORE_SRAM_ADDR
-/* if the client doesnt provide a memory slab then CFSTORE uses realloc internally*/
-
 #ifndef CFSTORE_DEBUG
 #define CFSTORE_FREE        free
 #define CFSTORE_MALLOC      malloc
-#define CFSTORE_REALLOC     realloc
 #else
 
-static uint32_t cfstore_malloc_size_g = 0;
-#define CFSTORE_MALLOC      malloc
-
-static void* CFSTORE_REALLOC(void *ptr, size_t size)
+static void* CFSTORE_MALLOC(size_t size)
 {
     void* mem;
 
-    mem = realloc(ptr, size);
-    CFSTORE_TP(CFSTORE_TP_MEM, "%s:ptr=%p, mem=%p, old_size=%u, new_size=%u.\n", __func__, ptr, mem, (int) cfstore_malloc_size_g, (int) size);
-    cfstore_malloc_size_g = size;
+    mem = malloc(size);
+    CFSTORE_TP(CFSTORE_TP_MEM, "%s:mem=%p, size=%u.\n", __func__, mem, (int) size);
     return mem;
 }
 
 static void CFSTORE_FREE(void *ptr)
 {
     free(ptr);
-    CFSTORE_TP(CFSTORE_TP_MEM, "%s:ptr=%p, old_size=%u, new_size=%u.\n", __func__, ptr, (int) cfstore_malloc_size_g, 0);
-    cfstore_malloc_size_g = 0;
+    CFSTORE_TP(CFSTORE_TP_MEM, "%s:ptr=%p.\n", __func__, ptr);
     return;
 }
 #endif /* CFSTORE_DEBUG */
 
-/* memory tracking */
-
-#else
-#define CFSTORE_FREE        CFSTORE_ASSERT(0)
-#define CFSTORE_MALLOC      CFSTORE_ASSERT(0)
-#define CFSTORE_REALLOC     cfstore_realloc
-
-
-
-/* function to realloc from a client provided memory slab
- * size = new size of area used by sram
- * ptr is always head of slab
- *
- * The cfstore_realloc() function changes the size of the memory
- * block pointed to by ptr to size bytes, backed by the client
- * provided memory slab. The contents will be unchanged in the
- * range from the start of the region up to the minimum of the
- * old and new sizes. If the new size is larger than the old size,
- * the added memory will not be initialized.
- *
- * ptr
- * ptr should be set to null on the first call to this function and
- * for size > 0 && size <= CFSTORE_YOTTA_CFG_CFSTORE_SRAM_SIZE
- * CFSTORE_YOTTA_CFG_CFSTORE_SRAM_ADDR will be returned.
- * On subsequent calls, ptr must have been returned by an earlier
- * call to this function.
- *
- * size
- * if size is equal to zero, and ptr is not NULL, then the call is
- * equivalent to reseting the memory area and NULL will be returned.
- */
-void *cfstore_realloc(void *ptr, ARM_CFSTORE_SIZE size)
-{
-    static uint8_t *cfstore_sram_head = NULL;
-    static uint8_t *cfstore_sram_tail = NULL;
-
-    if(size > 0) {
-        if(size <= CFSTORE_YOTTA_CFG_CFSTORE_SRAM_SIZE) {
-            if(ptr == NULL) {
-                memset(CFSTORE_YOTTA_CFG_CFSTORE_SRAM_ADDR, 0, CFSTORE_YOTTA_CFG_CFSTORE_SRAM_SIZE);
-                cfstore_sram_head = CFSTORE_YOTTA_CFG_CFSTORE_SRAM_ADDR;
-            }
-            cfstore_sram_tail = cfstore_sram_head + size;
-            return (void*) cfstore_sram_head;
-        }
-        /* requested size is too big so fail the operation by setting
-         * head/tail to NULL */
-    }
-    /* size == 0 => reset */
-    cfstore_sram_head = NULL;
-    cfstore_sram_tail = NULL;
-    return (void*) cfstore_sram_head;
-}
-
-#endif /* CFSTORE_YOTTA_CFG_CFSTORE_SRAM_ADDR */
-
 
 #ifdef TARGET_LIKE_X86_LINUX_NATIVE
 static inline void cfstore_critical_section_init(CFSTORE_LOCK* lock){ *lock = 0; }
@@ -744,6 +834,7 @@ static CFSTORE_INLINE int32_t cfstore_hkvt_refcount_dec(cfstore_area_hkvt_t* hkv
 
     __refcount =__sync_fetch_and_sub(&hdr->refcount, 1);
     if(refcount) *refcount = __refcount;
+    cfstore_area_page_set_dirty(hkvt->page);
     return ARM_DRIVER_OK;
 }
 
@@ -755,6 +846,7 @@ static CFSTORE_INLINE int32_t cfstore_hkvt_refcount_inc(cfstore_area_hkvt_t* hkv
 
     if( (__refcount = __sync_fetch_and_add(&hdr->refcount, 1)) < CFSTORE_LOCK_REFCOUNT_MAX) {
         if(refcount) *refcount = __refcount;
+        cfstore_area_page_set_dirty(hkvt->page);
         ret = ARM_DRIVER_OK;
     } else {
         /* maximum count reach, back down and return error*/
@@ -798,6 +890,7 @@ static CFSTORE_INLINE int32_t cfstore_hkvt_refcount_dec(cfstore_area_hkvt_t* hkv
     /* todo: put mbedosv3++ critical section enter here */
     hdr->refcount--;
     if(refcount) *refcount = hdr->refcount;
+    cfstore_area_page_set_dirty(hkvt->page);
     /* todo: put mbedosv3++ critical section exit here */
     return ARM_DRIVER_OK;
 }
@@ -812,6 +905,7 @@ static CFSTORE_INLINE int32_t cfstore_hkvt_refcount_inc(cfstore_area_hkvt_t* hkv
     {
         hdr->refcount++;
         if(refcount) *refcount = hdr->refcount;
+        cfstore_area_page_set_dirty(hkvt->page);
         ret = ARM_DRIVER_OK;
     }
     /* todo: put mbedosv3++ critical section exit here */
@@ -1161,6 +1255,7 @@ static CFSTORE_INLINE void cfstore_hkvt_set_flags_delete(cfstore_area_hkvt_t *hk
 {
     CFSTORE_ASSERT(hkvt != NULL);
     ((cfstore_area_header_t*) hkvt->head)->flags.delete = flag;
+    cfstore_area_page_set_dirty(hkvt->page);
 }
 
 
@@ -1199,9 +1294,9 @@ static CFSTORE_INLINE void cfstore_hkvt_init(cfstore_area_hkvt_t* hkvt)
 }
 
 
-static CFSTORE_INLINE bool cfstore_hkvt_is_valid(cfstore_area_hkvt_t *hkvt, uint8_t *area_0_tail)
+static CFSTORE_INLINE bool cfstore_hkvt_is_valid(cfstore_area_hkvt_t *hkvt)
 {
-    if(hkvt->head && hkvt->head != area_0_tail && hkvt->key && hkvt->value && hkvt->tail) {
+    if(hkvt->head && hkvt->key && hkvt->value && hkvt->tail && hkvt->page) {
         return true;
     }
     return false;
@@ -1215,16 +1310,54 @@ static CFSTORE_INLINE uint32_t cfstore_hkvt_set_value_len(cfstore_area_hkvt_t* h
     hdr = (cfstore_area_header_t*) hkvt->head;
     vlength = hdr->vlength;
     hdr->vlength = value_len;
+    cfstore_area_page_set_dirty(hkvt->page);
     return vlength;
 }
 
+/* @brief   helper function to get the KV data of a page */
+static CFSTORE_INLINE uint8_t* cfstore_area_page_get_data(cfstore_area_page_t* page)
+{
+    return (uint8_t*) (page + 1);
+}
+
+/* @brief   helper function to get the first page holding KVs at or after node in the page list,
+ *          or NULL if there are no more pages */
+static cfstore_area_page_t* cfstore_area_page_get_next(cfstore_ctx_t* ctx, cfstore_list_node_t* node)
+{
+    /* pages only remain empty while a KV is being inserted (see [NOTE1]) */
+    while(node != &ctx->area_0_pages){
+        if(((cfstore_area_page_t*) node)->used > 0){
+            return (cfstore_area_page_t*) node;
+        }
+        node = node->next;
+    }
+    return NULL;
+}
+
+/* @brief   helper function to get the page holding the KV at head, or NULL if head
+ *          isn't the start of KV data in any page */
+static cfstore_area_page_t* cfstore_area_page_find(cfstore_ctx_t* ctx, uint8_t* head)
+{
+    cfstore_list_node_t* node = ctx->area_0_pages.next;
+    cfstore_area_page_t* page = NULL;
+
+    while(node != NULL && node != &ctx->area_0_pages){
+        page = (cfstore_area_page_t*) node;
+        if(head >= cfstore_area_page_get_data(page) && head < cfstore_area_page_get_data(page) + page->used){
+            return page;
+        }
+        node = node->next;
+    }
+    return NULL;
+}
+
 /* @brief   helper function to detect if there are any KV's stored in the sram area */
 static bool cfstore_area_has_hkvt(void)
 {
     cfstore_ctx_t* ctx = cfstore_ctx_get();
 
-    /* head and tail pointer equal means there are no KVs stored */
-    if(ctx->area_0_head == ctx->area_0_tail){
+    /* zero area length means there are no KVs stored */
+    if(ctx->area_0_len == 0){
         /* there are no KV's stored*/
         return false;
     }
@@ -1232,8 +1365,8 @@ static bool cfstore_area_has_hkvt(void)
 }
 
 
-/* @brief   helper function to get the first KV in the sram area */
-static cfstore_area_hkvt_t cfstore_get_hkvt_from_head_ptr(uint8_t* head)
+/* @brief   helper function to get the KV at head in page */
+static cfstore_area_hkvt_t cfstore_get_hkvt_from_head_ptr(cfstore_area_page_t* page, uint8_t* head)
 {
     cfstore_area_hkvt_t hkvt;
 
@@ -1243,6 +1376,7 @@ static cfstore_area_hkvt_t cfstore_get_hkvt_from_head_ptr(uint8_t* head)
     hkvt.key = hkvt.head + sizeof(cfstore_area_header_t);
     hkvt.value = hkvt.key + ((cfstore_area_header_t*) hkvt.head)->klength;
     hkvt.tail = hkvt.value + ((cfstore_area_header_t*) hkvt.head)->vlength;
+    hkvt.page = page;
     return hkvt;
 }
 
@@ -1251,13 +1385,14 @@ static cfstore_area_hkvt_t cfstore_get_hkvt_from_head_ptr(uint8_t* head)
 static cfstore_area_hkvt_t cfstore_get_hkvt(ARM_CFSTORE_HANDLE hkey)
 {
     cfstore_file_t* file = (cfstore_file_t*) hkey;
-    return cfstore_get_hkvt_from_head_ptr((uint8_t*) file->head);
+    return cfstore_get_hkvt_from_head_ptr(cfstore_area_page_find(cfstore_ctx_get(), file->head), (uint8_t*) file->head);
 }
 
 
 /* @brief   helper function to convert a opaque handle to a struct cfstore_area_hkvt_t */
 static int32_t cfstore_get_head_hkvt(cfstore_area_hkvt_t* hkvt)
 {
+    cfstore_area_page_t* page = NULL;
     cfstore_ctx_t* ctx = cfstore_ctx_get();
 
     CFSTORE_FENTRYLOG("%s:entered\n", __func__);
@@ -1269,7 +1404,9 @@ static int32_t cfstore_get_head_hkvt(cfstore_area_hkvt_t* hkvt)
     }
 
     CFSTORE_TP(CFSTORE_TP_VERBOSE1, "%s:CFSTORE has KVs\n", __func__);
-    *hkvt = cfstore_get_hkvt_from_head_ptr(ctx->area_0_head);
+    page = cfstore_area_page_get_next(ctx, ctx->area_0_pages.next);
+    CFSTORE_ASSERT(page != NULL);
+    *hkvt = cfstore_get_hkvt_from_head_ptr(page, cfstore_area_page_get_data(page));
     return ARM_DRIVER_OK;
 }
 
@@ -1284,21 +1421,616 @@ static int32_t cfstore_get_head_hkvt(cfstore_area_hkvt_t* hkvt)
  */
 static int32_t cfstore_get_next_hkvt(cfstore_area_hkvt_t* prev, cfstore_area_hkvt_t* next)
 {
+    cfstore_area_page_t* page = NULL;
     cfstore_ctx_t* ctx = cfstore_ctx_get();
 
 	CFSTORE_ASSERT(prev != NULL);
     CFSTORE_ASSERT(next != NULL);
 
-    if(prev->tail == ctx->area_0_tail){
-        CFSTORE_TP(CFSTORE_TP_VERBOSE1, "%s:reached the end of the list. return NULL entry\n", __func__);
+    page = prev->page;
+    if(prev->tail == cfstore_area_page_get_data(page) + page->used){
+        /* end of the page so continue with the first KV of the next page */
+        page = cfstore_area_page_get_next(ctx, page->node.next);
+        if(page == NULL){
+            CFSTORE_TP(CFSTORE_TP_VERBOSE1, "%s:reached the end of the list. return NULL entry\n", __func__);
+            memset((void*) next, 0, sizeof(cfstore_area_hkvt_t));
+            return ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND;
+        }
+        *next = cfstore_get_hkvt_from_head_ptr(page, cfstore_area_page_get_data(page));
+        return ARM_DRIVER_OK;
+    }
+    /* use the prev tail pointer to find the next head pointer */
+    *next = cfstore_get_hkvt_from_head_ptr(page, (uint8_t*) prev->tail);
+    return ARM_DRIVER_OK;
+}
+
+
+/*
+ * Key index
+ *
+ * See cfstore_index_t. All functions require the rw_area0_lock to be held by
+ * the caller (or to be called in a context where the area cannot change).
+ */
+
+#ifdef CFSTORE_CONFIG_KEY_INDEX_ENABLED
+
+#define CFSTORE_INDEX_TABLE_SIZE_MIN    8
+
+/* @brief   FNV-1a hash of a key name */
+static uint32_t cfstore_index_hash(const uint8_t* key, uint8_t key_len)
+{
+    uint32_t hash = 2166136261u;
+
+    while(key_len-- > 0){
+        hash ^= *key++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static CFSTORE_INLINE cfstore_area_header_t* cfstore_index_get_header(cfstore_index_entry_t* entry)
+{
+    return (cfstore_area_header_t*) entry->head;
+}
+
+static CFSTORE_INLINE const uint8_t* cfstore_index_get_key(cfstore_index_entry_t* entry)
+{
+    return entry->head + sizeof(cfstore_area_header_t);
+}
+
+static CFSTORE_INLINE uint32_t cfstore_index_entry_hash(cfstore_index_entry_t* entry)
+{
+    return cfstore_index_hash(cfstore_index_get_key(entry), cfstore_index_get_header(entry)->klength);
+}
+
+/* @brief   compare the key of the KV of entry with key */
+static int32_t cfstore_index_compare(cfstore_index_entry_t* entry, const uint8_t* key, uint8_t key_len)
+{
+    int32_t ret = 0;
+    uint8_t len = cfstore_index_get_header(entry)->klength;
+
+    ret = memcmp(cfstore_index_get_key(entry), key, len < key_len ? len : key_len);
+    if(ret == 0){
+        ret = (int32_t) len - (int32_t) key_len;
+    }
+    return ret;
+}
+
+/* @brief   report whether the KV at (page, head) is located before the KV of entry in the area */
+static CFSTORE_INLINE bool cfstore_index_is_before(cfstore_area_page_t* page, uint8_t* head, cfstore_index_entry_t* entry)
+{
+    return page->seq < entry->page->seq || (page == entry->page && head < entry->head);
+}
+
+/* @brief   return the position of the first entry in the sorted list which
+ *          is not less than key */
+static uint32_t cfstore_index_lower_bound(cfstore_ctx_t* ctx, const uint8_t* key, uint8_t key_len)
+{
+    uint32_t lo = 0;
+    uint32_t hi = ctx->index.count;
+
+    while(lo < hi){
+        uint32_t mid = lo + (hi - lo) / 2;
+        if(cfstore_index_compare(&ctx->index.sorted[mid], key, key_len) < 0){
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void cfstore_index_free(cfstore_ctx_t* ctx)
+{
+    free(ctx->index.table);
+    free(ctx->index.sorted);
+    memset(&ctx->index, 0, sizeof(ctx->index));
+}
+
+static void cfstore_index_table_add(cfstore_index_t* index, uint32_t hash, cfstore_index_entry_t* entry)
+{
+    uint32_t mask = index->table_size - 1;
+    uint32_t i = hash & mask;
+
+    while(index->table[i].head != NULL){
+        i = (i + 1) & mask;
+    }
+    index->table[i] = *entry;
+}
+
+/* @brief   find the table slot and sorted list position of the KV hkvt.
+ *          The KV must be in the index and at the location recorded by it. */
+static void cfstore_index_locate(cfstore_ctx_t* ctx, cfstore_area_hkvt_t* hkvt, uint32_t* slot, uint32_t* pos)
+{
+    uint32_t i = 0;
+    uint32_t mask = ctx->index.table_size - 1;
+    uint8_t key_len = cfstore_hkvt_get_key_len(hkvt);
+    cfstore_index_t* index = &ctx->index;
+
+    i = cfstore_index_hash(hkvt->key, key_len) & mask;
+    while(index->table[i].head != NULL && index->table[i].head != hkvt->head){
+        i = (i + 1) & mask;
+    }
+    CFSTORE_ASSERT(index->table[i].head == hkvt->head);
+    *slot = i;
+
+    /* keys are unique apart from KVs being deleted, so the run of equal keys is short */
+    i = cfstore_index_lower_bound(ctx, hkvt->key, key_len);
+    while(i < index->count && index->sorted[i].head != hkvt->head){
+        i++;
+    }
+    CFSTORE_ASSERT(i < index->count);
+    *pos = i;
+}
+
+/* @brief   grow the index so another entry can be added */
+static int32_t cfstore_index_grow(cfstore_ctx_t* ctx)
+{
+    uint32_t i = 0;
+    uint32_t size = 0;
+    cfstore_index_entry_t *table = NULL;
+    cfstore_index_entry_t *sorted = NULL;
+    cfstore_index_t* index = &ctx->index;
+
+    if(index->count + 1 > index->sorted_size){
+        size = index->sorted_size ? 2 * index->sorted_size : CFSTORE_INDEX_TABLE_SIZE_MIN;
+        sorted = (cfstore_index_entry_t*) realloc(index->sorted, size * sizeof(cfstore_index_entry_t));
+        if(sorted == NULL){
+            return ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY;
+        }
+        index->sorted = sorted;
+        index->sorted_size = size;
+    }
+
+    /* keep the table at most 3/4 full so probe sequences stay short */
+    if(4 * (index->count + 1) > 3 * index->table_size){
+        size = index->table_size ? 2 * index->table_size : CFSTORE_INDEX_TABLE_SIZE_MIN;
+        table = (cfstore_index_entry_t*) calloc(size, sizeof(cfstore_index_entry_t));
+        if(table == NULL){
+            return ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY;
+        }
+        free(index->table);
+        index->table = table;
+        index->table_size = size;
+        for(i = 0; i < index->count; i++){
+            cfstore_index_table_add(index, cfstore_index_entry_hash(&index->sorted[i]), &index->sorted[i]);
+        }
+    }
+    return ARM_DRIVER_OK;
+}
+
+/* @brief   add the KV hkvt to the index. If the index cannot be grown it
+ *          is dropped and lookups revert to walking the area. */
+static void cfstore_index_insert(cfstore_ctx_t* ctx, cfstore_area_hkvt_t* hkvt)
+{
+    uint32_t pos = 0;
+    uint8_t key_len = cfstore_hkvt_get_key_len(hkvt);
+    cfstore_index_entry_t entry;
+    cfstore_index_t* index = &ctx->index;
+
+    if(!index->valid){
+        return;
+    }
+    if(cfstore_index_grow(ctx) < ARM_DRIVER_OK){
+        CFSTORE_TP(CFSTORE_TP_CREATE, "%s:out of memory for key index, dropping it\n", __func__);
+        cfstore_index_free(ctx);
+        return;
+    }
+    entry.page = hkvt->page;
+    entry.head = hkvt->head;
+    cfstore_index_table_add(index, cfstore_index_hash(hkvt->key, key_len), &entry);
+    pos = cfstore_index_lower_bound(ctx, hkvt->key, key_len);
+    memmove(&index->sorted[pos+1], &index->sorted[pos], (index->count - pos) * sizeof(cfstore_index_entry_t));
+    index->sorted[pos] = entry;
+    index->count++;
+}
+
+/* @brief   remove the KV hkvt from the index. Must be called before the
+ *          KV is removed from the area. */
+static void cfstore_index_remove(cfstore_ctx_t* ctx, cfstore_area_hkvt_t* hkvt)
+{
+    uint32_t i = 0;
+    uint32_t j = 0;
+    uint32_t home = 0;
+    uint32_t pos = 0;
+    uint32_t mask = 0;
+    cfstore_index_t* index = &ctx->index;
+
+    if(!index->valid || index->count == 0){
+        return;
+    }
+    mask = index->table_size - 1;
+    cfstore_index_locate(ctx, hkvt, &i, &pos);
+
+    /* backward shift deletion keeps the probe sequences of the following
+     * entries intact without the need for tombstones */
+    index->table[i].head = NULL;
+    j = i;
+    for(;;){
+        j = (j + 1) & mask;
+        if(index->table[j].head == NULL){
+            break;
+        }
+        home = cfstore_index_entry_hash(&index->table[j]) & mask;
+        /* move the entry into the hole if the hole lies on its probe sequence */
+        if(((j - home) & mask) >= ((j - i) & mask)){
+            index->table[i] = index->table[j];
+            index->table[j].head = NULL;
+            i = j;
+        }
+    }
+
+    index->count--;
+    memmove(&index->sorted[pos], &index->sorted[pos+1], (index->count - pos) * sizeof(cfstore_index_entry_t));
+}
+
+/* @brief   record that the KV hkvt is moving to head in page. Must be called
+ *          before the KV data is moved. Moving KVs doesn't change the key
+ *          order, and KVs keep their relative order in the area. */
+static void cfstore_index_move(cfstore_ctx_t* ctx, cfstore_area_hkvt_t* hkvt, cfstore_area_page_t* page, uint8_t* head)
+{
+    uint32_t slot = 0;
+    uint32_t pos = 0;
+    cfstore_index_t* index = &ctx->index;
+
+    if(!index->valid){
+        return;
+    }
+    cfstore_index_locate(ctx, hkvt, &slot, &pos);
+    index->table[slot].page = page;
+    index->table[slot].head = head;
+    index->sorted[pos] = index->table[slot];
+}
+
+/* @brief   (re)build the index from the KVs in the area e.g. after the area
+ *          has been read from flash */
+static void cfstore_index_rebuild(cfstore_ctx_t* ctx)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    cfstore_area_hkvt_t hkvt;
+
+    cfstore_index_free(ctx);
+    ctx->index.valid = true;
+    ret = cfstore_get_head_hkvt(&hkvt);
+    while(ret == ARM_DRIVER_OK && ctx->index.valid){
+        cfstore_index_insert(ctx, &hkvt);
+        ret = cfstore_get_next_hkvt(&hkvt, &hkvt);
+    }
+}
+
+/* @brief   check whether a KV satisfies the same conditions cfstore_find_ex()
+ *          applies when walking the area */
+static bool cfstore_index_is_match(cfstore_index_entry_t* entry, const char* key_name_query, bool exact)
+{
+    uint8_t key_len = CFSTORE_KEY_NAME_MAX_LENGTH+1;
+    char key_name[CFSTORE_KEY_NAME_MAX_LENGTH+1];
+    cfstore_area_hkvt_t hkvt = cfstore_get_hkvt_from_head_ptr(entry->page, entry->head);
+
+    if(cfstore_hkvt_get_flags_delete(&hkvt) || !cfstore_is_kv_client_readable(&hkvt)){
+        return false;
+    }
+    if(exact){
+        return true;
+    }
+    cfstore_get_key_name_ex(&hkvt, key_name, &key_len);
+    return cfstore_fnmatch(key_name_query, key_name, 0) == 0;
+}
+
+/** @brief  Find the next KV matching the query using the index.
+ *
+ * The result is the same as cfstore_find_ex() walking the area: the first
+ * matching KV located after prev in the area.
+ *
+ * @return  ARM_DRIVER_OK if a matching KV was found,
+ *          ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND if there are no more
+ *          matching KVs, or ARM_DRIVER_ERROR_UNSUPPORTED if the index can't
+ *          be used for this query (in which case the area has to be walked).
+ */
+static int32_t cfstore_index_find_ex(const char* key_name_query, cfstore_area_hkvt_t *prev, cfstore_area_hkvt_t *next)
+{
+    uint32_t i = 0;
+    uint32_t mask = 0;
+    size_t prefix_len = 0;
+    cfstore_index_entry_t* entry = NULL;
+    cfstore_index_entry_t* found = NULL;
+    cfstore_ctx_t* ctx = cfstore_ctx_get();
+    cfstore_index_t* index = &ctx->index;
+
+    if(!index->valid){
+        return ARM_DRIVER_ERROR_UNSUPPORTED;
+    }
+    /* the literal part of the query before the first wildcard */
+    prefix_len = strcspn(key_name_query, "*");
+    if(prefix_len == 0 || prefix_len > CFSTORE_KEY_NAME_MAX_LENGTH){
+        /* a leading wildcard matches anywhere in the area so walk it in order */
+        return ARM_DRIVER_ERROR_UNSUPPORTED;
+    }
+
+    if(key_name_query[prefix_len] == '\0'){
+        /* exact key name. Apart from a KV being deleted there is only one. */
+        if(index->count > 0){
+            mask = index->table_size - 1;
+            i = cfstore_index_hash((const uint8_t*) key_name_query, (uint8_t) prefix_len) & mask;
+            while(index->table[i].head != NULL){
+                entry = &index->table[i];
+                if((prev == NULL || cfstore_index_is_before(prev->page, prev->head, entry))
+                        && (found == NULL || cfstore_index_is_before(entry->page, entry->head, found))
+                        && cfstore_index_compare(entry, (const uint8_t*) key_name_query, (uint8_t) prefix_len) == 0
+                        && cfstore_index_is_match(entry, key_name_query, true)){
+                    found = entry;
+                }
+                i = (i + 1) & mask;
+            }
+        }
+    } else {
+        /* only the KVs starting with the prefix can match */
+        for(i = cfstore_index_lower_bound(ctx, (const uint8_t*) key_name_query, (uint8_t) prefix_len); i < index->count; i++){
+            entry = &index->sorted[i];
+            if(cfstore_index_get_header(entry)->klength < prefix_len
+                    || memcmp(cfstore_index_get_key(entry), key_name_query, prefix_len) != 0){
+                break;
+            }
+            if((prev == NULL || cfstore_index_is_before(prev->page, prev->head, entry))
+                    && (found == NULL || cfstore_index_is_before(entry->page, entry->head, found))
+                    && cfstore_index_is_match(entry, key_name_query, false)){
+                found = entry;
+            }
+        }
+    }
+
+    if(found == NULL){
         memset((void*) next, 0, sizeof(cfstore_area_hkvt_t));
         return ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND;
     }
-    /* use the prev tail pointer to find the next head pointer */
-    *next = cfstore_get_hkvt_from_head_ptr((uint8_t*) prev->tail);
+    *next = cfstore_get_hkvt_from_head_ptr(found->page, found->head);
     return ARM_DRIVER_OK;
 }
 
+#else
+
+static CFSTORE_INLINE void cfstore_index_free(cfstore_ctx_t* ctx){ (void) ctx; return; }
+static CFSTORE_INLINE void cfstore_index_insert(cfstore_ctx_t* ctx, cfstore_area_hkvt_t* hkvt){ (void) ctx; (void) hkvt; return; }
+static CFSTORE_INLINE void cfstore_index_remove(cfstore_ctx_t* ctx, cfstore_area_hkvt_t* hkvt){ (void) ctx; (void) hkvt; return; }
+static CFSTORE_INLINE void cfstore_index_move(cfstore_ctx_t* ctx, cfstore_area_hkvt_t* hkvt, cfstore_area_page_t* page, uint8_t* head){ (void) ctx; (void) hkvt; (void) page; (void) head; return; }
+static CFSTORE_INLINE void cfstore_index_rebuild(cfstore_ctx_t* ctx){ (void) ctx; return; }
+static CFSTORE_INLINE int32_t cfstore_index_find_ex(const char* key_name_query, cfstore_area_hkvt_t *prev, cfstore_area_hkvt_t *next){ (void) key_name_query; (void) prev; (void) next; return ARM_DRIVER_ERROR_UNSUPPORTED; }
+
+#endif /* CFSTORE_CONFIG_KEY_INDEX_ENABLED */
+
+
+/*
+ * Area pages
+ *
+ * See cfstore_area_page_t. All functions require the rw_area0_lock to be held
+ * by the caller.
+ */
+
+/* @brief   allocate a page with room for size bytes of KVs. The page is not
+ *          linked into the area. */
+static cfstore_area_page_t* cfstore_area_page_alloc(ARM_CFSTORE_SIZE size)
+{
+    cfstore_area_page_t* page = NULL;
+
+    page = (cfstore_area_page_t*) CFSTORE_MALLOC(sizeof(cfstore_area_page_t) + size);
+    if(page == NULL){
+        CFSTORE_ERRLOG("%s:Error: unable to allocate page (size=%d)\n", __func__, (int) size);
+        return NULL;
+    }
+    memset(page, 0, sizeof(cfstore_area_page_t));
+    CFSTORE_INIT_LIST_HEAD(&page->node);
+    page->size = (uint32_t) size;
+    page->flash_offset = CFSTORE_AREA_PAGE_DIRTY;
+    return page;
+}
+
+/* @brief   free all pages in the area */
+static void cfstore_area_free(cfstore_ctx_t* ctx)
+{
+    cfstore_list_node_t* node = ctx->area_0_pages.next;
+    cfstore_list_node_t* next = NULL;
+
+    while(node != NULL && node != &ctx->area_0_pages){
+        next = node->next;
+        CFSTORE_FREE(node);
+        node = next;
+    }
+    CFSTORE_INIT_LIST_HEAD(&ctx->area_0_pages);
+    ctx->area_0_len = 0;
+    ctx->area_0_seq = 0;
+}
+
+/* @brief   get a page at the end of the area with room for a KV of kv_size
+ *          bytes, appending a new page if required. The KV is to be
+ *          written at the used offset of the returned page. */
+static cfstore_area_page_t* cfstore_area_get_tail_page(cfstore_ctx_t* ctx, ARM_CFSTORE_SIZE kv_size)
+{
+    cfstore_area_page_t* page = NULL;
+
+    if(ctx->area_0_pages.prev != &ctx->area_0_pages){
+        page = (cfstore_area_page_t*) ctx->area_0_pages.prev;
+        if(page->size - page->used >= kv_size){
+            return page;
+        }
+    }
+    /* KVs larger than a page are given a page of their own */
+    page = cfstore_area_page_alloc(kv_size > CFSTORE_AREA_PAGE_SIZE ? kv_size : CFSTORE_AREA_PAGE_SIZE);
+    if(page == NULL){
+        return NULL;
+    }
+    page->seq = ctx->area_0_seq++;
+    cfstore_listAdd(ctx->area_0_pages.prev, &page->node, &ctx->area_0_pages);
+    return page;
+}
+
+/* @brief   unlink and free a page */
+static void cfstore_area_page_free(cfstore_area_page_t* page)
+{
+    cfstore_listDel(&page->node);
+    CFSTORE_FREE(page);
+}
+
+/* @brief   move the data of the KV hkvt to head in page, updating the index
+ *          and the open files referring to it. hkvt is updated to the new
+ *          location. The page used counts are not changed.
+ *
+ * @note    Moving a KV within a page must not overwrite other KVs, so KVs
+ *          are moved towards the start of the page in area order.
+ */
+static void cfstore_area_move_hkvt(cfstore_ctx_t* ctx, cfstore_area_hkvt_t* hkvt, cfstore_area_page_t* page, uint8_t* head)
+{
+    cfstore_file_t* file;
+    cfstore_list_node_t* node;
+    cfstore_list_node_t* file_list = &ctx->file_list;
+
+    cfstore_index_move(ctx, hkvt, page, head);
+    memmove(head, hkvt->head, cfstore_hkvt_get_size(hkvt));
+    cfstore_area_page_set_dirty(page);
+
+    node = file_list->next;
+    while(node != file_list){
+        file = (cfstore_file_t*) node;
+        if(file->head == hkvt->head){
+            file->head = head;
+        }
+        node = node->next;
+    }
+    *hkvt = cfstore_get_hkvt_from_head_ptr(page, head);
+}
+
+/* @brief   move the KVs of page src to the end of page dst and free src.
+ *          src must follow dst in the area and the KVs must fit in dst. */
+static void cfstore_area_page_merge(cfstore_ctx_t* ctx, cfstore_area_page_t* dst, cfstore_area_page_t* src)
+{
+    uint8_t* ptr = cfstore_area_page_get_data(src);
+    uint8_t* end = ptr + src->used;
+    cfstore_area_hkvt_t hkvt;
+
+    CFSTORE_TP(CFSTORE_TP_DELETE, "%s:merging page (seq=%d, used=%d) into page (seq=%d, used=%d)\n", __func__, (int) src->seq, (int) src->used, (int) dst->seq, (int) dst->used);
+    CFSTORE_ASSERT(dst->used + src->used <= dst->size);
+    while(ptr < end){
+        hkvt = cfstore_get_hkvt_from_head_ptr(src, ptr);
+        ptr = hkvt.tail;
+        cfstore_area_move_hkvt(ctx, &hkvt, dst, cfstore_area_page_get_data(dst) + dst->used);
+        dst->used += cfstore_hkvt_get_size(&hkvt);
+    }
+    cfstore_area_page_free(src);
+}
+
+/* @brief   remove the KV hkvt from its page, compacting the page. Empty pages
+ *          are freed and pages are merged with a neighbour when their KVs fit
+ *          into one page, so that the area doesn't fragment. */
+static void cfstore_area_remove_hkvt(cfstore_ctx_t* ctx, cfstore_area_hkvt_t* hkvt)
+{
+    uint8_t* ptr = hkvt->tail;
+    uint8_t* head = hkvt->head;
+    ARM_CFSTORE_SIZE kv_size = cfstore_hkvt_get_size(hkvt);
+    cfstore_area_page_t* page = hkvt->page;
+    cfstore_area_page_t* prev = NULL;
+    cfstore_area_page_t* next = NULL;
+    cfstore_area_hkvt_t moved;
+
+    /* move the following KVs of the page down over the removed KV */
+    while(ptr < cfstore_area_page_get_data(page) + page->used){
+        moved = cfstore_get_hkvt_from_head_ptr(page, ptr);
+        ptr = moved.tail;
+        cfstore_area_move_hkvt(ctx, &moved, page, head);
+        head = moved.tail;
+    }
+    /* zero the deleted KV memory */
+    memset(head, 0, kv_size);
+    page->used -= kv_size;
+    ctx->area_0_len -= kv_size;
+    cfstore_area_page_set_dirty(page);
+
+    if(page->used == 0){
+        cfstore_area_page_free(page);
+        return;
+    }
+    if(page->node.prev != &ctx->area_0_pages){
+        prev = (cfstore_area_page_t*) page->node.prev;
+        if(prev->used + page->used <= prev->size){
+            cfstore_area_page_merge(ctx, prev, page);
+            return;
+        }
+    }
+    if(page->node.next != &ctx->area_0_pages){
+        next = (cfstore_area_page_t*) page->node.next;
+        if(page->used + next->used <= page->size){
+            cfstore_area_page_merge(ctx, page, next);
+        }
+    }
+}
+
+/* @brief   change the size of the value of the KV hkvt by kv_size_diff bytes.
+ *          hkvt is updated to the new location of the KV.
+ *
+ * If the page has room the KVs following hkvt in the page are moved.
+ * Otherwise the KVs of the page are copied to a new larger page replacing it,
+ * so that only the data of the page is copied.
+ *
+ * @return  ARM_DRIVER_OK on success, ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY
+ *          if a larger page couldn't be allocated, in which case the KV is
+ *          unchanged.
+ */
+static int32_t cfstore_area_resize_hkvt(cfstore_ctx_t* ctx, cfstore_area_hkvt_t* hkvt, int32_t kv_size_diff)
+{
+    uint8_t* ptr = NULL;
+    uint8_t* end = NULL;
+    uint8_t* dst = NULL;
+    uint8_t* kv_tail = hkvt->tail;
+    ARM_CFSTORE_SIZE size = 0;
+    cfstore_area_page_t* page = hkvt->page;
+    cfstore_area_page_t* new_page = NULL;
+    cfstore_area_hkvt_t moved;
+
+    end = cfstore_area_page_get_data(page) + page->used;
+    if(kv_size_diff < 0){
+        /* value blob size shrinking => move the following KVs down */
+        ptr = hkvt->tail;
+        dst = hkvt->tail + kv_size_diff;
+        while(ptr < end){
+            moved = cfstore_get_hkvt_from_head_ptr(page, ptr);
+            ptr = moved.tail;
+            cfstore_area_move_hkvt(ctx, &moved, page, dst);
+            dst = moved.tail;
+        }
+        memset(dst, 0, -kv_size_diff);
+    } else if(hkvt->tail == end && page->size - page->used >= (uint32_t) kv_size_diff){
+        /* last KV in the page with room to grow */
+        memset(end, 0, kv_size_diff);
+    } else {
+        /* value blob size growing => copy the page to a new page with a gap for the growth */
+        size = page->used + kv_size_diff;
+        new_page = cfstore_area_page_alloc(size > CFSTORE_AREA_PAGE_SIZE ? size : CFSTORE_AREA_PAGE_SIZE);
+        if(new_page == NULL){
+            return ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY;
+        }
+        CFSTORE_TP(CFSTORE_TP_CREATE, "%s:replacing page (seq=%d, used=%d) with page of size %d\n", __func__, (int) page->seq, (int) page->used, (int) new_page->size);
+        new_page->seq = page->seq;
+        new_page->used = page->used;
+        cfstore_listAdd(page->node.prev, &new_page->node, page->node.next);
+        ptr = cfstore_area_page_get_data(page);
+        dst = cfstore_area_page_get_data(new_page);
+        while(ptr < end){
+            moved = cfstore_get_hkvt_from_head_ptr(page, ptr);
+            ptr = moved.tail;
+            cfstore_area_move_hkvt(ctx, &moved, new_page, dst);
+            dst = moved.tail;
+            if(ptr == kv_tail){
+                /* leave the gap for the growth after the resized KV */
+                *hkvt = moved;
+                memset(dst, 0, kv_size_diff);
+                dst += kv_size_diff;
+            }
+        }
+        /* the neighbours of the old page now link to the new page so it's just freed */
+        CFSTORE_FREE(page);
+    }
+    hkvt->page->used += kv_size_diff;
+    ctx->area_0_len += kv_size_diff;
+    cfstore_area_page_set_dirty(hkvt->page);
+    return ARM_DRIVER_OK;
+}
 
 /*
  * Flash support functions
@@ -1306,32 +2038,44 @@ static int32_t cfstore_get_next_hkvt(cfstore_area_hkvt_t* prev, cfstore_area_hkv
 
 static CFSTORE_INLINE void cfstore_hkvt_dump(cfstore_area_hkvt_t* hkvt, const char* tag);
 
-/* set the tail pointer */
+#ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
+
+/* set the used count of the page read from flash, which includes the padding after the last KV */
 static int32_t cfstore_flash_set_tail(void)
 {
     int32_t ret = ARM_DRIVER_ERROR;
     uint8_t* ptr = NULL;
     cfstore_ctx_t* ctx = cfstore_ctx_get();
     uint8_t* tail = NULL;
+    cfstore_area_page_t* page = NULL;
     cfstore_area_hkvt_t hkvt;
 
     /* walk the area to find the last KV */
     CFSTORE_FENTRYLOG("%s:entered: \n", __func__);
     CFSTORE_ASSERT(ctx != NULL);
     cfstore_hkvt_init(&hkvt);
-    ptr = ctx->area_0_head;
-    /* ctx->area_0_tail has been set to the end of the sram area allocated, but this is now refined so
+    page = cfstore_area_page_get_next(ctx, ctx->area_0_pages.next);
+    if(page == NULL){
+        return ret;
+    }
+    ptr = cfstore_area_page_get_data(page);
+    /* page->used has been set to the size of the blob, but this is now refined so
      * as to point to the end of the last KV */
-    tail = ctx->area_0_tail;
+    tail = ptr + page->used;
     while(ptr < tail) {
-        hkvt = cfstore_get_hkvt_from_head_ptr(ptr);
+        hkvt = cfstore_get_hkvt_from_head_ptr(page, ptr);
         cfstore_hkvt_dump(&hkvt, __func__);
+        if(hkvt.tail > tail){
+            CFSTORE_ERRLOG("%s:Error: KV extends beyond the end of the blob\n", __func__);
+            break;
+        }
         /* when the length between the hkvt.tail and tail (set to the end of the area including padding)
          * is less than the minimum KV length then we have found the last KV, and can set the
-         * area_0_tail correctly to the end of the last KV */
+         * used count correctly to the end of the last KV */
         if((uint32_t)(tail - hkvt.tail) < sizeof(cfstore_area_header_t)){
             /* ptr is last KV in area as there isn't space for another header  */
-            ctx->area_0_tail = hkvt.tail;
+            page->used = (uint32_t) (hkvt.tail - cfstore_area_page_get_data(page));
+            ctx->area_0_len = page->used;
             ret = ARM_DRIVER_OK;
             break;
         }
@@ -1340,7 +2084,59 @@ static int32_t cfstore_flash_set_tail(void)
     return ret;
 }
 
-#ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
+/* @brief   move the KVs read from flash into a single page to pages of
+ *          CFSTORE_AREA_PAGE_SIZE so that later changes only move the data
+ *          of a page. */
+static int32_t cfstore_flash_load_area(cfstore_ctx_t* ctx)
+{
+    uint8_t* ptr = NULL;
+    uint8_t* end = NULL;
+    ARM_CFSTORE_SIZE kv_size = 0;
+    cfstore_area_page_t* load = NULL;
+    cfstore_area_page_t* page = NULL;
+    cfstore_area_hkvt_t hkvt;
+
+    load = cfstore_area_page_get_next(ctx, ctx->area_0_pages.next);
+    if(load == NULL || load->used <= CFSTORE_AREA_PAGE_SIZE){
+        /* the page read from flash is small enough to be kept */
+        return ARM_DRIVER_OK;
+    }
+    cfstore_listDel(&load->node);
+    ctx->area_0_len = 0;
+    ctx->area_0_seq = 0;
+    ptr = cfstore_area_page_get_data(load);
+    end = ptr + load->used;
+    while(ptr < end){
+        hkvt = cfstore_get_hkvt_from_head_ptr(load, ptr);
+        kv_size = cfstore_hkvt_get_size(&hkvt);
+        page = cfstore_area_get_tail_page(ctx, kv_size);
+        if(page == NULL){
+            CFSTORE_FREE(load);
+            cfstore_area_free(ctx);
+            return ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY;
+        }
+        memcpy(cfstore_area_page_get_data(page) + page->used, ptr, kv_size);
+        page->used += kv_size;
+        ctx->area_0_len += kv_size;
+        ptr = hkvt.tail;
+    }
+    CFSTORE_FREE(load);
+    return ARM_DRIVER_OK;
+}
+
+/* @brief   record the offsets of the pages in the blob just read from or
+ *          committed to flash, which the area now matches. */
+static void cfstore_area_set_clean(cfstore_ctx_t* ctx)
+{
+    uint32_t offset = 0;
+    cfstore_area_page_t* page = cfstore_area_page_get_next(ctx, ctx->area_0_pages.next);
+
+    while(page != NULL){
+        page->flash_offset = offset;
+        offset += page->used;
+        page = cfstore_area_page_get_next(ctx, page->node.next);
+    }
+}
 
 /*
  * flash helper functions
@@ -1374,6 +2170,7 @@ static int32_t cfstore_flash_map_error(int32_t flash_journal_status_code)
         {
             return node->cfstore_error_code;
         }
+        node++;
     }
     return ARM_CFSTORE_DRIVER_ERROR_INTERNAL;
 }
@@ -1463,7 +2260,7 @@ static int32_t cfstore_fsm_init_on_entry(void* context)
 
     CFSTORE_FENTRYLOG("%s:entered\n", __func__);
 
-    ret = FlashJournal_initialize(&ctx->jrnl, drv, &FLASH_JOURNAL_STRATEGY_SEQUENTIAL, cfstore_flash_journal_callback);
+    ret = FlashJournal_initialize(&ctx->jrnl, drv, &CFSTORE_FLASH_JOURNAL_STRATEGY, cfstore_flash_journal_callback);
     CFSTORE_FENTRYLOG("%s:here\n", __func__);
     CFSTORE_TP(CFSTORE_TP_FSM, "%s:FlashJournal_initialize ret=%d\n", __func__, (int) ret);
     if(ret < ARM_DRIVER_OK){
@@ -1520,8 +2317,8 @@ static int32_t cfstore_fsm_initing(void* context)
  */
 static int32_t cfstore_fsm_read_on_entry(void* context)
 {
-    uint8_t* ptr = NULL;
     int32_t ret = 0;
+    cfstore_area_page_t* page = NULL;
     FlashJournal_Status_t status = JOURNAL_STATUS_ERROR;
     cfstore_ctx_t* ctx = (cfstore_ctx_t*) context;
 
@@ -1545,9 +2342,11 @@ static int32_t cfstore_fsm_read_on_entry(void* context)
         if(ctx->expected_blob_size % ctx->info.program_unit > 0){
             ctx->expected_blob_size += (ctx->info.program_unit - (ctx->info.sizeofJournaledBlob % ctx->info.program_unit));
         }
-        /* grow the area by the size of the stored blob */
-        ptr = (uint8_t*) CFSTORE_REALLOC((void*) ctx->area_0_head, ctx->expected_blob_size);
-        if(ptr == NULL){
+        /* read the stored blob into a single page, which is split into pages of
+         * CFSTORE_AREA_PAGE_SIZE by cfstore_flash_load_area() when the read has completed */
+        cfstore_area_free(ctx);
+        page = cfstore_area_page_alloc(ctx->expected_blob_size);
+        if(page == NULL){
             CFSTORE_ERRLOG("%s:Error: unable to allocate memory (size=%lu)\n", __func__, (long unsigned int) ctx->info.sizeofJournaledBlob);
             cfstore_ctx_reset(ctx);
             ret = ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY;
@@ -1555,13 +2354,11 @@ static int32_t cfstore_fsm_read_on_entry(void* context)
             cfstore_fsm_state_set(&ctx->fsm, cfstore_fsm_state_ready, ctx);
             goto out;
         }
-        memset(ptr, 0, ctx->expected_blob_size);
-        if(ptr != ctx->area_0_head){
-            CFSTORE_TP(CFSTORE_TP_FSM, "%s:cfstore_ctx_g.area_0_head pointer changed (cfstore_ctx_g.area_0_head=%p, ptr=%p)\n", __func__, ctx->area_0_head, ptr);
-            ctx->area_0_head = ptr;
-            ctx->area_0_tail = ctx->area_0_head + ctx->info.sizeofJournaledBlob;
-        }
-        ret = FlashJournal_read(&ctx->jrnl, (void*) ctx->area_0_head, ctx->info.sizeofJournaledBlob);
+        memset(cfstore_area_page_get_data(page), 0, ctx->expected_blob_size);
+        page->seq = ctx->area_0_seq++;
+        page->used = ctx->info.sizeofJournaledBlob;
+        cfstore_listAdd(ctx->area_0_pages.prev, &page->node, &ctx->area_0_pages);
+        ret = FlashJournal_read(&ctx->jrnl, (void*) cfstore_area_page_get_data(page), ctx->info.sizeofJournaledBlob);
         if(ret < ARM_DRIVER_OK){
             CFSTORE_ERRLOG("%s:Error: failed to initialize flash journaling layer (ret=%d)\n", __func__, (int) ret);
             /* move to ready state. cfstore client is expected to Uninitialize() before further calls */
@@ -1615,10 +2412,20 @@ static int32_t cfstore_fsm_reading(void* context)
                 if(ret < ARM_DRIVER_OK){
                     CFSTORE_ERRLOG("%s:Error: cfstore_flash_set_tail() failed (ret=%d)\n", __func__, (int) ret);
                     /* move to ready state. cfstore client is expected to Uninitialize() before further calls */
+                    cfstore_area_free(ctx);
                     cfstore_fsm_state_set(&ctx->fsm, cfstore_fsm_state_ready, ctx);
                     memset(&ctx->info, 0, sizeof(ctx->info));
                     goto out;
                 }
+                ret = cfstore_flash_load_area(ctx);
+                if(ret < ARM_DRIVER_OK){
+                    CFSTORE_ERRLOG("%s:Error: cfstore_flash_load_area() failed (ret=%d)\n", __func__, (int) ret);
+                    /* move to ready state. cfstore client is expected to Uninitialize() before further calls */
+                    cfstore_fsm_state_set(&ctx->fsm, cfstore_fsm_state_ready, ctx);
+                    goto out;
+                }
+                cfstore_area_set_clean(ctx);
+                cfstore_index_rebuild(ctx);
                 ret = cfstore_fsm_state_set(&ctx->fsm, cfstore_fsm_state_ready, ctx);
                 if(ret < ARM_DRIVER_OK){
                     CFSTORE_ERRLOG("%s:Error: cfstore_fsm_state_set() failed (ret=%d)\n", __func__, (int) ret);
@@ -1629,6 +2436,7 @@ static int32_t cfstore_fsm_reading(void* context)
             else
             {
                 CFSTORE_ERRLOG("%s:Error: read bytes (%d) does not equal requested read size (%d)\n", __func__, (int) ctx->status, (int) ctx->expected_blob_size);
+                cfstore_area_free(ctx);
                 ret = cfstore_fsm_state_set(&ctx->fsm, cfstore_fsm_state_ready, ctx);
                 if(ret < ARM_DRIVER_OK){
                     /* move to ready state. cfstore client is expected to Uninitialize() before further calls */
@@ -1671,7 +2479,113 @@ static int32_t cfstore_fsm_read_on_exit(void* context)
     return ARM_DRIVER_OK;
 }
 
-/* int32_t cfstore_fsm_log_on_entry(void* context){ (void) context;} */
+/* @brief   get the next chunk of the area to log, which is a multiple of the
+ *          program_unit. The data is logged directly from the pages where
+ *          possible. The data straddling page boundaries and the padding at
+ *          the end of the area are copied to ctx->log_buf.
+ */
+static void cfstore_flash_log_get_chunk(cfstore_ctx_t* ctx, const uint8_t** data, uint32_t* size)
+{
+    uint32_t len = 0;
+    uint32_t program_unit = cfstore_ctx_get_program_unit(ctx);
+    cfstore_area_page_t* page = ctx->log_page;
+
+    if(page != NULL && page->used - ctx->log_offset >= program_unit){
+        len = page->used - ctx->log_offset;
+        *data = cfstore_area_page_get_data(page) + ctx->log_offset;
+        *size = len - (len % program_unit);
+        ctx->log_from_buf = false;
+        return;
+    }
+    while(page != NULL && len < program_unit){
+        uint32_t n = page->used - ctx->log_offset;
+        if(n > program_unit - len){
+            n = program_unit - len;
+        }
+        memcpy(&ctx->log_buf[len], cfstore_area_page_get_data(page) + ctx->log_offset, n);
+        len += n;
+        ctx->log_offset += n;
+        if(ctx->log_offset == page->used){
+            page = cfstore_area_page_get_next(ctx, page->node.next);
+            ctx->log_offset = 0;
+        }
+    }
+    ctx->log_page = page;
+    memset(&ctx->log_buf[len], 0, program_unit - len);
+    *data = ctx->log_buf;
+    *size = program_unit;
+    ctx->log_from_buf = true;
+}
+
+/* @brief   log the next chunk of the area. With the log strategy a page which
+ *          is unchanged and at the same offset as in the committed blob is
+ *          skipped rather than logged, so the journal doesn't compare it.
+ *
+ * @return  as FlashJournal_log().
+ */
+static int32_t cfstore_flash_log_next(cfstore_ctx_t* ctx)
+{
+    const uint8_t* data = NULL;
+    uint32_t size = 0;
+
+#ifdef CFSTORE_CONFIG_JOURNAL_LOG_STRATEGY_ENABLED
+    if(ctx->log_page != NULL && ctx->log_offset == 0 && ctx->log_page->flash_offset == ctx->log_len){
+        CFSTORE_TP(CFSTORE_TP_FLUSH, "%s:skipping clean page: size=%d, logged=%d\n", __func__, (int) ctx->log_page->used, (int) ctx->log_len);
+        ctx->log_req = ctx->log_page->used;
+        ctx->log_from_buf = false;
+        return flashJournalStrategyLog_skip(&ctx->jrnl, ctx->log_req);
+    }
+#endif /* CFSTORE_CONFIG_JOURNAL_LOG_STRATEGY_ENABLED */
+    cfstore_flash_log_get_chunk(ctx, &data, &size);
+    CFSTORE_TP(CFSTORE_TP_FLUSH, "%s:logging: data=%p, size=%d, logged=%d\n", __func__, data, (int) size, (int) ctx->log_len);
+    ctx->log_req = size;
+    return FlashJournal_log(&ctx->jrnl, (const void*) data, size);
+}
+
+/* @brief   log the area to flash in chunks until the whole area has been logged
+ *          or a FlashJournal_log() is completing asynchronously.
+ *
+ * @param   status
+ *          number of bytes logged by the previous FlashJournal_log() request,
+ *          if any.
+ *
+ * @return  the number of bytes logged (> 0) when the whole area has been
+ *          logged, ARM_DRIVER_OK when awaiting the asynchronous completion of
+ *          a FlashJournal_log(), or < 0 on error.
+ */
+static int32_t cfstore_flash_log_area(cfstore_ctx_t* ctx, int32_t status)
+{
+    for(;;){
+        if(ctx->log_req > 0){
+            /* account for the completed request */
+            if(status <= 0 || (uint32_t) status > ctx->log_req || (ctx->log_from_buf && (uint32_t) status != ctx->log_req)){
+                CFSTORE_ERRLOG("%s:Error: FlashJournal_log() failed to log the expected number of bytes (requested=%d, logged=%d)\n", __func__, (int) ctx->log_req, (int) status);
+                return ARM_DRIVER_ERROR;
+            }
+            if(!ctx->log_from_buf){
+                ctx->log_offset += status;
+                if(ctx->log_offset == ctx->log_page->used){
+                    ctx->log_page = cfstore_area_page_get_next(ctx, ctx->log_page->node.next);
+                    ctx->log_offset = 0;
+                }
+            }
+            ctx->log_len += status;
+            ctx->log_req = 0;
+        }
+        if(ctx->log_len >= ctx->expected_blob_size){
+            return (int32_t) ctx->log_len;
+        }
+        status = cfstore_flash_log_next(ctx);
+        if(status < JOURNAL_STATUS_OK){
+            CFSTORE_ERRLOG("%s:Error: FlashJournal_log() failed (status=%d)\n", __func__, (int) status);
+            return cfstore_flash_map_error(status);
+        } else if(status == JOURNAL_STATUS_OK){
+            /* wait for async completion handler*/
+            return ARM_DRIVER_OK;
+        }
+    }
+}
+
 
 /* @brief   on entry to writing state, update value */
 int32_t cfstore_fsm_log_on_entry(void* context)
@@ -1696,20 +2610,30 @@ int32_t cfstore_fsm_log_on_entry(void* context)
     if(ctx->expected_blob_size % info.program_unit > 0){
         ctx->expected_blob_size += (info.program_unit - (ctx->expected_blob_size % info.program_unit));
     }
+    if(info.program_unit > CFSTORE_FLASH_STACK_BUF_SIZE){
+        CFSTORE_ERRLOG("%s:Error: program_unit (%d) larger than supported (%d)\n", __func__, (int) info.program_unit, (int) CFSTORE_FLASH_STACK_BUF_SIZE);
+        /* move to ready state. cfstore client is expected to Uninitialize() before further calls */
+        cfstore_fsm_state_set(&ctx->fsm, cfstore_fsm_state_ready, ctx);
+        return ARM_CFSTORE_DRIVER_ERROR_INTERNAL;
+    }
+    ctx->log_page = cfstore_area_page_get_next(ctx, ctx->area_0_pages.next);
+    ctx->log_offset = 0;
+    ctx->log_len = 0;
+    ctx->log_req = 0;
     /* log the changes to flash even when the area has shrunk to 0, as its necessary to erase the flash */
     if(ctx->area_dirty_flag == true)
     {
         if(ctx->expected_blob_size > 0){
-            CFSTORE_TP(CFSTORE_TP_FLUSH, "%s:logging: ctx->area_0_head=%p, ctx->expected_blob_size-%d\n", __func__, ctx->area_0_head, (int) ctx->expected_blob_size);
-            ret = FlashJournal_log(&ctx->jrnl, (const void*) ctx->area_0_head, ctx->expected_blob_size);
-            if(ret < JOURNAL_STATUS_OK){
-                CFSTORE_ERRLOG("%s:Error: FlashJournal_commit() failed (ret=%d)\n", __func__, (int) ret);
-                ret = cfstore_flash_map_error(status);
+            CFSTORE_TP(CFSTORE_TP_FLUSH, "%s:logging: ctx->area_0_len=%d, ctx->expected_blob_size-%d\n", __func__, (int) ctx->area_0_len, (int) ctx->expected_blob_size);
+            /* the area is logged one page at a time */
+            ret = cfstore_flash_log_area(ctx, 0);
+            if(ret < ARM_DRIVER_OK){
+                CFSTORE_ERRLOG("%s:Error: cfstore_flash_log_area() failed (ret=%d)\n", __func__, (int) ret);
                 /* move to ready state. cfstore client is expected to Uninitialize() before further calls */
                 cfstore_fsm_state_set(&ctx->fsm, cfstore_fsm_state_ready, ctx);
                 goto out0;
             } else if(ret > 0){
-                /* read has completed synchronously*/
+                /* log has completed synchronously*/
                 cfstore_flash_journal_callback(ret, FLASH_JOURNAL_OPCODE_LOG_BLOB);
                 ret = ctx->status;
             }
@@ -1728,7 +2652,8 @@ int32_t cfstore_fsm_log_on_entry(void* context)
     else
     {
         /* nothing to be logged so move back to ready state indicating success*/
-        CFSTORE_TP(CFSTORE_TP_FLUSH, "%s:not logging: ctx->area_0_head=%p, ctx->expected_blob_size-=%d\n", __func__, ctx->area_0_head, (int) ctx->expected_blob_size);
+        CFSTORE_TP(CFSTORE_TP_FLUSH, "%s:not logging: ctx->area_0_len=%d, ctx->expected_blob_size-=%d\n", __func__, (int) ctx->area_0_len, (int) ctx->expected_blob_size);
+        ctx->log_len = ctx->expected_blob_size;
         cfstore_flash_journal_callback(ctx->expected_blob_size, FLASH_JOURNAL_OPCODE_LOG_BLOB);
     }
 out0:
@@ -1738,6 +2663,7 @@ out0:
 /* @brief  fsm handler when in reading state */
 static int32_t cfstore_fsm_logging(void* context)
 {
+    int32_t ret = ARM_DRIVER_ERROR;
     cfstore_ctx_t* ctx = (cfstore_ctx_t*) context;
 
     CFSTORE_FENTRYLOG("%s:entered:ctx->status=%ld\n", __func__, ctx->status);
@@ -1749,7 +2675,22 @@ static int32_t cfstore_fsm_logging(void* context)
         ctx->status = cfstore_flash_map_error(ctx->status);
     }
     else
-    {   /* ctx->status >= 0 (status == 0 when everything is deleted) */
+    {
+        if(ctx->log_len < ctx->expected_blob_size){
+            /* an asynchronous log() of part of the area has completed so log the rest */
+            ret = cfstore_flash_log_area(ctx, ctx->status);
+            if(ret < ARM_DRIVER_OK){
+                /* move to ready state. cfstore client is expected to Uninitialize() before further calls */
+                cfstore_fsm_state_set(&ctx->fsm, cfstore_fsm_state_ready, ctx);
+                ctx->status = ret;
+                return ctx->status;
+            } else if(ret == ARM_DRIVER_OK){
+                /* wait for async completion handler*/
+                return ARM_DRIVER_OK;
+            }
+            ctx->status = ret;
+        }
+        /* ctx->status >= 0 (status == 0 when everything is deleted) */
         if(ctx->status == (int32_t)ctx->expected_blob_size){
             /* move to the committing state to commit to flash*/
             ctx->status = cfstore_fsm_state_set(&ctx->fsm, cfstore_fsm_state_committing, ctx);
@@ -1811,6 +2752,26 @@ static int32_t cfstore_fsm_commit_on_entry(void* context)
 }
 
 
+/* @brief   mark the pages clean and record the number of bytes the flash
+ *          journal programmed for the commit which has just completed. With
+ *          the log strategy this is the size of the delta record rather than
+ *          of the whole area.
+ */
+static void cfstore_flash_record_commit(cfstore_ctx_t* ctx)
+{
+    FlashJournal_Info_t info;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    cfstore_area_set_clean(ctx);
+    if(FlashJournal_getInfo(&ctx->jrnl, &info) < JOURNAL_STATUS_OK){
+        return;
+    }
+    ctx->flush_bytes = info.sizeofLastCommit;
+    ctx->flush_bytes_total += info.sizeofLastCommit;
+    CFSTORE_TP(CFSTORE_TP_FLUSH, "%s:commit programmed %d bytes for a %d byte area (total=%d)\n", __func__, (int) ctx->flush_bytes, (int) info.sizeofJournaledBlob, (int) ctx->flush_bytes_total);
+}
+
+
 /* @brief  fsm handler when in committing state
  * @note
  * Its unnecessary to provide CS protection for the flashJouranl_commit() as the all the
@@ -1838,6 +2799,10 @@ static int32_t cfstore_fsm_committing(void* context)
     }
     else
     {   /* ctx->status > 0. for flash-journal-strategy-sequential version >0.4.0, commit() return no longer reports size of commit block */
+        if(ctx->area_dirty_flag == true){
+            /* otherwise nothing was committed, see cfstore_fsm_commit_on_entry() */
+            cfstore_flash_record_commit(ctx);
+        }
         ctx->status = cfstore_fsm_state_set(&ctx->fsm, cfstore_fsm_state_ready, ctx);
     }
     return ctx->status;
@@ -1849,6 +2814,7 @@ static int32_t cfstore_fsm_commit_on_exit(void* context)
 
     CFSTORE_FENTRYLOG("%s:entered:\n", __func__);
     ctx->area_dirty_flag = false;
+    ctx->area_dirty_len = 0;
     /* notify client of commit status */
     cfstore_client_notify_data_init(&ctx->client_notify_data, CFSTORE_OPCODE_FLUSH, ctx->status, NULL);
     ctx->client_callback_notify_flag = true;
@@ -2071,6 +3037,7 @@ static int32_t cfstore_flash_flush(cfstore_ctx_t* ctx)
     /* put the async completion code state variables into a known state */
     ctx->status = ARM_DRIVER_OK;
     ctx->cmd_code = (FlashJournal_OpCode_t)((int) FLASH_JOURNAL_OPCODE_RESET+1);
+    ctx->flush_bytes = 0;
 
     /* cfstore_fsm_state_handle_event() is called at intr context via
      * cfstore_flash_journal_callback(), and hence calls from app context are
@@ -2116,79 +3083,13 @@ static int32_t cfstore_flash_flush(cfstore_ctx_t* ctx)
  */
 static int32_t cfstore_delete_ex(cfstore_area_hkvt_t* hkvt)
 {
-    uint8_t* ptr = NULL;
-    int32_t ret = ARM_DRIVER_ERROR;
-    ARM_CFSTORE_SIZE kv_size = 0;
-    ARM_CFSTORE_SIZE area_size = 0;
-    ARM_CFSTORE_SIZE realloc_size = 0;      /* size aligned to flash program_unit size */
     cfstore_ctx_t* ctx = cfstore_ctx_get();
-    cfstore_file_t* file;
-    cfstore_list_node_t* node;
-    cfstore_list_node_t* file_list = &ctx->file_list;
 
-    CFSTORE_FENTRYLOG("%s:entered:(ctx->area_0_head=%p, ctx->area_0_tail=%p)\n", __func__, ctx->area_0_head, ctx->area_0_tail);
-    kv_size  = cfstore_hkvt_get_size(hkvt);
-    area_size = cfstore_ctx_get_area_len();
-    memmove(hkvt->head, hkvt->tail, ctx->area_0_tail - hkvt->tail);
-    /* zero the deleted KV memory */
-    memset(ctx->area_0_tail-kv_size, 0, kv_size);
-
-    /* In the general case the new ((area_size - kv_size) % program_unit > 0). The new area_size is
-     * aligned to a program_unit boundary to facilitate r/w to flash and so the memory realloc size
-     * is calculated to align, as follows */
-    /* setup the reallocation memory size. */
-    realloc_size = area_size - kv_size;
-    if(realloc_size % cfstore_ctx_get_program_unit(ctx) > 0){
-        realloc_size += (cfstore_ctx_get_program_unit(ctx) - (realloc_size % cfstore_ctx_get_program_unit(ctx)));
-    }
-    /* realloc() can return non-zero ptr for size = 0 when the last KV is deleted */
-    if(realloc_size > 0)
-    {
-        ptr = (uint8_t*) CFSTORE_REALLOC((void*) ctx->area_0_head, realloc_size);
-        /* realloc can return NULL when the last KV is deleted.
-         * It also appears that realloc can return non-zero ptr even when realloc_size = 0 */
-        if(ptr == NULL){
-            CFSTORE_ERRLOG("%s:Error:realloc failed\n", __func__);
-            cfstore_ctx_reset(ctx);
-            return ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY;
-        }
-        /* check realloc() hasnt move area in memory from cfstore_ctx_g.area_0_head */
-        if(ptr != ctx->area_0_head){
-            CFSTORE_TP(CFSTORE_TP_DELETE, "%s: cfstore_ctx_g.area_0_head pointer changed (cfstore_ctx_g.area_0_head=%p, cfstore_ctx_g.area_0_tail=%p)\n", __func__, ctx->area_0_head, ptr);
-            /* realloc() has moved the area in memory */
-            ctx->area_0_head = ptr;
-        }
-        /* set tail to be the end of the new area, which will be updated by cfstore_flash_set_tail */
-        ctx->area_0_tail = ptr + area_size - kv_size;
-        ret = cfstore_flash_set_tail();
-        if(ret < ARM_DRIVER_OK){
-            CFSTORE_ERRLOG("%s:Error: cfstore_flash_set_tail() failed (ret=%d)\n", __func__, (int) ret);
-            goto out0;
-        }
-
-        /* now have to walk the file list updating head pointers for the KVs that remain*/
-        node = file_list->next;
-        while(node != file_list){
-            /* Any KV positioned later in the area than the deleted KV will require file head pointers updating.
-             * If file's head pointer is beyond the deleted KV tail then the file->head needs to be updated
-             * to reflect the memove */
-            file = (cfstore_file_t*) node;
-            if(file->head >= hkvt->head){
-                file->head -= kv_size;
-            }
-            node = node->next;
-        }
-    }
-    else
-    {
-        /* realloc_size = 0 */
-        CFSTORE_FREE((void*) ctx->area_0_head);
-        ctx->area_0_head = NULL;
-        ctx->area_0_tail = NULL;
-    }
-    ret = ARM_DRIVER_OK;
-out0:
-    return ret;
+    CFSTORE_FENTRYLOG("%s:entered:(ctx->area_0_len=%d, hkvt->head=%p)\n", __func__, (int) ctx->area_0_len, hkvt->head);
+    cfstore_index_remove(ctx, hkvt);
+    /* only the KVs in the same page are moved, and the file head pointers to them updated */
+    cfstore_area_remove_hkvt(ctx, hkvt);
+    return ARM_DRIVER_OK;
 }
 
 
@@ -2219,7 +3120,8 @@ static cfstore_file_t* cfstore_file_create(cfstore_area_hkvt_t* hkvt, ARM_CFSTOR
         file->flags.read = flags.read;
         file->flags.write = flags.write;
         if(list_head != NULL){
-            cfstore_listAdd(list_head, &file->node, list_head);
+            /* all open files are on the list so their head pointers can be updated when KVs move */
+            cfstore_listAdd(list_head->prev, &file->node, list_head);
         }
     }
     return file;
@@ -2234,22 +3136,22 @@ static int32_t cfstore_file_destroy(cfstore_file_t* file)
 
     CFSTORE_FENTRYLOG("%s:entered\n", __func__);
     if(file) {
-        hkvt = cfstore_get_hkvt_from_head_ptr(file->head);
-        CFSTORE_ASSERT(cfstore_hkvt_is_valid(&hkvt, cfstore_ctx_get()->area_0_tail) == true);
+        hkvt = cfstore_get_hkvt(file);
+        CFSTORE_ASSERT(cfstore_hkvt_is_valid(&hkvt) == true);
         ret = ARM_DRIVER_OK;
         cfstore_hkvt_refcount_dec(&hkvt, &refcount);
         CFSTORE_TP(CFSTORE_TP_FILE, "%s:refcount =%d\n", __func__, (int)refcount);
+        /* delete the file even if not deleting the KV*/
+        cfstore_listDel(&file->node);
         if(refcount == 0){
             /* check for delete */
             CFSTORE_TP(CFSTORE_TP_FILE, "%s:checking delete flag\n", __func__);
             if(cfstore_hkvt_get_flags_delete(&hkvt)){
                 ret = cfstore_delete_ex(&hkvt);
             }
-            /* reset client buffer to empty ready for reuse */
-            /* delete the file even if not deleting the KV*/
-            cfstore_listDel(&file->node);
-            memset(file, 0, sizeof(cfstore_file_t));
         }
+        /* reset client buffer to empty ready for reuse */
+        memset(file, 0, sizeof(cfstore_file_t));
     }
     return ret;
 }
@@ -2268,13 +3170,7 @@ static bool cfstore_file_is_valid(ARM_CFSTORE_HANDLE hkey, cfstore_ctx_t* ctx)
 {
     cfstore_file_t* file = cfstore_file_get(hkey);
 
-    if(ctx->area_0_head != NULL && ctx->area_0_tail != NULL){
-        if(file->head < ctx->area_0_head || file->head > ctx->area_0_tail){
-            return 0;
-        }
-        return true;
-    }
-    return false;
+    return cfstore_area_page_find(ctx, file->head) != NULL;
 }
 
 /**
@@ -2634,7 +3530,7 @@ static int32_t cfstore_get_key_name(ARM_CFSTORE_HANDLE hkey, char* key_name, uin
     }
     memset(&hkvt, 0, sizeof(hkvt));
     hkvt = cfstore_get_hkvt(hkey);
-    if(!cfstore_hkvt_is_valid(&hkvt, ctx->area_0_tail)){
+    if(!cfstore_hkvt_is_valid(&hkvt)){
         CFSTORE_ERRLOG("%s:ARM_CFSTORE_DRIVER_ERROR_INVALID_HANDLE\n", __func__);
         ret = ARM_CFSTORE_DRIVER_ERROR_INVALID_HANDLE;
         goto out0;
@@ -2676,6 +3572,29 @@ static ARM_CFSTORE_STATUS cfstore_get_status(void)
     return status;
 }
 
+/* @brief  See definition in configuration_store.h for description. */
+static int32_t cfstore_get_flush_info(ARM_CFSTORE_FLUSH_INFO* info)
+{
+    cfstore_ctx_t* ctx = cfstore_ctx_get();
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    if(!cfstore_ctx_is_initialised(ctx)) {
+        CFSTORE_ERRLOG("%s:Error: CFSTORE is not initialised.\n", __func__);
+        return ARM_CFSTORE_DRIVER_ERROR_UNINITIALISED;
+    }
+    if(info == NULL) {
+        CFSTORE_ERRLOG("%s:Error: invalid info argument.\n", __func__);
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+    memset(info, 0, sizeof(ARM_CFSTORE_FLUSH_INFO));
+    info->dirty_len = ctx->area_dirty_len;
+#ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
+    info->last_flush_len = ctx->flush_bytes;
+    info->total_flush_len = ctx->flush_bytes_total;
+#endif /* CFSTORE_CONFIG_BACKEND_FLASH_ENABLED */
+    return ARM_DRIVER_OK;
+}
+
 /* @brief  See definition in configuration_store.h for description. */
 static int32_t cfstore_get_value_len(ARM_CFSTORE_HANDLE hkey, ARM_CFSTORE_SIZE *value_len)
 {
@@ -2705,7 +3624,7 @@ static int32_t cfstore_get_value_len(ARM_CFSTORE_HANDLE hkey, ARM_CFSTORE_SIZE *
         goto out0;
     }
     hkvt = cfstore_get_hkvt(hkey);
-    if(!cfstore_hkvt_is_valid(&hkvt, ctx->area_0_tail)){
+    if(!cfstore_hkvt_is_valid(&hkvt)){
         CFSTORE_ERRLOG("%s:ARM_CFSTORE_DRIVER_ERROR_INVALID_HANDLE\n", __func__);
         ret = ARM_CFSTORE_DRIVER_ERROR_INVALID_HANDLE;
         goto out0;
@@ -2748,10 +3667,11 @@ static CFSTORE_INLINE void cfstore_hkvt_dump(cfstore_area_hkvt_t* hkvt, const ch
      * col 4: the value of the pointer described in col 3 as an offset from the start of the sram area
      * col 5: field specified data e.g. for header, the extracted key length, value_length.
      */
-    CFSTORE_TP(CFSTORE_TP_VERBOSE3, "%s:hkvt->head:%8p:%8p:klen=%08d:vlen=%08d:\n", tag, hkvt->head, (void*)(hkvt->head - ctx->area_0_head), (int) klen, (int) vlen);
-    CFSTORE_TP(CFSTORE_TP_VERBOSE3, "%s:hkvt->key :%8p:%8p:%s\n", tag, hkvt->key, (void*)(hkvt->key - ctx->area_0_head), kname);
-    CFSTORE_TP(CFSTORE_TP_VERBOSE3, "%s:hkvt->val :%8p:%8p:%s\n", tag, hkvt->value, (void*)(hkvt->value - ctx->area_0_head), value);
-    CFSTORE_TP(CFSTORE_TP_VERBOSE3, "%s:hkvt->tail:%8p:%8p:\n", tag, hkvt->tail, (void*)(hkvt->tail - ctx->area_0_head));
+    CFSTORE_TP(CFSTORE_TP_VERBOSE3, "%s:hkvt->page:%8p:seq=%08d:\n", tag, hkvt->page, (int) hkvt->page->seq);
+    CFSTORE_TP(CFSTORE_TP_VERBOSE3, "%s:hkvt->head:%8p:%8p:klen=%08d:vlen=%08d:\n", tag, hkvt->head, (void*)(hkvt->head - cfstore_area_page_get_data(hkvt->page)), (int) klen, (int) vlen);
+    CFSTORE_TP(CFSTORE_TP_VERBOSE3, "%s:hkvt->key :%8p:%8p:%s\n", tag, hkvt->key, (void*)(hkvt->key - cfstore_area_page_get_data(hkvt->page)), kname);
+    CFSTORE_TP(CFSTORE_TP_VERBOSE3, "%s:hkvt->val :%8p:%8p:%s\n", tag, hkvt->value, (void*)(hkvt->value - cfstore_area_page_get_data(hkvt->page)), value);
+    CFSTORE_TP(CFSTORE_TP_VERBOSE3, "%s:hkvt->tail:%8p:%8p:\n", tag, hkvt->tail, (void*)(hkvt->tail - cfstore_area_page_get_data(hkvt->page)));
     return;
 #else
     (void) hkvt;
@@ -2805,8 +3725,7 @@ static CFSTORE_INLINE void cfstore_dump_contents(const char* tag)
     cfstore_ctx_t* ctx = cfstore_ctx_get();
 
     CFSTORE_TP(CFSTORE_TP_VERBOSE3, "%s:*** Dumping CFSTORE Contents : Start ***\n", tag);
-    CFSTORE_TP(CFSTORE_TP_VERBOSE3, "%s:cfstore_ctx_g.area_0_head=%8p\n", tag, ctx->area_0_head);
-    CFSTORE_TP(CFSTORE_TP_VERBOSE3, "%s:cfstore_ctx_g.area_0_tail=%8p\n", tag, ctx->area_0_tail);
+    CFSTORE_TP(CFSTORE_TP_VERBOSE3, "%s:cfstore_ctx_g.area_0_len=%d\n", tag, (int) ctx->area_0_len);
     ret = cfstore_get_head_hkvt(&hkvt);
     if(ret == ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND){
         CFSTORE_TP(CFSTORE_TP_VERBOSE1, "%s:CFSTORE has no KVs\n", tag);
@@ -2883,7 +3802,7 @@ static int32_t cfstore_delete(ARM_CFSTORE_HANDLE hkey)
     }
     hkvt = cfstore_get_hkvt(hkey);
     /* check its a valid hkvt */
-    if(!cfstore_hkvt_is_valid(&hkvt, ctx->area_0_tail)){
+    if(!cfstore_hkvt_is_valid(&hkvt)){
         CFSTORE_ERRLOG("%s:ARM_CFSTORE_DRIVER_ERROR_INVALID_HANDLE\n", __func__);
         ret = ARM_CFSTORE_DRIVER_ERROR_INVALID_HANDLE;
         goto out0;
@@ -2893,7 +3812,7 @@ static int32_t cfstore_delete(ARM_CFSTORE_HANDLE hkey)
     cfstore_hkvt_set_flags_delete(&hkvt, true);
 
     /* set the dirty flag so the changes are persisted to backing store when flushed */
-    ctx->area_dirty_flag = true;
+    cfstore_ctx_set_dirty(ctx, cfstore_hkvt_get_size(&hkvt));
 
 out0:
     /* Delete() always completes synchronously irrespective of flash mode, so indicate to caller */
@@ -2922,9 +3841,13 @@ static int32_t cfstore_find_ex(const char* key_name_query, cfstore_area_hkvt_t *
     int32_t ret = ARM_DRIVER_ERROR;
     uint8_t next_key_len;
     char key_name[CFSTORE_KEY_NAME_MAX_LENGTH+1];
-    cfstore_ctx_t* ctx = cfstore_ctx_get();
 
     CFSTORE_TP((CFSTORE_TP_FIND|CFSTORE_TP_FENTRY), "%s:entered: key_name_query=\"%s\", prev=%p, next=%p\n", __func__, key_name_query, prev, next);
+    /* use the key index if possible, otherwise walk the area */
+    ret = cfstore_index_find_ex(key_name_query, prev, next);
+    if(ret != ARM_DRIVER_ERROR_UNSUPPORTED){
+        return ret;
+    }
     if(prev == NULL){
         ret = cfstore_get_head_hkvt(next);
         /* CFSTORE_TP(CFSTORE_TP_FIND, "%s:next->head=%p, next->key=%p, next->value=%p, next->tail=%p, \n", __func__, next->head, next->key, next->value, next->tail); */
@@ -2937,7 +3860,7 @@ static int32_t cfstore_find_ex(const char* key_name_query, cfstore_area_hkvt_t *
         }
 
         /* check for no KVs in the store => hkvt is not valid */
-        if(!cfstore_hkvt_is_valid(next, ctx->area_0_tail)){
+        if(!cfstore_hkvt_is_valid(next)){
             /* no KVs in store */
             CFSTORE_TP(CFSTORE_TP_FIND, "%s:hkvt is not valid\n", __func__);
             return ARM_DRIVER_OK;
@@ -2957,9 +3880,8 @@ static int32_t cfstore_find_ex(const char* key_name_query, cfstore_area_hkvt_t *
         CFSTORE_TP(CFSTORE_TP_FIND, "%s:No more entries found\n", __func__);
         return ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND;
     }
-    /* CFSTORE_TP(CFSTORE_TP_FIND, "%s:cfstore_ctx_g.area_0_head=%p, cfstore_ctx_g.area_0_tail=%p\n", __func__, cfstore_ctx_g.area_0_head, cfstore_ctx_g.area_0_tail);*/
     cfstore_hkvt_dump(next, __func__);
-    while(cfstore_hkvt_is_valid(next, ctx->area_0_tail))
+    while(cfstore_hkvt_is_valid(next))
     {
         /* CFSTORE_TP(CFSTORE_TP_FIND, "%s:next->head=%p, next->key=%p, next->value=%p, next->tail=%p, \n", __func__, next->head, next->key, next->value, next->tail); */
         cfstore_hkvt_dump(next, __func__);
@@ -3052,7 +3974,7 @@ static int32_t cfstore_find(const char* key_name_query, const ARM_CFSTORE_HANDLE
         memset(phkvt_previous, 0, sizeof(hkvt_previous));
         hkvt_previous = cfstore_get_hkvt(previous);
         cfstore_hkvt_dump(&hkvt_previous, __func__);
-        if(!cfstore_hkvt_is_valid(phkvt_previous, ctx->area_0_tail)){
+        if(!cfstore_hkvt_is_valid(phkvt_previous)){
             ret = ARM_CFSTORE_DRIVER_ERROR_INVALID_HANDLE;
             goto out1;
         }
@@ -3067,7 +3989,7 @@ static int32_t cfstore_find(const char* key_name_query, const ARM_CFSTORE_HANDLE
         goto out2;
     }
 
-    if(!cfstore_hkvt_is_valid(&hkvt_next, ctx->area_0_tail)){
+    if(!cfstore_hkvt_is_valid(&hkvt_next)){
         CFSTORE_TP(CFSTORE_TP_FIND, "%s:Did not find any matching KVs.\n", __func__);
         ret = ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND;
         goto out2;
@@ -3093,7 +4015,7 @@ out2:
         cfstore_file_destroy(cfstore_file_get(previous));
 
         /* check hkvt is valid before trying to retrieve name*/
-        if(!cfstore_hkvt_is_valid(&hkvt_next, ctx->area_0_tail)){
+        if(!cfstore_hkvt_is_valid(&hkvt_next)){
             goto out1;
         }
         if(cfstore_get_key_name_ex(&hkvt_next, key_name, &key_len) < ARM_DRIVER_OK){
@@ -3123,9 +4045,8 @@ out1:
  * @note rw_lock must be held by the caller of this function rw_area0_lock */
 static int32_t cfstore_recreate(const char* key_name, ARM_CFSTORE_SIZE value_len, ARM_CFSTORE_HANDLE hkey, cfstore_area_hkvt_t* hkvt)
 {
-    uint8_t* ptr = NULL;
+    int32_t ret = ARM_DRIVER_ERROR;
     int32_t kv_size_diff = 0;
-    ARM_CFSTORE_SIZE area_size = 0;
     ARM_CFSTORE_FMODE flags;
     cfstore_ctx_t* ctx = cfstore_ctx_get();
 
@@ -3141,50 +4062,23 @@ static int32_t cfstore_recreate(const char* key_name, ARM_CFSTORE_SIZE value_len
         return ARM_DRIVER_OK;
     }
 
-    CFSTORE_TP(CFSTORE_TP_CREATE, "%s:cfstore_ctx_g.area_0_head=%p, cfstore_ctx_g.area_0_tail=%p\n", __func__, ctx->area_0_head, ctx->area_0_tail);
-    CFSTORE_TP(CFSTORE_TP_CREATE, "%s:sizeof(header)=%d, sizeof(key)=%d, sizeof(value)=%d, kv_size_diff=%d, area_size=%d\n", __func__, (int) sizeof(cfstore_area_header_t),  (int)(strlen(key_name)), (int)value_len, (int) kv_size_diff, (int) area_size);
-
-    /* grow the area by the size of the new KV */
-    area_size = cfstore_ctx_get_area_len();
-    if (kv_size_diff < 0){
-        /* value blob size shrinking => do memmove() before realloc() which will free memory */
-        memmove(hkvt->tail + kv_size_diff, hkvt->tail, ctx->area_0_tail - hkvt->tail);
-        //todo: wip: do we have to update file pointers for KVs after the one thats changed size?
-    }
-    ptr = (uint8_t*) CFSTORE_REALLOC((void*) ctx->area_0_head, area_size + kv_size_diff);
-    if(ptr == NULL){
-        CFSTORE_ERRLOG("%s:realloc failed for key_name=%s\n", __func__, key_name);
-        cfstore_ctx_reset(ctx);
-        return ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY;
-    }
-    if(ptr != ctx->area_0_head){
-        CFSTORE_TP(CFSTORE_TP_CREATE, "%s:cfstore_ctx_g.area_0_head pointer changed (cfstore_ctx_g.area_0_head=%p, cfstore_ctx_g.area_0_tail=%p)\n", __func__, ctx->area_0_head, ptr);
-        /* This covers the cases where CFSTORE_REALLOC() has moved the area in memory
-         * As realloc() has caused the memory to move, hkvt needs re-initialising */
-        hkvt->head += ptr - ctx->area_0_head;
-        hkvt->key += ptr - ctx->area_0_head;
-        hkvt->value +=  ptr - ctx->area_0_head;
-        hkvt->tail += ptr - ctx->area_0_head;
-        /* Set head and tail to old relative position in new area */
-        ctx->area_0_head = ptr;
-        ctx->area_0_tail = ctx->area_0_head + area_size;
-        //todo: wip: do we have to update file pointers for KVs after the memory has moved?
-    }
-
-    if(kv_size_diff > 0) {
-        /* value blob size growing requires memmove() after realloc() */
-        memset(ctx->area_0_tail, 0, kv_size_diff);
-        memmove(hkvt->tail+kv_size_diff, hkvt->tail, ctx->area_0_tail - hkvt->tail);
-        //todo: wip: do we have to update file pointers for KVs after the one thats changed size?
-    }
-    /* hkvt->head, hkvt->key and hkvt->value remain unchanged but hkvt->tail has moved. Update it.*/
+    CFSTORE_TP(CFSTORE_TP_CREATE, "%s:cfstore_ctx_g.area_0_len=%d, hkvt->page=%p\n", __func__, (int) ctx->area_0_len, hkvt->page);
+    CFSTORE_TP(CFSTORE_TP_CREATE, "%s:sizeof(header)=%d, sizeof(key)=%d, sizeof(value)=%d, kv_size_diff=%d\n", __func__, (int) sizeof(cfstore_area_header_t),  (int)(strlen(key_name)), (int)value_len, (int) kv_size_diff);
+
+    /* grow/shrink the KV within its page. This only moves the KVs of the page,
+     * updating the file head pointers and index entries for them */
+    ret = cfstore_area_resize_hkvt(ctx, hkvt, kv_size_diff);
+    if(ret < ARM_DRIVER_OK){
+        CFSTORE_ERRLOG("%s:failed to resize KV for key_name=%s\n", __func__, key_name);
+        return ret;
+    }
+    /* hkvt->head, hkvt->key and hkvt->value are relative to the page but hkvt->tail has moved. Update it.*/
     hkvt->tail = hkvt->tail + kv_size_diff;
 
     /* set the new value length in the header */
     cfstore_hkvt_set_value_len(hkvt, value_len);
-    ctx->area_0_tail = ctx->area_0_head + area_size + kv_size_diff;
     cfstore_file_create(hkvt, flags, hkey, &ctx->file_list);
-    ctx->area_dirty_flag = true;
+    cfstore_ctx_set_dirty(ctx, cfstore_hkvt_get_size(hkvt));
 
 #ifdef CFSTORE_DEBUG
     cfstore_hkvt_dump(hkvt, __func__);
@@ -3198,13 +4092,11 @@ static int32_t cfstore_recreate(const char* key_name, ARM_CFSTORE_SIZE value_len
 static int32_t cfstore_create(const char* key_name, ARM_CFSTORE_SIZE value_len, const ARM_CFSTORE_KEYDESC* kdesc, ARM_CFSTORE_HANDLE hkey)
 {
     bool b_acl_default = false;
-    uint8_t* ptr = NULL;
     int32_t ret = ARM_DRIVER_ERROR;
     int32_t cfstore_uvisor_box_id = 0;
-    ARM_CFSTORE_SIZE area_size = 0;
     ARM_CFSTORE_SIZE kv_size = 0;
-    ARM_CFSTORE_SIZE realloc_size = 0;
     cfstore_area_header_t* hdr;
+    cfstore_area_page_t* page = NULL;
     cfstore_area_hkvt_t hkvt;
     cfstore_ctx_t* ctx = cfstore_ctx_get();
     ARM_CFSTORE_FMODE flags;
@@ -3254,7 +4146,7 @@ static int32_t cfstore_create(const char* key_name, ARM_CFSTORE_SIZE value_len,
         goto out1;
     }
 
-    if(ret != ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND && cfstore_hkvt_is_valid(&hkvt, ctx->area_0_tail)){
+    if(ret != ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND && cfstore_hkvt_is_valid(&hkvt)){
         /* found pre-existing entry; */
         if(cfstore_hkvt_get_flags_delete(&hkvt)){
             CFSTORE_ERRLOG("%s:CFSTORE pre-existing KV with key_name=\"%s\" deleting\n", __func__, key_name);
@@ -3284,43 +4176,15 @@ static int32_t cfstore_create(const char* key_name, ARM_CFSTORE_SIZE value_len,
     kv_size += value_len;
     kv_size += sizeof(cfstore_area_header_t);
 
-    /* grow the area by the size of the new KV
-     * In the general case the new ((area_size + kv_size) % program_unit > 0). The new area_size is
-     * aligned to a program_unit boundary to facilitate r/w to flash and so the memory realloc size
-     * is calculated to align, as follows */
-    area_size = cfstore_ctx_get_area_len();
-    // moved to flash_init() and program_unit stored in ctx
-    /*
-    status = FlashJournal_getInfo(&ctx->jrnl, &info);
-    if(status < JOURNAL_STATUS_OK){
-        CFSTORE_TP(CFSTORE_TP_CREATE, "%s:Error: failed get journal info (status=%d)\n", __func__, (int) status);
-        ret = cfstore_flash_map_error(status);
-        goto out1;
-    }
-    */
-    /* setup the reallocation memory size. */
-    realloc_size = area_size + kv_size;
-    if(realloc_size % cfstore_ctx_get_program_unit(ctx) > 0){
-        realloc_size += (cfstore_ctx_get_program_unit(ctx) - (realloc_size % cfstore_ctx_get_program_unit(ctx)));
-    }
-    ptr = (uint8_t*) CFSTORE_REALLOC((void*) ctx->area_0_head, realloc_size);
-    if(ptr == NULL){
-        CFSTORE_ERRLOG("%s:realloc failed for key_name=%s\n", __func__, key_name);
-        cfstore_ctx_reset(ctx);
+    /* the KV is appended to the last page, or to a new page if there isn't room.
+     * Padding the area to the flash program_unit is done when flushing. */
+    page = cfstore_area_get_tail_page(ctx, kv_size);
+    if(page == NULL){
+        CFSTORE_ERRLOG("%s:page allocation failed for key_name=%s\n", __func__, key_name);
         ret = ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY;
         goto out1;
     }
-    if(ptr != ctx->area_0_head){
-        CFSTORE_TP(CFSTORE_TP_CREATE, "%s:cfstore_ctx_g.area_0_head pointer changed (cfstore_ctx_g.area_0_head=%p, cfstore_ctx_g.area_0_tail=%p)\n", __func__, ctx->area_0_head, ptr);
-        /* this covers the following cases:
-         * - this is the first KV insertion in the area, which is special as both area head/tail pointers need setting.
-         * - realloc() has move the area in memory */
-        ctx->area_0_head = ptr;
-        ctx->area_0_tail = ctx->area_0_head + area_size;
-    }
-
-    /* check realloc() hasnt move area in memory from cfstore_ctx_g.area_0_head*/
-    CFSTORE_TP(CFSTORE_TP_CREATE, "%s:cfstore_ctx_g.area_0_head=%p, ptr=%p\n", __func__, ctx->area_0_head, ptr);
+    CFSTORE_TP(CFSTORE_TP_CREATE, "%s:page=%p, page->seq=%d, page->used=%d\n", __func__, page, (int) page->seq, (int) page->used);
 
     /* determine if should adopt a default behavior for acl permission setting */
     if(cfstore_acl_is_default(kdesc->acl)){
@@ -3329,8 +4193,8 @@ static int32_t cfstore_create(const char* key_name, ARM_CFSTORE_SIZE value_len,
         b_acl_default = true;
     }
     /* set the header up, then copy key_name into header */
-    memset(ctx->area_0_tail, 0, kv_size);
-    hdr = (cfstore_area_header_t*) ctx->area_0_tail;
+    hdr = (cfstore_area_header_t*) (cfstore_area_page_get_data(page) + page->used);
+    memset(hdr, 0, kv_size);
     hdr->klength = (uint8_t) strlen(key_name);
     hdr->vlength = value_len;
     hdr->perm_owner_read = b_acl_default ? true : kdesc->acl.perm_owner_read;
@@ -3340,9 +4204,12 @@ static int32_t cfstore_create(const char* key_name, ARM_CFSTORE_SIZE value_len,
     hdr->perm_other_write = kdesc->acl.perm_other_write;
     hdr->perm_other_execute = kdesc->acl.perm_other_execute;
     strncpy((char*)hdr + sizeof(cfstore_area_header_t), key_name, strlen(key_name));
-    /* Updating the area_0_tail pointer reveals the inserted KV to other operations. See [NOTE1] for details.*/
-    ctx->area_0_tail = ctx->area_0_head + area_size + kv_size;
-    hkvt = cfstore_get_hkvt_from_head_ptr((uint8_t*) hdr);
+    /* Updating the page used count reveals the inserted KV to other operations. See [NOTE1] for details.*/
+    page->used += kv_size;
+    ctx->area_0_len += kv_size;
+    cfstore_area_page_set_dirty(page);
+    hkvt = cfstore_get_hkvt_from_head_ptr(page, (uint8_t*) hdr);
+    cfstore_index_insert(ctx, &hkvt);
     if(cfstore_flags_is_default(kdesc->flags)){
         /* set as read-only by default default */
         flags.read = true;
@@ -3352,7 +4219,7 @@ static int32_t cfstore_create(const char* key_name, ARM_CFSTORE_SIZE value_len,
         flags.write = kdesc->flags.write;
     }
     cfstore_file_create(&hkvt, flags, hkey, &ctx->file_list);
-    ctx->area_dirty_flag = true;
+    cfstore_ctx_set_dirty(ctx, kv_size);
     ret = ARM_DRIVER_OK;
 out1:
     cfstore_hkvt_dump(&hkvt,  __func__);
@@ -3415,7 +4282,7 @@ static int32_t cfstore_open(const char* key_name, ARM_CFSTORE_FMODE flags, ARM_C
         CFSTORE_TP(CFSTORE_TP_OPEN, "%s:debug: find failed or no more kvs.\n", __func__);
         goto out1;
     }
-    if(!cfstore_hkvt_is_valid(&hkvt, ctx->area_0_tail))
+    if(!cfstore_hkvt_is_valid(&hkvt))
     {
         CFSTORE_ERRLOG("%s:Error: Could not find pre-existing key to open with key_name=(%s).\n", __func__, key_name);
         ret = ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND;
@@ -3490,7 +4357,7 @@ static int32_t cfstore_close(ARM_CFSTORE_HANDLE hkey)
     }
     /* check the hkey is valid */
     hkvt = cfstore_get_hkvt(hkey);
-    if(!cfstore_hkvt_is_valid(&hkvt, ctx->area_0_tail)){
+    if(!cfstore_hkvt_is_valid(&hkvt)){
         CFSTORE_ERRLOG("%s:ARM_CFSTORE_DRIVER_ERROR_INVALID_HANDLE\n", __func__);
         ret = ARM_CFSTORE_DRIVER_ERROR_INVALID_HANDLE;
         goto out0;
@@ -3550,7 +4417,7 @@ static int32_t cfstore_read(ARM_CFSTORE_HANDLE hkey, void* data, ARM_CFSTORE_SIZ
     cfstore_hkvt_init(&hkvt);
     hkvt = cfstore_get_hkvt(hkey);
     /* check the hkey is valid */
-    if(!cfstore_hkvt_is_valid(&hkvt, ctx->area_0_tail)){
+    if(!cfstore_hkvt_is_valid(&hkvt)){
         CFSTORE_ERRLOG("%s:ARM_CFSTORE_DRIVER_ERROR_INVALID_HANDLE\n", __func__);
         ret = ARM_CFSTORE_DRIVER_ERROR_INVALID_HANDLE;
         goto out0;
@@ -3626,7 +4493,7 @@ static int32_t cfstore_write(ARM_CFSTORE_HANDLE hkey, const char* data, ARM_CFST
     }
     memset(&hkvt, 0, sizeof(hkvt));
     hkvt = cfstore_get_hkvt(hkey);
-    if(!cfstore_hkvt_is_valid(&hkvt, ctx->area_0_tail)){
+    if(!cfstore_hkvt_is_valid(&hkvt)){
         CFSTORE_ERRLOG("%s:Error: ARM_CFSTORE_DRIVER_ERROR_INVALID_HANDLE.\n", __func__);
         ret = ARM_CFSTORE_DRIVER_ERROR_INVALID_HANDLE;
         goto out0;
@@ -3638,10 +4505,14 @@ static int32_t cfstore_write(ARM_CFSTORE_HANDLE hkey, const char* data, ARM_CFST
     }
     value_len = (ARM_CFSTORE_SIZE) cfstore_hkvt_get_value_len(&hkvt);
     *len = *len < value_len ? *len: value_len;
-    memcpy(hkvt.value + file->wlocation, data, *len);
+    /* rewriting a value with the data it already holds leaves nothing to flush */
+    if(memcmp(hkvt.value + file->wlocation, data, *len) != 0){
+        memcpy(hkvt.value + file->wlocation, data, *len);
+        cfstore_area_page_set_dirty(hkvt.page);
+        cfstore_ctx_set_dirty(ctx, *len);
+    }
     file->wlocation += *len;
     cfstore_hkvt_dump(&hkvt, __func__);
-    ctx->area_dirty_flag = true;
     ret = *len;
 out0:
     /* Write() always completes synchronously irrespective of flash mode, so indicate to caller */
@@ -3685,7 +4556,7 @@ static int32_t cfstore_rseek(ARM_CFSTORE_HANDLE hkey, ARM_CFSTORE_OFFSET offset)
     }
     cfstore_hkvt_init(&hkvt);
     hkvt = cfstore_get_hkvt(hkey);
-    if(!cfstore_hkvt_is_valid(&hkvt, ctx->area_0_tail)){
+    if(!cfstore_hkvt_is_valid(&hkvt)){
         CFSTORE_ERRLOG("%s:Error: ARM_CFSTORE_DRIVER_ERROR_INVALID_HANDLE.\n", __func__);
         ret = ARM_CFSTORE_DRIVER_ERROR_INVALID_HANDLE;
         goto out0;
@@ -3763,8 +4634,10 @@ static int32_t cfstore_initialise(ARM_CFSTORE_CALLBACK callback, void* client_co
         /* This is not required here are the lock is statically initialised to 0
          *  cfstore_critical_section_init(&ctx->rw_area0_lock);
          */
-        ctx->area_0_head = NULL;
-        ctx->area_0_tail = NULL;
+        CFSTORE_INIT_LIST_HEAD(&ctx->area_0_pages);
+        ctx->area_0_len = 0;
+        ctx->area_0_seq = 0;
+        cfstore_index_rebuild(ctx);
 
         CFSTORE_ASSERT(sizeof(cfstore_file_t) == CFSTORE_HANDLE_BUFSIZE);
         if(sizeof(cfstore_file_t) != CFSTORE_HANDLE_BUFSIZE){
@@ -3775,6 +4648,7 @@ static int32_t cfstore_initialise(ARM_CFSTORE_CALLBACK callback, void* client_co
         ctx->client_callback = callback;
         ctx->client_context = client_context;
         ctx->area_dirty_flag = false;
+        ctx->area_dirty_len = 0;
         ctx->client_callback_notify_flag = false;
 
         cfstore_client_notify_data_init(&ctx->client_notify_data, CFSTORE_OPCODE_MAX, ARM_DRIVER_ERROR, NULL);
@@ -3782,6 +4656,8 @@ static int32_t cfstore_initialise(ARM_CFSTORE_CALLBACK callback, void* client_co
         ctx->status = ARM_DRIVER_OK;
 
 #ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
+        ctx->flush_bytes = 0;
+        ctx->flush_bytes_total = 0;
         /* set the cfstore async flag according to the storage driver mode */
         storage_caps = cfstore_storage_drv->GetCapabilities();
         cfstore_caps_g.asynchronous_ops = storage_caps.asynchronous_ops;
@@ -3851,11 +4727,8 @@ static int32_t cfstore_uninitialise(void)
             CFSTORE_ERRLOG("%s:Error: failed to uninitialise flash journal layer.\n", __func__);
             goto out;
         }
-        if(ctx->area_0_head){
-            CFSTORE_FREE(ctx->area_0_head);
-            ctx->area_0_head = NULL;
-            ctx->area_0_tail = NULL;
-        }
+        cfstore_area_free(ctx);
+        cfstore_index_free(ctx);
     }
 out:
     /* notify client */
@@ -4094,6 +4967,7 @@ ARM_CFSTORE_DRIVER cfstore_driver =
         .Rseek = cfstore_uvisor_rseek,
         .Uninitialize = cfstore_uvisor_uninitialize,
         .Write = cfstore_uvisor_write,
+        .GetFlushInfo = cfstore_get_flush_info,
 };
 
 #else
@@ -4118,6 +4992,7 @@ ARM_CFSTORE_DRIVER cfstore_driver =
         .Rseek = cfstore_rseek,
         .Uninitialize = cfstore_uninitialise,
         .Write = cfstore_write,
+        .GetFlushInfo = cfstore_get_flush_info,
 };
 
 #endif /* YOTTA_CFG_CFSTORE_UVISOR */
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2006-2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __FLASH_JOURNAL_LOG_CONFIG_H__
+#define __FLASH_JOURNAL_LOG_CONFIG_H__
+
+/**
+ * Maximum number of delta records which may follow a base record before the
+ * journal rewrites the complete blob as a new base record. Longer chains mean
+ * fewer bytes programmed per commit but slower reads.
+ */
+#ifndef LOG_FLASH_JOURNAL_MAX_DELTAS
+#define LOG_FLASH_JOURNAL_MAX_DELTAS 6
+#endif
+
+/**
+ * The usable log space (all sectors but one) is divided by this value to
+ * obtain the largest record the journal will write. Records need to fit twice
+ * into the usable space so that a new base record can always be written
+ * without disturbing the last committed state.
+ */
+#ifndef LOG_FLASH_JOURNAL_CAPACITY_DIVISOR
+#define LOG_FLASH_JOURNAL_CAPACITY_DIVISOR 3
+#endif
+
+/**
+ * Space reserved in every record for patch headers; bounds the number of
+ * log() calls (each may add one patch header to a record).
+ */
+#ifndef LOG_FLASH_JOURNAL_PATCH_SLACK
+#define LOG_FLASH_JOURNAL_PATCH_SLACK 256
+#endif
+
+/**
+ * Largest program_unit of the underlying MTD supported by the journal.
+ * Partially filled program units are staged in the journal handle.
+ */
+#define LOG_FLASH_JOURNAL_MAX_PROGRAM_UNIT 16
+
+/**
+ * Size of the stack buffer used to compare logged data against the
+ * previously committed blob.
+ */
+#ifndef LOG_FLASH_JOURNAL_COMPARE_BUFFER_SIZE
+#define LOG_FLASH_JOURNAL_COMPARE_BUFFER_SIZE 64
+#endif
+
+#endif /* __FLASH_JOURNAL_LOG_CONFIG_H__ */
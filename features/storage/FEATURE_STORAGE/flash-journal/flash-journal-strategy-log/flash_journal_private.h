@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2006-2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __FLASH_JOURNAL_LOG_PRIVATE_H__
+#define __FLASH_JOURNAL_LOG_PRIVATE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "flash-journal/flash_journal.h"
+#include "flash-journal-strategy-log/config.h"
+
+static const uint32_t LOG_FLASH_JOURNAL_VERSION        = 1;
+static const uint32_t LOG_FLASH_JOURNAL_SECTOR_MAGIC   = 0xCE0210C5UL;
+static const uint32_t LOG_FLASH_JOURNAL_RECORD_MAGIC   = 0xCE0210C6UL;
+static const uint32_t LOG_FLASH_JOURNAL_TAIL_MARKER    = 0x7A11E60FUL; /* can never be a valid patch offset */
+static const uint32_t LOG_FLASH_JOURNAL_INVALID_OFFSET = 0xFFFFFFFFUL;
+
+/* record flags */
+#define LOG_FLASH_JOURNAL_RECORD_BASE  0x1 /**< record contains the complete blob rather than a delta. */
+
+typedef enum {
+    LOG_JOURNAL_STATE_NOT_INITIALIZED,
+    LOG_JOURNAL_STATE_INIT_SCANNING_LOG,
+    LOG_JOURNAL_STATE_INITIALIZED,
+    LOG_JOURNAL_STATE_RESETING,
+    LOG_JOURNAL_STATE_LOGGING_BODY,
+} LogFlashJournalState_t;
+
+/**
+ * Meta-data placed at the start of every erase sector of the log.
+ *
+ * @note the magic is placed at the end of this structure so that a partially
+ *     written sector-head won't be accepted as valid.
+ */
+typedef struct _LogFlashJournalSectorHead {
+    uint32_t sectorNumber; /**< logical sector number; increases by one every time the log enters a new sector. */
+    uint32_t liveStart;    /**< log position of the base record of the committed state, or LOG_FLASH_JOURNAL_INVALID_OFFSET. */
+    uint32_t recordStart;  /**< log position of the record being written when this sector was entered. */
+    uint32_t magic;
+} LogFlashJournalSectorHead_t;
+
+#define LOG_JOURNAL_VALID_SECTOR_HEAD(PTR, SECTOR_NUMBER) \
+    (((PTR)->magic == LOG_FLASH_JOURNAL_SECTOR_MAGIC) && ((PTR)->sectorNumber == (SECTOR_NUMBER)))
+
+/**
+ * Meta-data placed at the head of a log record. It is followed by a sequence
+ * of patches (a LogFlashJournalPatchHead_t followed by 'length' octets of
+ * data) and terminated by a LogFlashJournalRecordTail_t.
+ */
+typedef struct _LogFlashJournalRecordHead {
+    uint32_t version;
+    uint32_t sequenceNumber;
+    uint32_t flags;
+    uint32_t magic;
+} LogFlashJournalRecordHead_t;
+
+#define LOG_JOURNAL_VALID_RECORD_HEAD(PTR) \
+    (((PTR)->version == LOG_FLASH_JOURNAL_VERSION) && ((PTR)->magic == LOG_FLASH_JOURNAL_RECORD_MAGIC))
+
+typedef struct _LogFlashJournalPatchHead {
+    uint32_t offset;       /**< offset within the blob; LOG_FLASH_JOURNAL_TAIL_MARKER for the record tail. */
+    uint32_t length;
+} LogFlashJournalPatchHead_t;
+
+/**
+ * Meta-data terminating a log record. A record is only considered committed
+ * once its tail has been written out completely.
+ *
+ * @note the most crucial items are placed at the end of this structure; this
+ *     ensures that a partially written tail won't be accepted as valid.
+ */
+typedef struct _LogFlashJournalRecordTail {
+    uint32_t marker;         /**< LOG_FLASH_JOURNAL_TAIL_MARKER; overlays LogFlashJournalPatchHead_t::offset. */
+    uint32_t crc;            /**< CRC32 over the record-head and all patches. */
+    uint32_t sizeofBlob;     /**< size of the blob after applying this record. */
+    uint32_t magic;
+    uint32_t sequenceNumber;
+} LogFlashJournalRecordTail_t;
+
+typedef struct _LogFlashJournal_t {
+    FlashJournal_Ops_t             ops;                /**< the mandatory OPS table defining the strategy. */
+    FlashJournal_Callback_t        callback;           /**< command completion callback. */
+    FlashJournal_Info_t            info;               /**< the info structure returned from GetInfo(). */
+    ARM_DRIVER_STORAGE            *mtd;                /**< The underlying Memory-Technology-Device. */
+    ARM_STORAGE_CAPABILITIES       mtdCapabilities;    /**< the return from mtd->GetCapabilities(); held for quick reference. */
+    uint64_t                       mtdStartOffset;     /**< the start of the address range maintained by the underlying MTD. */
+    uint32_t                       sectorSize;         /**< size of an erase sector. */
+    uint32_t                       sectorCount;        /**< number of sectors in the log ring. */
+    uint32_t                       maxRecordSize;      /**< largest record which may be written. */
+    uint16_t                       sectorHeadSize;     /**< size of LogFlashJournalSectorHead_t rounded up to the program unit. */
+    uint8_t                        programUnit;        /**< program unit of the MTD. */
+    uint8_t                        erasedValue;        /**< value of an erased octet. */
+    LogFlashJournalState_t         state;              /**< state of the journal. LOG_JOURNAL_STATE_INITIALIZED being the default. */
+    FlashJournal_OpCode_t          prevCommand;        /**< the last command issued to the journal. */
+    uint32_t                       nextSequenceNumber; /**< sequence number for the next record. */
+    uint32_t                       head;               /**< log position up to which data has been programmed. */
+
+    /**
+     * Log positions of the records making up the committed state: a base
+     * record followed by up to LOG_FLASH_JOURNAL_MAX_DELTAS delta records.
+     */
+    uint32_t                       chain[LOG_FLASH_JOURNAL_MAX_DELTAS + 1];
+    uint32_t                       chainLength;
+
+    /** state relevant to the record currently being logged. */
+    struct {
+        uint32_t recordStart;  /**< log position of the record-head. */
+        uint32_t crc;          /**< running CRC32 over the record. */
+        uint32_t sizeofBlob;   /**< amount of blob data logged so far. */
+        uint32_t programmed;   /**< octets programmed for the record so far, including sector-heads. */
+        uint8_t  flags;        /**< LOG_FLASH_JOURNAL_RECORD_xxx flags. */
+        uint8_t  stageFill;    /**< octets held in 'stage' not yet programmed. */
+        uint8_t  stage[LOG_FLASH_JOURNAL_MAX_PROGRAM_UNIT];
+    } log;
+
+    /** state relevant to read-back of data. */
+    struct {
+        uint32_t totalDataRead; /**< the total data that has been read off the blob so far. */
+    } read;
+} LogFlashJournal_t;
+
+/**<
+ * A static assert to ensure that the size of LogJournal is smaller than
+ * FlashJournal_t. The caller will only allocate a FlashJournal_t and expect the
+ * Log Strategy to reuse that space for a LogFlashJournal_t.
+ */
+typedef char AssertLogJournalSizeLessThanOrEqualToGenericJournal[sizeof(LogFlashJournal_t)<=sizeof(FlashJournal_t)?1:-1];
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* __FLASH_JOURNAL_LOG_PRIVATE_H__ */
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2006-2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __FLASH_JOURNAL_STRATEGY_LOG_H__
+#define __FLASH_JOURNAL_STRATEGY_LOG_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "flash-journal/flash_journal.h"
+
+/**
+ * A log-structured journal strategy.
+ *
+ * The MTD is treated as a ring of erase sectors. Every commit appends a record
+ * at the head of the log; only the sector the head moves into is erased, so
+ * sectors are erased in turn (wear levelling) and a commit which fits into the
+ * current sector requires no erase at all.
+ *
+ * Records are either base records, containing the complete blob, or delta
+ * records, containing only those ranges of the blob which differ from the
+ * previously committed state. Logged data is compared against the committed
+ * state, so callers keep logging the complete blob and the journal decides
+ * what needs to be programmed.
+ *
+ * Initialization scans the log from the oldest record still in use and
+ * recovers the latest record with a valid tail; partially written records are
+ * discarded.
+ *
+ * @note This strategy requires an MTD which completes operations
+ *     synchronously. Logged data doesn't need to be aligned with the MTD's
+ *     program_unit; getInfo() reports a program_unit of 1.
+ */
+int32_t               flashJournalStrategyLog_initialize(FlashJournal_t           *journal,
+                                                         ARM_DRIVER_STORAGE       *mtd,
+                                                         const FlashJournal_Ops_t *ops,
+                                                         FlashJournal_Callback_t   callback);
+FlashJournal_Status_t flashJournalStrategyLog_getInfo(FlashJournal_t *journal, FlashJournal_Info_t *info);
+int32_t               flashJournalStrategyLog_read(FlashJournal_t *journal, void *blob, size_t n);
+int32_t               flashJournalStrategyLog_log(FlashJournal_t *journal, const void *blob, size_t n);
+int32_t               flashJournalStrategyLog_commit(FlashJournal_t *journal);
+int32_t               flashJournalStrategyLog_reset(FlashJournal_t *journal);
+
+/**
+ * Log n bytes of the blob which are known to be unchanged from the committed
+ * state, in place of a log() of the same bytes. The journal then neither
+ * reads back nor compares that range, and a delta record doesn't grow.
+ *
+ * This isn't part of FlashJournal_Ops_t; it is for callers which track
+ * their own changes and know that they are using this strategy.
+ *
+ * @note The range, from the current offset in the blob being logged, must
+ *     be within the committed blob. skip() completes synchronously and
+ *     returns n on success.
+ */
+int32_t               flashJournalStrategyLog_skip(FlashJournal_t *journal, size_t n);
+
+static const FlashJournal_Ops_t FLASH_JOURNAL_STRATEGY_LOG = {
+    flashJournalStrategyLog_initialize,
+    flashJournalStrategyLog_getInfo,
+    flashJournalStrategyLog_read,
+    flashJournalStrategyLog_log,
+    flashJournalStrategyLog_commit,
+    flashJournalStrategyLog_reset
+};
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* __FLASH_JOURNAL_STRATEGY_LOG_H__ */
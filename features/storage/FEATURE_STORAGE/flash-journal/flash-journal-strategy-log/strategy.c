@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2006-2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flash-journal-strategy-log/flash_journal_private.h"
+#include "flash-journal-strategy-log/flash_journal_strategy_log.h"
+#include "support_funcs.h"
+#include <string.h>
+
+static inline int32_t flashJournalStrategyLog_read_sanityChecks(LogFlashJournal_t *journal, const void *blob, size_t sizeofBlob)
+{
+    if ((journal == NULL) || (blob == NULL) || (sizeofBlob == 0)) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+    if ((journal->state == LOG_JOURNAL_STATE_NOT_INITIALIZED) || (journal->state == LOG_JOURNAL_STATE_INIT_SCANNING_LOG)) {
+        return JOURNAL_STATUS_NOT_INITIALIZED;
+    }
+    if (journal->state != LOG_JOURNAL_STATE_INITIALIZED) {
+        return JOURNAL_STATUS_ERROR; /* journal is in an un-expected state. */
+    }
+    /* a read following any other command starts again from the beginning of the blob */
+    if ((journal->info.sizeofJournaledBlob == 0) ||
+        ((journal->prevCommand == FLASH_JOURNAL_OPCODE_READ_BLOB) && (journal->read.totalDataRead == journal->info.sizeofJournaledBlob))) {
+        journal->read.totalDataRead = 0;
+        return JOURNAL_STATUS_EMPTY;
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+static inline int32_t flashJournalStrategyLog_append_sanityChecks(LogFlashJournal_t *journal, size_t sizeofBlob)
+{
+    if ((journal->state == LOG_JOURNAL_STATE_NOT_INITIALIZED) || (journal->state == LOG_JOURNAL_STATE_INIT_SCANNING_LOG)) {
+        return JOURNAL_STATUS_NOT_INITIALIZED;
+    }
+    if ((journal->state != LOG_JOURNAL_STATE_INITIALIZED) && (journal->state != LOG_JOURNAL_STATE_LOGGING_BODY)) {
+        return JOURNAL_STATUS_ERROR; /* journal is in an un-expected state. */
+    }
+    if (journal->state == LOG_JOURNAL_STATE_INITIALIZED) {
+        if (sizeofBlob > journal->info.capacity) {
+            return JOURNAL_STATUS_BOUNDED_CAPACITY;
+        }
+    } else {
+        /* Besides the blob, the record needs to hold one more patch-head,
+         * the tail and padding up to the next program unit. */
+        uint32_t recordSize = journal->head + journal->log.stageFill - journal->log.recordStart;
+        if ((journal->log.sizeofBlob + sizeofBlob > journal->info.capacity) ||
+            (recordSize + sizeof(LogFlashJournalPatchHead_t) + sizeofBlob + sizeof(LogFlashJournalRecordTail_t) + journal->programUnit > journal->maxRecordSize)) {
+            return JOURNAL_STATUS_BOUNDED_CAPACITY;
+        }
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+static inline int32_t flashJournalStrategyLog_log_sanityChecks(LogFlashJournal_t *journal, const void *blob, size_t sizeofBlob)
+{
+    if ((journal == NULL) || (blob == NULL) || (sizeofBlob == 0)) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+
+    return flashJournalStrategyLog_append_sanityChecks(journal, sizeofBlob);
+}
+
+static inline int32_t flashJournalStrategyLog_skip_sanityChecks(LogFlashJournal_t *journal, size_t sizeofBlob)
+{
+    if ((journal == NULL) || (sizeofBlob == 0)) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+
+    return flashJournalStrategyLog_append_sanityChecks(journal, sizeofBlob);
+}
+
+static inline int32_t flashJournalStrategyLog_commit_sanityChecks(LogFlashJournal_t *journal)
+{
+    if (journal == NULL) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+    if ((journal->state == LOG_JOURNAL_STATE_NOT_INITIALIZED) || (journal->state == LOG_JOURNAL_STATE_INIT_SCANNING_LOG)) {
+        return JOURNAL_STATUS_NOT_INITIALIZED;
+    }
+    if (journal->state == LOG_JOURNAL_STATE_LOGGING_BODY) {
+        if (journal->prevCommand != FLASH_JOURNAL_OPCODE_LOG_BLOB) {
+            return JOURNAL_STATUS_ERROR;
+        }
+    } else if (journal->state != LOG_JOURNAL_STATE_INITIALIZED) {
+        return JOURNAL_STATUS_ERROR; /* journal is in an un-expected state. */
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+int32_t flashJournalStrategyLog_initialize(FlashJournal_t           *_journal,
+                                           ARM_DRIVER_STORAGE       *mtd,
+                                           const FlashJournal_Ops_t *ops,
+                                           FlashJournal_Callback_t   callback)
+{
+    int32_t rc;
+
+    LogFlashJournal_t *journal = (LogFlashJournal_t *)_journal;
+    journal->state             = LOG_JOURNAL_STATE_NOT_INITIALIZED;
+
+    /* the log is replayed and appended to synchronously */
+    ARM_STORAGE_CAPABILITIES mtdCaps = mtd->GetCapabilities();
+    if (mtdCaps.asynchronous_ops) {
+        return JOURNAL_STATUS_UNSUPPORTED;
+    }
+
+    /* fetch MTD's INFO and the geometry of the first storage block */
+    ARM_STORAGE_INFO mtdInfo;
+    if ((rc = mtd->GetInfo(&mtdInfo)) != ARM_DRIVER_OK) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+    ARM_STORAGE_BLOCK mtdBlock;
+    if ((mtd->GetNextBlock(NULL, &mtdBlock)) != ARM_DRIVER_OK) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+    if (!ARM_STORAGE_VALID_BLOCK(&mtdBlock) || !mtdBlock.attributes.erasable || (mtdBlock.attributes.erase_unit == 0)) {
+        return JOURNAL_STATUS_ERROR;
+    }
+
+    uint32_t programUnit = (mtdInfo.program_unit > 1) ? mtdInfo.program_unit : 1;
+    if ((programUnit > LOG_FLASH_JOURNAL_MAX_PROGRAM_UNIT) || (LOG_FLASH_JOURNAL_MAX_PROGRAM_UNIT % programUnit)) {
+        return JOURNAL_STATUS_UNSUPPORTED;
+    }
+
+    /* initialize the journal structure */
+    memcpy(&journal->ops, ops, sizeof(FlashJournal_Ops_t));
+    journal->mtd             = mtd;
+    journal->mtdCapabilities = mtdCaps;
+    journal->mtdStartOffset  = mtdBlock.addr;
+    journal->sectorSize      = mtdBlock.attributes.erase_unit;
+    journal->sectorCount     = mtdInfo.total_storage / journal->sectorSize;
+    journal->sectorHeadSize  = ((sizeof(LogFlashJournalSectorHead_t) + programUnit - 1) / programUnit) * programUnit;
+    journal->programUnit     = programUnit;
+    journal->erasedValue     = mtdInfo.erased_value ? 0xFF : 0x00;
+    journal->callback        = callback;
+    journal->prevCommand     = FLASH_JOURNAL_OPCODE_INITIALIZE;
+    if ((journal->sectorCount < 3) || (journal->sectorSize <= journal->sectorHeadSize)) {
+        return JOURNAL_STATUS_BOUNDED_CAPACITY;
+    }
+
+    /* One sector is kept free for the head to move into; the rest must be
+     * able to hold the committed state, a sector skipped after a failed
+     * record, and a new record at the same time. */
+    uint32_t payload  = journal->sectorSize - journal->sectorHeadSize;
+    uint32_t usable   = (journal->sectorCount - 1) * payload;
+    uint32_t overhead = sizeof(LogFlashJournalRecordHead_t) + sizeof(LogFlashJournalRecordTail_t) + programUnit + LOG_FLASH_JOURNAL_PATCH_SLACK;
+    journal->maxRecordSize = usable / LOG_FLASH_JOURNAL_CAPACITY_DIVISOR;
+    if (2 * journal->maxRecordSize + payload > usable) {
+        journal->maxRecordSize = (usable > payload) ? ((usable - payload) / 2) : 0;
+    }
+    if (journal->maxRecordSize <= overhead) {
+        return JOURNAL_STATUS_BOUNDED_CAPACITY;
+    }
+    journal->info.capacity     = journal->maxRecordSize - overhead; /* effective capacity */
+    journal->info.program_unit = 1; /* partial program units are staged by the journal */
+    journal->info.sizeofLastCommit = 0;
+
+    /* initialize MTD */
+    rc = mtd->Initialize(logJournal_mtdHandler);
+    if (rc < ARM_DRIVER_OK) {
+        memset(journal, 0, sizeof(FlashJournal_t));
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+
+    if ((rc = logJournal_discoverLatestState(journal)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    return 1; /* synchronous completion */
+}
+
+FlashJournal_Status_t flashJournalStrategyLog_getInfo(FlashJournal_t *_journal, FlashJournal_Info_t *infoP)
+{
+    LogFlashJournal_t *journal = (LogFlashJournal_t *)_journal;
+
+    memcpy(infoP, &journal->info, sizeof(FlashJournal_Info_t));
+    return JOURNAL_STATUS_OK;
+}
+
+int32_t flashJournalStrategyLog_read(FlashJournal_t *_journal, void *blob, size_t sizeofBlob)
+{
+    LogFlashJournal_t *journal = (LogFlashJournal_t *)_journal;
+
+    int32_t rc;
+    if ((rc = flashJournalStrategyLog_read_sanityChecks(journal, blob, sizeofBlob)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    if (journal->prevCommand != FLASH_JOURNAL_OPCODE_READ_BLOB) {
+        journal->read.totalDataRead = 0;
+    }
+    journal->prevCommand = FLASH_JOURNAL_OPCODE_READ_BLOB;
+
+    uint32_t amountLeftToRead = journal->info.sizeofJournaledBlob - journal->read.totalDataRead;
+    if (amountLeftToRead > sizeofBlob) {
+        amountLeftToRead = sizeofBlob;
+    }
+    if ((rc = logJournal_readBlob(journal, journal->read.totalDataRead, blob, amountLeftToRead)) != JOURNAL_STATUS_OK) {
+        journal->read.totalDataRead = 0;
+        return rc;
+    }
+
+    journal->read.totalDataRead += amountLeftToRead;
+    return amountLeftToRead;
+}
+
+int32_t flashJournalStrategyLog_log(FlashJournal_t *_journal, const void *blob, size_t size)
+{
+    LogFlashJournal_t *journal = (LogFlashJournal_t *)_journal;
+
+    int32_t rc;
+    if ((rc = flashJournalStrategyLog_log_sanityChecks(journal, blob, size)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    if (journal->state == LOG_JOURNAL_STATE_INITIALIZED) {
+        if ((rc = logJournal_beginRecord(journal)) != JOURNAL_STATUS_OK) {
+            logJournal_abandonRecord(journal);
+            return rc;
+        }
+        journal->state = LOG_JOURNAL_STATE_LOGGING_BODY;
+    }
+    journal->prevCommand = FLASH_JOURNAL_OPCODE_LOG_BLOB;
+
+    if ((rc = logJournal_logData(journal, (const uint8_t *)blob, size)) != JOURNAL_STATUS_OK) {
+        logJournal_abandonRecord(journal);
+        journal->state = LOG_JOURNAL_STATE_INITIALIZED; /* reset state */
+        return rc;
+    }
+
+    return size;
+}
+
+int32_t flashJournalStrategyLog_skip(FlashJournal_t *_journal, size_t size)
+{
+    LogFlashJournal_t *journal = (LogFlashJournal_t *)_journal;
+
+    int32_t rc;
+    if ((rc = flashJournalStrategyLog_skip_sanityChecks(journal, size)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    if (journal->state == LOG_JOURNAL_STATE_INITIALIZED) {
+        if ((rc = logJournal_beginRecord(journal)) != JOURNAL_STATUS_OK) {
+            logJournal_abandonRecord(journal);
+            return rc;
+        }
+        journal->state = LOG_JOURNAL_STATE_LOGGING_BODY;
+    }
+    journal->prevCommand = FLASH_JOURNAL_OPCODE_LOG_BLOB;
+
+    if ((rc = logJournal_skipData(journal, size)) != JOURNAL_STATUS_OK) {
+        logJournal_abandonRecord(journal);
+        journal->state = LOG_JOURNAL_STATE_INITIALIZED; /* reset state */
+        return rc;
+    }
+
+    return size;
+}
+
+int32_t flashJournalStrategyLog_commit(FlashJournal_t *_journal)
+{
+    LogFlashJournal_t *journal = (LogFlashJournal_t *)_journal;
+
+    int32_t rc;
+    if ((rc = flashJournalStrategyLog_commit_sanityChecks(journal)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    if (journal->state == LOG_JOURNAL_STATE_INITIALIZED) {
+        /* commit() without preceding log()s results in an empty blob. */
+        rc = logJournal_beginRecord(journal);
+    }
+    if (rc == JOURNAL_STATUS_OK) {
+        rc = logJournal_endRecord(journal);
+    }
+    if (rc != JOURNAL_STATUS_OK) {
+        logJournal_abandonRecord(journal);
+    }
+
+    journal->state       = LOG_JOURNAL_STATE_INITIALIZED;
+    journal->prevCommand = FLASH_JOURNAL_OPCODE_COMMIT;
+    return (rc == JOURNAL_STATUS_OK) ? 1 : rc; /* commit returns 1 upon completion. */
+}
+
+int32_t flashJournalStrategyLog_reset(FlashJournal_t *_journal)
+{
+    LogFlashJournal_t *journal = (LogFlashJournal_t *)_journal;
+
+    int32_t rc;
+    if ((journal->state == LOG_JOURNAL_STATE_NOT_INITIALIZED) || (journal->state == LOG_JOURNAL_STATE_INIT_SCANNING_LOG)) {
+        return JOURNAL_STATUS_NOT_INITIALIZED;
+    }
+
+    journal->state       = LOG_JOURNAL_STATE_RESETING;
+    journal->prevCommand = FLASH_JOURNAL_OPCODE_RESET;
+    rc = logJournal_erase(journal);
+    journal->state       = LOG_JOURNAL_STATE_INITIALIZED;
+
+    return (rc == JOURNAL_STATUS_OK) ? 1 : rc;
+}
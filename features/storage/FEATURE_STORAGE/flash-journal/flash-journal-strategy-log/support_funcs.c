@@ -0,0 +1,703 @@
+/*
+ * Copyright (c) 2006-2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "support_funcs.h"
+#include <string.h>
+#include <stdbool.h>
+
+/*
+ * Log positions address the payload of the sectors making up the ring, i.e.
+ * they skip the sector-heads. Position 'p' lives in logical sector
+ * (p / payload), which is stored in physical sector ((p / payload) % sectorCount).
+ */
+static inline uint32_t sectorPayload(const LogFlashJournal_t *journal)
+{
+    return journal->sectorSize - journal->sectorHeadSize;
+}
+
+static inline uint64_t sectorAddr(const LogFlashJournal_t *journal, uint32_t sectorNumber)
+{
+    return journal->mtdStartOffset + (uint64_t)(sectorNumber % journal->sectorCount) * journal->sectorSize;
+}
+
+static uint32_t crc32(uint32_t crc, const void *data, uint32_t size)
+{
+    const uint8_t *octets = (const uint8_t *)data;
+
+    crc = ~crc;
+    while (size--) {
+        crc ^= *octets++;
+        for (unsigned bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static int32_t readAt(LogFlashJournal_t *journal, uint32_t position, void *data, uint32_t size)
+{
+    uint8_t *dst     = (uint8_t *)data;
+    uint32_t payload = sectorPayload(journal);
+
+    while (size) {
+        uint32_t inSector = position % payload;
+        uint32_t xfer     = ((payload - inSector) < size) ? (payload - inSector) : size;
+
+        int32_t rc = journal->mtd->ReadData(sectorAddr(journal, position / payload) + journal->sectorHeadSize + inSector, dst, xfer);
+        if (rc <= ARM_DRIVER_OK) {
+            return JOURNAL_STATUS_STORAGE_IO_ERROR;
+        }
+        position += rc;
+        dst      += rc;
+        size     -= rc;
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+static int32_t readSectorHead(LogFlashJournal_t *journal, uint32_t sectorNumber, LogFlashJournalSectorHead_t *head)
+{
+    int32_t rc = journal->mtd->ReadData(sectorAddr(journal, sectorNumber), head, sizeof(LogFlashJournalSectorHead_t));
+    if (rc != sizeof(LogFlashJournalSectorHead_t)) {
+        return JOURNAL_STATUS_STORAGE_IO_ERROR;
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+static int32_t eraseRange(LogFlashJournal_t *journal, uint64_t addr, uint64_t size)
+{
+    while (size) {
+        int32_t rc = journal->mtd->Erase(addr, (size > 0xFFFFFFFFUL) ? 0xFFFFFFFFUL : (uint32_t)size);
+        if (rc <= ARM_DRIVER_OK) {
+            return JOURNAL_STATUS_STORAGE_IO_ERROR;
+        }
+        addr += rc;
+        size -= rc;
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+/**
+ * Erase the physical sector backing 'sectorNumber' and write its sector-head.
+ * This is the only place where the log erases flash during logging.
+ */
+static int32_t enterSector(LogFlashJournal_t *journal, uint32_t sectorNumber)
+{
+    int32_t rc;
+
+    /* The physical sector was last used for (sectorNumber - sectorCount);
+     * it must not hold any part of the committed state. */
+    if ((journal->chainLength > 0) &&
+        ((journal->chain[0] / sectorPayload(journal)) + journal->sectorCount <= sectorNumber)) {
+        return JOURNAL_STATUS_BOUNDED_CAPACITY;
+    }
+
+    uint64_t addr = sectorAddr(journal, sectorNumber);
+    if ((rc = eraseRange(journal, addr, journal->sectorSize)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    uint8_t buffer[sizeof(LogFlashJournalSectorHead_t) + LOG_FLASH_JOURNAL_MAX_PROGRAM_UNIT];
+    LogFlashJournalSectorHead_t head;
+    head.sectorNumber = sectorNumber;
+    head.liveStart    = (journal->chainLength > 0) ? journal->chain[0] : LOG_FLASH_JOURNAL_INVALID_OFFSET;
+    head.recordStart  = journal->log.recordStart;
+    head.magic        = LOG_FLASH_JOURNAL_SECTOR_MAGIC;
+    memset(buffer, journal->erasedValue, journal->sectorHeadSize);
+    memcpy(buffer, &head, sizeof(head));
+
+    rc = journal->mtd->ProgramData(addr, buffer, journal->sectorHeadSize);
+    if (rc != journal->sectorHeadSize) {
+        return JOURNAL_STATUS_STORAGE_IO_ERROR;
+    }
+    journal->log.programmed += rc;
+
+    return JOURNAL_STATUS_OK;
+}
+
+/**
+ * Program 'size' octets at the head of the log. Both the head and 'size' are
+ * aligned with the program unit.
+ */
+static int32_t programAtHead(LogFlashJournal_t *journal, const uint8_t *data, uint32_t size)
+{
+    int32_t  rc;
+    uint32_t payload = sectorPayload(journal);
+
+    while (size) {
+        uint32_t inSector = journal->head % payload;
+        if (inSector == 0) {
+            if ((rc = enterSector(journal, journal->head / payload)) != JOURNAL_STATUS_OK) {
+                return rc;
+            }
+        }
+
+        uint32_t xfer = ((payload - inSector) < size) ? (payload - inSector) : size;
+        rc = journal->mtd->ProgramData(sectorAddr(journal, journal->head / payload) + journal->sectorHeadSize + inSector, data, xfer);
+        if (rc <= ARM_DRIVER_OK) {
+            return JOURNAL_STATUS_STORAGE_IO_ERROR;
+        }
+        journal->head           += rc;
+        journal->log.programmed += rc;
+        data                    += rc;
+        size                    -= rc;
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+/**
+ * Append data to the record being logged. Partial program units are staged
+ * in the journal until they can be programmed.
+ */
+static int32_t streamWrite(LogFlashJournal_t *journal, const void *data, uint32_t size)
+{
+    int32_t        rc;
+    const uint8_t *src  = (const uint8_t *)data;
+    uint32_t       unit = journal->programUnit;
+
+    journal->log.crc = crc32(journal->log.crc, data, size);
+    while (size) {
+        if ((journal->log.stageFill == 0) && (size >= unit)) {
+            uint32_t direct = size - (size % unit);
+            if ((rc = programAtHead(journal, src, direct)) != JOURNAL_STATUS_OK) {
+                return rc;
+            }
+            src  += direct;
+            size -= direct;
+            continue;
+        }
+
+        uint32_t xfer = unit - journal->log.stageFill;
+        if (xfer > size) {
+            xfer = size;
+        }
+        memcpy(&journal->log.stage[journal->log.stageFill], src, xfer);
+        journal->log.stageFill += xfer;
+        src                    += xfer;
+        size                   -= xfer;
+
+        if (journal->log.stageFill == unit) {
+            journal->log.stageFill = 0;
+            if ((rc = programAtHead(journal, journal->log.stage, unit)) != JOURNAL_STATUS_OK) {
+                return rc;
+            }
+        }
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+static int32_t streamFlush(LogFlashJournal_t *journal)
+{
+    if (journal->log.stageFill == 0) {
+        return JOURNAL_STATUS_OK;
+    }
+
+    memset(&journal->log.stage[journal->log.stageFill], journal->erasedValue, journal->programUnit - journal->log.stageFill);
+    journal->log.stageFill = 0;
+    return programAtHead(journal, journal->log.stage, journal->programUnit);
+}
+
+static int32_t writePatch(LogFlashJournal_t *journal, uint32_t offset, const uint8_t *data, uint32_t length)
+{
+    int32_t rc;
+    LogFlashJournalPatchHead_t patch;
+    patch.offset = offset;
+    patch.length = length;
+
+    if ((rc = streamWrite(journal, &patch, sizeof(patch))) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+    return streamWrite(journal, data, length);
+}
+
+/**
+ * Reconstruct a range of the committed blob by applying the patches of every
+ * record in the chain in turn.
+ */
+int32_t logJournal_readBlob(LogFlashJournal_t *journal, uint32_t offset, void *buffer, uint32_t size)
+{
+    int32_t  rc;
+    uint8_t *dst = (uint8_t *)buffer;
+
+    for (uint32_t record = 0; record < journal->chainLength; record++) {
+        uint32_t position = journal->chain[record] + sizeof(LogFlashJournalRecordHead_t);
+        while (true) {
+            LogFlashJournalPatchHead_t patch;
+            if ((rc = readAt(journal, position, &patch, sizeof(patch))) != JOURNAL_STATUS_OK) {
+                return rc;
+            }
+            if (patch.offset == LOG_FLASH_JOURNAL_TAIL_MARKER) {
+                break;
+            }
+            position += sizeof(patch);
+
+            uint32_t lo = (patch.offset > offset) ? patch.offset : offset;
+            uint32_t hi = ((patch.offset + patch.length) < (offset + size)) ? (patch.offset + patch.length) : (offset + size);
+            if (lo < hi) {
+                if ((rc = readAt(journal, position + (lo - patch.offset), dst + (lo - offset), hi - lo)) != JOURNAL_STATUS_OK) {
+                    return rc;
+                }
+            }
+            position += patch.length;
+        }
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+int32_t logJournal_beginRecord(LogFlashJournal_t *journal)
+{
+    uint32_t usable   = (journal->sectorCount - 1) * sectorPayload(journal);
+    uint32_t liveSpan = (journal->chainLength > 0) ? (journal->head - journal->chain[0]) : 0;
+
+    /* A delta is only written if a base record would still fit afterwards,
+     * even if a failed record made the head skip to the next sector;
+     * otherwise the chain is collapsed into a new base record, which frees
+     * the sectors holding the old chain for reuse. */
+    journal->log.flags = LOG_FLASH_JOURNAL_RECORD_BASE;
+    if ((journal->chainLength > 0) &&
+        (journal->chainLength <= LOG_FLASH_JOURNAL_MAX_DELTAS) &&
+        (liveSpan + 2 * journal->maxRecordSize + sectorPayload(journal) <= usable)) {
+        journal->log.flags = 0;
+    }
+
+    journal->log.recordStart = journal->head;
+    journal->log.crc         = 0;
+    journal->log.sizeofBlob  = 0;
+    journal->log.programmed  = 0;
+    journal->log.stageFill   = 0;
+
+    LogFlashJournalRecordHead_t head;
+    head.version        = LOG_FLASH_JOURNAL_VERSION;
+    head.sequenceNumber = journal->nextSequenceNumber;
+    head.flags          = journal->log.flags;
+    head.magic          = LOG_FLASH_JOURNAL_RECORD_MAGIC;
+    return streamWrite(journal, &head, sizeof(head));
+}
+
+int32_t logJournal_logData(LogFlashJournal_t *journal, const uint8_t *blob, uint32_t size)
+{
+    int32_t  rc;
+    uint32_t base = journal->log.sizeofBlob; /* offset of blob[0] within the blob being logged */
+
+    if (journal->log.flags & LOG_FLASH_JOURNAL_RECORD_BASE) {
+        if ((rc = writePatch(journal, base, blob, size)) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+        journal->log.sizeofBlob += size;
+        return JOURNAL_STATUS_OK;
+    }
+
+    /* Emit patches only for the ranges which differ from the committed blob.
+     * Changes separated by less than a patch-head are merged into one patch;
+     * this bounds a delta record by the size of the data plus one patch-head. */
+    uint8_t  committed[LOG_FLASH_JOURNAL_COMPARE_BUFFER_SIZE];
+    uint32_t committedSize = (uint32_t)journal->info.sizeofJournaledBlob;
+    uint32_t spanStart     = 0;
+    uint32_t lastChange    = 0;
+    bool     inSpan        = false;
+
+    for (uint32_t pos = 0; pos < size; ) {
+        uint32_t xfer      = ((size - pos) < sizeof(committed)) ? (size - pos) : sizeof(committed);
+        uint32_t available = 0;
+        if (base + pos < committedSize) {
+            available = committedSize - (base + pos);
+            if (available > xfer) {
+                available = xfer;
+            }
+            if ((rc = logJournal_readBlob(journal, base + pos, committed, available)) != JOURNAL_STATUS_OK) {
+                return rc;
+            }
+        }
+
+        for (uint32_t index = 0; index < xfer; index++, pos++) {
+            if ((index >= available) || (committed[index] != blob[pos])) {
+                if (!inSpan) {
+                    inSpan    = true;
+                    spanStart = pos;
+                }
+                lastChange = pos;
+            } else if (inSpan && ((pos - lastChange) > sizeof(LogFlashJournalPatchHead_t))) {
+                if ((rc = writePatch(journal, base + spanStart, blob + spanStart, lastChange + 1 - spanStart)) != JOURNAL_STATUS_OK) {
+                    return rc;
+                }
+                inSpan = false;
+            }
+        }
+    }
+    if (inSpan) {
+        if ((rc = writePatch(journal, base + spanStart, blob + spanStart, lastChange + 1 - spanStart)) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+    }
+
+    journal->log.sizeofBlob += size;
+    return JOURNAL_STATUS_OK;
+}
+
+/**
+ * Account for a range of the blob which is unchanged from the committed blob.
+ * A delta record just leaves it out; a base record has to hold the complete
+ * blob, so the range is copied from the committed state as one patch.
+ */
+int32_t logJournal_skipData(LogFlashJournal_t *journal, uint32_t size)
+{
+    int32_t  rc;
+    uint32_t base = journal->log.sizeofBlob;
+
+    if ((base + size < base) || (base + size > journal->info.sizeofJournaledBlob)) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+
+    if (journal->log.flags & LOG_FLASH_JOURNAL_RECORD_BASE) {
+        uint8_t committed[LOG_FLASH_JOURNAL_COMPARE_BUFFER_SIZE];
+        LogFlashJournalPatchHead_t patch;
+        patch.offset = base;
+        patch.length = size;
+        if ((rc = streamWrite(journal, &patch, sizeof(patch))) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+        for (uint32_t pos = 0; pos < size; ) {
+            uint32_t xfer = ((size - pos) < sizeof(committed)) ? (size - pos) : sizeof(committed);
+            if ((rc = logJournal_readBlob(journal, base + pos, committed, xfer)) != JOURNAL_STATUS_OK) {
+                return rc;
+            }
+            if ((rc = streamWrite(journal, committed, xfer)) != JOURNAL_STATUS_OK) {
+                return rc;
+            }
+            pos += xfer;
+        }
+    }
+
+    journal->log.sizeofBlob += size;
+    return JOURNAL_STATUS_OK;
+}
+
+int32_t logJournal_endRecord(LogFlashJournal_t *journal)
+{
+    int32_t rc;
+
+    LogFlashJournalRecordTail_t tail;
+    tail.marker         = LOG_FLASH_JOURNAL_TAIL_MARKER;
+    tail.crc            = journal->log.crc;
+    tail.sizeofBlob     = journal->log.sizeofBlob;
+    tail.magic          = LOG_FLASH_JOURNAL_RECORD_MAGIC;
+    tail.sequenceNumber = journal->nextSequenceNumber;
+    if ((rc = streamWrite(journal, &tail, sizeof(tail))) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+    if ((rc = streamFlush(journal)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    /* the record is now committed */
+    if (journal->log.flags & LOG_FLASH_JOURNAL_RECORD_BASE) {
+        journal->chainLength = 0;
+    }
+    journal->chain[journal->chainLength++] = journal->log.recordStart;
+    journal->info.sizeofJournaledBlob      = journal->log.sizeofBlob;
+    journal->info.sizeofLastCommit         = journal->log.programmed;
+    journal->nextSequenceNumber++;
+
+    return JOURNAL_STATUS_OK;
+}
+
+void logJournal_abandonRecord(LogFlashJournal_t *journal)
+{
+    uint32_t payload = sectorPayload(journal);
+
+    /* Whatever got programmed for this record can't be overwritten in place.
+     * Restart at the first sector boundary following the start of the record;
+     * the sectors from there on hold nothing but the abandoned record and are
+     * erased again as the head moves into them. A recovery scan skips to the
+     * same sector. */
+    journal->log.stageFill = 0;
+    journal->head          = ((journal->log.recordStart + payload - 1) / payload) * payload;
+
+    /* The retry must not share a sequence number with the abandoned record,
+     * whose remains may still be read back from the sector it started in. */
+    journal->nextSequenceNumber++;
+}
+
+int32_t logJournal_erase(LogFlashJournal_t *journal)
+{
+    int32_t rc;
+    if ((rc = eraseRange(journal, journal->mtdStartOffset, (uint64_t)journal->sectorCount * journal->sectorSize)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    journal->chainLength              = 0;
+    journal->head                     = 0;
+    journal->nextSequenceNumber       = 0;
+    journal->info.sizeofJournaledBlob = 0;
+    return JOURNAL_STATUS_OK;
+}
+
+/**
+ * Find the first sector from 'first' on, up to 'last', which doesn't carry a
+ * valid sector-head. Returns last + 1 in 'limit' if they all do.
+ */
+static int32_t findInvalidSector(LogFlashJournal_t *journal, uint32_t first, uint32_t last, uint32_t *limit)
+{
+    int32_t rc;
+
+    for (*limit = first; (int32_t)(last - *limit) >= 0; (*limit)++) {
+        LogFlashJournalSectorHead_t sectorHead;
+        if ((rc = readSectorHead(journal, *limit, &sectorHead)) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+        if (!LOG_JOURNAL_VALID_SECTOR_HEAD(&sectorHead, *limit)) {
+            break;
+        }
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+/**
+ * Validate the record at 'position'. Returns 1 for a committed record, 0 if
+ * there is no valid record at 'position', or an error.
+ */
+static int32_t scanRecord(LogFlashJournal_t                *journal,
+                          uint32_t                          position,
+                          uint32_t                          limit,
+                          LogFlashJournalRecordHead_t      *head,
+                          LogFlashJournalRecordTail_t      *tail,
+                          uint32_t                         *end)
+{
+    int32_t  rc;
+    uint32_t crc;
+    uint32_t start   = position;
+    uint32_t payload = sectorPayload(journal);
+
+    if ((limit - position) < sizeof(LogFlashJournalRecordHead_t)) {
+        return 0;
+    }
+    if ((rc = readAt(journal, position, head, sizeof(LogFlashJournalRecordHead_t))) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+    if (!LOG_JOURNAL_VALID_RECORD_HEAD(head)) {
+        return 0;
+    }
+    crc       = crc32(0, head, sizeof(LogFlashJournalRecordHead_t));
+    position += sizeof(LogFlashJournalRecordHead_t);
+
+    while (true) {
+        LogFlashJournalPatchHead_t patch;
+        if ((limit - position) < sizeof(patch)) {
+            return 0;
+        }
+        if ((rc = readAt(journal, position, &patch, sizeof(patch))) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+
+        if (patch.offset == LOG_FLASH_JOURNAL_TAIL_MARKER) {
+            if ((limit - position) < sizeof(LogFlashJournalRecordTail_t)) {
+                return 0;
+            }
+            if ((rc = readAt(journal, position, tail, sizeof(LogFlashJournalRecordTail_t))) != JOURNAL_STATUS_OK) {
+                return rc;
+            }
+            if ((tail->magic          != LOG_FLASH_JOURNAL_RECORD_MAGIC) ||
+                (tail->sequenceNumber != head->sequenceNumber)           ||
+                (tail->crc            != crc)                            ||
+                (tail->sizeofBlob      > journal->info.capacity)) {
+                return 0;
+            }
+
+            position += sizeof(LogFlashJournalRecordTail_t);
+
+            /* Every sector the record runs into must have been entered while
+             * it was being written. Otherwise the sector was erased again
+             * after the record was abandoned, and what follows its start is
+             * a later record which only happens to read as its remainder. */
+            for (uint32_t sector = start / payload + 1; sector * payload < position; sector++) {
+                LogFlashJournalSectorHead_t sectorHead;
+                if ((rc = readSectorHead(journal, sector, &sectorHead)) != JOURNAL_STATUS_OK) {
+                    return rc;
+                }
+                if (sectorHead.recordStart != start) {
+                    return 0;
+                }
+            }
+
+            *end = ((position + journal->programUnit - 1) / journal->programUnit) * journal->programUnit;
+            return 1;
+        }
+
+        if ((patch.offset > journal->info.capacity) || (patch.length > journal->info.capacity - patch.offset)) {
+            return 0;
+        }
+        crc       = crc32(crc, &patch, sizeof(patch));
+        position += sizeof(patch);
+        if ((limit - position) < patch.length) {
+            return 0;
+        }
+
+        uint8_t buffer[32];
+        while (patch.length) {
+            uint32_t xfer = (patch.length < sizeof(buffer)) ? patch.length : sizeof(buffer);
+            if ((rc = readAt(journal, position, buffer, xfer)) != JOURNAL_STATUS_OK) {
+                return rc;
+            }
+            crc           = crc32(crc, buffer, xfer);
+            position     += xfer;
+            patch.length -= xfer;
+        }
+    }
+}
+
+int32_t logJournal_discoverLatestState(LogFlashJournal_t *journal)
+{
+    int32_t  rc;
+    uint32_t payload = sectorPayload(journal);
+
+    /* reset top level journal metadata prior to scanning the log. */
+    journal->chainLength              = 0;
+    journal->head                     = 0;
+    journal->nextSequenceNumber       = 0;
+    journal->info.sizeofJournaledBlob = 0;
+    journal->log.stageFill            = 0;
+    journal->state                    = LOG_JOURNAL_STATE_INIT_SCANNING_LOG;
+
+    /* find the most recently entered sector */
+    bool found = false;
+    LogFlashJournalSectorHead_t newest;
+    for (uint32_t index = 0; index < journal->sectorCount; index++) {
+        LogFlashJournalSectorHead_t sectorHead;
+        if ((rc = readSectorHead(journal, index, &sectorHead)) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+        if ((sectorHead.magic != LOG_FLASH_JOURNAL_SECTOR_MAGIC) || ((sectorHead.sectorNumber % journal->sectorCount) != index)) {
+            continue;
+        }
+        /* unsigned arithmetic takes care of wraparound of sector numbers */
+        if (!found || ((int32_t)(sectorHead.sectorNumber - newest.sectorNumber) > 0)) {
+            newest = sectorHead;
+            found  = true;
+        }
+    }
+    if (!found) {
+        journal->state = LOG_JOURNAL_STATE_INITIALIZED; /* nothing has been logged yet */
+        return JOURNAL_STATUS_OK;
+    }
+
+    /* Every sector from the start of the scan up to the newest one should
+     * carry a valid sector-head; stop the scan at the first one that doesn't. */
+    uint32_t position = (newest.liveStart != LOG_FLASH_JOURNAL_INVALID_OFFSET) ? newest.liveStart : newest.recordStart;
+    uint32_t limit;
+    if ((rc = findInvalidSector(journal, position / payload, newest.sectorNumber, &limit)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+    if (limit == position / payload) {
+        /* Power was lost after enterSector() erased the sector following the
+         * newest one, and before it wrote the new sector-head; that sector
+         * held 'liveStart'. enterSector() only erases it once the committed
+         * state has moved on to a base record committed after the newest
+         * sector was entered, so replay from the record being written then. */
+        position = newest.recordStart;
+        if ((rc = findInvalidSector(journal, position / payload, newest.sectorNumber, &limit)) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+    }
+    limit *= payload;
+
+    /* replay the records */
+    while (position < limit) {
+        LogFlashJournalRecordHead_t head;
+        LogFlashJournalRecordTail_t tail;
+        uint32_t                    end = 0;
+        memset(&head, 0, sizeof(head));
+        if ((rc = scanRecord(journal, position, limit, &head, &tail, &end)) < JOURNAL_STATUS_OK) {
+            return rc;
+        }
+
+        bool base = (head.flags & LOG_FLASH_JOURNAL_RECORD_BASE) != 0;
+        if (rc == 1) {
+            if (base || ((journal->chainLength > 0) && (journal->chainLength <= LOG_FLASH_JOURNAL_MAX_DELTAS))) {
+                if (base) {
+                    journal->chainLength = 0;
+                }
+                journal->chain[journal->chainLength++] = position;
+                journal->info.sizeofJournaledBlob      = tail.sizeofBlob;
+            }
+            /* a delta which doesn't extend the chain, such as one found ahead
+             * of the first base record, has been superseded; skip it */
+            journal->nextSequenceNumber = head.sequenceNumber + 1;
+            position                    = end;
+            continue;
+        }
+
+        /* the records logged from now on mustn't reuse the sequence number
+         * of an incomplete record, see logJournal_abandonRecord() */
+        if (LOG_JOURNAL_VALID_RECORD_HEAD(&head) && ((int32_t)(head.sequenceNumber - journal->nextSequenceNumber) >= 0)) {
+            journal->nextSequenceNumber = head.sequenceNumber + 1;
+        }
+
+        /* No valid record here. Logging resumes at the start of a sector after
+         * an incomplete record; carry on from the first sector which was
+         * entered at the start of a record. */
+        uint32_t next;
+        for (next = (position / payload + 1) * payload; next < limit; next += payload) {
+            LogFlashJournalSectorHead_t sectorHead;
+            if ((rc = readSectorHead(journal, next / payload, &sectorHead)) != JOURNAL_STATUS_OK) {
+                return rc;
+            }
+            if (sectorHead.recordStart == next) {
+                break;
+            }
+        }
+        if (next >= limit) {
+            break;
+        }
+        position = next;
+    }
+
+    /* Resume logging where the scan stopped if nothing has been programmed
+     * there, otherwise skip the remainder of the sector. */
+    journal->head = position;
+    if (position % payload) {
+        uint8_t  probe[sizeof(LogFlashJournalRecordHead_t)];
+        uint32_t size = payload - (position % payload);
+        if (size > sizeof(probe)) {
+            size = sizeof(probe);
+        }
+        if ((rc = readAt(journal, position, probe, size)) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+        for (uint32_t index = 0; index < size; index++) {
+            if (probe[index] != journal->erasedValue) {
+                journal->head = (position / payload + 1) * payload;
+                break;
+            }
+        }
+    }
+
+    journal->state = LOG_JOURNAL_STATE_INITIALIZED;
+    return JOURNAL_STATUS_OK;
+}
+
+void logJournal_mtdHandler(int32_t status, ARM_STORAGE_OPERATION operation)
+{
+    /* The log strategy only drives MTDs which complete synchronously. */
+    (void)status;
+    (void)operation;
+}
@@ -132,6 +132,7 @@ int32_t flashJournalStrategySequential_initialize(FlashJournal_t           *_jou
     journal->sequentialSkip    = mtdCapacity / SEQUENTIAL_FLASH_JOURNAL_MAX_LOGGED_BLOBS;
     journal->info.capacity     = journal->sequentialSkip - (sizeof(SequentialFlashJournalLogHead_t) + sizeof(SequentialFlashJournalLogTail_t)); /* effective capacity */
     journal->info.program_unit = mtdInfo.program_unit;
+    journal->info.sizeofLastCommit = 0;
     journal->callback          = callback;
     journal->prevCommand       = FLASH_JOURNAL_OPCODE_INITIALIZE;
 
@@ -357,6 +357,7 @@ int32_t flashJournalStrategySequential_log_progress(void)
 
             case SEQUENTIAL_JOURNAL_STATE_LOGGING_TAIL:
                 journal->info.sizeofJournaledBlob = journal->log.tail.sizeofBlob;
+                journal->info.sizeofLastCommit    = sizeof(SequentialFlashJournalLogHead_t) + journal->log.tail.sizeofBlob + sizeof(SequentialFlashJournalLogTail_t);
                 journal->state                    = SEQUENTIAL_JOURNAL_STATE_INITIALIZED; /* reset state to allow further operations */
 
                 ++journal->currentBlobIndex;
@@ -74,6 +74,11 @@ typedef struct _FlashJournal_Info {
                                    ///<   upon receiving the error JOURNAL_STATUS_SMALL_LOG_REQUEST
                                    ///<   (of when the actual amount of data logged is smaller than
                                    ///<   the requested amount).
+    uint32_t sizeofLastCommit;     ///< number of octets programmed into storage by the most recent
+                                   ///<   commit, including the journal's own meta-data. Strategies
+                                   ///<   which only write the changes to the blob report less than
+                                   ///<   sizeofJournaledBlob here. 0 if nothing has been committed
+                                   ///<   since initialization.
 } FlashJournal_Info_t;
 
 /**
@@ -111,7 +116,7 @@ typedef struct _FlashJournal_Ops_t FlashJournal_Ops_t;
  * strategy-specific metadata. The value of this MAX_SIZE may need to be
  * increased if some future journal-strategy needs more metadata.
  */
-#define FLASH_JOURNAL_HANDLE_MAX_SIZE 140
+#define FLASH_JOURNAL_HANDLE_MAX_SIZE 160
 
 /**
  * This is the set of operations offered by the flash-journal abstraction. A set
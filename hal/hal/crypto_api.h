@@ -0,0 +1,137 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_CRYPTO_API_H
+#define MBED_CRYPTO_API_H
+
+#include "device.h"
+
+#if DEVICE_AES || DEVICE_SHA1 || DEVICE_SHA256
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \defgroup hal_crypto Crypto accelerator hal functions
+ *
+ * Block level access to on-chip crypto engines. The engine is a single
+ * shared resource: calls must not be made concurrently, which the mbed TLS
+ * glue in features/mbedtls/platform guarantees by running each call in a
+ * critical section on bounded chunks of data.
+ *
+ * Keys, IVs and counters are byte arrays in the order defined by FIPS-197,
+ * data lengths are in bytes and must be a multiple of the block size. All
+ * buffers must be word aligned.
+ * @{
+ */
+
+#if DEVICE_AES
+
+#define CRYPTO_AES_BLOCK_SIZE 16
+
+/** Derive the key the engine needs to decrypt
+ *
+ * Engines that run the key schedule backwards need the last round key
+ * to decrypt, others can copy the key unchanged.
+ *
+ * @param dkey      Destination for the decryption key, keybits/8 bytes
+ * @param key       Encryption key
+ * @param keybits   Key length in bits, 128 or 256
+ */
+void crypto_aes_decrypt_key(uint8_t *dkey, const uint8_t *key, unsigned keybits);
+
+/** AES electronic codebook
+ *
+ * @param out       Output buffer, may equal in
+ * @param in        Input buffer
+ * @param length    Number of bytes to process
+ * @param key       Encryption key, or the decryption key when decrypting
+ * @param keybits   Key length in bits, 128 or 256
+ * @param encrypt   Non-zero to encrypt, zero to decrypt
+ */
+void crypto_aes_ecb(uint8_t *out, const uint8_t *in, size_t length,
+                    const uint8_t *key, unsigned keybits, int encrypt);
+
+/** AES cipher block chaining
+ *
+ * @param out       Output buffer, may equal in
+ * @param in        Input buffer
+ * @param length    Number of bytes to process
+ * @param key       Encryption key, or the decryption key when decrypting
+ * @param keybits   Key length in bits, 128 or 256
+ * @param iv        Initialisation vector, updated for the next call
+ * @param encrypt   Non-zero to encrypt, zero to decrypt
+ */
+void crypto_aes_cbc(uint8_t *out, const uint8_t *in, size_t length,
+                    const uint8_t *key, unsigned keybits,
+                    uint8_t iv[CRYPTO_AES_BLOCK_SIZE], int encrypt);
+
+/** AES counter mode
+ *
+ * The counter is treated as a 128-bit big-endian integer and is left
+ * pointing at the block following the last one used.
+ *
+ * @param out       Output buffer, may equal in
+ * @param in        Input buffer
+ * @param length    Number of bytes to process
+ * @param key       Encryption key
+ * @param keybits   Key length in bits, 128 or 256
+ * @param counter   Counter block, updated for the next call
+ */
+void crypto_aes_ctr(uint8_t *out, const uint8_t *in, size_t length,
+                    const uint8_t *key, unsigned keybits,
+                    uint8_t counter[CRYPTO_AES_BLOCK_SIZE]);
+
+#endif
+
+#if DEVICE_SHA1
+
+/** Run the SHA-1 compression function over whole blocks
+ *
+ * @param state     Intermediate hash value, H0 to H4
+ * @param data      Message blocks
+ * @param blocks    Number of 64 byte blocks
+ */
+void crypto_sha1_process(uint32_t state[5], const uint8_t *data, size_t blocks);
+
+#endif
+
+#if DEVICE_SHA256
+
+/** Run the SHA-256 compression function over whole blocks
+ *
+ * Also used for SHA-224, which differs only in its initial state.
+ *
+ * @param state     Intermediate hash value, H0 to H7
+ * @param data      Message blocks
+ * @param blocks    Number of 64 byte blocks
+ */
+void crypto_sha256_process(uint32_t state[8], const uint8_t *data, size_t blocks);
+
+#endif
+
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+#endif
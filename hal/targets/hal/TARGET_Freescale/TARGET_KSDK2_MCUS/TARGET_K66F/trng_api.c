@@ -22,8 +22,12 @@
  * Reference: "K66 Sub-Family Reference Manual, Rev. 2", chapter 38
  */
 
+#include "device.h"
+#if DEVICE_TRNG
+
 #include <stdlib.h>
 #include "cmsis.h"
+#include "trng_api.h"
 #include "fsl_common.h"
 #include "fsl_clock.h"
 
@@ -46,12 +50,10 @@ static void rng_get_byte( unsigned char *byte )
 /*
  * Get len bytes of entropy from the hardware RNG.
  */
-int mbedtls_hardware_poll( void *data,
-                    unsigned char *output, size_t len, size_t *olen )
+int trng_get_bytes( uint8_t *output, size_t len, size_t *olen )
 {
     size_t i;
     int ret;
-    ((void) data);
 
     CLOCK_EnableClock( kCLOCK_Rnga0 );
     CLOCK_DisableClock( kCLOCK_Rnga0 );
@@ -62,7 +64,10 @@ int mbedtls_hardware_poll( void *data,
     RNG->CR = RNG_CR_INTM_MASK | RNG_CR_HA_MASK | RNG_CR_GO_MASK;
 
     for( i = 0; i < len; i++ )
+    {
+        output[i] = 0;
         rng_get_byte( output + i );
+    }
 
     /* Just be extra sure that we didn't do it wrong */
     if( ( RNG->SR & RNG_SR_SECV_MASK ) != 0 )
@@ -81,3 +86,4 @@ cleanup:
     return( ret );
 }
 
+#endif
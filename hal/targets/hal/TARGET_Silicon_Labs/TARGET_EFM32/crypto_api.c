@@ -0,0 +1,197 @@
+/***************************************************************************//**
+ * @file crypto_api.c
+ *******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2016 Silicon Labs, http://www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "device.h"
+#if DEVICE_AES || DEVICE_SHA1 || DEVICE_SHA256
+
+#include <string.h>
+#include "mbed_assert.h"
+#include "crypto_api.h"
+
+#include "em_cmu.h"
+#if defined(CRYPTO_COUNT) && (CRYPTO_COUNT > 0)
+#include "em_crypto.h"
+#define CRYPTO_CLOCK cmuClock_CRYPTO
+#else
+#include "em_aes.h"
+#define CRYPTO_CLOCK cmuClock_AES
+#endif
+
+/* The engine only needs a clock while it is in use, callers serialize */
+static void crypto_enable(void)
+{
+    CMU_ClockEnable(CRYPTO_CLOCK, true);
+}
+
+static void crypto_disable(void)
+{
+    CMU_ClockEnable(CRYPTO_CLOCK, false);
+}
+
+#if DEVICE_AES
+
+#if !defined(CRYPTO_COUNT) && !defined(AES_CTRL_AES256)
+#error "DEVICE_AES requires 256-bit key support, leave it out of device_has for this target"
+#endif
+
+/* emlib only increments the low word, mbed TLS expects a 128-bit counter */
+static void crypto_aes_ctr_increment(uint8_t *ctr)
+{
+    for (int i = CRYPTO_AES_BLOCK_SIZE - 1; i >= 0; i--) {
+        if (++ctr[i] != 0) {
+            break;
+        }
+    }
+}
+
+void crypto_aes_decrypt_key(uint8_t *dkey, const uint8_t *key, unsigned keybits)
+{
+    MBED_ASSERT(keybits == 128 || keybits == 256);
+
+    crypto_enable();
+    if (keybits == 128) {
+        AES_DecryptKey128(dkey, key);
+    } else {
+        AES_DecryptKey256(dkey, key);
+    }
+    crypto_disable();
+}
+
+void crypto_aes_ecb(uint8_t *out, const uint8_t *in, size_t length,
+                    const uint8_t *key, unsigned keybits, int encrypt)
+{
+    MBED_ASSERT(keybits == 128 || keybits == 256);
+
+    crypto_enable();
+    if (keybits == 128) {
+        AES_ECB128(out, in, length, key, encrypt != 0);
+    } else {
+        AES_ECB256(out, in, length, key, encrypt != 0);
+    }
+    crypto_disable();
+}
+
+void crypto_aes_cbc(uint8_t *out, const uint8_t *in, size_t length,
+                    const uint8_t *key, unsigned keybits,
+                    uint8_t iv[CRYPTO_AES_BLOCK_SIZE], int encrypt)
+{
+    MBED_ASSERT(keybits == 128 || keybits == 256);
+    uint32_t next_iv[CRYPTO_AES_BLOCK_SIZE / 4];
+
+    if (length == 0) {
+        return;
+    }
+
+    /* emlib does not hand back the chaining value, so keep the last
+     * ciphertext block before an in-place call overwrites it */
+    if (!encrypt) {
+        memcpy(next_iv, in + length - CRYPTO_AES_BLOCK_SIZE, CRYPTO_AES_BLOCK_SIZE);
+    }
+
+    crypto_enable();
+    if (keybits == 128) {
+        AES_CBC128(out, in, length, key, iv, encrypt != 0);
+    } else {
+        AES_CBC256(out, in, length, key, iv, encrypt != 0);
+    }
+    crypto_disable();
+
+    if (encrypt) {
+        memcpy(iv, out + length - CRYPTO_AES_BLOCK_SIZE, CRYPTO_AES_BLOCK_SIZE);
+    } else {
+        memcpy(iv, next_iv, CRYPTO_AES_BLOCK_SIZE);
+    }
+}
+
+void crypto_aes_ctr(uint8_t *out, const uint8_t *in, size_t length,
+                    const uint8_t *key, unsigned keybits,
+                    uint8_t counter[CRYPTO_AES_BLOCK_SIZE])
+{
+    MBED_ASSERT(keybits == 128 || keybits == 256);
+
+    crypto_enable();
+    if (keybits == 128) {
+        AES_CTR128(out, in, length, key, counter, crypto_aes_ctr_increment);
+    } else {
+        AES_CTR256(out, in, length, key, counter, crypto_aes_ctr_increment);
+    }
+    crypto_disable();
+}
+
+#endif
+
+#if DEVICE_SHA1 || DEVICE_SHA256
+
+#if !defined(CRYPTO_COUNT)
+#error "DEVICE_SHA1 and DEVICE_SHA256 require the CRYPTO peripheral"
+#endif
+
+/* Same sequence CRYPTO_SHA_1/CRYPTO_SHA_256 use internally, but starting
+ * from and handing back an intermediate state instead of the IV */
+static void crypto_sha_process(uint32_t ctrl, uint32_t *state, unsigned words,
+                               const uint8_t *data, size_t blocks)
+{
+    uint32_t ddata[8] = {0};
+    memcpy(ddata, state, words * sizeof(uint32_t));
+
+    crypto_enable();
+    CRYPTO->CTRL     = ctrl;
+    CRYPTO->SEQCTRL  = 0;
+    CRYPTO->SEQCTRLB = 0;
+    CRYPTO_ResultWidthSet(cryptoResult256Bits);
+
+    CRYPTO_DDataWrite(cryptoRegDDATA1, ddata);
+    CRYPTO_EXECUTE_2(CRYPTO_CMD_INSTR_DDATA1TODDATA0,
+                     CRYPTO_CMD_INSTR_SELDDATA0DDATA1);
+
+    while (blocks--) {
+        CRYPTO_QDataWrite(cryptoRegQDATA1BIG, (uint32_t *)data);
+        CRYPTO_EXECUTE_3(CRYPTO_CMD_INSTR_SHA,
+                         CRYPTO_CMD_INSTR_MADD32,
+                         CRYPTO_CMD_INSTR_DDATA0TODDATA1);
+        data += 64;
+    }
+
+    CRYPTO_DDataRead(cryptoRegDDATA1, ddata);
+    crypto_disable();
+
+    memcpy(state, ddata, words * sizeof(uint32_t));
+}
+
+#if DEVICE_SHA1
+void crypto_sha1_process(uint32_t state[5], const uint8_t *data, size_t blocks)
+{
+    crypto_sha_process(CRYPTO_CTRL_SHA_SHA1, state, 5, data, blocks);
+}
+#endif
+
+#if DEVICE_SHA256
+void crypto_sha256_process(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    crypto_sha_process(CRYPTO_CTRL_SHA_SHA2, state, 8, data, blocks);
+}
+#endif
+
+#endif
+
+#endif
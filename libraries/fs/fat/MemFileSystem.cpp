@@ -0,0 +1,242 @@
+/* mbed Microcontroller Library - MemFileSystem
+ * Copyright (c) 2008, sford
+ */
+#include "MemFileSystem.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace mbed
+{
+
+MemFileSystem::MemFileSystem(const char* name, uint32_t sectors)
+    : FATFileSystem(name), _sectors(sectors), _used(0),
+      _buckets(NULL), _bucket_count(0), _page_count(0), _last(NULL),
+      _chunks(NULL), _free(NULL) {
+    rehash(MEMFS_MIN_BUCKETS);
+}
+
+MemFileSystem::~MemFileSystem() {
+    for (uint32_t i = 0; i < _bucket_count; i++) {
+        page_t *page = _buckets[i];
+        while (page) {
+            page_t *next = page->next;
+            free(page);
+            page = next;
+        }
+    }
+    free(_buckets);
+
+    while (_chunks) {
+        chunk_t *next = _chunks->next;
+        free(_chunks);
+        _chunks = next;
+    }
+}
+
+int MemFileSystem::disk_read(uint8_t *buffer, uint32_t sector, uint32_t count) {
+    if (sector + count > _sectors || sector + count < sector) {
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < count; i++, sector++, buffer += MEMFS_SECTOR_SIZE) {
+        page_t *page = page_find(sector / MEMFS_PAGE_SECTORS);
+        uint8_t *sec = page ? page->sector[sector % MEMFS_PAGE_SECTORS] : NULL;
+        if (sec == NULL) {
+            // nothing allocated means sector is empty
+            memset(buffer, 0, MEMFS_SECTOR_SIZE);
+        } else {
+            memcpy(buffer, sec, MEMFS_SECTOR_SIZE);
+        }
+    }
+    return 0;
+}
+
+int MemFileSystem::disk_write(const uint8_t *buffer, uint32_t sector, uint32_t count) {
+    if (sector + count > _sectors || sector + count < sector) {
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < count; i++, sector++, buffer += MEMFS_SECTOR_SIZE) {
+        uint32_t slot = sector % MEMFS_PAGE_SECTORS;
+        page_t *page = page_find(sector / MEMFS_PAGE_SECTORS);
+
+        // if buffer is zero deallocate sector
+        if (is_zero(buffer)) {
+            if (page && page->sector[slot]) {
+                sector_free(page->sector[slot]);
+                page->sector[slot] = NULL;
+                _used--;
+                if (--page->used == 0) {
+                    page_remove(page);
+                }
+            }
+            continue;
+        }
+
+        // else allocate a sector if needed, and write
+        if (page == NULL) {
+            page = page_create(sector / MEMFS_PAGE_SECTORS);
+            if (page == NULL) {
+                return 1; // out of memory
+            }
+        }
+        if (page->sector[slot] == NULL) {
+            uint8_t *sec = sector_alloc();
+            if (sec == NULL) {
+                if (page->used == 0) {
+                    page_remove(page);
+                }
+                return 1; // out of memory
+            }
+            page->sector[slot] = sec;
+            page->used++;
+            _used++;
+        }
+        memcpy(page->sector[slot], buffer, MEMFS_SECTOR_SIZE);
+    }
+    return 0;
+}
+
+uint32_t MemFileSystem::disk_sectors() {
+    return _sectors;
+}
+
+uint32_t MemFileSystem::disk_used() {
+    return _used;
+}
+
+MemFileSystem::page_t *MemFileSystem::page_find(uint32_t index) {
+    // FatFs mostly walks sectors in order, so check the last page first
+    if (_last && _last->index == index) {
+        return _last;
+    }
+    if (_bucket_count == 0) {
+        return NULL;
+    }
+
+    page_t *page = _buckets[index & (_bucket_count - 1)];
+    while (page && page->index != index) {
+        page = page->next;
+    }
+    if (page) {
+        _last = page;
+    }
+    return page;
+}
+
+MemFileSystem::page_t *MemFileSystem::page_create(uint32_t index) {
+    page_t *page = (page_t*)calloc(1, sizeof(page_t));
+    if (page == NULL) {
+        return NULL;
+    }
+
+    // keep chains short, growing is best effort
+    if (_page_count >= 2*_bucket_count) {
+        rehash(_bucket_count ? 2*_bucket_count : (uint32_t)MEMFS_MIN_BUCKETS);
+    }
+    if (_bucket_count == 0) {
+        free(page);
+        return NULL;
+    }
+
+    page_t **bucket = &_buckets[index & (_bucket_count - 1)];
+    page->index = index;
+    page->next = *bucket;
+    *bucket = page;
+    _page_count++;
+    _last = page;
+    return page;
+}
+
+void MemFileSystem::page_remove(page_t *page) {
+    page_t **p = &_buckets[page->index & (_bucket_count - 1)];
+    while (*p != page) {
+        p = &(*p)->next;
+    }
+    *p = page->next;
+    _page_count--;
+    if (_last == page) {
+        _last = NULL;
+    }
+    free(page);
+}
+
+void MemFileSystem::rehash(uint32_t buckets) {
+    page_t **table = (page_t**)calloc(buckets, sizeof(page_t*));
+    if (table == NULL) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < _bucket_count; i++) {
+        page_t *page = _buckets[i];
+        while (page) {
+            page_t *next = page->next;
+            page->next = table[page->index & (buckets - 1)];
+            table[page->index & (buckets - 1)] = page;
+            page = next;
+        }
+    }
+
+    free(_buckets);
+    _buckets = table;
+    _bucket_count = buckets;
+}
+
+uint8_t *MemFileSystem::sector_alloc() {
+    if (_free == NULL) {
+        // carve a new chunk into sectors, the chunk header keeps the
+        // sectors word aligned
+        chunk_t *chunk = (chunk_t*)malloc(
+                sizeof(chunk_t) + MEMFS_POOL_SECTORS*MEMFS_SECTOR_SIZE);
+        if (chunk == NULL) {
+            return NULL;
+        }
+        chunk->next = _chunks;
+        _chunks = chunk;
+
+        uint8_t *sec = (uint8_t*)(chunk + 1);
+        for (int i = 0; i < MEMFS_POOL_SECTORS; i++) {
+            sector_free(sec + i*MEMFS_SECTOR_SIZE);
+        }
+    }
+
+    void *sec = _free;
+    _free = *(void**)sec;
+    return (uint8_t*)sec;
+}
+
+void MemFileSystem::sector_free(uint8_t *sec) {
+    *(void**)sec = _free;
+    _free = sec;
+}
+
+bool MemFileSystem::is_zero(const uint8_t *buffer) {
+    const uint8_t *end = buffer + MEMFS_SECTOR_SIZE;
+
+    // bytes up to the first word boundary
+    while (buffer < end && ((uintptr_t)buffer & (sizeof(uint32_t)-1))) {
+        if (*buffer++) {
+            return false;
+        }
+    }
+
+    // then a word at a time
+    const uint32_t *word = (const uint32_t*)buffer;
+    const uint32_t *word_end = (const uint32_t*)((uintptr_t)end & ~(uintptr_t)(sizeof(uint32_t)-1));
+    while (word < word_end) {
+        if (*word++) {
+            return false;
+        }
+    }
+
+    buffer = (const uint8_t*)word;
+    while (buffer < end) {
+        if (*buffer++) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
@@ -7,71 +7,100 @@
 #define MBED_MEMFILESYSTEM_H
 
 #include "FATFileSystem.h"
+#include <stdint.h>
 
 namespace mbed
 {
 
+    /** RAM backed FAT filesystem
+     *
+     * Sectors are stored sparsely: only sectors holding non-zero data use
+     * memory. Sectors are grouped into pages of MEMFS_PAGE_SECTORS which are
+     * found through a small hash table, so the size of the disk is not
+     * limited by a fixed table and an empty disk costs almost nothing.
+     * Sector storage is carved out of pooled chunks to avoid a heap
+     * allocation per sector.
+     *
+     * @code
+     * #include "mbed.h"
+     * #include "MemFileSystem.h"
+     *
+     * MemFileSystem ram("ram", 8192); // 4MB disk
+     *
+     * int main() {
+     *     ram.format();
+     *     FILE *fp = fopen("/ram/myfile.txt", "w");
+     *     fprintf(fp, "Hello World!\n");
+     *     fclose(fp);
+     * }
+     * @endcode
+     */
     class MemFileSystem : public FATFileSystem
     {
     public:
-    
-        // 2000 sectors, each 512 bytes (malloced as required)
-        char *sectors[2000];
-    
-        MemFileSystem(const char* name) : FATFileSystem(name) {
-            memset(sectors, 0, sizeof(sectors));
-        }
-    
-        virtual ~MemFileSystem() {
-            for(int i = 0; i < 2000; i++) {
-                if(sectors[i]) {
-                    free(sectors[i]);
-                }
-            }
-        }
-    
-        // read a sector in to the buffer, return 0 if ok
-        virtual int disk_read(char *buffer, int sector) {
-            if(sectors[sector] == 0) {
-                // nothing allocated means sector is empty
-                memset(buffer, 0, 512);
-            } else {
-                memcpy(buffer, sectors[sector], 512);
-            }
-            return 0;
-        }
-    
-        // write a sector from the buffer, return 0 if ok
-        virtual int disk_write(const char *buffer, int sector) {
-            // if buffer is zero deallocate sector
-            char zero[512];
-            memset(zero, 0, 512);
-            if(memcmp(zero, buffer, 512)==0) {
-                if(sectors[sector] != 0) {
-                    free(sectors[sector]);
-                    sectors[sector] = 0;
-                }
-                return 0;
-            }
-            // else allocate a sector if needed, and write
-            if(sectors[sector] == 0) {
-                char *sec = (char*)malloc(512);
-                if(sec==0) {
-                    return 1; // out of memory
-                }
-                sectors[sector] = sec;
-            }
-            memcpy(sectors[sector], buffer, 512);
-            return 0;
-        }
-    
+
+        /** Create a RAM filesystem
+         *
+         * @param name    The name used to access the virtual filesystem
+         * @param sectors Size of the disk in 512 byte sectors
+         */
+        MemFileSystem(const char* name, uint32_t sectors = 2000);
+        virtual ~MemFileSystem();
+
+        // read sectors in to the buffer, return 0 if ok
+        virtual int disk_read(uint8_t *buffer, uint32_t sector, uint32_t count);
+
+        // write sectors from the buffer, return 0 if ok
+        virtual int disk_write(const uint8_t *buffer, uint32_t sector, uint32_t count);
+
         // return the number of sectors
-        virtual int disk_sectors() {
-            return sizeof(sectors)/sizeof(sectors[0]);
-        }
-    
+        virtual uint32_t disk_sectors();
+
+        /** Number of sectors currently holding data
+         */
+        uint32_t disk_used();
+
+    private:
+        enum {
+            MEMFS_SECTOR_SIZE  = 512,
+            MEMFS_PAGE_SECTORS = 32,   // sectors covered by one page
+            MEMFS_POOL_SECTORS = 8,    // sectors allocated per pool chunk
+            MEMFS_MIN_BUCKETS  = 8,
+        };
+
+        struct page_t {
+            page_t *next;              // hash chain
+            uint32_t index;            // sector / MEMFS_PAGE_SECTORS
+            uint32_t used;             // number of non-NULL entries in sector[]
+            uint8_t *sector[MEMFS_PAGE_SECTORS];
+        };
+
+        struct chunk_t {
+            chunk_t *next;
+        };
+
+        page_t *page_find(uint32_t index);
+        page_t *page_create(uint32_t index);
+        void page_remove(page_t *page);
+        void rehash(uint32_t buckets);
+
+        uint8_t *sector_alloc();
+        void sector_free(uint8_t *sec);
+
+        static bool is_zero(const uint8_t *buffer);
+
+        uint32_t _sectors;
+        uint32_t _used;
+
+        page_t **_buckets;
+        uint32_t _bucket_count;        // always a power of two
+        uint32_t _page_count;
+        page_t *_last;                 // most recently accessed page
+
+        chunk_t *_chunks;              // pool chunks, freed on destruction
+        void *_free;                   // free list threaded through unused sectors
     };
 
 }
 
-#endif
\ No newline at end of file
+#endif
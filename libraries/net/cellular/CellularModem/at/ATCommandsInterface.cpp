@@ -32,11 +32,13 @@ using std::memmove;
 #include "ATCommandsInterface.h"
 
 ATCommandsInterface::ATCommandsInterface(IOStream* pStream) :
-   m_pStream(pStream), m_open(false), m_transactionState(IDLE), m_env2AT(), m_AT2Env(), m_processingMtx(),
+   m_pStream(pStream), m_open(false), m_pTransaction(NULL), m_transactionState(IDLE), m_inputPos(0), m_linePos(0),
+   m_commandQueue(), m_processingMtx(),
    m_processingThread(&ATCommandsInterface::staticCallback, this, (osPriority)AT_THREAD_PRIORITY, 4*192),
    m_eventsMgmtMtx(), m_eventsProcessingMtx()
 {
   memset(m_eventsHandlers, 0, MAX_AT_EVENTS_HANDLERS * sizeof(IATEventsHandler*));
+  m_inputBuf[0] = '\0';
 
   m_processingMtx.lock();
 }
@@ -65,10 +67,6 @@ int ATCommandsInterface::open()
 //Initialize AT link & start events processing
 int ATCommandsInterface::init(bool reset /* = true*/)
 {
-  
-  //Lock transaction mutex
-  m_transactionMtx.lock();
-  
   if (reset)
   {
     DBG("Sending ATZ E1 V1");
@@ -87,18 +85,15 @@ int ATCommandsInterface::init(bool reset /* = true*/)
     if( err )
     {
       ERR("Sending ATZ E1 V1 returned with err code %d", err);
-      m_transactionMtx.unlock();
       return err;
     }
   }
   
   //Enable events handling and execute events enabling commands
+  //Events stay enabled until the interface is closed
   enableEvents();
 
   DBG("AT interface initialized");
-  
-  //Unlock transaction mutex
-  m_transactionMtx.unlock();
 
   return OK;
 }
@@ -114,7 +109,7 @@ int ATCommandsInterface::close()
 
   DBG("Closing AT interface");
   
-  //Lock transaction mutex
+  //Lock transaction mutex, no other command can be queued from now on
   m_transactionMtx.lock();
   
   //Disable events handling and advertize this to the events handlers
@@ -122,11 +117,6 @@ int ATCommandsInterface::close()
 
   //Stop processing
   m_processingThread.signal_set(AT_SIG_PROCESSING_STOP);
-  //m_stopSphre.release();
-
-  int* msg = m_env2AT.alloc(osWaitForever);
-  *msg = AT_STOP;
-  m_env2AT.put(msg); //Used to unstall the process if needed
 
   //Unlock process routine (abort read)
   m_pStream->abortRead(); //This is thread-safe
@@ -158,17 +148,8 @@ int ATCommandsInterface::execute(const char* command, IATCommandsProcessor* pPro
     return NET_INVALID;
   }
 
-  //Lock transaction mutex
-  m_transactionMtx.lock();
-  
-  disableEvents(); //Disable unsollicited result codes
-  int ret = executeInternal(command, pProcessor, pResult, timeout);
-  enableEvents(); //Re-enable unsollicited result codes whatever the result of the command is
-  
-  //Unlock transaction mutex
-  m_transactionMtx.unlock();
-  
-  return ret;
+  //Unsollicited result codes are left enabled, the processing thread tells them apart from the command's response
+  return executeInternal(command, pProcessor, pResult, timeout);
 }
 
 int ATCommandsInterface::registerEventsHandler(IATEventsHandler* pHdlr)
@@ -213,80 +194,52 @@ int ATCommandsInterface::deregisterEventsHandler(IATEventsHandler* pHdlr)
 
 int ATCommandsInterface::executeInternal(const char* command, IATCommandsProcessor* pProcessor, ATResult* pResult, uint32_t timeout/*=1000*/)
 {
-  DBG("Executing command %s", command);
-
-  //Discard previous result if it arrived too late
-  osEvent evt = m_AT2Env.get(0);
+  DBG("Queueing command %s", command);
 
-  if(evt.status == osEventMail)
-  {
-    m_AT2Env.free((int*)evt.value.p);
-    WARN("Previous result discarded");
-  }
-
-  //Send params to the process routine
-  m_transactionCommand = command;
+  ATTransaction transaction;
+  transaction.command = command;
   if(pProcessor != NULL)
   {
-    m_pTransactionProcessor = pProcessor;
+    transaction.pProcessor = pProcessor;
   }
   else
   {
-    m_pTransactionProcessor = this; //Use default behaviour
+    transaction.pProcessor = this; //Use default behaviour
   }
+  transaction.timeout = timeout;
+  transaction.ret = NET_INTERRUPTED;
 
-  DBG("Sending command ready signal to AT thread & aborting current blocking read operation");
-
-  //Produce command ready signal
-  int* msg = m_env2AT.alloc(osWaitForever);
-  *msg = AT_CMD_READY;
-  m_env2AT.put(msg);
+  m_transactionMtx.lock();
+  if(!m_open)
+  {
+    m_transactionMtx.unlock();
+    WARN("Interface is not open!");
+    return NET_INVALID;
+  }
+  m_commandQueue.put(&transaction, osWaitForever);
+  m_transactionMtx.unlock();
 
-  DBG("Trying to enter abortRead()");
-  //Unlock process routine (abort read)
+  //Unlock process routine (abort read) in case it is waiting for incoming data
   m_pStream->abortRead(); //This is thread-safe
 
-  //Wait for a result (get result message)
-  evt = m_AT2Env.get(timeout);
+  //The processing thread always completes the transaction, with a result, on timeout or when closing
+  transaction.done.wait();
 
-  if(evt.status != osEventMail)
+  if(transaction.ret != OK)
   {
-    //Cancel request
-    msg = m_env2AT.alloc(osWaitForever);
-    *msg = AT_TIMEOUT;
-    m_env2AT.put(msg);
-
-    DBG("Trying to enter abortRead()");
-    //Unlock process routine (abort read)
-    m_pStream->abortRead(); //This is thread-safe
-    
-    //Wait for acknowledge
-    int msgResult;
-    do
-    {
-      evt = m_AT2Env.get(osWaitForever);
-      msgResult = *((int*) evt.value.p);
-      m_AT2Env.free((int*)evt.value.p);
-    } while(msgResult != AT_TIMEOUT);  
-
-    WARN("Command returned no message");
-    WARN("Command \"%s\" returned no message", command);
-    return NET_TIMEOUT;
+    WARN("Command \"%s\" returned no message (%d)", command, transaction.ret);
+    return transaction.ret;
   }
-  DBG("Command returned with message %d", *msg);
-
-  m_AT2Env.free((int*)evt.value.p);
 
   if(pResult != NULL)
   {
-    *pResult = m_transactionResult;
+    *pResult = transaction.result;
   }
 
-  int ret = ATResultToReturnCode(m_transactionResult);
+  int ret = ATResultToReturnCode(transaction.result);
   if(ret != OK)
   {
-    WARN("Command returned AT result %d with code %d", m_transactionResult.result, m_transactionResult.code);
-    WARN("Command \"%s\" returned AT result %d with code %d", command, m_transactionResult.result, m_transactionResult.code);
+    WARN("Command \"%s\" returned AT result %d with code %d", command, transaction.result.result, transaction.result.code);
   }
 
   DBG("Command returned successfully");
@@ -296,268 +249,116 @@ int ATCommandsInterface::executeInternal(const char* command, IATCommandsProcess
 
 int ATCommandsInterface::tryReadLine()
 {
-  static bool lineDetected = false;
-
-  //Block on serial read or incoming command
-  DBG("Trying to read a new line from stream");
-  int ret = m_pStream->waitAvailable(); //This can be aborted
-  size_t readLen = 0;
-  if(ret == OK)
+  //Wait for incoming data, an incoming command or the current command's deadline
+  uint32_t timeout = osWaitForever;
+  if(m_pTransaction != NULL)
   {
-    ret = m_pStream->read((uint8_t*)m_inputBuf + m_inputPos, &readLen, AT_INPUT_BUF_SIZE - 1 - m_inputPos, 0); //Do NOT wait at this point
+    uint32_t elapsed = m_transactionTimer.read_ms();
+    if(elapsed >= m_pTransaction->timeout)
+    {
+      WARN("Command \"%s\" timed out", m_transactionCommand);
+      completeTransaction(NET_TIMEOUT);
+      return NET_TIMEOUT;
+    }
+    timeout = m_pTransaction->timeout - elapsed;
   }
-  if(ret == OK)
+
+  DBG("Trying to read a new line from stream");
+  int ret = m_pStream->waitAvailable(timeout); //This can be aborted
+  if(ret != OK)
   {
-    m_inputPos+=readLen;
-    m_inputBuf[m_inputPos] = '\0'; //Add null terminating character to ease the use of str* functions
-    DBG("In buffer: [%s]", m_inputBuf);
+    DBG("Nothing read (%d)", ret);
+    return ret;
   }
 
-  if( ret == NET_INTERRUPTED ) //It is worth checking readLen as data might have been read even though the read was interrupted
+  //Make room at the end of the buffer; lines are parsed in place so data is only moved once the buffer wraps
+  if(m_inputPos == AT_INPUT_BUF_SIZE - 1)
   {
-    DBG("Read was interrupted");
-    return NET_INTERRUPTED; //0 chars were read
+    if(m_linePos > 0)
+    {
+      memmove(m_inputBuf, m_inputBuf + m_linePos, (m_inputPos + 1) - m_linePos); //Move null-terminating char as well
+      m_inputPos -= m_linePos;
+      m_linePos = 0;
+    }
+    else
+    {
+      //If the line could not be processed AND buffer is full, it means that we won't ever be able to process it (buffer too short)
+      WARN("Incoming buffer is too short to process incoming line");
+      resetInputBuffer();
+    }
   }
-  else if(readLen == 0)
+
+  size_t readLen = 0;
+  ret = m_pStream->read((uint8_t*)m_inputBuf + m_inputPos, &readLen, AT_INPUT_BUF_SIZE - 1 - m_inputPos, 0); //Do NOT wait at this point
+  if(ret != OK || readLen == 0)
   {
     DBG("Nothing read");
-    return OK; //0 chars were read
+    return ret;
   }
 
-  DBG("Trying to process incoming line");
-  bool lineProcessed = false;
+  m_inputPos += readLen;
+  m_inputBuf[m_inputPos] = '\0'; //Add null terminating character to ease the use of str* functions
+  DBG("In buffer: [%s]", m_inputBuf + m_linePos);
 
-  do
-  {
-    lineProcessed = false; //Reset flag
+  return processInputBuffer();
+}
 
-    DBG("New iteration");
+//Parses every complete line in the input buffer; lines are null-terminated in place and handed out without copying
+int ATCommandsInterface::processInputBuffer()
+{
+  while(m_linePos < m_inputPos)
+  {
+    char* line = m_inputBuf + m_linePos;
 
-    //Look for a new line
-    if(!lineDetected)
+    //Skip line terminators, whether they end the previous line or start the next one
+    if(line[0] == CR || line[0] == LF)
     {
-      DBG("No line detected yet");
-      //Try to look for a starting CRLF
-      char* crPtr = strchr(m_inputBuf, CR);
-      /*
-      Different cases at this point:
-      - CRLF%c sequence: this is the start of a line
-      - CRLFCR(LF) sequence: this is the end of a line (followed by the beginning of the next one)
-      - LF: this is the trailing LF char of the previous line, discard
-      - CR / CRLF incomplete sequence: more data is needed to determine which action to take
-      - %c ... CR sequence: this should be the echo of the previous sequence
-      - %c sequence: This might be the echo of the previous command; more data is needed to determine which action to take
-
-      In every case, move mem at the beginning
-      */
-      if(crPtr != NULL)
-      {
-        DBG("CR char found");
-
-#if 0
-        //Discard all preceding characters (can do nothing if m_inputBuf == crPtr)
-        memmove(m_inputBuf, crPtr, (m_inputPos + 1) - (crPtr-m_inputBuf)); //Move null-terminating char as well
-        m_inputPos = m_inputPos - (crPtr-m_inputBuf); //Adjust m_inputPos
-#endif
-
-        //If the line starts with CR, this should be a result code
-        if( crPtr == m_inputBuf )
-        {
-          //To determine the sequence we need at least 3 chars
-          if(m_inputPos >= 3)
-          {
-            //Look for a LF char next to the CR char
-            if(m_inputBuf[1] == LF)
-            {
-              //At this point we can check whether this is the end of a preceding line or the beginning of a new one
-              if(m_inputBuf[2] != CR)
-              {
-                DBG("Beginning of new line found");
-                //Beginning of a line
-                lineDetected = true; //Move to next state-machine step
-              }
-              else
-              {
-                //End of an unprocessed line
-                WARN("End of unprocessed line");
-              }
-              //In both cases discard CRLF
-              DBG("Discarding CRLF");
-              memmove(m_inputBuf, m_inputBuf + 2, (m_inputPos + 1) - 2); //Move null-terminating char as well
-              m_inputPos = m_inputPos - 2; //Adjust m_inputPos
-            }
-            else
-            {
-              //This is completely unexpected, discard the CR char to try to recover good state
-              WARN("Unexpected %c char (%02d code) found after CR char", m_inputBuf[1]);
-              memmove(m_inputBuf, m_inputBuf + 1, (m_inputPos + 1) - 1); //Move null-terminating char as well
-              m_inputPos = m_inputPos - 1; //Adjust m_inputPos
-            }
-          }
-        }
-        //if the line does NOT begin with CR, this can be an echo of the previous command, process it
-        else
-        {
-          int crPos = crPtr - m_inputBuf;
-          int lfOff = 0; //Offset for LF if present
-          DBG("New line found (possible echo of command)");
-          //This is the end of line
-          //Replace m_inputBuf[crPos] with null-terminating char
-          m_inputBuf[crPos] = '\0';
-          //Check if there is a LF char afterwards
-          if(m_inputPos - crPos >= 1)
-          {
-            if(m_inputBuf[crPos+1] == LF)
-            {
-              lfOff++; //We will discard LF char as well
-            }
-          }
-          //Process line
-          int ret = processReadLine();
-          if(ret)
-          {
-            m_inputPos = 0;
-            m_inputBuf[0] = '\0'; //Always have a null-terminating char at start of buffer
-            lineDetected = false;
-            return ret;
-          }
-
-          //If sendData has been called, all incoming data has been discarded
-          if(m_inputPos > 0)
-          {
-            memmove(m_inputBuf, m_inputBuf + crPos + lfOff + 1, (m_inputPos + 1) - (crPos + lfOff + 1)); //Move null-terminating char as well
-            m_inputPos = m_inputPos - (crPos + lfOff + 1); //Adjust m_inputPos
-          }
-          DBG("One line was successfully processed");
-          lineProcessed = true; //Line was processed with success
-          lineDetected = false; //Search now for a new line
-        }
-      }
-      else if(m_inputBuf[0] == LF) //If there is a remaining LF char from the previous line, discard it
-      {
-        DBG("Discarding single LF char");
-        memmove(m_inputBuf, m_inputBuf + 1, (m_inputPos + 1) - 1); //Move null-terminating char as well
-        m_inputPos = m_inputPos - 1; //Adjust m_inputPos
-      }
+      m_linePos++;
+      continue;
     }
 
-    //Look for the end of line
-    if(lineDetected)
+    //An entry prompt is not followed by a CRLF sequence
+    if(line[0] == GD)
     {
-      DBG("Looking for end of line");
-      //Try to look for a terminating CRLF
-      char* crPtr = strchr(m_inputBuf, CR);
-      /*
-      Different cases at this point:
-      - CRLF sequence: this is the end of the line
-      - CR%c sequence : unexpected
-      - CR incomplete sequence: more data is needed to determine which action to take
-      */
-
-      //Try to look for a '>' (greater than character) that marks an entry prompt
-      char* greaterThanPtr = strchr(m_inputBuf, GD);
-      /*
-      This character must be detected as there is no CRLF sequence at the end of an entry prompt
-       */
-
-      if(crPtr != NULL)
+      //To determine the sequence we need at least 2 chars
+      if(m_inputPos - m_linePos < 2)
       {
-        DBG("CR char found");
-        int crPos = crPtr - m_inputBuf;
-        //To determine the sequence we need at least 2 chars
-        if(m_inputPos - crPos >= 2)
-        {
-          //Look for a LF char next to the CR char
-          if(m_inputBuf[crPos + 1] == LF)
-          {
-            DBG("End of new line found");
-            //This is the end of line
-            //Replace m_inputBuf[crPos] with null-terminating char
-            m_inputBuf[crPos] = '\0';
-            //Process line
-            int ret = processReadLine();
-            if(ret)
-            {
-              m_inputPos = 0;
-              m_inputBuf[0] = '\0'; //Always have a null-terminating char at start of buffer
-              lineDetected = false;
-              return ret;
-            }
-
-            //If sendData has been called, all incoming data has been discarded
-            if(m_inputPos > 0)
-            {
-              //Shift remaining data to beginning of buffer
-              memmove(m_inputBuf, m_inputBuf + crPos + 2, (m_inputPos + 1) - (crPos + 2)); //Move null-terminating char as well
-              m_inputPos = m_inputPos - (crPos + 2); //Adjust m_inputPos
-            }
-
-            DBG("One line was successfully processed");
-            lineProcessed = true; //Line was processed with success
-          }
-          else
-          {
-            //This is completely unexpected, discard all chars till the CR char to try to recover good state
-            WARN("Unexpected %c char (%02d code) found in incoming line", m_inputBuf[crPos + 1]);
-            memmove(m_inputBuf, m_inputBuf + crPos + 1, (m_inputPos + 1) - (crPos + 1)); //Move null-terminating char as well
-            m_inputPos = m_inputPos - (crPos + 1); //Adjust m_inputPos
-          }
-          lineDetected = false; //In both case search now for a new line
-        }
+        break;
       }
-      else if(greaterThanPtr != NULL)
+
+      if(line[1] == ' ')
       {
-        DBG("> char found");
-        int gdPos = greaterThanPtr - m_inputBuf;
-        //To determine the sequence we need at least 2 chars
-        if(m_inputPos - gdPos >= 2)
+        m_linePos += 2;
+        int ret = processEntryPrompt(); //Here sendData can be called, which discards the input buffer
+        if(ret)
         {
-          //Look for a space char next to the GD char
-          if(m_inputBuf[gdPos + 1] == ' ')
-          {
-            //This is an entry prompt
-            //Replace m_inputBuf[gdPos] with null-terminating char
-            m_inputBuf[gdPos] = '\0';
-
-            //Shift remaining data to beginning of buffer
-            memmove(m_inputBuf, m_inputBuf + gdPos + 1, (m_inputPos + 1) - (gdPos + 1)); //Move null-terminating char as well
-            m_inputPos = m_inputPos - (gdPos + 1); //Adjust m_inputPos
-
-            //Process prompt
-            ret = processEntryPrompt();
-            if(ret)
-            {
-              m_inputPos = 0;
-              m_inputBuf[0] = '\0'; //Always have a null-terminating char at start of buffer
-              lineDetected = false;
-              return ret;
-            }
-
-            DBG("One line was successfully processed");
-            lineProcessed = true; //Line was processed with success
-          }
-          else
-          {
-            //This is completely unexpected, discard all chars till the GD char to try to recover good state
-            WARN("Unexpected %c char (%02d code) found in incoming line", m_inputBuf[gdPos + 1]);
-            memmove(m_inputBuf, m_inputBuf + gdPos + 1, (m_inputPos + 1) - (gdPos + 1)); //Move null-terminating char as well
-            m_inputPos = m_inputPos - (gdPos + 1); //Adjust m_inputPos
-          }
-          lineDetected = false; //In both case search now for a new line
+          resetInputBuffer();
+          return ret;
         }
+        continue;
       }
     }
-  } while(lineProcessed); //If one complete line was processed there might be other incoming lines that can also be processed without reading the buffer again
 
-  //If the line could not be processed AND buffer is full, it means that we won't ever be able to process it (buffer too short)
-  if(m_inputPos == AT_INPUT_BUF_SIZE - 1)
+    char* end = strpbrk(line, "\r\n");
+    if(end == NULL)
+    {
+      break; //More data is needed
+    }
+
+    *end = '\0';
+    m_linePos = end + 1 - m_inputBuf;
+
+    int ret = processReadLine(line); //Here sendData can be called, which discards the input buffer
+    if(ret)
+    {
+      resetInputBuffer();
+      return ret;
+    }
+  }
+
+  if(m_linePos == m_inputPos)
   {
-    //Discard everything
-    m_inputPos = 0;
-    m_inputBuf[0] = '\0'; //Always have a null-terminating char at start of buffer
-    WARN("Incoming buffer is too short to process incoming line");
-    //Look for a new line
-    lineDetected = false;
+    resetInputBuffer(); //Everything was parsed, start again from the beginning of the buffer
   }
 
   DBG("Processed every full incoming lines");
@@ -565,161 +366,209 @@ int ATCommandsInterface::tryReadLine()
   return OK;
 }
 
+void ATCommandsInterface::resetInputBuffer()
+{
+  m_inputPos = 0;
+  m_linePos = 0;
+  m_inputBuf[0] = '\0'; //Always have a null-terminating char at start of buffer
+}
+
 int ATCommandsInterface::trySendCommand()
 {
-  osEvent evt = m_env2AT.get(0);
-  DBG("status = %d, msg = %d", evt.status, evt.value.p);
-  if(evt.status == osEventMail)
+  if(m_pTransaction != NULL)
   {
-    int* msg = (int*) evt.value.p;
-    if( *msg == AT_CMD_READY ) //Command pending
-    {
-      if(m_transactionState != IDLE)
-      {
-        WARN("Previous command not processed!");
-      }
-      DBG("Sending pending command");
-      m_pStream->write((uint8_t*)m_transactionCommand, strlen(m_transactionCommand), osWaitForever);
-      char cr = CR;
-      m_pStream->write((uint8_t*)&cr, 1, osWaitForever); //Carriage return line terminator
-      m_transactionState = COMMAND_SENT;
-    }
-    else //Timeout
-    {
-      //Acknowledge
-      int* msg = m_AT2Env.alloc(osWaitForever);
-      *msg = AT_TIMEOUT;
-      m_AT2Env.put(msg); //Command has timed out
-      m_transactionState = IDLE; //State-machine reset
-    }
-    m_env2AT.free(msg);
+    return OK; //Only one command can be in flight on an AT link
+  }
+
+  osEvent evt = m_commandQueue.get(0);
+  if(evt.status != osEventMessage)
+  {
+    return OK;
   }
+
+  m_pTransaction = (ATTransaction*) evt.value.p;
+  m_transactionCommand = m_pTransaction->command;
+  m_pTransactionProcessor = m_pTransaction->pProcessor;
+
+  DBG("Sending pending command %s", m_transactionCommand);
+  m_pStream->write((uint8_t*)m_transactionCommand, strlen(m_transactionCommand), osWaitForever);
+  char cr = CR;
+  m_pStream->write((uint8_t*)&cr, 1, osWaitForever); //Carriage return line terminator
+  m_transactionState = COMMAND_SENT;
+
+  m_transactionTimer.reset();
+  m_transactionTimer.start();
   return OK;
 }
 
-int ATCommandsInterface::processReadLine()
+//Hands the result of the current command back to the calling thread; the next queued command is sent right away
+void ATCommandsInterface::completeTransaction(int ret)
 {
-  DBG("Processing read line [%s]", m_inputBuf);
-  //The line is stored in m_inputBuf
-  if(m_transactionState == COMMAND_SENT)
+  m_transactionState = IDLE;
+  m_transactionTimer.stop();
+
+  ATTransaction* pTransaction = m_pTransaction;
+  if(pTransaction == NULL)
   {
-    //If the command has been sent, checks echo to see if it has been received properly
-    if( strcmp(m_transactionCommand, m_inputBuf) == 0 )
-    {
-      DBG("Command echo received");
-      //If so, it means that the following lines will only be solicited results
-      m_transactionState = READING_RESULT;
-      return OK;
-    }
+    return;
   }
-  if(m_transactionState == IDLE || m_transactionState == COMMAND_SENT)
+
+  m_pTransaction = NULL;
+  pTransaction->result = m_transactionResult;
+  pTransaction->ret = ret;
+  pTransaction->done.release(); //pTransaction must not be accessed after this point
+}
+
+//Fails the current command and every queued one
+void ATCommandsInterface::flushTransactions()
+{
+  completeTransaction(NET_INTERRUPTED);
+
+  osEvent evt;
+  while( (evt = m_commandQueue.get(0)).status == osEventMessage )
   {
-    bool found = false;
-    char* pSemicol = strchr(m_inputBuf, ':');
-    char* pData = NULL;
-    if( pSemicol != NULL ) //Split the identifier & the result code (if it exists)
+    ATTransaction* pTransaction = (ATTransaction*) evt.value.p;
+    pTransaction->ret = NET_INTERRUPTED;
+    pTransaction->done.release();
+  }
+}
+
+//Responses to a command start with the command's name, eg "+CMGR: ..." for "AT+CMGR=1"
+bool ATCommandsInterface::isTransactionResponse(const char* atCode)
+{
+  if(m_transactionState != READING_RESULT)
+  {
+    return false;
+  }
+
+  const char* cmd = m_transactionCommand;
+  if((cmd[0] == 'A' || cmd[0] == 'a') && (cmd[1] == 'T' || cmd[1] == 't'))
+  {
+    cmd += 2;
+  }
+
+  size_t len = strcspn(cmd, "=?");
+  return (strlen(atCode) == len) && (strncmp(atCode, cmd, len) == 0);
+}
+
+//Dispatches unsollicited result codes to the events handlers, returns false if the line is not one
+bool ATCommandsInterface::processEvent(char* line)
+{
+  char* pSemicol = strchr(line, ':');
+  char* pData = NULL;
+  if( pSemicol != NULL ) //Split the identifier & the result code (if it exists)
+  {
+    *pSemicol = '\0';
+    pData = pSemicol + 1;
+    if(pData[0]==' ')
     {
-      *pSemicol = '\0';
-      pData = pSemicol + 1;
-      if(pData[0]==' ')
-      {
-        pData++; //Suppress whitespace
-      }
+      pData++; //Suppress whitespace
     }
-    //Looks for a unsolicited result code; we can have m_transactionState == COMMAND_SENT as the code may have arrived just before we sent the command
+  }
+
+  bool found = false;
+  if(!isTransactionResponse(line))
+  {
     m_eventsProcessingMtx.lock();
     //Go through the list
-    for(int i = 0; i < MAX_AT_EVENTS_HANDLERS; i++) //Find a free slot
+    for(int i = 0; i < MAX_AT_EVENTS_HANDLERS; i++)
     {
       if( m_eventsHandlers[i] != NULL )
       {
-        if( m_eventsHandlers[i]->isATCodeHandled(m_inputBuf) )
+        if( m_eventsHandlers[i]->isATCodeHandled(line) )
         {
-          m_eventsHandlers[i]->onEvent(m_inputBuf, pData);
+          m_eventsHandlers[i]->onEvent(line, pData);
           found = true; //Do not break here as there might be multiple handlers for one event type
         }
       }
     }
     m_eventsProcessingMtx.unlock();
-    if(found)
+  }
+
+  if(!found && pSemicol != NULL)
+  {
+    *pSemicol = ':'; //Restore the line for the transaction processor
+  }
+  return found;
+}
+
+int ATCommandsInterface::processReadLine(char* line)
+{
+  DBG("Processing read line [%s]", line);
+  if(m_transactionState == COMMAND_SENT)
+  {
+    //If the command has been sent, checks echo to see if it has been received properly
+    if( strcmp(m_transactionCommand, line) == 0 )
     {
+      DBG("Command echo received");
+      //If so, it means that the following lines will only be solicited results or unsollicited result codes
+      m_transactionState = READING_RESULT;
       return OK;
     }
   }
+
+  //Looks for a unsolicited result code; they can arrive at any time, including while a command is being processed
+  if(processEvent(line))
+  {
+    return OK;
+  }
+
   if(m_transactionState == READING_RESULT)
   {
     //The following lines can either be a command response or a result code (OK / ERROR / CONNECT / +CME ERROR: %s / +CMS ERROR: %s)
-    if(strcmp("OK", m_inputBuf) == 0)
+    if(strcmp("OK", line) == 0)
     {
       DBG("OK result received");
       m_transactionResult.code = 0;
       m_transactionResult.result = ATResult::AT_OK;
-      m_transactionState = IDLE;
-      int* msg = m_AT2Env.alloc(osWaitForever);
-      *msg = AT_RESULT_READY;
-      m_AT2Env.put(msg); //Command has been processed
+      completeTransaction(OK); //Command has been processed
       return OK;
     }
-    else if(strcmp("ERROR", m_inputBuf) == 0)
+    else if(strcmp("ERROR", line) == 0)
     {
       DBG("ERROR result received");
       m_transactionResult.code = 0;
       m_transactionResult.result = ATResult::AT_ERROR;
-      m_transactionState = IDLE;
-      int* msg = m_AT2Env.alloc(osWaitForever);
-      *msg = AT_RESULT_READY;
-      m_AT2Env.put(msg); //Command has been processed
+      completeTransaction(OK); //Command has been processed
       return OK;
     }
-    else if(strncmp("CONNECT", m_inputBuf, 7 /*=strlen("CONNECT")*/) == 0) //Result can be "CONNECT" or "CONNECT %d", indicating baudrate
+    else if(strncmp("CONNECT", line, 7 /*=strlen("CONNECT")*/) == 0) //Result can be "CONNECT" or "CONNECT %d", indicating baudrate
     {
       DBG("CONNECT result received");
       m_transactionResult.code = 0;
       m_transactionResult.result = ATResult::AT_CONNECT;
-      m_transactionState = IDLE;
-      int* msg = m_AT2Env.alloc(osWaitForever);
-      *msg = AT_RESULT_READY;
-      m_AT2Env.put(msg); //Command has been processed
+      completeTransaction(OK); //Command has been processed
       return OK;
     }
-    else if(strcmp("COMMAND NOT SUPPORT", m_inputBuf) == 0) //Huawei-specific, not normalized
+    else if(strcmp("COMMAND NOT SUPPORT", line) == 0) //Huawei-specific, not normalized
     {
       DBG("COMMAND NOT SUPPORT result received");
       m_transactionResult.code = 0;
       m_transactionResult.result = ATResult::AT_ERROR;
-      m_transactionState = IDLE;
-      int* msg = m_AT2Env.alloc(osWaitForever);
-      *msg = AT_RESULT_READY;
-      m_AT2Env.put(msg); //Command has been processed
+      completeTransaction(OK); //Command has been processed
       return OK;
     }
-    else if(strstr(m_inputBuf, "+CME ERROR:") == m_inputBuf) //Mobile Equipment Error
+    else if(strstr(line, "+CME ERROR:") == line) //Mobile Equipment Error
     {
-      std::sscanf(m_inputBuf + 12 /* =strlen("+CME ERROR: ") */, "%d", &m_transactionResult.code);
+      std::sscanf(line + 12 /* =strlen("+CME ERROR: ") */, "%d", &m_transactionResult.code);
       DBG("+CME ERROR: %d result received", m_transactionResult.code);
       m_transactionResult.result = ATResult::AT_CME_ERROR;
-      m_transactionState = IDLE;
-      int* msg = m_AT2Env.alloc(osWaitForever);
-      *msg = AT_RESULT_READY;
-      m_AT2Env.put(msg); //Command has been processed
+      completeTransaction(OK); //Command has been processed
       return OK;
     }
-    else if(strstr(m_inputBuf, "+CMS ERROR:") == m_inputBuf) //SIM Error
+    else if(strstr(line, "+CMS ERROR:") == line) //SIM Error
     {
-      std::sscanf(m_inputBuf + 13 /* =strlen("+CME ERROR: ") */, "%d", &m_transactionResult.code);
+      std::sscanf(line + 13 /* =strlen("+CME ERROR: ") */, "%d", &m_transactionResult.code);
       DBG("+CMS ERROR: %d result received", m_transactionResult.code);
       m_transactionResult.result = ATResult::AT_CMS_ERROR;
-      m_transactionState = IDLE;
-      int* msg = m_AT2Env.alloc(osWaitForever);
-      *msg = AT_RESULT_READY;
-      m_AT2Env.put(msg); //Command has been processed
+      completeTransaction(OK); //Command has been processed
       return OK;
     }
     else
     {
-      DBG("Unprocessed result received: '%s'", m_inputBuf);
+      DBG("Unprocessed result received: '%s'", line);
       //Must call transaction processor to complete line processing
-      int ret = m_pTransactionProcessor->onNewATResponseLine(this, m_inputBuf); //Here sendData can be called
+      int ret = m_pTransactionProcessor->onNewATResponseLine(this, line); //Here sendData can be called
       return ret;
     }
   }
@@ -742,7 +591,7 @@ int ATCommandsInterface::processEntryPrompt()
   return OK;
 }
 
-//This will be called on initialization & after the execution of a command
+//This will be called on initialization
 void ATCommandsInterface::enableEvents()
 {
   //Advertize this to events handlers
@@ -767,7 +616,7 @@ void ATCommandsInterface::enableEvents()
   m_eventsMgmtMtx.unlock();
 }
 
-//This will be called on de-initialization & before the execution of a command to prevent unsollicited result codes from polluting the results
+//This will be called on de-initialization
 void ATCommandsInterface::disableEvents()
 {
   //Advertize this to events handlers
@@ -776,7 +625,7 @@ void ATCommandsInterface::disableEvents()
   {
     if( m_eventsHandlers[i] != NULL )
     {
-      m_eventsHandlers[i]->onDispatchStart();
+      m_eventsHandlers[i]->onDispatchStop();
       //Disable this kind of events
       const char* cmd = m_eventsHandlers[i]->getEventsDisableCommand();
       if(cmd != NULL)
@@ -796,7 +645,7 @@ void ATCommandsInterface::disableEvents()
 //Access to this method is protected (can ONLY be called on processing thread during IATCommandsProcessor::onNewATResponseLine execution)
 int ATCommandsInterface::sendData(const char* data)
 {
-  //m_inputBuf is cleared at this point (and MUST therefore be empty)
+  //Any unparsed input is discarded at this point
   int dataLen = strlen(data);
   DBG("Sending raw string of length %d", dataLen);
   int ret = m_pStream->write((uint8_t*)data, dataLen, osWaitForever);
@@ -815,8 +664,7 @@ int ATCommandsInterface::sendData(const char* data)
     if(ret)
     {
       WARN("Could not read from stream (returned %d)", ret);
-      m_inputPos = 0; //Reset input buffer state
-      m_inputBuf[0] = '\0'; //Always have a null-terminating char at start of buffer
+      resetInputBuffer(); //Reset input buffer state
       return ret;
     }
 
@@ -825,8 +673,7 @@ int ATCommandsInterface::sendData(const char* data)
       //Echo does not match output
       m_inputBuf[readLen] = '\0';
       WARN("Echo does not match output, got '%s' instead", m_inputBuf);
-      m_inputPos = 0; //Reset input buffer state
-      m_inputBuf[0] = '\0'; //Always have a null-terminating char at start of buffer
+      resetInputBuffer(); //Reset input buffer state
       return NET_DIFF;
     }
 
@@ -837,8 +684,7 @@ int ATCommandsInterface::sendData(const char* data)
 
   DBG("String sent successfully");
 
-  m_inputPos = 0; //Reset input buffer state
-  m_inputBuf[0] = '\0'; //Always have a null-terminating char at start of buffer
+  resetInputBuffer(); //Reset input buffer state
 
   return OK;
 }
@@ -887,7 +733,7 @@ void ATCommandsInterface::process() //Processing thread
     {
       ret = m_pStream->read((uint8_t*)m_inputBuf, &readLen, AT_INPUT_BUF_SIZE - 1, 0); //Do NOT wait at this point
     } while(ret == OK);
-    m_inputPos = 0; //Clear input buffer
+    resetInputBuffer(); //Clear input buffer
     do
     {
       DBG("Trying to send a pending command");
@@ -895,8 +741,8 @@ void ATCommandsInterface::process() //Processing thread
       DBG("Trying to read a new line");
       tryReadLine();
     } while( m_processingThread.signal_wait(AT_SIG_PROCESSING_STOP, 0).status != osEventSignal ); //Loop until the process is interrupted
+    flushTransactions(); //Release any thread still waiting for a result
     m_processingMtx.unlock();
     DBG("AT Processing stopped");
   }
 }
-
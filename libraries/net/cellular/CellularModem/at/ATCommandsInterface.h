@@ -22,6 +22,7 @@
 
 #include "core/fwk.h"
 #include "rtos.h"
+#include "Timer.h"
 
 #define MAX_AT_EVENTS_HANDLERS 4
 
@@ -58,15 +59,12 @@ protected:
 //Signals to be sent to the processing thread
 #define AT_SIG_PROCESSING_START 1
 #define AT_SIG_PROCESSING_STOP 2
-//Messages to be sent to the processing thread
-#define AT_CMD_READY 1
-#define AT_TIMEOUT 2
-#define AT_STOP 3
-//Messages to be sent from the processing thread
-#define AT_RESULT_READY 1
 
 /** AT Commands interface class
  *
+ * Commands from any number of threads are queued and sent back to back by the
+ * processing thread, which also dispatches unsolicited result codes as they are
+ * parsed, so they do not need to be disabled around each command.
  */
 class ATCommandsInterface : protected IATCommandsProcessor
 {
@@ -91,6 +89,7 @@ public:
     int code;
   };
 
+  //The timeout is counted from the moment the command is sent to the modem, not from when it is queued
   int executeSimple(const char* command, ATResult* pResult, uint32_t timeout=1000);
   int execute(const char* command, IATCommandsProcessor* pProcessor, ATResult* pResult, uint32_t timeout=1000);
   
@@ -103,12 +102,30 @@ public:
 
   static void staticCallback(void const* p);
 private:
+  //A queued command, owned by the calling thread which waits on done until the processing thread completes it
+  class ATTransaction
+  {
+  public:
+    const char* command;
+    IATCommandsProcessor* pProcessor;
+    uint32_t timeout;
+    ATResult result;
+    int ret;
+    Semaphore done;
+  };
+
   int executeInternal(const char* command, IATCommandsProcessor* pProcessor, ATResult* pResult, uint32_t timeout=1000);
   
   int tryReadLine();
   int trySendCommand();
-  int processReadLine();
+  void completeTransaction(int ret);
+  void flushTransactions();
+  int processInputBuffer();
+  int processReadLine(char* line);
   int processEntryPrompt();
+  bool processEvent(char* line);
+  bool isTransactionResponse(const char* atCode);
+  void resetInputBuffer();
   
   void enableEvents();
   void disableEvents();
@@ -124,22 +141,23 @@ private:
   
   bool m_open; //< TRUE when the AT interface is open, and FALSE when it is not.
 
+  ATTransaction* m_pTransaction; //Command currently on the wire, only accessed by the processing thread
   const char* m_transactionCommand;
-  const char* m_transactionData;
 
   IATCommandsProcessor* m_pTransactionProcessor;
   ATResult m_transactionResult;
 
-  enum { IDLE, COMMAND_SENT, READING_RESULT, ABORTED } m_transactionState;
+  enum { IDLE, COMMAND_SENT, READING_RESULT } m_transactionState;
+  mbed::Timer m_transactionTimer; //Time since the current command was sent
 
   char m_inputBuf[AT_INPUT_BUF_SIZE]; // Stores characters received from the modem.
   int m_inputPos; // Current position of fill pointer in the input buffer.
+  int m_linePos; // Start of the first line in the input buffer that has not been parsed yet.
 
-  Mutex m_transactionMtx;
+  Mutex m_transactionMtx; //Keeps commands from being queued while the interface closes
 
-  // These are RTOS queues, concurrent access protected. In this case both only contain an integer.
-  Mail<int,1> m_env2AT; // used by calling function to inform processing thread of events
-  Mail<int,1> m_AT2Env; // used by processing thread to inform calling function of events
+  // RTOS queue, concurrent access protected. Holds the commands waiting for the AT link
+  Queue<ATTransaction, AT_CMD_QUEUE_SIZE> m_commandQueue;
 
   IATEventsHandler* m_eventsHandlers[MAX_AT_EVENTS_HANDLERS]; // all registered events handlers
 
@@ -22,6 +22,7 @@
 
 //Configuration
 #define AT_THREAD_PRIORITY 0
+#define AT_CMD_QUEUE_SIZE 4 //Commands that can be waiting for the AT link at once
 
 
 #endif /* CONFIG_H_ */
@@ -0,0 +1,99 @@
+#include "mbed.h"
+#include "mbedtls/aes.h"
+
+/*
+ * Cycles per byte of the software AES as configured at build time. Build
+ * once per table option to compare them:
+ *
+ *   (default)                 T-tables generated into RAM on first use
+ *   -D MBEDTLS_AES_ROM_TABLES T-tables in ROM
+ *   -D MBEDTLS_AES_COMPACT    S-boxes only, no T-tables
+ */
+#if defined(MBEDTLS_AES_ALT)
+#define AES_TABLES "hardware (MBEDTLS_AES_ALT)"
+#elif defined(MBEDTLS_AES_COMPACT)
+#define AES_TABLES "compact"
+#elif defined(MBEDTLS_AES_ROM_TABLES)
+#define AES_TABLES "ROM tables"
+#else
+#define AES_TABLES "RAM tables"
+#endif
+
+namespace {
+const int BUFFER_SIZE = 1024;
+const int ROUNDS = 64;
+
+unsigned char buffer[BUFFER_SIZE];
+unsigned char key[32];
+unsigned char iv[16];
+Timer timer;
+}
+
+static void report(const char *name, int us, int bytes) {
+    /* Tenths of a cycle, printf may be built without float support */
+    uint64_t cycles = (uint64_t)us * (SystemCoreClock / 1000000) * 10;
+    unsigned per_byte = (unsigned)(cycles / bytes);
+    printf("%-24s %8d us %6u.%u cycles/byte\r\n", name, us,
+           per_byte / 10, per_byte % 10);
+}
+
+static int time_ecb(mbedtls_aes_context *ctx, int mode) {
+    timer.reset();
+    timer.start();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < BUFFER_SIZE; i += 16) {
+            mbedtls_aes_crypt_ecb(ctx, mode, buffer + i, buffer + i);
+        }
+    }
+    timer.stop();
+    return timer.read_us();
+}
+
+static int time_cbc(mbedtls_aes_context *ctx, int mode) {
+    timer.reset();
+    timer.start();
+    for (int r = 0; r < ROUNDS; r++) {
+        mbedtls_aes_crypt_cbc(ctx, mode, BUFFER_SIZE, iv, buffer, buffer);
+    }
+    timer.stop();
+    return timer.read_us();
+}
+
+int main() {
+    mbedtls_aes_context ctx;
+    char name[32];
+
+    printf("AES benchmark: %s, %lu Hz\r\n", AES_TABLES,
+           (unsigned long)SystemCoreClock);
+
+    mbedtls_aes_init(&ctx);
+
+    /* The first key schedule also pays for generating the RAM tables */
+    timer.start();
+    mbedtls_aes_setkey_enc(&ctx, key, 128);
+    timer.stop();
+    printf("%-24s %8d us\r\n", "first setkey", timer.read_us());
+
+    for (unsigned keybits = 128; keybits <= 256; keybits += 128) {
+        mbedtls_aes_setkey_enc(&ctx, key, keybits);
+        sprintf(name, "AES-%u-ECB encrypt", keybits);
+        report(name, time_ecb(&ctx, MBEDTLS_AES_ENCRYPT), BUFFER_SIZE * ROUNDS);
+#if defined(MBEDTLS_CIPHER_MODE_CBC)
+        sprintf(name, "AES-%u-CBC encrypt", keybits);
+        report(name, time_cbc(&ctx, MBEDTLS_AES_ENCRYPT), BUFFER_SIZE * ROUNDS);
+#endif
+
+        mbedtls_aes_setkey_dec(&ctx, key, keybits);
+        sprintf(name, "AES-%u-ECB decrypt", keybits);
+        report(name, time_ecb(&ctx, MBEDTLS_AES_DECRYPT), BUFFER_SIZE * ROUNDS);
+#if defined(MBEDTLS_CIPHER_MODE_CBC)
+        sprintf(name, "AES-%u-CBC decrypt", keybits);
+        report(name, time_cbc(&ctx, MBEDTLS_AES_DECRYPT), BUFFER_SIZE * ROUNDS);
+#endif
+    }
+
+    mbedtls_aes_free(&ctx);
+
+    printf("done\r\n");
+    while (1);
+}
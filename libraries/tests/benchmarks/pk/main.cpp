@@ -0,0 +1,101 @@
+#include "mbed.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/certs.h"
+
+/*
+ * Milliseconds per RSA-2048 and ECDSA P-256 signature and verification,
+ * which mostly measure the bignum multiply kernel bn_mul.h picks for the
+ * core: UMAAL on Cortex-M4/M7, UMLAL on Cortex-M3 and 16 bit multiplies
+ * on Cortex-M0/M0+. Only optimised builds use the assembly kernels.
+ */
+#if !defined(MBEDTLS_HAVE_ASM) || !defined(__OPTIMIZE__)
+#define KERNEL "C"
+#elif defined(__thumb__) && !defined(__thumb2__)
+#define KERNEL "Thumb-1"
+#elif defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define KERNEL "UMAAL"
+#elif defined(__arm__)
+#define KERNEL "UMLAL"
+#else
+#define KERNEL "C"
+#endif
+
+namespace {
+const int ROUNDS = 4;
+
+unsigned char hash[32];
+unsigned char sig[MBEDTLS_MPI_MAX_SIZE];
+Timer timer;
+uint32_t seed = 0x2545F491;
+}
+
+/* Reproducible, and only good enough for a benchmark */
+static int bench_rng(void *ctx, unsigned char *out, size_t len) {
+    (void)ctx;
+    while (len--) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        *out++ = (unsigned char)seed;
+    }
+    return 0;
+}
+
+static void bench(const char *name, const char *key, size_t key_len) {
+    mbedtls_pk_context pk;
+    size_t sig_len = 0;
+    int ret;
+
+    mbedtls_pk_init(&pk);
+    ret = mbedtls_pk_parse_key(&pk, (const unsigned char *)key, key_len, NULL, 0);
+    if (ret != 0) {
+        printf("%-12s parse failed: -0x%04x\r\n", name, -ret);
+        return;
+    }
+
+    timer.reset();
+    timer.start();
+    for (int r = 0; r < ROUNDS && ret == 0; r++) {
+        ret = mbedtls_pk_sign(&pk, MBEDTLS_MD_SHA256, hash, sizeof(hash),
+                              sig, &sig_len, bench_rng, NULL);
+    }
+    timer.stop();
+    if (ret != 0) {
+        printf("%-12s sign failed: -0x%04x\r\n", name, -ret);
+        mbedtls_pk_free(&pk);
+        return;
+    }
+    printf("%-12s sign   %8d ms\r\n", name, timer.read_ms() / ROUNDS);
+
+    timer.reset();
+    timer.start();
+    for (int r = 0; r < ROUNDS && ret == 0; r++) {
+        ret = mbedtls_pk_verify(&pk, MBEDTLS_MD_SHA256, hash, sizeof(hash),
+                                sig, sig_len);
+    }
+    timer.stop();
+    if (ret != 0) {
+        printf("%-12s verify failed: -0x%04x\r\n", name, -ret);
+    } else {
+        printf("%-12s verify %8d ms\r\n", name, timer.read_ms() / ROUNDS);
+    }
+
+    mbedtls_pk_free(&pk);
+}
+
+int main() {
+    printf("PK benchmark: %s kernel, %lu Hz\r\n", KERNEL,
+           (unsigned long)SystemCoreClock);
+
+    bench_rng(NULL, hash, sizeof(hash));
+
+#if defined(MBEDTLS_RSA_C)
+    bench("RSA-2048", mbedtls_test_srv_key_rsa, mbedtls_test_srv_key_rsa_len);
+#endif
+#if defined(MBEDTLS_ECDSA_C) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+    bench("ECDSA P-256", mbedtls_test_srv_key_ec, mbedtls_test_srv_key_ec_len);
+#endif
+
+    printf("done\r\n");
+    while (1);
+}
@@ -0,0 +1,222 @@
+"""
+mbed SDK
+Copyright (c) 2016 ARM Limited
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+Generate the constant comb tables used by mbed TLS when
+MBEDTLS_ECP_ROM_TABLES is defined.
+
+The domain parameters are read from ecp_curves.c and the curve list from
+config.h, so the tables always match the sources they are built with. For
+each curve the table is exactly what ecp_precompute_comb() would compute
+for the generator on the first call to mbedtls_ecp_mul(), in affine
+coordinates:
+
+    T[i] = G + sum over the bits b set in i of 2^(d*(b+1)) G
+
+Run it again after enabling another short Weierstrass curve:
+
+    python tools/dev/ecp_comb_tables.py
+"""
+from __future__ import print_function
+
+import re
+import sys
+from argparse import ArgumentParser
+from os.path import join, dirname, abspath
+
+ROOT = abspath(join(dirname(__file__), "..", ".."))
+MBEDTLS = join(ROOT, "features", "mbedtls")
+
+CURVES_C = join(MBEDTLS, "src", "ecp_curves.c")
+CONFIG_H = join(MBEDTLS, "inc", "mbedtls", "config.h")
+OUTPUT = join(MBEDTLS, "src", "ecp_comb_tables.h")
+
+# ecp_curves.c prefix -> MBEDTLS_ECP_DP_<id>
+CURVE_IDS = [
+    ("secp192r1", "SECP192R1"),
+    ("secp224r1", "SECP224R1"),
+    ("secp256r1", "SECP256R1"),
+    ("secp384r1", "SECP384R1"),
+    ("secp521r1", "SECP521R1"),
+    ("secp192k1", "SECP192K1"),
+    ("secp224k1", "SECP224K1"),
+    ("secp256k1", "SECP256K1"),
+    ("brainpoolP256r1", "BP256R1"),
+    ("brainpoolP384r1", "BP384R1"),
+    ("brainpoolP512r1", "BP512R1"),
+]
+
+ARRAY_RE = re.compile(
+    r"static const mbedtls_mpi_uint (\w+)\[\] = \{(.*?)\};", re.S)
+BYTES_RE = re.compile(r"BYTES_TO_T_UINT_\d\(([^)]*)\)")
+
+
+def read_constants(path):
+    """Return {name: (value, length in bytes)} for the embedded MPIs"""
+    constants = {}
+    with open(path) as f:
+        source = f.read()
+    for name, body in ARRAY_RE.findall(source):
+        data = []
+        for group in BYTES_RE.findall(body):
+            data.extend(int(b, 16) for b in group.split(","))
+        value = 0
+        for i, b in enumerate(data):
+            value |= b << (8 * i)
+        constants[name] = (value, len(data))
+    return constants
+
+
+def enabled_curves(path):
+    with open(path) as f:
+        return set(re.findall(r"^#define MBEDTLS_ECP_DP_(\w+)_ENABLED",
+                              f.read(), re.M))
+
+
+class Curve(object):
+    def __init__(self, name, ident, constants):
+        self.name = name
+        self.ident = ident
+        self.p, self.size = constants[name + "_p"]
+        a = constants.get(name + "_a")
+        self.a = a[0] if a else self.p - 3
+        self.b = constants[name + "_b"][0]
+        self.g = (constants[name + "_gx"][0], constants[name + "_gy"][0])
+        self.nbits = constants[name + "_n"][0].bit_length()
+
+        x, y = self.g
+        if (y * y - x * x * x - self.a * x - self.b) % self.p:
+            raise ValueError("%s: generator is not on the curve" % name)
+
+    def add(self, P, Q):
+        p = self.p
+        if P == Q:
+            l = (3 * P[0] * P[0] + self.a) * pow(2 * P[1], p - 2, p)
+        else:
+            l = (Q[1] - P[1]) * pow(Q[0] - P[0], p - 2, p)
+        x = (l * l - P[0] - Q[0]) % p
+        return (x, (l * (P[0] - x) - P[1]) % p)
+
+    def window(self):
+        """Comb width ecp_mul_comb() picks for the generator"""
+        w = 5 if self.nbits >= 384 else 4
+        return w + 1
+
+    def comb(self):
+        w = self.window()
+        d = (self.nbits + w - 1) // w
+        # B[l] = 2^(d*l) G
+        B = [self.g]
+        for _ in range(w - 1):
+            Q = B[-1]
+            for _ in range(d):
+                Q = self.add(Q, Q)
+            B.append(Q)
+        T = []
+        for i in range(1 << (w - 1)):
+            Q = self.g
+            for l in range(1, w):
+                if i & (1 << (l - 1)):
+                    Q = self.add(Q, B[l])
+            T.append(Q)
+        return w, T
+
+
+def limbs(value, size):
+    """Little-endian BYTES_TO_T_UINT_x lines as found in ecp_curves.c"""
+    data = [(value >> (8 * i)) & 0xFF for i in range(size)]
+    lines = []
+    for i in range(0, size, 8):
+        chunk = data[i:i + 8]
+        lines.append("    BYTES_TO_T_UINT_%d( %s )," %
+                     (len(chunk), ", ".join("0x%02X" % b for b in chunk)))
+    return lines
+
+
+def generate(curves):
+    out = [
+        "/*",
+        " *  Constant comb tables for fixed-point multiplication",
+        " *",
+        " *  Generated by tools/dev/ecp_comb_tables.py, do not edit.",
+        " *  Included from ecp_curves.c when MBEDTLS_ECP_ROM_TABLES is defined.",
+        " */",
+        "",
+    ]
+    entries = []
+    for c in curves:
+        w, T = c.comb()
+        guard = ("defined(MBEDTLS_ECP_DP_%s_ENABLED) && "
+                 "MBEDTLS_ECP_FIXED_POINT_OPTIM == 1 && "
+                 "MBEDTLS_ECP_WINDOW_SIZE >= %d" % (c.ident, w))
+        out.append("#if %s" % guard)
+        points = []
+        for i, (x, y) in enumerate(T):
+            for coord, v in (("X", x), ("Y", y)):
+                out.append("static const mbedtls_mpi_uint %s_T_%d_%s[] = {" %
+                           (c.name, i, coord))
+                out.extend(limbs(v, c.size))
+                out.append("};")
+            points.append("    ECP_POINT_INIT_XY_Z1( %s_T_%d_X, %s_T_%d_Y )," %
+                          (c.name, i, c.name, i))
+        out.append("static const mbedtls_ecp_point %s_T[%d] = {" %
+                   (c.name, len(T)))
+        out.extend(points)
+        out.append("};")
+        out.append("#endif")
+        out.append("")
+        entries.append((guard, "    { MBEDTLS_ECP_DP_%s, %s_T }," %
+                        (c.ident, c.name)))
+
+    out.append("static const ecp_comb_table ecp_comb_tables[] = {")
+    for guard, line in entries:
+        out.append("#if %s" % guard)
+        out.append(line)
+        out.append("#endif")
+    out.append("    { MBEDTLS_ECP_DP_NONE, NULL },")
+    out.append("};")
+    return "\n".join(out) + "\n"
+
+
+def main():
+    parser = ArgumentParser(
+        description="Generate the mbed TLS constant comb tables")
+    parser.add_argument("curves", nargs="*",
+                        help="ecp_curves.c names of the curves to generate, "
+                             "default the ones enabled in config.h")
+    parser.add_argument("-o", "--output", default=OUTPUT,
+                        help="output file, default %(default)s")
+    args = parser.parse_args()
+
+    constants = read_constants(CURVES_C)
+    if args.curves:
+        wanted = set(args.curves)
+        selected = [(n, i) for n, i in CURVE_IDS if n in wanted]
+        unknown = wanted - set(n for n, _ in selected)
+        if unknown:
+            parser.error("unknown curve(s): %s" % ", ".join(sorted(unknown)))
+    else:
+        enabled = enabled_curves(CONFIG_H)
+        selected = [(n, i) for n, i in CURVE_IDS if i in enabled]
+
+    curves = [Curve(n, i, constants) for n, i in selected]
+    with open(args.output, "w") as f:
+        f.write(generate(curves))
+    print("%s: %s" % (args.output,
+                      ", ".join(c.name for c in curves) or "no curves"))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
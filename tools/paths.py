@@ -85,6 +85,9 @@ DSP_CMSIS = join(DSP, "cmsis_dsp")
 DSP_ABSTRACTION = join(DSP, "dsp")
 DSP_LIBRARIES = join(BUILD_DIR, "dsp")
 
+# mbed TLS
+MBEDTLS = join(ROOT, "features", "mbedtls")
+
 # USB Device
 USB = join(LIB_DIR, "USBDevice")
 USB_LIBRARIES = join(BUILD_DIR, "usb")
@@ -387,6 +387,21 @@ TESTS = [
         "source_dir": join(BENCHMARKS_DIR, "all"),
         "dependencies": [MBED_LIBRARIES]
     },
+    {
+        "id": "BENCHMARK_6", "description": "Speed (AES)",
+        "source_dir": join(BENCHMARKS_DIR, "aes"),
+        "dependencies": [MBED_LIBRARIES, MBEDTLS]
+    },
+    {
+        "id": "BENCHMARK_7", "description": "Speed (RSA and ECDSA)",
+        "source_dir": join(BENCHMARKS_DIR, "pk"),
+        "dependencies": [MBED_LIBRARIES, MBEDTLS]
+    },
+    {
+        "id": "BENCHMARK_8", "description": "Speed (AES-CCM and AES-GCM)",
+        "source_dir": join(BENCHMARKS_DIR, "aead"),
+        "dependencies": [MBED_LIBRARIES, MBEDTLS]
+    },
 
     # performance related tests
     {